@@ -66,6 +66,8 @@ typedef struct{
 	char ** text;
 	int colct, rowct, textct;
     unsigned long *colhash, *rowhash, *texthash;
+    int *rowrefs; /**< If not \c NULL, the count of name structs sharing the row names; see \ref apop_name_copy. Don't touch. */
+    char borrowed; /**< Nonzero if the row names are a slice of another struct's, as in the views made by \ref apop_data_split, so \ref apop_name_free leaves them alone. Don't touch. */
 } apop_name;
 
 /** The \ref apop_data structure represents a data set. See \ref dataoverview.*/
@@ -78,6 +80,7 @@ typedef struct apop_data{
     gsl_vector  *weights;
     struct apop_data   *more;
     char        error;
+    struct apop_text_store *textstore; /**< Bookkeeping for packed text (see \ref apop_text_pack) and text shared among copies (see \ref apop_data_copy). Don't touch. */
 } apop_data;
 
 /* Settings groups. For internal use only; see apop_settings.c and 
@@ -187,9 +190,16 @@ freed location, and you can later safely test conditions like <tt>if (data) ...<
 char        apop_data_free_base(apop_data *freeme);
 Apop_var_declare( apop_data * apop_data_alloc(const size_t size1, const size_t size2, const int size3) )
 Apop_var_declare( apop_data * apop_data_calloc(const size_t size1, const size_t size2, const int size3) )
+void apop_arena_begin(void);
+void apop_arena_end(void);
+void *apop_arena_alloc(size_t size);
+gsl_vector *apop_arena_vector(size_t size);
+gsl_matrix *apop_arena_matrix(size_t size1, size_t size2);
+Apop_var_declare( apop_data * apop_arena_data(const size_t size1, const size_t size2, const int size3) )
 Apop_var_declare( apop_data * apop_data_stack(apop_data *m1, apop_data * m2, char posn, char inplace) )
-apop_data ** apop_data_split(apop_data *in, int splitpoint, char r_or_c);
+Apop_var_declare( apop_data ** apop_data_split(apop_data *in, int splitpoint, char r_or_c, char view) )
 apop_data * apop_data_copy(const apop_data *in);
+void apop_data_unshare(apop_data *d);
 void        apop_data_rm_columns(apop_data *d, int *drop);
 void apop_data_memcpy(apop_data *out, const apop_data *in);
 Apop_var_declare( double * apop_data_ptr(apop_data *data, int row, int col, const char *rowname, const char *colname, const char *page) )
@@ -198,6 +208,7 @@ Apop_var_declare( int apop_data_set(apop_data *data, size_t row, int col, const
 void apop_data_add_named_elmt(apop_data *d, char *name, double val);
 int apop_text_set(apop_data *in, const size_t row, const size_t col, const char *fmt, ...);
 apop_data * apop_text_alloc(apop_data *in, const size_t row, const size_t col);
+Apop_var_declare( apop_data * apop_text_pack(apop_data *d, char dictionary) )
 void apop_text_free(char ***freeme, int rows, int cols);
 Apop_var_declare( apop_data * apop_data_transpose(apop_data *in, char transpose_text, char inplace) )
 gsl_matrix * apop_matrix_realloc(gsl_matrix *m, size_t newheight, size_t newwidth);
@@ -225,6 +236,7 @@ Apop_var_declare( gsl_matrix * apop_vector_to_matrix(const gsl_vector *in, char
 //From matrix
 gsl_matrix *apop_matrix_copy(const gsl_matrix *in);
 Apop_var_declare( apop_data *apop_db_to_crosstab(char const*tabname, char const*row, char const*col, char const*data, char is_aggregate) )
+Apop_var_declare( apop_data *apop_data_to_crosstab(apop_data *d, int row, int col, char row_type, char col_type, int data) )
 
 //From array
 Apop_var_declare( gsl_vector * apop_array_to_vector(double *in, int size) )
@@ -407,10 +419,34 @@ long double apop_vector_entropy(gsl_vector *in);
 long double apop_matrix_sum(const gsl_matrix *m);
 double apop_matrix_mean(const gsl_matrix *data);
 void apop_matrix_mean_and_var(const gsl_matrix *data, double *mean, double *var);
-apop_data * apop_data_summarize(apop_data *data);
+Apop_var_declare( apop_data * apop_data_summarize(apop_data *data, double error) )
 Apop_var_declare( double * apop_vector_percentiles(gsl_vector *data, char rounding)  )
 
+/** A mergeable one-pass summary of a stream of numbers: count, weighted moments, min,
+  max, and a KLL sketch for approximate quantiles. See \ref apop_sketch_alloc. */
+typedef struct {
+    size_t n;             /**< The number of items added. */
+    long double wsum;     /**< The total weight of the items added. */
+    double min, max;      /**< The smallest and largest items added. */
+    double shift;         /**< Moments are accumulated around this value (the first item seen). */
+    long double s1, s2;   /**< Weighted sums of \f$x-\f$ \c shift and its square. */
+    int k;                /**< Capacity of the top compactor; zero if there is no quantile sketch. */
+    int levels;           /**< Compactor levels in use. */
+    size_t *len, *space;  /**< Items in, and space allocated for, each level. */
+    double **items;       /**< The compactors; an item at level \f$h\f$ stands in for \f$2^h\f$ inputs. */
+    unsigned int coin;    /**< State for the coin flips that choose which half of a compactor survives. */
+} apop_sketch;
+
+apop_sketch *apop_sketch_alloc(double error);
+Apop_var_declare( void apop_sketch_add(apop_sketch *s, double x, double weight) )
+apop_sketch *apop_sketch_merge(apop_sketch *into, apop_sketch const *from);
+double apop_sketch_quantile(apop_sketch const *s, double q);
+double apop_sketch_mean(apop_sketch const *s);
+double apop_sketch_var(apop_sketch const *s);
+void apop_sketch_free(apop_sketch *s);
+
 apop_data *apop_test_fisher_exact(apop_data *intab); //in apop_fisher.c
+apop_data *apop_test_fisher_exact_batch(apop_data *tables);
 
 //from apop_t_f_chi.c:
 Apop_var_declare( int apop_matrix_is_positive_semidefinite(gsl_matrix *m, char semi) )
@@ -434,7 +470,7 @@ gsl_vector * apop_vector_unique_elements(const gsl_vector *v);
 Apop_var_declare( apop_data * apop_data_to_factors(apop_data *data, char intype, int incol, int outcol) )
 Apop_var_declare( apop_data * apop_data_get_factor_names(apop_data *data, int col, char type) )
 
-Apop_var_declare( apop_data * apop_data_to_dummies(apop_data *d, int col, char type, int keep_first, char append, char remove) )
+Apop_var_declare( apop_data * apop_data_to_dummies(apop_data *d, int col, char type, int keep_first, char append, char remove, char sparse) )
 
 Apop_var_declare( long double apop_model_entropy(apop_model *in, int draws) )
 Apop_var_declare( long double apop_kl_divergence(apop_model *from, apop_model *to, int draw_ct, gsl_rng *rng) )
@@ -565,10 +601,14 @@ int apop_system(const char *fmt, ...) __attribute__ ((format (printf,1,2)));
 
 //Histograms and PMFs
 gsl_vector * apop_vector_moving_average(gsl_vector *, size_t);
+Apop_var_declare( gsl_vector * apop_vector_rolling(gsl_vector const *v, size_t bandwidth, char stat, double lambda) )
+Apop_var_declare( apop_data * apop_data_rolling(apop_data const *d, size_t bandwidth, char stat, double lambda) )
 apop_data * apop_histograms_test_goodness_of_fit(apop_model *h0, apop_model *h1);
 apop_data * apop_test_kolmogorov(apop_model *m1, apop_model *m2);
+Apop_var_declare( apop_data * apop_test_kolmogorov_vector(gsl_vector const *x, gsl_vector const *y, apop_model *reference, char exact) )
 apop_data *apop_data_pmf_compress(apop_data *in);
 Apop_var_declare( apop_data * apop_data_to_bins(apop_data const *indata, apop_data const *binspec, int bin_count, char close_top_bin) )
+Apop_var_declare( apop_data * apop_data_histogram(apop_data const *indata, apop_data const *binspec, int bin_count, char close_top_bin) )
 Apop_var_declare( apop_model * apop_model_to_pmf(apop_model *model, apop_data *binspec, long int draws, int bin_count) )
 
 //text conveniences
@@ -681,12 +721,31 @@ Apop_var_declare( apop_data * apop_rake(char const *margin_table, char * const*v
     //Some linear algebra utilities
 
 double apop_det_and_inv(const gsl_matrix *in, gsl_matrix **out, int calc_det, int calc_inv);
-Apop_var_declare( apop_data * apop_dot(const apop_data *d1, const apop_data *d2, char form1, char form2) )
+Apop_var_declare( apop_data * apop_dot(const apop_data *d1, const apop_data *d2, char form1, char form2, apop_data *out, double alpha, double beta, char hint1, char hint2) )
 Apop_var_declare( int         apop_vector_bounded(const gsl_vector *in, long double max) )
 gsl_matrix * apop_matrix_inverse(const gsl_matrix *in) ;
 double      apop_matrix_determinant(const gsl_matrix *in) ;
+double apop_spd_logdet_and_inv(const gsl_matrix *in, gsl_matrix **out, int calc_logdet, int calc_inv);
+gsl_matrix * apop_matrix_spd_inverse(const gsl_matrix *in);
+double      apop_matrix_spd_logdet(const gsl_matrix *in);
+int         apop_matrix_spd_solve(const gsl_matrix *A, const gsl_vector *b, gsl_vector *x);
 //apop_data*  apop_sv_decomposition(gsl_matrix *data, int dimensions_we_want);
-Apop_var_declare( apop_data *  apop_matrix_pca(gsl_matrix *data, int const dimensions_we_want) )
+Apop_var_declare( apop_data *  apop_matrix_pca(gsl_matrix *data, int const dimensions_we_want, char method) )
+
+/** Running centered cross-products for principal component analysis of data sent one
+  block of rows at a time. See \ref apop_pca_blocks_alloc. */
+typedef struct {
+    size_t d;           /**< Columns of the data. Set by the first block. */
+    size_t n;           /**< Observations accumulated so far. */
+    gsl_vector *mean;   /**< Column means of the data so far. */
+    gsl_matrix *cross;  /**< Lower triangle of \f$(X-\mu)'(X-\mu)\f$. */
+    char error;         /**< \c 'd' if a block's width did not match the first block's. */
+} apop_pca_blocks;
+
+apop_pca_blocks *apop_pca_blocks_alloc(void);
+int apop_pca_blocks_add(apop_data *block, void *acc);
+Apop_var_declare( apop_data * apop_pca_blocks_estimate(apop_pca_blocks *acc, int dimensions_we_want, char method) )
+void apop_pca_blocks_free(apop_pca_blocks *acc);
 Apop_var_declare( gsl_vector * apop_vector_stack(gsl_vector *v1, gsl_vector const * v2, char inplace) )
 Apop_var_declare( gsl_matrix * apop_matrix_stack(gsl_matrix *m1, gsl_matrix const * m2, char posn, char inplace) )
 
@@ -844,6 +903,8 @@ scope in which it is declared.
 
 /** \cond doxy_ignore */
 /* Not (yet) for public use. */
+struct apop_text_store *apop_text_view_store(apop_data const *d);
+
 #define Apop_subvector(v, start, len) (                                          \
         ((v) == NULL || (v)->size < ((start)+(len)) || (start) < 0) ? NULL      \
         : &(gsl_vector){.size=(len), .stride=(v)->stride, .data=(v)->data+(start*(v)->stride)})
@@ -879,6 +940,7 @@ The view is automatically allocated, and disappears as soon as the program leave
         .textsize[0]=(d)->textsize[0]> (rownum)+(len)-1 ? (len) : 0,                                   \
         .textsize[1]=(d)->textsize[1],                                           \
         .text = (d)->text ? &((d)->text[rownum]) : NULL,                         \
+        .textstore = (d)->text ? apop_text_view_store(d) : NULL,                 \
         })
 
 
@@ -1004,6 +1066,7 @@ apop_data * apop_query_to_data(const char * fmt, ...) __attribute__ ((format (pr
 apop_data * apop_query_to_mixed_data(const char *typelist, const char * fmt, ...) __attribute__ ((format (printf,2,3)));
 gsl_vector * apop_query_to_vector(const char * fmt, ...) __attribute__ ((format (printf,1,2)));
 double apop_query_to_float(const char * fmt, ...) __attribute__ ((format (printf,1,2)));
+int apop_query_to_blocks(size_t block_rows, int (*fn)(apop_data *block, void *aux), void *aux, const char * fmt, ...) __attribute__ ((format (printf,4,5)));
 
 int apop_data_to_db(const apop_data *set, const char *tabname, char);
 
@@ -1229,10 +1292,33 @@ delta;
                              through the dimensions is within this amount of the previous cycle's log likelihood. There
                              will be at least two cycles.
                              */
+    int         dim_cycle_blocks; /**< If zero (the default), dimension cycling optimizes one dimension
+                             at a time, in sequence. If \f$>1\f$, split the parameters into this many
+                             contiguous blocks and optimize every block in parallel from the same
+                             point, holding the other blocks fixed (a block-Jacobi step). If the
+                             combined update does worse than the best single block's update, only that
+                             block's update is kept, so every cycle is an improvement. Works best
+                             when the blocks are nearly independent. */
+//multiple starting points (see \ref multistart):
+    int         starts;     /**< If \f$>1\f$, run this many searches in parallel, each from
+                             its own starting point, and keep the one with the highest log
+                             likelihood. The first search starts at \c starting_pt; the others at
+                             points drawn as per \c start_draws. Default: 1 (the usual single search). */
+    apop_data   *start_list; /**< If not \c NULL, each row of the matrix is a starting point, and
+                             I run one search from each row. Overrides \c starts and \c start_draws. */
+    char        start_draws; /**< How to generate the starting points beyond the first: \c 'l'
+                             (the default) for a Latin hypercube, where each dimension is cut into
+                             \c starts strata and every stratum is used exactly once, or \c 'r' for
+                             independent uniform draws. */
+    double      start_range; /**< Draws are taken from \c starting_pt \f$\pm\f$ \c start_range
+                             in each dimension. Default: 1. */
 //simulated annealing (also uses step_size);
     int         n_tries, iters_fixed_T;
     double      k, t_initial, mu_t, t_min ;
-    gsl_rng     *rng;
+    gsl_rng     *rng; /**< For simulated annealing and for drawing multiple starting points.
+                        Default: an RNG from \ref apop_rng_get_thread. When running several
+                        searches via \c starts, each annealing search gets its own RNG, seeded
+                        by a draw from this one. */
     apop_data   **path;    /**< If not \c NULL, record each vector tried by the optimizer as one row of this \ref apop_data set.
                               Each row of the \c matrix element holds the vector tried; the corresponding element in the \c vector is the evaluated value at that vector (after out-of-constraints penalties have been subtracted).
                               A new \ref apop_data set is allocated at the pointer you send in. This data set has no names; add them as desired. For a sample use, see \ref maxipage.
@@ -1246,8 +1332,29 @@ typedef struct {
     char want_cov; /**< Deprecated. Please use \ref apop_parts_wanted_settings. */
     char want_expected_value; /**< Deprecated. Please use \ref apop_parts_wanted_settings. */
     apop_model *input_distribution; /**< The distribution of \f$P(Y|X)\f$ is specified by the model holding this struct, but the distribution of \f$X\f$ needs to be specified as well for any calculation of \f$P(Y)\f$. See the notes in the RNG section of the \ref apop_ols documentation. */
+    apop_data *fixed_effects; /**< Index-coded dummies, as produced by <tt>apop_data_to_dummies(..., .sparse='y')</tt>, to be absorbed into the regression without building the grid of dummies. See the \ref apop_ols documentation. Not copied, so it must outlive the model. Default: \c NULL. */
 } apop_lm_settings;
 
+/** Running cross-products for fitting an \ref apop_ols or \ref apop_iv regression one
+  block of rows at a time, so the full data set never needs to be in memory. See \ref
+  apop_lm_blocks_alloc. */
+typedef struct {
+    size_t k;            /**< Columns of \f$X\f$, including the constant column. Set by the first block. */
+    size_t n;            /**< Observations accumulated so far. */
+    gsl_matrix *cross;   /**< Lower triangle of \f$A'WA\f$, where each row of \f$A\f$ is \f$[X\ y\ Z_{inst}\ 1]\f$. */
+    gsl_matrix *raw_cross; /**< Lower triangle of the unweighted \f$[X\ y]'[X\ y]\f$; only allocated for weighted data. */
+    long double sum_log_weights;
+    gsl_vector *instrumented; /**< For IV, the \f$X\f$ columns replaced by instruments; \c NULL for OLS. */
+    apop_name *names;    /**< Names of \f$y\f$ and the \f$X\f$ columns, taken from the first block. */
+    char error;          /**< \c 'd' if a block's dimensions did not match the first block's;
+                              \c 'w' if a block was weighted and the first wasn't, or vice versa. */
+} apop_lm_blocks;
+
+apop_lm_blocks *apop_lm_blocks_alloc(gsl_vector const *instrumented);
+int apop_lm_blocks_add(apop_data *block, void *acc);
+apop_model *apop_lm_blocks_estimate(apop_lm_blocks *acc, apop_model *m);
+void apop_lm_blocks_free(apop_lm_blocks *acc);
+
 /** The default is for the estimation routine to give some auxiliary information,
   such as a covariance matrix, predicted values, and common hypothesis tests.
   Some uses of a model depend on these items, but if they are a waste
@@ -56,6 +56,7 @@ apop_data * apop_jackknife_cov(apop_data *in, apop_model *model){
     gsl_vector *overall_params = apop_data_pack(overall_est->parameters);
     gsl_vector_scale(overall_params, n); //do it just once.
     gsl_vector *pseudoval = gsl_vector_alloc(overall_params->size);
+    gsl_vector *estp = gsl_vector_alloc(overall_params->size);
 
     //Copy the original, minus the first row.
     apop_data *subset = apop_data_copy(Apop_rs(in, 1, n-1));
@@ -68,19 +69,19 @@ apop_data * apop_jackknife_cov(apop_data *in, apop_model *model){
         //Get a view of row i, and copy it to position i-1 in the short matrix.
         if (i >= 0) apop_data_memcpy(Apop_r(subset, i), Apop_r(in, i));
         apop_model *est = apop_estimate(subset, e);
-        gsl_vector *estp = apop_data_pack(est->parameters);
+        apop_data_pack(est->parameters, estp);
         gsl_vector_memcpy(pseudoval, overall_params);// *n above.
         gsl_vector_scale(estp, n-1);
         gsl_vector_sub(pseudoval, estp);
         gsl_matrix_set_row(array_of_boots->matrix, i+1, pseudoval);
         apop_model_free(est);
-        gsl_vector_free(estp);
     }
     in->names = tmpnames;
     apop_data *out = apop_data_covariance(array_of_boots);
     gsl_matrix_scale(out->matrix, 1./(n-1.));
     apop_data_free(subset);
     gsl_vector_free(pseudoval);
+    gsl_vector_free(estp);
     apop_data_free(array_of_boots);
     if (e!=overall_est)
         apop_model_free(overall_est);
@@ -131,6 +132,7 @@ APOP_VAR_ENDHEAD
     Get_vmsizes(data); //vsize, msize1, msize2
     apop_model *e = apop_model_copy(model);
     apop_data *subset = apop_data_copy(data);
+    apop_text_unshare(subset); //rows are rewritten via views below
     apop_data *array_of_boots = NULL,
               *summary;
     //prevent and infinite regression of covariance calculation.
@@ -147,27 +149,25 @@ APOP_VAR_ENDHEAD
 		}
 		//get the parameter estimates.
 		apop_model *est = apop_estimate(subset, e);
-        gsl_vector *estp = apop_data_pack(est->parameters);
-        if (!gsl_isnan(apop_sum(estp))){
-            if (i==0){
-                array_of_boots	      = apop_data_alloc(iterations, estp->size);
-                apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'v');
-                apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'c');
-                apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'r');
-            }
-            gsl_matrix_set_row(array_of_boots->matrix, i, estp);
-        } else if (ignore_nans=='y'){
+        if (!array_of_boots){
+            array_of_boots	      = apop_data_alloc(iterations, apop_data_pack_size(est->parameters));
+            apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'v');
+            apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'c');
+            apop_name_stack(array_of_boots->names, est->parameters->names, 'c', 'r');
+        }
+        gsl_vector *estp = Apop_rv(array_of_boots, i); //pack straight into the output
+        apop_data_pack(est->parameters, estp);
+        if (gsl_isnan(apop_sum(estp)) && ignore_nans=='y'){
             i--; 
             nan_draws++;
         }
         apop_model_free(est);
-        gsl_vector_free(estp);
 	}
     if(data) data->names = tmpnames;
     apop_data_free(subset);
     apop_model_free(e);
     int set_error=0;
-    Apop_stopif(i == 0 && nan_draws == iterations, apop_return_data_error(N),
+    Apop_stopif(i == 0 && nan_draws == iterations, apop_data_free(array_of_boots); apop_return_data_error(N),
                 1, "I ran into %i NaNs and no not-NaN estimations, and so stopped. "
                        , iterations);
     Apop_stopif(nan_draws == iterations,  set_error++;
@@ -73,15 +73,121 @@ APOP_VAR_ENDHEAD
     return out;
 }
 
-static int find_cat_index(char **d, char * r, int start_from, int size){
-//used for apop_db_to_crosstab.
-    int i = start_from % size;	//i is probably the same or i+1.
-	do {
-		if(!strcmp(d[i], r)) return i;
-		i++;
-		i %= size;	//loop around as necessary.
-	} while (i!=start_from); 
-    Apop_assert_c(0, -2, 0, "Something went wrong in the crosstabbing; couldn't find %s.", r);
+/* The crosstab builder: each label of each dimension gets an index via a hash table as
+   it first appears, and each cell is recorded as (row index, col index, value). When
+   the input is done, the labels are sorted once and the cells placed in the grid. */
+struct apop_crosstab_builder {
+    apop_distinct labels[2]; //keys are copies owned by the builder.
+    char *kinds[2];
+    double *nums[2];
+    size_t *cells;           //pairs of label indices, in input order.
+    double *vals;
+    size_t n, cap;
+};
+
+apop_crosstab_builder *apop_crosstab_builder_alloc(void){
+    apop_crosstab_builder *b = calloc(1, sizeof(apop_crosstab_builder));
+    Apop_stopif(!b || apop_distinct_init(b->labels, 't', 0) || apop_distinct_init(b->labels+1, 't', 0),
+            free(b); return NULL, 0, "Allocation error.");
+    return b;
+}
+
+static void crosstab_builder_free(apop_crosstab_builder *b){
+    for (int d=0; d< 2; d++){
+        for (size_t k=0; k< b->labels[d].count; k++) free((char*)b->labels[d].tkeys[k]);
+        apop_distinct_free(b->labels+d);
+        free(b->kinds[d]);
+        free(b->nums[d]);
+    }
+    free(b->cells);
+    free(b->vals);
+    free(b);
+}
+
+//Return nonzero on allocation failure.
+int apop_crosstab_builder_add(apop_crosstab_builder *b, char const *labels[2], char const kinds[2], double val){
+    size_t ij[2];
+    for (int d=0; d< 2; d++){
+        apop_distinct *h = b->labels+d;
+        size_t before = h->count;
+        ptrdiff_t idx = apop_distinct_add(h, 0, labels[d]);
+        if (idx < 0) return 1;
+        if (h->count > before){
+            if (!(before & (before-1))){ //at each power of two, double the label info.
+                size_t newcap = before ? 2*before : 1;
+                char *k = realloc(b->kinds[d], newcap);
+                double *x = realloc(b->nums[d], newcap*sizeof(double));
+                if (k) b->kinds[d] = k;
+                if (x) b->nums[d] = x;
+                Apop_stopif(!k || !x, return 1, 0, "Allocation error.");
+            }
+            h->tkeys[idx] = strdup(labels[d]);
+            b->kinds[d][idx] = kinds[d];
+            b->nums[d][idx] = kinds[d]=='d' ? strtod(labels[d], NULL) : 0;
+        }
+        ij[d] = idx;
+    }
+    if (b->n == b->cap){
+        b->cap = b->cap ? 2*b->cap : 1024;
+        size_t *c = realloc(b->cells, 2*b->cap*sizeof(size_t));
+        double *v = realloc(b->vals, b->cap*sizeof(double));
+        if (c) b->cells = c;
+        if (v) b->vals = v;
+        Apop_stopif(!c || !v, return 1, 0, "Allocation error.");
+    }
+    b->cells[2*b->n] = ij[0];
+    b->cells[2*b->n+1] = ij[1];
+    b->vals[b->n++] = val;
+    return 0;
+}
+
+static threadlocal apop_crosstab_builder *sorting_builder;
+static threadlocal int sorting_dim;
+
+//As SQL would sort: NULLs, then numbers by value, then text.
+static int crosstab_label_cmp(void const *a, void const *b){
+    size_t i = *(size_t const*)a, j = *(size_t const*)b;
+    char ki = sorting_builder->kinds[sorting_dim][i], kj = sorting_builder->kinds[sorting_dim][j];
+    int ri = ki=='n' ? 0 : ki=='d' ? 1 : 2, rj = kj=='n' ? 0 : kj=='d' ? 1 : 2;
+    if (ri != rj) return ri - rj;
+    if (ri == 1){
+        double xi = sorting_builder->nums[sorting_dim][i], xj = sorting_builder->nums[sorting_dim][j];
+        if (xi != xj) return (xi > xj) - (xi < xj);
+    }
+    return strcmp(sorting_builder->labels[sorting_dim].tkeys[i], sorting_builder->labels[sorting_dim].tkeys[j]);
+}
+
+/* Sort the labels, fill the grid, and free the builder. If a cell appears more than once,
+   the last value wins. Returns NULL if nothing was added. */
+apop_data *apop_crosstab_builder_finish(apop_crosstab_builder *b){
+    if (!b) return NULL;
+    if (!b->n){
+        crosstab_builder_free(b);
+        return NULL;
+    }
+    apop_data *out = apop_data_alloc();
+    size_t *rank[2];
+    for (int d=0; d< 2; d++){
+        size_t ct = b->labels[d].count;
+        size_t *order = malloc(ct*sizeof(size_t));
+        rank[d] = malloc(ct*sizeof(size_t));
+        for (size_t k=0; k< ct; k++) order[k] = k;
+        sorting_builder = b;
+        sorting_dim = d;
+        qsort(order, ct, sizeof(size_t), crosstab_label_cmp);
+        for (size_t k=0; k< ct; k++){
+            rank[d][order[k]] = k;
+            apop_name_add(out->names, b->labels[d].tkeys[order[k]], d ? 'c' : 'r');
+        }
+        free(order);
+    }
+    out->matrix = gsl_matrix_calloc(b->labels[0].count, b->labels[1].count);
+    for (size_t k=0; k< b->n; k++)
+        gsl_matrix_set(out->matrix, rank[0][b->cells[2*k]], rank[1][b->cells[2*k+1]], b->vals[k]);
+    free(rank[0]);
+    free(rank[1]);
+    crosstab_builder_free(b);
+    return out;
 }
 
 /**Give the name of a table in the database, and optional names of three of its columns:
@@ -100,8 +206,13 @@ indexed by 'row' and cols by 'col' and the cells filled with the entry in the 'd
     tabname) returns an empty data set, then I will return a \c NULL data set and if
     <tt>apop_opts.verbosity >= 1</tt> print a warning.
 
-\exception out->error='n' Name not found error.
-\exception out->error='q' Query returned an empty table (which might mean that it just failed).
+\exception out->error='q' Query error.
+
+\li One query is run, and its rows are read one at a time. Row and column labels are
+    indexed via hash tables as they appear, then sorted once: NULLs first, then numbers by
+    value, then text, as an <tt>order by</tt> would sort them in SQLite. Labels that are
+    <tt>NULL</tt> in the database are named per \ref apop_opts_type "apop_opts.nan_string".
+\li For a crosstab of an in-memory data set, see \ref apop_data_to_crosstab.
 
 \li The simplest use is to get a tally of how often (r1, r2) appears in the data via <tt>apop_db_to_crosstab("datatab", "r1", "r2")</tt>.
 \li If you want a 1-D crosstab, omit the other dimension. Or omit both to get a grand tally of your statistic for the entire table.
@@ -118,11 +229,6 @@ APOP_VAR_HEAD apop_data *apop_db_to_crosstab(char const*tabname, char const*row,
     //Note the transitional check for "group by", which we should one day remove.
     char apop_varad_var(is_aggregate, (strchr(data, ')') && !strstr(data, "group by"))?'y':'n');
 APOP_VAR_ENDHEAD
-    gsl_matrix *out=NULL;
-    int	i, j=0;
-    apop_data *pre_d1=NULL, *pre_d2=NULL, *datachars=NULL;
-    apop_data *outdata = apop_data_alloc();
-
     char* p = apop_opts.db_name_column;
     apop_opts.db_name_column = NULL;//we put this back at the end.
     char *Q;
@@ -132,39 +238,75 @@ APOP_VAR_ENDHEAD
                                     is_aggregate!='n' ? row : "",
                                     is_aggregate!='n' ? "," : "",
                                     is_aggregate!='n' ? col : "");
-    datachars = apop_query_to_text("%s", Q);
-    Apop_stopif(!datachars, free(Q); return NULL, 2, "[%s] returned an empty table.", Q);
-    Apop_stopif(datachars->error, free(Q); goto bailout, 0, "error from [%s].", Q);
-
-    //A bit inefficient, but well-encapsulated.
-    //Pull the distinct (sorted) list of headers, copy into outdata->names.
-    pre_d1 = apop_query_to_text("select distinct %s, 1 from %s order by %s", row, tabname, row);
-    Apop_stopif(!pre_d1||pre_d1->error, outdata->error='q'; goto bailout, 0, "Error querying %s from %s.", row, tabname);
-    for (i=0; i < pre_d1->textsize[0]; i++)
-        apop_name_add(outdata->names, pre_d1->text[i][0], 'r');
-
-	pre_d2 = apop_query_to_text("select distinct %s from %s order by %s", col, tabname, col);
-    Apop_stopif(!pre_d2||pre_d2->error, outdata->error='q'; goto bailout, 0, "Error querying %s from %s.", row, tabname);
-    for (i=0; i < pre_d2->textsize[0]; i++)
-        apop_name_add(outdata->names, pre_d2->text[i][0], 'c');
-
-	out	= gsl_matrix_calloc(pre_d1->textsize[0], pre_d2->textsize[0]);
-	for (size_t k =0; k< datachars->textsize[0]; k++){
-		i = find_cat_index(outdata->names->row, datachars->text[k][0], i, pre_d1->textsize[0]);
-		j = find_cat_index(outdata->names->col, datachars->text[k][1], j, pre_d2->textsize[0]);
-        Apop_stopif(i==-2 || j == -2, outdata->error='n'; goto bailout, 0, "Something went wrong in the crosstabbing; "
-                                                 "couldn't find %s or %s.", datachars->text[k][0], datachars->text[k][1]);
-		gsl_matrix_set(out, i, j, atof(datachars->text[k][2]));
-	}
-    bailout:
-    apop_data_free(pre_d1);
-    apop_data_free(pre_d2);
-    apop_data_free(datachars);
-    outdata->matrix = out;
+    apop_crosstab_builder *b = apop_crosstab_builder_alloc();
+    int err = apop_query_to_crosstab_builder(Q, b);
+    apop_data *outdata = apop_crosstab_builder_finish(b);
     apop_opts.db_name_column = p;
+    Apop_stopif(err, if (!outdata) outdata = apop_data_alloc(); outdata->error='q'; free(Q); return outdata,
+                    0, "error from [%s].", Q);
+    Apop_stopif(!outdata, free(Q); return NULL, 2, "[%s] returned an empty table.", Q);
+    free(Q);
 	return outdata;
 }
 
+/** Build a crosstab from two columns of an in-memory data set, as \ref apop_db_to_crosstab
+does for a database table. The output's \c matrix has one row for each distinct value
+of the \c row column and one column for each distinct value of the \c col column, with
+those values (sorted) as the row and column names.
+
+\param d The data set. (No default; must not be \c NULL)
+\param row The column whose values will indicate the rows of the crosstab; -1 is the vector. (default: 0)
+\param col The column whose values will indicate the columns of the crosstab; -1 is the vector. (default: 1)
+\param row_type \c 't' if \c row refers to a text column; \c 'd' if it refers to the vector or matrix. (default: \c 't')
+\param col_type As with \c row_type, for \c col. (default: \c 't')
+\param data If given, each cell is the sum of this numeric column (-1 is the vector) over
+the rows in the cell. If omitted, each cell is a count of its rows, or the sum of their
+weights if \c d has weights.
+
+\return An \ref apop_data set with the crosstab in the \c matrix. Cells with no data are zero.
+\exception out->error='d' Dimension error: a requested column isn't present.
+
+\li Each column's distinct values are found with hash tables, and the lists are sorted
+once at the end; see \ref apop_vector_unique_elements.
+\li Numeric labels are printed using <tt>%g</tt>.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data *apop_data_to_crosstab(apop_data *d, int row, int col, char row_type, char col_type, int data){
+    apop_data * apop_varad_var(d, NULL);
+    Apop_stopif(!d, return NULL, 1, "You sent me a NULL data set. Returning NULL.");
+    int apop_varad_var(row, 0);
+    int apop_varad_var(col, 1);
+    char apop_varad_var(row_type, 't');
+    char apop_varad_var(col_type, 't');
+    int apop_varad_var(data, -2);
+APOP_VAR_ENDHEAD
+    apop_data *out = apop_data_alloc();
+    int cols[] = {row, col};
+    char types[] = {row_type, col_type};
+    for (int k=0; k< 2; k++){
+        if (types[k] == 't')
+            Apop_stopif(cols[k] < 0 || cols[k] >= d->textsize[1], out->error='d'; return out,
+                        0, "You asked for text column %i, but the data set has %zu.", cols[k], d->textsize[1]);
+        else
+            Apop_stopif(cols[k] == -1 ? !d->vector : (cols[k] < -1 || !d->matrix || cols[k] >= d->matrix->size2),
+                        out->error='d'; return out, 0, "You asked for column %i, which isn't in the data set.", cols[k]);
+    }
+    Apop_stopif(data != -2 && (data == -1 ? !d->vector : (data < -1 || !d->matrix || data >= d->matrix->size2)),
+                out->error='d'; return out, 0, "You asked for data column %i, which isn't in the data set.", data);
+    size_t rowct, colct;
+    size_t *ri = apop_factor_index(d, row, row_type, out->names, 'r', &rowct);
+    size_t *ci = apop_factor_index(d, col, col_type, out->names, 'c', &colct);
+    Apop_stopif(!ri || !ci, free(ri); free(ci); out->error='a'; return out, 0, "Allocation error.");
+    size_t n = row_type == 't' ? d->textsize[0] : row == -1 ? d->vector->size : d->matrix->size1;
+    gsl_vector *vals = data == -2 ? d->weights : data == -1 ? d->vector : Apop_cv(d, data);
+    out->matrix = gsl_matrix_calloc(rowct, colct);
+    for (size_t i=0; i< n; i++)
+        *gsl_matrix_ptr(out->matrix, ri[i], ci[i]) += vals ? gsl_vector_get(vals, i) : 1;
+    free(ri);
+    free(ci);
+    return out;
+}
+
 /** See \ref apop_db_to_crosstab for the storyline; this is the complement, which takes a
   crosstab and writes its values to the database.
 
@@ -735,6 +877,9 @@ static size_t sizecount(const apop_data *in, bool all_pp, bool use_info_pp){
              + (all_pp ? sizecount(in->more, all_pp, use_info_pp) : 0);
 }
 
+//The size of the vector apop_data_pack(in) would produce, for callers with their own buffer.
+size_t apop_data_pack_size(const apop_data *in){ return sizecount(in, true, false); }
+
 /** This function takes in an \ref apop_data set and writes it as a single column of
 numbers, outputting a \c gsl_vector.
  It is valid to use the \c out_vector->data element as an array of \c doubles of size
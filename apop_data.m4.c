@@ -3,6 +3,7 @@ The apop_data structure joins together a gsl_matrix, apop_name, and a table of s
 /* Copyright (c) 2006--2009 by Ben Klemens.  Licensed under the GPLv2; see COPYING.  */
 
 #include "apop_internal.h"
+#include <stdbool.h>
 //apop_gsl_error is in apop_linear_algebra.c
 #define Set_gsl_handler gsl_error_handler_t *prior_handler = gsl_set_error_handler(apop_gsl_error);
 #define Unset_gsl_handler gsl_set_error_handler(prior_handler);
@@ -106,18 +107,233 @@ APOP_VAR_ENDHEAD
     return setme;
 }
 
+/* The arena is a thread-local stack of chunks with a bump pointer. apop_arena_begin
+   records the current top in a mark that is itself bump-allocated, and apop_arena_end
+   rewinds to that mark. Chunks emptied by a rewind are freed, except that the largest is
+   kept as a spare, so a loop that opens and closes a scope doesn't call malloc at all
+   after its first pass. */
+typedef union { long double ld; long long ll; void *p; } arena_align;
+
+typedef struct arena_chunk {
+    struct arena_chunk *prev;
+    size_t size, used;
+    arena_align data[];
+} arena_chunk;
+
+typedef struct arena_mark {
+    arena_chunk *chunk;
+    size_t used;
+    struct arena_mark *prev;
+} arena_mark;
+
+static threadlocal arena_chunk *arena_top, *arena_spare;
+static threadlocal arena_mark *arena_open;
+static const size_t arena_chunk_size = 1<<16;
+
+static void *arena_bump(size_t size){
+    size = (size + sizeof(arena_align) - 1) / sizeof(arena_align) * sizeof(arena_align);
+    if (!arena_top || arena_top->used + size > arena_top->size){
+        arena_chunk *c;
+        if (arena_spare && arena_spare->size >= size){
+            c = arena_spare;
+            arena_spare = NULL;
+        } else {
+            size_t csize = GSL_MAX(size, arena_chunk_size);
+            c = malloc(sizeof(arena_chunk) + csize);
+            Apop_stopif(!c, return NULL, 0, "malloc failed. Probably out of memory.");
+            c->size = csize;
+        }
+        c->used = 0;
+        c->prev = arena_top;
+        arena_top = c;
+    }
+    void *out = (char*)arena_top->data + arena_top->used;
+    arena_top->used += size;
+    return out;
+}
+
+/** Open a scope for temporary allocations. Until the matching \ref apop_arena_end, \ref
+apop_arena_alloc, \ref apop_arena_vector, \ref apop_arena_matrix, and \ref apop_arena_data
+take memory from a per-thread pool instead of the system allocator, and \ref apop_arena_end
+releases everything allocated in the scope at once.
+
+Use this for short-lived intermediates in loops that would otherwise spend much of their
+time in \c malloc and \c free:
+
+\code
+for (int i=0; i< draws; i++){
+    apop_arena_begin();
+    gsl_vector *scratch = apop_arena_vector(dim);
+    apop_data *point = apop_arena_data(1, dim);
+    //...use them; do not free them...
+    apop_arena_end();
+}
+\endcode
+
+\li Scopes nest: an inner \ref apop_arena_end releases only what was allocated since the matching \ref apop_arena_begin.
+\li Each thread has its own pool, so allocations in different OpenMP threads don't interfere.
+\li Never pass arena memory to \c free, \c gsl_vector_free, \ref apop_data_free, or the like,
+and never keep a pointer to it after the scope closes.
+*/
+void apop_arena_begin(void){
+    arena_mark m = {.chunk=arena_top, .used= arena_top ? arena_top->used : 0, .prev=arena_open};
+    arena_mark *stored = arena_bump(sizeof(arena_mark));
+    Apop_stopif(!stored, return, 0, "Couldn't open an arena scope.");
+    *stored = m;
+    arena_open = stored;
+}
+
+/** Close the innermost scope opened by \ref apop_arena_begin, releasing everything allocated from the arena since then. */
+void apop_arena_end(void){
+    Apop_stopif(!arena_open, return, 0, "apop_arena_end called with no open arena scope.");
+    arena_mark m = *arena_open;
+    while (arena_top != m.chunk){
+        arena_chunk *c = arena_top;
+        arena_top = c->prev;
+        if (!arena_spare || arena_spare->size < c->size){
+            free(arena_spare);
+            arena_spare = c;
+        } else free(c);
+    }
+    if (arena_top) arena_top->used = m.used;
+    arena_open = m.prev;
+}
+
+/** Allocate memory from the innermost open arena scope; see \ref apop_arena_begin.
+The memory is aligned for any type, uninitialized, and freed by \ref apop_arena_end.
+
+\return A pointer to \c size bytes, or \c NULL if no scope is open or allocation failed.
+*/
+void *apop_arena_alloc(size_t size){
+    Apop_stopif(!arena_open, return NULL, 0, "No arena scope is open; call apop_arena_begin first.");
+    return arena_bump(size);
+}
+
+/** Allocate an uninitialized vector from the innermost open arena scope; see \ref apop_arena_begin.
+The vector has no \c block, so it is usable anywhere a view is, but must not be freed or reallocated.
+*/
+gsl_vector *apop_arena_vector(size_t size){
+    gsl_vector *out = apop_arena_alloc(sizeof(gsl_vector) + sizeof(double)*size);
+    if (!out) return NULL;
+    *out = (gsl_vector){.size=size, .stride=1, .data=(double*)(out+1)};
+    return out;
+}
+
+/** Allocate an uninitialized matrix from the innermost open arena scope; see \ref apop_arena_begin.
+As with \ref apop_arena_vector, the matrix has no \c block and must not be freed or reallocated.
+*/
+gsl_matrix *apop_arena_matrix(size_t size1, size_t size2){
+    gsl_matrix *out = apop_arena_alloc(sizeof(gsl_matrix) + sizeof(double)*size1*size2);
+    if (!out) return NULL;
+    *out = (gsl_matrix){.size1=size1, .size2=size2, .tda=size2, .data=(double*)(out+1)};
+    return out;
+}
+
+/** Allocate an \ref apop_data set from the innermost open arena scope; see \ref apop_arena_begin.
+The arguments follow \ref apop_data_alloc: vector size, matrix rows, matrix columns, with fewer
+arguments giving a matrix only or a vector only. The set, its empty names, its
+vector, and its matrix all come from the arena; the data is not initialized.
+
+\li Freed by \ref apop_arena_end; never use \ref apop_data_free on it.
+\li Anything you add with the usual heap functions (names, text, weights, pages) is not
+released by the arena. Either free it yourself before the scope closes, or don't add it.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data * apop_arena_data(const size_t size1, const size_t size2, const int size3){
+    const size_t apop_varad_var(size1, 0);
+    const size_t apop_varad_var(size2, 0);
+    const int apop_varad_var(size3, 0);
+APOP_VAR_ENDHEAD
+    size_t vsize=0, msize1=0; 
+    int msize2=0;
+    if (size3){
+        vsize = size1;
+        msize1 = size2;
+        msize2 = size3;
+    }
+    else if (size2) {
+        msize1 = size1;
+        msize2 = size2;
+    }
+    else vsize = size1;
+    struct {apop_data d; apop_name n;} *dn = apop_arena_alloc(sizeof(*dn));
+    Apop_stopif(!dn, return NULL, 0, "Couldn't allocate from the arena.");
+    dn->n = (apop_name){ };
+    dn->d = (apop_data){.names=&dn->n};
+    if (msize2 > 0 && msize1 > 0) dn->d.matrix = apop_arena_matrix(msize1, msize2);
+    if (vsize) dn->d.vector = apop_arena_vector(vsize);
+    return &dn->d;
+}
+
 /*For a touch of space saving, blank strings in a text grid 
 all point to the same nul string. */
 char *apop_nul_string = "";
 
+/* Text grids come in two layouts. In the classic layout, built by apop_text_alloc and
+   apop_text_set, every row is its own malloced array and every cell its own malloced
+   string. In the packed layout, built by apop_text_pack and the query functions, the
+   rows are slices of one block of cell pointers and the strings sit end to end in one
+   pool. A packed grid can still be written to: new cells are malloced as usual and old
+   cells are freed only if they aren't in the pool, and anything that reshapes the grid
+   first gives each row its own array. Either way, blank cells point to apop_nul_string.
+
+   The store also counts the sets sharing the grid; see apop_data_copy. A borrowed store
+   marks a grid that is a slice of another set's, so the cells belong to the parent:
+   'h' is a store on the heap for a view from apop_data_split, freed with the view, and
+   'v' is the handle that follows every store in memory, which the view macros like
+   Apop_r put in their views. Borrowed stores record the parent's pool, so a write via
+   any view can tell a pooled cell from one it may free, and the parent's store, so the
+   write can tell whether the parent still shares its grid with a copy. */
+struct apop_text_store {
+    int refs;
+    char *pool;
+    size_t poolsize;
+    char **cells;
+    char borrowed;
+    struct apop_text_store *owner;
+};
+
+static bool in_pool(char const *cell, char const *pool, size_t size){
+    return pool && cell >= pool && cell < pool + size;
+}
+
+//May this cell be freed on its own? Only if it isn't blank and isn't in the pool.
+static bool text_owns(apop_data const *d, char const *cell){
+    if (!cell || cell == apop_nul_string) return false;
+    return !d->textstore || !in_pool(cell, d->textstore->pool, d->textstore->poolsize);
+}
+
+//Fill in a new store and the view handle after it.
+static void text_store_set(struct apop_text_store *s, char *pool, size_t poolsize, char **cells){
+    s[0] = (struct apop_text_store){.refs=1, .pool=pool, .poolsize=poolsize, .cells=cells};
+    s[1] = (struct apop_text_store){.refs=1, .pool=pool, .poolsize=poolsize, .borrowed='v', .owner=s};
+}
+
+/* Is the grid a view looks at shared with a copy of the viewed set? Views never detach
+   their parent, so a write via such a view would reach the copy as well. */
+static bool text_parent_shared(struct apop_text_store *s){
+    if (!s || !s->borrowed) return false;
+    while (s && s->borrowed) s = s->owner;
+    return s && apop_ref_shared(&s->refs);
+}
+
+static struct apop_text_store *text_store_alloc(void){
+    struct apop_text_store *out = malloc(2*sizeof(struct apop_text_store));
+    Apop_stopif(!out, return NULL, 0, "malloc failed. Probably out of memory.");
+    text_store_set(out, NULL, 0, NULL);
+    return out;
+}
+
 static void apop_text_blank(apop_data *in, const size_t row, const size_t col){
-    if (in->text[row][col] != apop_nul_string) free(in->text[row][col]);
+    if (text_owns(in, in->text[row][col])) free(in->text[row][col]);
     in->text[row][col] = apop_nul_string;
 }
 
 /** Free a matrix of chars* (i.e., a char***).
-This is what \c apop_data_free uses internally to deallocate the \c text element of
-an \ref apop_data set. You may never need to use it directly.
+This is what \c apop_data_free uses internally to deallocate a classic \c text element of
+an \ref apop_data set, as built by \ref apop_text_alloc. You may never need to use it directly.
+Don't use it on the text of a set that has been through \ref apop_text_pack or
+\ref apop_data_copy; \ref apop_data_free knows how to free those.
 
 Sample usage:
 \code
@@ -135,6 +351,331 @@ void apop_text_free(char ***freeme, int rows, int cols){
     free(freeme);
 }
 
+//Drop d's hold on its text grid, freeing the grid if no other set shares it.
+static void text_release(apop_data *d){
+    struct apop_text_store *s = d->textstore;
+    if (s && s->borrowed){
+        if (s->borrowed == 'h') free(s);
+    } else if (!s || apop_ref_release(&s->refs)){
+        if (s && (s->pool || s->cells)){
+            for (size_t i=0; i < d->textsize[0]; i++){
+                for (size_t j=0; j < d->textsize[1]; j++)
+                    if (text_owns(d, d->text[i][j])) free(d->text[i][j]);
+                if (!s->cells) free(d->text[i]);
+            }
+            free(d->text);
+        } else apop_text_free(d->text, d->textsize[0], d->textsize[1]);
+        if (s){
+            free(s->pool);
+            free(s->cells);
+            free(s);
+        }
+    }
+    d->text = NULL;
+    d->textsize[0] = d->textsize[1] = 0;
+    d->textstore = NULL;
+}
+
+/* Builds a packed grid one cell at a time, in row-major order. The pool moves as it
+   grows, so cells are recorded as offsets and turned into pointers at the end.
+
+   With a dictionary, each column keeps a hash table of the strings it has seen, and a
+   repeated string is stored once. Under the adaptive setting a column drops its table
+   once more than half of the first thousand or so values turn out to be distinct. */
+typedef struct {
+    size_t *slots; //pool offset + 1; zero is empty.
+    size_t cap, count, seen;
+    bool off;
+} text_dict;
+
+struct apop_text_builder {
+    size_t cols, cellct, cellcap, poolsize, poolcap;
+    size_t *offsets;
+    char *pool;
+    char dictionary, error;
+    text_dict *dicts;
+};
+
+static const size_t text_null = (size_t)-1, text_blank = (size_t)-2;
+
+//Same as apop_name_hash (and so apop_settings_hash).
+static unsigned long text_hash(char const *str){
+    unsigned long int hash = 5381;
+    char c;
+    while ((c = *str++)) hash = hash*33 + c;
+    return hash;
+}
+
+apop_text_builder *apop_text_builder_alloc(size_t cols, char dictionary){
+    apop_text_builder *b = malloc(sizeof(apop_text_builder));
+    Apop_stopif(!b, return NULL, 0, "malloc failed. Probably out of memory.");
+    *b = (apop_text_builder){.cols=cols, .dictionary=dictionary};
+    if (dictionary != 'n') b->dicts = calloc(cols, sizeof(text_dict));
+    return b;
+}
+
+static size_t text_pool_add(apop_text_builder *b, char const *s, size_t len){
+    if (b->poolsize + len + 1 > b->poolcap){
+        size_t cap = GSL_MAX(2*b->poolcap, b->poolsize + len + 1);
+        cap = GSL_MAX(cap, 4096);
+        char *pool = realloc(b->pool, cap);
+        Apop_stopif(!pool, b->error='a'; return text_null, 0, "realloc failed growing a text pool to %zu bytes.", cap);
+        b->pool = pool;
+        b->poolcap = cap;
+    }
+    size_t out = b->poolsize;
+    memcpy(b->pool + out, s, len+1);
+    b->poolsize += len+1;
+    return out;
+}
+
+static void text_dict_grow(text_dict *t, char const *pool){
+    size_t cap = t->cap ? 2*t->cap : 64;
+    size_t *slots = calloc(cap, sizeof(size_t));
+    Apop_stopif(!slots, t->off=true; free(t->slots); t->slots=NULL; return,
+            0, "Couldn't grow a text dictionary; storing this column without one.");
+    for (size_t i=0; i< t->cap; i++)
+        if (t->slots[i]){
+            size_t k = text_hash(pool + t->slots[i]-1) & (cap-1);
+            while (slots[k]) k = (k+1) & (cap-1);
+            slots[k] = t->slots[i];
+        }
+    free(t->slots);
+    t->slots = slots;
+    t->cap = cap;
+}
+
+static size_t text_dict_add(apop_text_builder *b, text_dict *t, char const *s){
+    size_t len = strlen(s);
+    if (t->off) return text_pool_add(b, s, len);
+    if (b->dictionary == 'a' && t->seen++ >= 1024 && t->count > t->seen/2){
+        t->off = true;
+        free(t->slots);
+        t->slots = NULL;
+        return text_pool_add(b, s, len);
+    }
+    if (2*(t->count+1) > t->cap) text_dict_grow(t, b->pool);
+    if (t->off) return text_pool_add(b, s, len);
+    size_t k = text_hash(s) & (t->cap-1);
+    for ( ; t->slots[k]; k = (k+1) & (t->cap-1))
+        if (!strcmp(b->pool + t->slots[k]-1, s)) return t->slots[k]-1;
+    size_t out = text_pool_add(b, s, len);
+    if (out != text_null){
+        t->slots[k] = out+1;
+        t->count++;
+    }
+    return out;
+}
+
+//Add the next cell. NULL is kept as NULL, and "" becomes apop_nul_string.
+void apop_text_builder_add(apop_text_builder *b, char const *s){
+    if (b->error) return;
+    if (b->cellct == b->cellcap){
+        size_t cap = GSL_MAX(2*b->cellcap, 1024);
+        size_t *offsets = realloc(b->offsets, sizeof(size_t)*cap);
+        Apop_stopif(!offsets, b->error='a'; return, 0, "realloc failed growing a text grid to %zu cells.", cap);
+        b->offsets = offsets;
+        b->cellcap = cap;
+    }
+    size_t col = b->cellct % b->cols;
+    b->offsets[b->cellct++] = !s ? text_null
+                            : !*s ? text_blank
+                            : b->dicts ? text_dict_add(b, b->dicts+col, s)
+                                       : text_pool_add(b, s, strlen(s));
+}
+
+/* Install the built grid as d's text, replacing whatever d had, and free the builder.
+   A partly filled last row is padded with blanks. */
+void apop_text_builder_finish(apop_text_builder *b, apop_data *d){
+    if (!b) return;
+    text_release(d);
+    if (b->dicts) for (size_t i=0; i< b->cols; i++) free(b->dicts[i].slots);
+    free(b->dicts);
+    b->dicts = NULL;
+    Apop_stopif(b->error, d->error='a'; free(b->offsets); free(b->pool); free(b); return,
+            0, "Allocation error building a text grid.");
+    while (b->cols && b->cellct % b->cols) apop_text_builder_add(b, "");
+    size_t rows = b->cols ? b->cellct/b->cols : 0;
+    if (!rows){
+        free(b->offsets); free(b->pool); free(b);
+        return;
+    }
+    char *pool = b->pool;
+    if (!b->poolsize){
+        free(pool);
+        pool = NULL;
+    } else if (b->poolsize < b->poolcap){ //give back the slack
+        char *shrunk = realloc(pool, b->poolsize);
+        if (shrunk) pool = shrunk;
+    }
+    struct apop_text_store *s = text_store_alloc();
+    char **cells = malloc(sizeof(char*) * b->cellct);
+    d->text = malloc(sizeof(char**) * rows);
+    Apop_stopif(!s || !cells || !d->text, d->error='a'; free(s); free(cells); free(d->text); d->text=NULL;
+                free(pool); free(b->offsets); free(b); return,
+            0, "malloc failed setting up a %zu x %zu text grid.", rows, b->cols);
+    for (size_t i=0; i< b->cellct; i++)
+        cells[i] = b->offsets[i] == text_null  ? NULL
+                 : b->offsets[i] == text_blank ? apop_nul_string
+                                               : pool + b->offsets[i];
+    for (size_t i=0; i< rows; i++) d->text[i] = cells + i*b->cols;
+    text_store_set(s, pool, b->poolsize, cells);
+    d->textstore = s;
+    d->textsize[0] = rows;
+    d->textsize[1] = b->cols;
+    free(b->offsets);
+    free(b);
+}
+
+/** Repack the text of a data set into one block of memory.
+
+By default, every cell of an \ref apop_data set's text grid is a separately allocated
+string, and every row a separately allocated array. For a large grid, that is a lot of
+small allocations, with the overhead and poor locality that implies. This function
+moves all of the strings into a single pool and all of the rows into a single block,
+so the whole grid takes three allocations. You still read the text as usual, via
+<tt>your_data->text[row][col]</tt>.
+
+\li With dictionary encoding, each string that repeats within a column is stored only
+once, and every cell holding it points to that one copy. This is a large saving for
+categorical columns with few distinct values.
+\li You can keep writing to the set via \ref apop_text_set and \ref apop_text_alloc, or
+use it anywhere else in the library. Cells you overwrite are allocated individually,
+as usual; the pool is freed with the set.
+\li Don't <tt>free</tt> or <tt>realloc</tt> individual cells or rows of a packed grid
+yourself, and don't use \ref apop_text_free on it; \ref apop_data_free knows what to do.
+\li The text returned by \ref apop_query_to_text and \ref apop_query_to_mixed_data
+(for SQLite) is already packed, using <tt>dictionary='a'</tt>.
+
+\param d The data set whose text is to be packed. If \c NULL or without text, this is a no-op.
+\param dictionary If \c 'y', store each distinct string in a column only once. If \c 'n',
+don't try. If \c 'a', use a dictionary for each column until it becomes clear that the
+column is mostly distinct values. (default: \c 'a')
+\return The input data set, now with packed text.
+\exception d->error='a' Allocation error.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data *apop_text_pack(apop_data *d, char dictionary){
+    apop_data * apop_varad_var(d, NULL);
+    char apop_varad_var(dictionary, 'a');
+APOP_VAR_ENDHEAD
+    if (!d || !d->textsize[0] || !d->textsize[1]) return d;
+    apop_text_builder *b = apop_text_builder_alloc(d->textsize[1], dictionary);
+    Apop_stopif(!b, d->error='a'; return d, 0, "Allocation error.");
+    for (size_t i=0; i< d->textsize[0]; i++)
+        for (size_t j=0; j< d->textsize[1]; j++)
+            apop_text_builder_add(b, d->text[i][j]);
+    apop_text_builder_finish(b, d);
+    return d;
+}
+
+/* Give out a copy of in's text, packed. If in has its own pool, copy the pool in one go
+   and rebase the cells pointing into it, keeping any dictionary encoding; else (including
+   for views, which may cover only a few rows of their parent's pool) pack afresh. */
+static void text_copy(apop_data *out, apop_data const *in){
+    struct apop_text_store const *s = in->textstore;
+    size_t rows = in->textsize[0], cols = in->textsize[1];
+    if (!s || !s->pool || s->borrowed){
+        apop_text_builder *b = apop_text_builder_alloc(cols, 'n');
+        Apop_stopif(!b, out->error='a'; return, 0, "Allocation error.");
+        for (size_t i=0; i< rows; i++)
+            for (size_t j=0; j< cols; j++)
+                apop_text_builder_add(b, in->text[i][j]);
+        apop_text_builder_finish(b, out);
+        return;
+    }
+    struct apop_text_store *t = text_store_alloc();
+    char *pool = malloc(s->poolsize);
+    char **cells = malloc(sizeof(char*) * rows * cols);
+    char ***text = malloc(sizeof(char**) * rows);
+    Apop_stopif(!t || !pool || !cells || !text, out->error='a'; free(t); free(pool); free(cells); free(text); return,
+            0, "malloc failed copying a %zu x %zu text grid.", rows, cols);
+    memcpy(pool, s->pool, s->poolsize);
+    for (size_t i=0; i< rows; i++){
+        text[i] = cells + i*cols;
+        for (size_t j=0; j< cols; j++){
+            char *c = in->text[i][j];
+            text[i][j] = in_pool(c, s->pool, s->poolsize) ? pool + (c - s->pool)
+                       : text_owns(in, c)                 ? strdup(c)
+                                                          : c;
+        }
+    }
+    text_store_set(t, pool, s->poolsize, cells);
+    text_release(out);
+    out->text = text;
+    out->textstore = t;
+    out->textsize[0] = rows;
+    out->textsize[1] = cols;
+}
+
+/* Give d its own copy of a text grid it shares with copies; see apop_data_copy and the
+   notes on reference counting in apop_name.c. */
+void apop_text_unshare(apop_data *d){
+    if (!d || !d->textstore || !apop_ref_shared(&d->textstore->refs)) return;
+    apop_data held = {.text=d->text, .textsize={d->textsize[0], d->textsize[1]}, .textstore=d->textstore};
+    d->text = NULL;
+    d->textstore = NULL;
+    d->textsize[0] = d->textsize[1] = 0;
+    text_copy(d, &held);
+    text_release(&held);
+}
+
+//Give a view from apop_data_split its own copy of the grid, so it can be resized.
+static void text_own_view(apop_data *d){
+    struct apop_text_store *s = d->textstore;
+    if (!s || s->borrowed != 'h') return;
+    apop_data held = {.text=d->text, .textsize={d->textsize[0], d->textsize[1]}, .textstore=s};
+    d->text = NULL;
+    d->textstore = NULL;
+    d->textsize[0] = d->textsize[1] = 0;
+    text_copy(d, &held);
+    free(s);
+}
+
+/** \cond doxy_ignore */
+//For the view macros, like Apop_r: the handle a view of d carries, so writes via the view know d's pool.
+struct apop_text_store *apop_text_view_store(apop_data const *d){
+    struct apop_text_store *s = d->textstore;
+    return !s || s->borrowed == 'v' ? s : s+1;
+}
+/** \endcond */
+
+//Give each row of a packed grid its own array, so rows can be realloced.
+static void text_unpack_rows(apop_data *d){
+    struct apop_text_store *s = d->textstore;
+    if (!s || !s->cells) return;
+    for (size_t i=0; i< d->textsize[0]; i++){
+        char **row = malloc(sizeof(char*) * d->textsize[1]);
+        Apop_stopif(!row, d->error='a'; return, 0, "malloc failed copying out row %zu of a text grid.", i);
+        memcpy(row, d->text[i], sizeof(char*) * d->textsize[1]);
+        d->text[i] = row;
+    }
+    free(s->cells);
+    s->cells = NULL;
+}
+
+/** \ref apop_data_copy shares the row names and text of the input with the copy, and
+each set gets its own copy of the shared part the first time it is written to via \ref
+apop_text_set, \ref apop_name_add, or any other function in this library. 
+
+Views, like <tt>Apop_r(d, 3)</tt>, look directly at the text and row names of the set
+they view, and making a view never changes the viewed set, so reading through views of
+a copy costs nothing extra. But a view can't give its parent a copy of its own, so
+writing via a view of a set that shares text or row names with a copy would write to
+the copy as well. Call this function on the parent set before writing through views
+into its text or row names, to give the set (and its subsequent pages) its own copies
+of anything still shared. \ref apop_text_set refuses to write via a view whose parent
+still shares its text; row names written directly through a view can't be checked.
+
+\exception d->error='a' Allocation error.
+*/
+void apop_data_unshare(apop_data *d){
+    for ( ; d; d = d->more){
+        apop_text_unshare(d);
+        apop_name_unshare_rows(d->names);
+    }
+}
+
 /** Free the elements of the given \ref apop_data set and then the \ref apop_data set
   itself. Intended to be used by \ref apop_data_free, a macro that calls this to free
   elements, then sets the value to \c NULL.
@@ -165,7 +706,7 @@ char apop_data_free_base(apop_data *freeme){
     if (freeme->weights)
         gsl_vector_free(freeme->weights);
     apop_name_free(freeme->names);
-    apop_text_free(freeme->text, freeme->textsize[0] , freeme->textsize[1]);
+    text_release(freeme);
     free(freeme);
     return 0;
 }
@@ -231,6 +772,7 @@ void apop_data_memcpy(apop_data *out, const apop_data *in){
     }
     if (in->names){
         if (!out->names) out->names = apop_name_alloc();
+        if (in->names->rowct) apop_name_unshare_rows(out->names);
         Asprintf(&out->names->title, "%s", in->names->title);
         if (out->names->vector && in->names->vector) {Asprintf(&out->names->vector, "%s", in->names->vector);}
         for (int i=0; i< in->names->rowct; i++)
@@ -243,6 +785,7 @@ void apop_data_memcpy(apop_data *out, const apop_data *in){
             if (i< out->names->textct) {Asprintf(out->names->text+i, "%s", in->names->text[i]);}
             else  apop_name_add(out->names, in->names->text[i], 't');
     }
+    if (in->textsize[0] && in->textsize[1]) apop_text_unshare(out);
     out->textsize[0] = in->textsize[0]; 
     out->textsize[1] = in->textsize[1]; 
     if (in->textsize[0] && in->textsize[1]){
@@ -266,6 +809,13 @@ void apop_data_memcpy(apop_data *out, const apop_data *in){
 Basically a front-end for \ref apop_data_memcpy for those who prefer this sort of syntax. 
 
 If the data set has a \c more pointer, that will be followed and subsequent pages copied as well.
+
+\li The numeric parts are copied immediately. The text grid and the row names are
+shared with the input until either set writes to them, so copying a set with millions
+of text cells or row names costs no more than copying its numbers. Writing via \ref
+apop_text_set, \ref apop_name_add, or the other functions of this library gives the
+written-to set its own copy first, so the two sets behave as fully independent. The
+exception is writing through a view, like <tt>Apop_r(d, 2)</tt>; see \ref apop_data_unshare.
  
   \param in    the input data
   \return       a structure that this function will allocate and fill. If input is NULL, then this will be NULL.
@@ -309,11 +859,20 @@ apop_data *apop_data_copy(const apop_data *in){
         out->weights = gsl_vector_alloc(in->weights->size);
         Apop_stopif(!out->weights, out->error='a'; return out, 0, "Allocation error on weights vector of size %zu.", in->weights->size);
     }
+    if (in->vector) gsl_vector_memcpy(out->vector, in->vector);
+    if (in->matrix) gsl_matrix_memcpy(out->matrix, in->matrix);
+    if (in->weights) gsl_vector_memcpy(out->weights, in->weights);
+    if (in->names) apop_name_copy_to(out->names, in->names);
     if (in->textsize[0] && in->textsize[1]){
-        apop_text_alloc(out, in->textsize[0], in->textsize[1]);
+        if (in->textstore && !in->textstore->borrowed){
+            apop_ref_add(&in->textstore->refs);
+            out->text = in->text;
+            out->textstore = in->textstore;
+            out->textsize[0] = in->textsize[0];
+            out->textsize[1] = in->textsize[1];
+        } else text_copy(out, in);
         Apop_stopif(out->error, return out, 0, "Allocation error on text grid of size %zu X %zu.", in->textsize[0], in->textsize[1]);
     }
-    apop_data_memcpy(out, in);
     return out;
 }
 
@@ -327,6 +886,9 @@ For the opposite operation, see \ref apop_data_split.
     if 'c', stack columns of m1 to left of m2's<br>
     (default = 'r')
 \param  inplace If \c 'y', use \ref apop_matrix_realloc and \ref apop_vector_realloc to modify \c m1 in place. Otherwise, allocate a new \ref apop_data set, leaving \c m1 undisturbed. (default='n')
+    Those functions leave spare room when a set grows by rows, so repeatedly stacking
+    batches of rows onto one set in place takes time proportional to the rows added, not
+    to the size of the set. Stacking columns in place reallocates the matrix once.
 \return         The stacked data, either in a new \ref apop_data set or \c m1
 \exception out->error=='a' Allocation error.
 \exception out->error=='d'  Dimension error; couldn't make a complete copy.
@@ -374,19 +936,33 @@ APOP_VAR_ENDHEAD
     if (m2->names && !out->names) out->names = apop_name_alloc();
     
     if (posn == 'c'){
-        if (m2->vector && out->vector){
-            gsl_matrix_view mview = gsl_matrix_view_vector(m2->vector, m2->vector->size, 1);
-            out->matrix = apop_matrix_stack(out->matrix, &mview.matrix, posn, .inplace='y');
-            apop_name_stack(out->names, m2->names, 'c', 'v');
-            if (m2->names && !m2->names->vector && m2->names->colct) apop_name_add(out->names, "v", 'c');
+        //m2's vector (if out has one already) and matrix become new columns, in one reallocation.
+        bool vector_col = m2->vector && out->vector;
+        size_t extra = vector_col + (m2->matrix ? m2->matrix->size2 : 0);
+        size_t rows = m2->matrix ? m2->matrix->size1 : vector_col ? m2->vector->size : 0;
+        if (extra){
+            Apop_stopif((out->matrix && out->matrix->size1 != rows) || (vector_col && m2->vector->size != rows),
+                    out->error='d'; return out, 0, "When stacking side by side, the columns must all "
+                    "have the same number of rows, but the first set has %zu and the second has %zu.",
+                    out->matrix ? out->matrix->size1 : out->vector->size, rows);
+            size_t base = out->matrix ? out->matrix->size2 : 0;
+            out->matrix = apop_matrix_realloc(out->matrix, rows, base + extra);
+            Apop_stopif(!out->matrix, out->error='a'; return out, 0, "Allocation error widening the matrix.");
+            if (vector_col){
+                gsl_matrix_set_col(out->matrix, base++, m2->vector);
+                apop_name_stack(out->names, m2->names, 'c', 'v');
+                if (m2->names && !m2->names->vector && m2->names->colct) apop_name_add(out->names, "v", 'c');
+            }
+            if (m2->matrix){
+                gsl_matrix_view dest = gsl_matrix_submatrix(out->matrix, 0, base, rows, m2->matrix->size2);
+                gsl_matrix_memcpy(&dest.matrix, m2->matrix);
+            }
         }
         if (m2->vector && !out->vector) {
             out->vector= apop_vector_copy(m2->vector);
             if (m2->names->vector) apop_name_add(out->names, m2->names->vector, 'v');
         }
-    }
-
-    out->matrix = apop_matrix_stack(out->matrix, m2->matrix, posn, .inplace='y');
+    } else out->matrix = apop_matrix_stack(out->matrix, m2->matrix, posn, .inplace='y');
 
 
     if (posn == 'r'){
@@ -434,6 +1010,78 @@ APOP_VAR_ENDHEAD
     return out;
 }
 
+/* For apop_data_split(..., .view='y'): a heap-allocated view of rows [r0, r0+rowct)
+   and matrix columns [c0, c0+colct) of in, plus the vector and text if asked. The
+   gsl structs are views (owner=0), so gsl_*_free frees only the struct; the row names
+   and text are marked borrowed, so apop_data_free leaves the parent's alone. */
+static apop_data *data_view(apop_data *in, size_t r0, size_t rowct, size_t c0, size_t colct,
+                                                            bool with_vector, bool with_text){
+    size_t vsize = in->vector ? in->vector->size : 0,
+           msize1 = in->matrix ? in->matrix->size1 : 0;
+    apop_data *out = apop_data_alloc();
+    Apop_stopif(out->error, return out, 0, "Allocation error.");
+    if (with_vector && vsize > r0){
+        out->vector = malloc(sizeof(gsl_vector));
+        *out->vector = gsl_vector_subvector(in->vector, r0, GSL_MIN(rowct, vsize - r0)).vector;
+    }
+    if (colct && msize1 > r0){
+        out->matrix = malloc(sizeof(gsl_matrix));
+        *out->matrix = gsl_matrix_submatrix(in->matrix, r0, c0, GSL_MIN(rowct, msize1 - r0), colct).matrix;
+    }
+    if (in->weights && in->weights->size > r0){
+        out->weights = malloc(sizeof(gsl_vector));
+        *out->weights = gsl_vector_subvector(in->weights, r0, GSL_MIN(rowct, in->weights->size - r0)).vector;
+    }
+    if (in->names){
+        apop_name *n = out->names, *parent = in->names;
+        if (parent->title) apop_name_add(n, parent->title, 'h');
+        if (with_vector) apop_name_add(n, parent->vector, 'v');
+        for (size_t i=c0; i< c0+colct && i< (size_t)parent->colct; i++)
+            apop_name_add(n, parent->col[i], 'c');
+        if (with_text) apop_name_stack(n, parent, 't');
+        if ((size_t)parent->rowct > r0){
+            n->row = parent->row + r0;
+            n->rowhash = parent->rowhash ? parent->rowhash + r0 : NULL;
+            n->rowct = GSL_MIN(rowct, parent->rowct - r0);
+            n->borrowed = 1;
+        }
+    }
+    if (with_text && in->textsize[0] > r0 && in->textsize[1]){
+        struct apop_text_store *parent = in->textstore;
+        out->textstore = text_store_alloc();
+        Apop_stopif(!out->textstore, out->error='a'; return out, 0, "Allocation error.");
+        if (parent) text_store_set(out->textstore, parent->pool, parent->poolsize, NULL);
+        out->textstore->borrowed = 'h';
+        out->textstore->owner = parent;
+        out->text = in->text + r0;
+        out->textsize[0] = GSL_MIN(rowct, in->textsize[0] - r0);
+        out->textsize[1] = in->textsize[1];
+    }
+    return out;
+}
+
+//apop_data_split with .view='y'. The cases follow the copying version below.
+static apop_data **split_views(apop_data *in, int splitpoint, char r_or_c, apop_data **out){
+    Get_vmsizes(in); //vsize, msize1, msize2, maxsize
+    size_t height = GSL_MAX(maxsize, in->textsize[0]);
+    if (in->weights) height = GSL_MAX(height, in->weights->size);
+    if (r_or_c == 'r' || r_or_c == 'R'){
+        size_t s = splitpoint < 0 ? 0 : GSL_MIN((size_t)splitpoint, height);
+        if (s > 0)      out[0] = data_view(in, 0, s, 0, msize2, true, true);
+        if (s < height) out[1] = data_view(in, s, height - s, 0, msize2, true, true);
+    } else if (r_or_c == 'c' || r_or_c == 'C'){
+        if (splitpoint <= -1)
+            out[1] = data_view(in, 0, height, 0, msize2, true, true);
+        else if (splitpoint >= msize2)
+            out[0] = data_view(in, 0, height, 0, msize2, true, true);
+        else {
+            out[0] = data_view(in, 0, height, 0, splitpoint, true, false);
+            out[1] = data_view(in, 0, height, splitpoint, msize2 - splitpoint, false, false);
+        }
+    } else Apop_notify(0, "Please set r_or_c == 'r' or == 'c'. Returning two NULLs.");
+    return out;
+}
+
 /** Split one input \ref apop_data structure into two.
 
  For the opposite operation, see \ref apop_data_stack.
@@ -454,13 +1102,33 @@ size, \c splitpoint will equal the number of rows/columns in the first matrix.
  \li The \c more pointer is ignored.
  \li The <tt>apop_data->vector</tt> is taken to be the -1st element of the matrix.  
  \li Weights will be preserved. If splitting by rows, then the top and bottom parts of the weights vector will be assigned to the top and bottom parts of the main data set. If splitting by columns, identical copies of the weights vector will be assigned to both parts.
- \li Data is copied, so you may want to call <tt>apop_data_free(in)</tt> after this.
+ \li Data is copied, so you may want to call <tt>apop_data_free(in)</tt> after this, unless you ask for views.
+
+\param view If \c 'y', the two output sets are views into \c in, as with \ref Apop_rs, except
+ that they are allocated on the heap. Nothing is copied: the numbers, the text, and the row
+ names of the outputs are slices of those in \c in, and writing to an element of a view
+ writes to \c in; if \c in shares text or row names with a copy, call \ref
+ apop_data_unshare on it before writing through the views. Column and vector names,
+ which are short, are copied. Free the views with
+ \ref apop_data_free as usual, which leaves \c in intact, and free \c in only after
+ you are done with its views. A view can't be resized in place (\ref apop_text_alloc and
+ adding row names give it its own copy of the text or names first); use \ref
+ apop_data_copy to get an independent set. If splitting by columns, text is not
+ included, except when one side gets the whole set. (default: \c 'n')
+
+ \li This function uses the \ref designated syntax for inputs.
  */
-apop_data ** apop_data_split(apop_data *in, int splitpoint, char r_or_c){
+APOP_VAR_HEAD apop_data ** apop_data_split(apop_data *in, int splitpoint, char r_or_c, char view){
+    apop_data * apop_varad_var(in, NULL);
+    int apop_varad_var(splitpoint, 0);
+    char apop_varad_var(r_or_c, 'r');
+    char apop_varad_var(view, 'n');
+APOP_VAR_ENDHEAD
     //A long, dull series of contingencies. Bonus: a reasonable use of goto.
     apop_data   **out   = malloc(2*sizeof(apop_data *));
     out[0] = out[1] = NULL;
     Apop_stopif(!in, return out, 1, "input was NULL; output will be an array of two NULLs.");
+    if (view == 'y' || view == 'Y') return split_views(in, splitpoint, r_or_c, out);
     gsl_vector v1, v2, w1, w2;
     gsl_matrix m1, m2;
     int set_v1 = 1, set_v2 = 1,
@@ -969,7 +1637,8 @@ void apop_data_add_names_base(apop_data *d, const char type, char const ** names
 \param fmt The text to write.
 \param ... You can use a printf-style fmt and follow it with the usual variables to fill in.
 
-\return 0=OK, -1=error (probably out-of-bounds)
+\return 0=OK, -1=error (probably out-of-bounds, or a write via a view of a set that
+shares its text with a copy; see \ref apop_data_unshare)
 
   \li UTF-8 or ASCII text is correctly handled.
   \li Apophenia follows a general rule of not reallocating behind your back: if
@@ -997,7 +1666,11 @@ int apop_text_set(apop_data *in, const size_t row, const size_t col, const char
     Apop_stopif((in->textsize[0] < (int)row+1) || (in->textsize[1] < (int)col+1), return -1, 0, "You asked me to put the text "
                             " '%s' at position (%zu, %zu), but the text array has size (%zu, %zu)\n", 
                                fmt,             row, col,                  in->textsize[0], in->textsize[1]);
-    if (in->text[row][col] != apop_nul_string) free(in->text[row][col]);
+    Apop_stopif(text_parent_shared(in->textstore), return -1, 0, "You asked me to write text via a view "
+                            "of a data set that shares its text with a copy, which would change the copy as well. "
+                            "Call apop_data_unshare on the viewed set first.");
+    apop_text_unshare(in);
+    if (text_owns(in, in->text[row][col])) free(in->text[row][col]);
     if (!fmt){
         Asprintf(&(in->text[row][col]), "%s", apop_opts.nan_string);
         return 0;
@@ -1024,12 +1697,15 @@ apop_data * apop_text_alloc(apop_data *in, const size_t row, const size_t col){
     Apop_stopif((!row && col) || (!col && row), return in, 1, "Not allocating a %zu x %zu text grid. "
                                             "Returning the input apop_data set.", row, col);
     if (!in) in  = apop_data_alloc();
+    apop_text_unshare(in);
+    text_own_view(in);
     if (!in->text){
         if (row){
             in->text = malloc(sizeof(char**) * row);
             Apop_stopif(!in->text, in->error='a'; return in, 
                     0, "malloc failed setting up %zu rows. Probably out of memory.", row);
         }
+        if (!in->textstore) in->textstore = text_store_alloc();
         if (row && col)
             for (size_t i=0; i< row; i++){
                 in->text[i] = malloc(sizeof(char*) * col);
@@ -1041,10 +1717,11 @@ apop_data * apop_text_alloc(apop_data *in, const size_t row, const size_t col){
     } else { //realloc
         size_t rows_now = in->textsize[0];
         size_t cols_now = in->textsize[1];
+        if (rows_now != row || cols_now != col) text_unpack_rows(in);
         if (rows_now > row){
             for (int i=row; i < rows_now; i++){
                 for (int j=0; j < cols_now; j++)
-                    if (in->text[i][j] != apop_nul_string) 
+                    if (text_owns(in, in->text[i][j]))
                         free(in->text[i][j]);
                 free(in->text[i]);
             }
@@ -1068,7 +1745,7 @@ apop_data * apop_text_alloc(apop_data *in, const size_t row, const size_t col){
         if (cols_now > col)
             for (int i=0; i < row; i++)
                 for (int j=col; j < cols_now; j++)
-                    if (in->text[i][j]!=apop_nul_string) 
+                    if (text_owns(in, in->text[i][j]))
                         free(in->text[i][j]);
         if (cols_now != col)
             for (int i=0; i < row; i++){
@@ -1131,9 +1808,13 @@ APOP_VAR_ENDHEAD
             }
         }
         if (out->names){
+            apop_name_unshare_rows(out->names);
             char **tmp = out->names->col;
             out->names->col = out->names->row;
             out->names->row = tmp;
+            unsigned long *tmphash = out->names->colhash;
+            out->names->colhash = out->names->rowhash;
+            out->names->rowhash = tmphash;
             int tmpct = out->names->colct;
             out->names->colct = out->names->rowct;
             out->names->rowct = tmpct;
@@ -1145,6 +1826,8 @@ APOP_VAR_ENDHEAD
     }
     if (transpose_text!='y' || in->textsize[0] == 0 || in->textsize[1] == 0) return out;
     if (inplace=='y'){
+        apop_text_unshare(in);
+        text_unpack_rows(in);
         size_t orows = in->textsize[0];
         size_t ocols = in->textsize[1];
         if (orows > ocols){ //extend the first ocols rows to their now-longer length
@@ -1198,9 +1881,10 @@ APOP_VAR_ENDHEAD
 
 Data in the matrix will be retained. If the new height or width is smaller than the old, then data in the later rows/columns will be cropped away (in a non--memory-leaking manner). If the new height or width is larger than the old, then new cells will be filled with garbage; it is your responsibility to zero out or otherwise fill new rows/columns before use.
 
-  \li A large number of <tt>realloc</tt>s can take a noticeable amount of time. You
-are encouraged to determine the size of your data beforehand and avoid writing \c for
-loops that reallocate the matrix at every iteration.
+  \li When rows are added at an unchanged width, the matrix grows its underlying
+block by at least half again, so a loop that appends a few rows at a time, as with
+<tt>apop_data_stack(d, new_rows, .inplace='y')</tt>, reallocates only occasionally and
+takes time proportional to the rows added. Shrinking releases the unused space.
   \li The <tt>gsl_matrix</tt> is a versatile struct that can represent submatrices and
 other cuts from parent data. Resizing a subset of a parent matrix makes no sense,
 so return \c NULL and print a warning if asked to resize a view of a matrix.
@@ -1212,30 +1896,30 @@ so return \c NULL and print a warning if asked to resize a view of a matrix.
 gsl_matrix * apop_matrix_realloc(gsl_matrix *m, size_t newheight, size_t newwidth){
     if (!m)
         return (newheight && newwidth) ?  gsl_matrix_alloc(newheight, newwidth) : NULL;
-    size_t i, oldoffset=0, newoffset=0, realloced = 0;
     Apop_stopif(m->block->data!=m->data || !m->owner || m->tda != m->size2,
             return NULL, 0, "I can't resize submatrices or other subviews.");
-    m->block->size = newheight * newwidth;
-    if (m->size2 > newwidth)
-        for (i=1; i< GSL_MIN(m->size1, newheight); i++){
-            oldoffset +=m->size2;
-            newoffset +=newwidth;
-            memmove(m->data+newoffset, m->data+oldoffset, sizeof(double)*newwidth);
-        } 
-    else if (m->size2 < newwidth){
-        m->block->data = m->data = realloc(m->data, sizeof(double) * m->block->size);
-        realloced = 1;
-        int height = GSL_MIN(m->size1, newheight);
-        for (i= height-1; i > 0; i--){
-            newoffset +=newwidth;
-            memmove(m->data+(height * newwidth) - newoffset, m->data+i*m->size2, sizeof(double)*m->size2);
-        }
+    size_t oldwidth = m->size2, height = GSL_MIN(m->size1, newheight);
+    size_t need = newheight * newwidth, cap = m->block->size, newcap = cap;
+    if (newwidth < oldwidth) //narrow rows front to back, before any shrinking realloc.
+        for (size_t i=1; i< height; i++)
+            memmove(m->data + i*newwidth, m->data + i*oldwidth, sizeof(double)*newwidth);
+    if (need > cap)
+        newcap = (newwidth == oldwidth) ? GSL_MAX(need, (cap + cap/2 + newwidth - 1)/newwidth*newwidth)
+                                        : need;
+    else if (need < m->size1 * oldwidth)
+        newcap = need;
+    if (newcap != cap){
+        double *data = realloc(m->data, sizeof(double) * newcap);
+        Apop_stopif(newcap && !data, return NULL, 0, "realloc to %zu elements failed. Probably out of memory.", newcap);
+        m->block->data = m->data = data;
+        m->block->size = newcap;
     }
+    if (newwidth > oldwidth) //widen rows back to front, after any growing realloc.
+        for (size_t i=height; i-- > 1; )
+            memmove(m->data + i*newwidth, m->data + i*oldwidth, sizeof(double)*oldwidth);
     m->size1 = newheight;
     m->tda   =
     m->size2 = newwidth;
-    if (!realloced)
-        m->block->data = m->data = realloc(m->data, sizeof(double) * m->block->size);
     return m;
 }
 
@@ -1247,9 +1931,9 @@ cropped away (in a non--memory-leaking manner). If the new height is larger than
 then new cells will be filled with garbage; it is your responsibility
 to zero out or otherwise fill them before use.
 
-  \li A large number of <tt>realloc</tt>s can take a noticeable amount of time. You
-are thus encouraged to make an effort to determine the size of your data and do one
-allocation, rather than writing \c for loops that resize a vector at every increment.
+  \li When the vector grows, its underlying block grows by at least half again, so
+a loop that appends a few elements at a time reallocates only occasionally and takes
+time proportional to the elements added. Shrinking releases the unused space.
   \li The <tt>gsl_vector</tt> is a versatile struct that
 can represent subvectors, matrix columns and other cuts from parent data. 
 Resizing a portion of a parent matrix makes no sense, so
@@ -1263,10 +1947,16 @@ gsl_vector * apop_vector_realloc(gsl_vector *v, size_t newheight){
     if (!v) return newheight ? gsl_vector_alloc(newheight) : NULL;
     Apop_stopif(v->block->data!=v->data || !v->owner || v->stride != 1,
                     return NULL, 0, "I can't resize subvectors or other views.");
-    v->block->size = newheight;
+    size_t cap = v->block->size, newcap = cap;
+    if (newheight > cap)            newcap = GSL_MAX(newheight, cap + cap/2);
+    else if (newheight < v->size)   newcap = newheight;
+    if (newcap != cap){
+        double *data = realloc(v->data, sizeof(double) * newcap);
+        Apop_stopif(newcap && !data, return NULL, 0, "realloc to %zu elements failed. Probably out of memory.", newcap);
+        v->block->data = v->data = data;
+        v->block->size = newcap;
+    }
     v->size = newheight;
-    v->block->data = 
-    v->data        = realloc(v->data, sizeof(double) * v->block->size);
     return v;
 }
 
@@ -1377,6 +2067,147 @@ APOP_VAR_ENDHEAD
     } else return NULL;
 }
 
+/* Row compaction, for apop_data_rm_rows and apop_data_listwise_delete. Every part of a
+   set is compacted the same way: a kept row moves up to the count of kept rows above it,
+   and runs of consecutive kept rows move in one memmove. */
+
+//Slide the kept rows among the first n (each width doubles, stride apart) to the top.
+static size_t compact_doubles(double *data, size_t stride, size_t width, size_t n, int const *gone){
+    size_t out = 0;
+    for (size_t i=0; i < n; ){
+        if (gone[i]){ i++; continue; }
+        size_t end = i+1;
+        while (end < n && !gone[end]) end++;
+        if (out != i) memmove(data + out*stride, data + i*stride, sizeof(double)*((end-i-1)*stride + width));
+        out += end - i;
+        i = end;
+    }
+    return out;
+}
+
+/* Move the kept rows of a text grid to the top and the dropped rows below them, where
+   apop_text_alloc will free them. Only row pointers move. */
+static size_t compact_text_rows(char ***text, size_t n, int const *gone){
+    char ***dropped = malloc(sizeof(char**) * n);
+    Apop_stopif(!dropped, return n, 0, "malloc failed. Probably out of memory.");
+    size_t out = 0, dropct = 0;
+    for (size_t i=0; i < n; i++)
+        if (gone[i]) dropped[dropct++] = text[i];
+        else         text[out++] = text[i];
+    memcpy(text + out, dropped, sizeof(char**) * dropct);
+    free(dropped);
+    return out;
+}
+
+/* Keep the row names not marked in gone[0..n), and free the rest, including any past n.
+   A NULL gone frees them all. Returns the new count. */
+static int compact_row_names(apop_name *names, int const *gone, int n){
+    int out = 0;
+    for (int i=0; i < names->rowct; i++)
+        if (!gone || i >= n || gone[i]) free(names->row[i]);
+        else {
+            names->row[out] = names->row[i];
+            if (names->rowhash) names->rowhash[out] = names->rowhash[i];
+            out++;
+        }
+    return out;
+}
+
+/* A view's rows are its parent's, so they can't be compacted or trimmed. These are the
+   same tests apop_vector_realloc and apop_matrix_realloc make, plus text borrowed by a
+   row view. */
+static int rows_are_borrowed(apop_data const *d){
+    gsl_vector const *vs[] = {d->vector, d->weights};
+    for (int i=0; i < 2; i++)
+        if (vs[i] && (!vs[i]->owner || vs[i]->block->data != vs[i]->data || vs[i]->stride != 1))
+            return 1;
+    gsl_matrix const *m = d->matrix;
+    if (m && (!m->owner || m->block->data != m->data || m->tda != m->size2)) return 1;
+    return d->textstore && d->textstore->borrowed == 'v';
+}
+
+static gsl_vector *vector_trim(gsl_vector *v, size_t n){
+    if (!v) return NULL;
+    if (n) return apop_vector_realloc(v, n);
+    gsl_vector_free(v);
+    return NULL;
+}
+
+//Number of the (ascending) row numbers in from[0..ct) that are below limit.
+static size_t rows_below(size_t const *from, size_t ct, size_t limit){
+    size_t lo = 0, hi = ct;
+    while (lo < hi){
+        size_t mid = (lo + hi)/2;
+        if (from[mid] < limit) lo = mid+1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/* A new set holding the rows of in not marked in gone[0..len), in order. Only the kept
+   rows are copied: the list of source rows is built in one pass, then the numbers and
+   row names are gathered in parallel, and the text packed into a new pool. Later pages
+   are copied as they are. Used by apop_data_listwise_delete. */
+apop_data *apop_data_gather_rows(apop_data *in, int const *gone, size_t len){
+    Get_vmsizes(in); //vsize, wsize, msize1, msize2
+    size_t *from = malloc(sizeof(size_t) * GSL_MAX(len, 1));
+    apop_data *out = apop_data_alloc();
+    Apop_stopif(!from || out->error, free(from); out->error='a'; return out, 0, "Allocation error.");
+    size_t kept = 0;
+    for (size_t i=0; i < len; i++)
+        if (!gone[i]) from[kept++] = i;
+    size_t kv = rows_below(from, kept, vsize),
+           kw = rows_below(from, kept, wsize),
+           km = msize2 ? rows_below(from, kept, msize1) : 0,
+           kt = in->textsize[1] ? rows_below(from, kept, in->textsize[0]) : 0,
+           kn = in->names ? rows_below(from, kept, in->names->rowct) : 0;
+    if (kv) out->vector = gsl_vector_alloc(kv);
+    if (kw) out->weights = gsl_vector_alloc(kw);
+    if (km) out->matrix = gsl_matrix_alloc(km, msize2);
+    if (in->names){
+        apop_name *n = out->names;
+        if (in->names->title) Asprintf(&n->title, "%s", in->names->title);
+        apop_name_stack(n, in->names, 'v');
+        apop_name_stack(n, in->names, 'c');
+        apop_name_stack(n, in->names, 't');
+        if (kn){
+            n->row = malloc(sizeof(char*) * kn);
+            n->rowhash = malloc(sizeof(unsigned long) * kn);
+            n->rowrefs = malloc(sizeof(int));
+            Apop_stopif(!n->row || !n->rowhash || !n->rowrefs, out->error='a'; free(from); return out,
+                    0, "malloc failed. Probably out of memory.");
+            *n->rowrefs = 1;
+            n->rowct = kn;
+        }
+    }
+    Apop_stopif((kv && !out->vector) || (kw && !out->weights) || (km && !out->matrix),
+            out->error='a'; free(from); return out, 0, "Allocation error.");
+
+    OMP_for (size_t i=0; i < kept; i++){
+        size_t r = from[i];
+        if (i < kv) gsl_vector_set(out->vector, i, gsl_vector_get(in->vector, r));
+        if (i < kw) gsl_vector_set(out->weights, i, gsl_vector_get(in->weights, r));
+        if (i < km) memcpy(gsl_matrix_ptr(out->matrix, i, 0), gsl_matrix_const_ptr(in->matrix, r, 0),
+                                                                        sizeof(double)*msize2);
+        if (i < kn){
+            out->names->row[i] = strdup(in->names->row[r]);
+            out->names->rowhash[i] = in->names->rowhash ? in->names->rowhash[r]
+                                                        : text_hash(in->names->row[r]);
+        }
+    }
+    if (kt){
+        apop_text_builder *b = apop_text_builder_alloc(in->textsize[1], 'n');
+        Apop_stopif(!b, out->error='a'; free(from); return out, 0, "Allocation error.");
+        for (size_t i=0; i < kt; i++)
+            for (size_t j=0; j < in->textsize[1]; j++)
+                apop_text_builder_add(b, in->text[from[i]][j]);
+        apop_text_builder_finish(b, out);
+    }
+    free(from);
+    if (in->more) out->more = apop_data_copy(in->more);
+    return out;
+}
+
 typedef int (*apop_fn_ir)(apop_data*, void*);
 
 /** Remove the rows set to one in the \c drop vector or for which the \c do_drop function returns one.  
@@ -1407,6 +2238,12 @@ typedef int (*apop_fn_ir)(apop_data*, void*);
     NULL, I return without doing anything, and print a warning if <tt>apop_opts.verbose
     >=2</tt>. If you provide both, I will drop the row if either the vector has a one in
     that row's position, or if the function returns a nonzero value.
+\li Rows are compacted in one pass: each run of kept rows moves up in a single \c memmove,
+    and the vector, matrix, weights, and text are compacted in parallel if Apophenia
+    was compiled with OpenMP. The \c do_drop function is called on one row at a time.
+\li A view, such as one from \ref Apop_rs or \ref Apop_c, shares its rows with its
+    parent, so they can't be removed. If \c in is a view, I set <tt>in->error='v'</tt>
+    and return it with no changes made, to it or to its parent.
 \li This function uses the \ref designated syntax for inputs.
 \see \ref apop_data_listwise_delete, \ref apop_data_rm_columns
 */  
@@ -1420,37 +2257,54 @@ APOP_VAR_HEAD apop_data* apop_data_rm_rows(apop_data *in, int *drop, apop_fn_ir
             "indicating which rows to drop, nor a drop_fn I can use to test "
             "each row. Returning with no changes made.");
 APOP_VAR_ENDHEAD
-    //First, shift columns down to the nearest not-freed row.
-    int outlength = 0;
-    Get_vmsizes(in); //vsize, msize1, maxsize
-    for (int i=0 ; i < maxsize; i++){
-        int drop_row=0;
-        if (drop && drop[i]) drop_row = 1;
-        else if (do_drop){
-            drop_row = do_drop(Apop_r(in, i), drop_parameter);
-        }
-        if (!drop_row){
-            if (outlength != i) apop_data_memcpy(Apop_r(in, outlength), Apop_r(in, i));
-            outlength++;
-        }
+    Apop_stopif(rows_are_borrowed(in), in->error='v'; return in, 0, "The input is a view "
+            "of another data set, so I can't remove its rows. Returning with no changes made.");
+    Get_vmsizes(in); //maxsize
+    int *gone = drop;
+    if (do_drop){
+        gone = malloc(sizeof(int) * GSL_MAX(maxsize, 1));
+        Apop_stopif(!gone, in->error='a'; return in, 0, "malloc failed. Probably out of memory.");
+        for (int i=0; i < maxsize; i++)
+            gone[i] = (drop && drop[i]) || do_drop(Apop_r(in, i), drop_parameter);
     }
+    size_t outlength = 0;
+    for (int i=0; i < maxsize; i++) outlength += !gone[i];
+
     if (!outlength){
         gsl_vector_free(in->vector);  in->vector = NULL;
         gsl_vector_free(in->weights); in->weights = NULL;
         gsl_matrix_free(in->matrix);  in->matrix = NULL;
         apop_text_alloc(in, 0, 0);
         //leave colnames intact, remove rownames below.
+    } else {
+        //Rows are about to be shuffled, so first detach text shared with copies or borrowed from a parent.
+        apop_text_unshare(in);
+        text_own_view(in);
+        size_t kept[4] = {0};
+        OMP_for (int part=0; part < 4; part++){ //the parts are independent, so move them side by side.
+            if (part==0 && in->vector)
+                kept[0] = compact_doubles(in->vector->data, in->vector->stride, 1, vsize, gone);
+            if (part==1 && in->weights)
+                kept[1] = compact_doubles(in->weights->data, in->weights->stride, 1, GSL_MIN(wsize, maxsize), gone);
+            if (part==2 && in->matrix)
+                kept[2] = compact_doubles(in->matrix->data, in->matrix->tda, msize2, msize1, gone);
+            if (part==3 && in->text)
+                kept[3] = compact_text_rows(in->text, in->textsize[0], gone);
+        }
+        //now trim excess memory:
+        in->vector  = vector_trim(in->vector, kept[0]);
+        in->weights = vector_trim(in->weights, kept[1]);
+        if (in->matrix && !kept[2]){
+            gsl_matrix_free(in->matrix);
+            in->matrix = NULL;
+        } else if (in->matrix) apop_matrix_realloc(in->matrix, kept[2], msize2);
+        if (in->text) apop_text_alloc(in, kept[3], kept[3] ? in->textsize[1] : 0);
     }
-
-    //now trim excess memory:
-    if (in->vector)  apop_vector_realloc(in->vector, GSL_MIN(in->vector->size, outlength));
-    if (in->weights) apop_vector_realloc(in->weights, GSL_MIN(in->weights->size, outlength));
-    if (in->matrix)  apop_matrix_realloc(in->matrix, GSL_MIN(in->matrix->size1, outlength), in->matrix->size2);
-    if (in->text)    apop_text_alloc(in, GSL_MIN(outlength, in->textsize[0]), in->textsize[1]);
-    if (in->names && in->names->rowct > outlength){
-        for (int k=outlength; k< in->names->rowct; k++)
-            free(in->names->row[k]);
-        in->names->rowct = outlength;
+    if (in->names && in->names->rowct){ //likewise for row names
+        apop_name_own_rows(in->names);
+        apop_name_unshare_rows(in->names);
+        in->names->rowct = compact_row_names(in->names, outlength ? gone : NULL, maxsize);
     }
+    if (gone != drop) free(gone);
     return in;
 }
@@ -338,6 +338,165 @@ apop_data * apop_query_to_data(const char * fmt, ...){
 }
 
 
+/** \cond doxy_ignore */
+typedef struct {    //for apop_query_to_blocks.
+    size_t    block_rows, row;
+    int       namecol, error;
+    apop_data *block;
+    int       (*fn)(apop_data *, void *);
+    void      *aux;
+} block_query_t;
+/** \endcond */
+
+//Send the rows filled so far to the callback, via a view of the block.
+static int flush_block(block_query_t *bq){
+    if (!bq->row) return 0;
+    apop_data view = *bq->block;
+    gsl_matrix filled = gsl_matrix_submatrix(bq->block->matrix, 0, 0, bq->row, bq->block->matrix->size2).matrix;
+    view.matrix = &filled;
+    bq->row = 0;
+    return bq->fn(&view, bq->aux);
+}
+
+//apop_query_to_blocks callback.
+static int db_to_blocks(void *qinfo, int argc, char **argv, char **column){
+    Apop_stopif(!argv, return -1, apop_errorlevel, "Got NULL data from SQLite.");
+    block_query_t *bq = qinfo;
+    if (!bq->block){
+        for (int i=0; i<argc; i++)
+            if (apop_opts.db_name_column && !strcasecmp(column[i], apop_opts.db_name_column)){
+                bq->namecol = i;
+                break;
+            }
+        int cols = argc - (bq->namecol >= 0);
+        Apop_stopif(!cols, bq->error='d'; return 1, 0, "The query returned no numeric columns.");
+        bq->block = apop_data_alloc(bq->block_rows, cols);
+        for (int i=0; i<argc; i++)
+            if (bq->namecol != i)
+                apop_name_add(bq->block->names, column[i], 'c');
+    }
+    for (int jj=0, col=0; jj<argc; jj++)
+        if (jj != bq->namecol)
+            gsl_matrix_set(bq->block->matrix, bq->row, col++,
+                !argv[jj] || !strcmp(argv[jj], "NULL")|| 
+                (apop_opts.nan_string && !strcasecmp(apop_opts.nan_string, argv[jj]))
+                 ? GSL_NAN : atof(argv[jj]));
+    if (++bq->row == bq->block_rows) bq->error = flush_block(bq);
+	return bq->error;
+}
+
+/** Run a query and hand its output to a function one block of rows at a time, so
+  the full result never needs to be held in memory. Each block is an \ref apop_data set
+  whose \c matrix holds up to \c block_rows rows, with column names set as per \ref
+  apop_query_to_data. Blocks are views of a reused buffer, so copy anything you need
+  to keep.
+
+\param block_rows The number of rows in each block (the last block may be shorter).
+\param fn A function taking in a block and the \c aux pointer. Return zero to continue; any
+other value halts the query and is returned by this function.
+\param aux A pointer to be passed to \c fn along with each block, such as an \ref
+apop_lm_blocks accumulator to be filled via \ref apop_lm_blocks_add.
+\param fmt A <tt>printf</tt>-style SQL query.
+\return Zero on success; the nonzero return value of \c fn if it halted the query; -1 on query errors.
+
+\li Row names (per \ref apop_opts_type "apop_opts.db_name_column") are dropped.
+\li Blanks in the database (i.e., <tt> NULL</tt>s) and elements that match \ref
+    apop_opts_type "apop_opts.nan_string" are filled with <tt>NAN</tt>s in the matrix.
+\li With mySQL, the full result is read in and then sent to \c fn in blocks.
+*/
+int apop_query_to_blocks(size_t block_rows, int (*fn)(apop_data *block, void *aux), void *aux, const char * fmt, ...){
+    Fillin(query, fmt)
+    Apop_stopif(!fn || !block_rows, free(query); return -1, 0, "I need a function to call and a nonzero block size.");
+    if (!apop_opts.db_engine) get_db_type();
+    if (apop_opts.db_engine == 'm'){
+#ifdef HAVE_MYSQL
+        apop_data *d = apop_mysql_query_core(query, process_result_set_data);
+        free(query);
+        Apop_stopif(d && d->error, apop_data_free(d); return -1, 0, "Query error.");
+        int out = 0;
+        for (size_t i=0; d && !out && i< d->matrix->size1; i+=block_rows)
+            out = fn(Apop_rs(d, i, GSL_MIN(block_rows, d->matrix->size1 - i)), aux);
+        apop_data_free(d);
+        return out;
+#else
+        Apop_stopif(1, free(query); return -1, 0, "Apophenia was compiled without mysql support.");
+#endif
+    }
+    //else
+    char *err=NULL;
+    block_query_t bq = {.block_rows=block_rows, .namecol=-1, .fn=fn, .aux=aux};
+	if (db==NULL) apop_db_open(NULL);
+    sqlite3_exec(db, query, db_to_blocks, &bq, &err); 
+    if (!bq.error){
+        Apop_stopif(err, bq.error=-1, 0, "%s: %s", query, err);
+        if (!err) bq.error = flush_block(&bq);
+    }
+    sqlite3_free(err);
+    free(query);
+    apop_data_free(bq.block);
+	return bq.error;
+}
+
+static int crosstab_is_nan(char const *s){
+    return !s || (apop_opts.nan_string && !strcasecmp(apop_opts.nan_string, s));
+}
+
+/* For apop_db_to_crosstab: run a query giving (row label, column label, value) and feed
+each row to the builder. SQLite rows are read as typed values via sqlite3_step, so numeric
+labels can be sorted as numbers; mySQL results arrive as text, so a label is taken to be
+numeric if it parses as a number. Returns zero on success. */
+int apop_query_to_crosstab_builder(char const *query, apop_crosstab_builder *b){
+    Apop_stopif(!b, return -1, 0, "NULL crosstab builder.");
+    if (!apop_opts.db_engine) get_db_type();
+    if (apop_opts.db_engine == 'm'){
+#ifdef HAVE_MYSQL
+        apop_data *d = apop_mysql_query_core((char*)query, process_result_set_chars);
+        Apop_stopif(d && d->error, apop_data_free(d); return -1, 0, "Query error.");
+        Apop_stopif(d && d->textsize[1] < 3, apop_data_free(d); return -1, 0, "The crosstab query needs three columns.");
+        int err = 0;
+        for (size_t i=0; d && !err && i< d->textsize[0]; i++){
+            char const *labels[2] = {d->text[i][0], d->text[i][1]};
+            char kinds[2];
+            for (int k=0; k< 2; k++){
+                char *end;
+                strtod(labels[k], &end);
+                kinds[k] = crosstab_is_nan(labels[k]) ? 'n' : (*labels[k] && !*end) ? 'd' : 't';
+            }
+            err = apop_crosstab_builder_add(b, labels, kinds,
+                            crosstab_is_nan(d->text[i][2]) ? GSL_NAN : atof(d->text[i][2]));
+        }
+        apop_data_free(d);
+        return err;
+#else
+        Apop_stopif(1, return -1, 0, "Apophenia was compiled without mysql support.");
+#endif
+    }
+    if (db==NULL) apop_db_open(NULL);
+    sqlite3_stmt *stmt;
+    Apop_stopif(sqlite3_prepare_v2(db, query, -1, &stmt, NULL) != SQLITE_OK,
+            return -1, 0, "%s: %s", query, sqlite3_errmsg(db));
+    Apop_stopif(sqlite3_column_count(stmt) < 3, sqlite3_finalize(stmt); return -1,
+            0, "The crosstab query needs three columns.");
+    int err;
+    while ((err = sqlite3_step(stmt)) == SQLITE_ROW){
+        char const *labels[2];
+        char kinds[2];
+        for (int k=0; k< 2; k++){
+            int type = sqlite3_column_type(stmt, k);
+            kinds[k] = type == SQLITE_NULL ? 'n' : (type == SQLITE_INTEGER || type == SQLITE_FLOAT) ? 'd' : 't';
+            labels[k] = type == SQLITE_NULL ? XN(apop_opts.nan_string) : (char const*)sqlite3_column_text(stmt, k);
+        }
+        int type = sqlite3_column_type(stmt, 2);
+        double val = type == SQLITE_NULL ? GSL_NAN
+                   : type == SQLITE_TEXT && crosstab_is_nan((char const*)sqlite3_column_text(stmt, 2)) ? GSL_NAN
+                   : sqlite3_column_double(stmt, 2);
+        if (apop_crosstab_builder_add(b, labels, kinds, val)) break;
+    }
+    sqlite3_finalize(stmt);
+    Apop_stopif(err != SQLITE_DONE, return -1, 0, "%s: %s", query, sqlite3_errmsg(db));
+    return 0;
+}
+
     /** \cond doxy_ignore */
 //These used to do more, but I'll leave them as a macro anyway in case of future expansion.
 #define Store_settings  \
@@ -134,26 +134,20 @@ static void * process_result_set_vector (MYSQL *conn, MYSQL_RES *res_set) {
 static void * process_result_set_chars (MYSQL *conn, MYSQL_RES *res_set) {
     MYSQL_ROW row;
     unsigned int total_cols = mysql_num_fields(res_set);
-    unsigned int total_rows = mysql_num_rows(res_set);
 
     MYSQL_FIELD *fields = mysql_fetch_fields(res_set);
     int name_row = get_name_row(&total_cols, fields);
-    apop_data *out = apop_text_alloc(NULL, total_rows, total_cols);
+    apop_data *out = apop_data_alloc();
+    apop_text_builder *text = total_cols ? apop_text_builder_alloc(total_cols, 'a') : NULL;
 
     for (size_t i = 0; i < total_cols + (name_row>=0); i++)
         if (i!=name_row) apop_name_add(out->names, fields[i].name, 't');
 
-    for (int i=0; (row = mysql_fetch_row (res_set)); i++){
-        int passed_name = 0;
-		for (size_t jj=0; jj<total_cols; jj++){
-            if (jj==name_row){
-                apop_name_add(out->names, row[jj], 'r');
-                passed_name = 1;
-                continue;
-            }
-            apop_text_set(out, i, jj-passed_name, "%s", (row[jj]==NULL)?  apop_opts.nan_string : row[jj]);
-		}
-    }
+    while ((row = mysql_fetch_row (res_set)))
+		for (size_t jj=0; jj<total_cols + (name_row>=0); jj++)
+            if (jj==name_row) apop_name_add(out->names, row[jj], 'r');
+            else apop_text_builder_add(text, (row[jj]==NULL)?  apop_opts.nan_string : row[jj]);
+    apop_text_builder_finish(text, out);
     check_and_clean(;)
 }
 
@@ -177,6 +177,7 @@ typedef struct {    //for the apop_query_to_... functions.
     int       firstcall, namecol;
     size_t    currentrow;
     apop_data *outdata;
+    apop_text_builder *text;
 } callback_t;
 /** \endcond */
 
@@ -193,17 +194,15 @@ static int db_to_chars(void *qinfo,int argc, char **argv, char **column){
                 qi->namecol = i;
                 break;
             }
+        int cols = argc - (qi->namecol >= 0);
+        if (cols) qi->text = apop_text_builder_alloc(cols, 'a');
     }
-    int rows = d->textsize[0];
-    int cols = argc - (qi->namecol >= 0);
-    apop_text_alloc(d, rows+1, cols);//doesn't move d.
     for (size_t jj=0; jj<argc; jj++)
         if (jj == qi->namecol){
             apop_name_add(d->names, argv[jj], 'r'); 
             ncshift ++;
         } else {
-            apop_text_set(d, rows, jj-ncshift, (argv[jj]==NULL)? apop_opts.nan_string: argv[jj]);
-            //Asprintf(&(d->text[rows][jj-ncshift]), "%s", (argv[jj]==NULL)? "NaN": argv[jj]);
+            apop_text_builder_add(qi->text, (argv[jj]==NULL)? apop_opts.nan_string: argv[jj]);
             if(addnames)
                 apop_name_add(d->names, column[jj], 't'); 
         }
@@ -214,7 +213,9 @@ apop_data * apop_sqlite_query_to_text(char *query){
     char *err = NULL;
     callback_t qinfo = {.outdata=apop_data_alloc(), .namecol=-1, .firstcall=1};
     if (db==NULL) apop_db_open(NULL);
-    sqlite3_exec(db, query, db_to_chars, &qinfo, &err); ERRCHECK_SET_ERROR(qinfo.outdata)
+    sqlite3_exec(db, query, db_to_chars, &qinfo, &err);
+    apop_text_builder_finish(qinfo.text, qinfo.outdata);
+    ERRCHECK_SET_ERROR(qinfo.outdata)
     if (qinfo.outdata->textsize[0]==0){
         apop_data_free(qinfo.outdata);
         return NULL;
@@ -228,6 +229,7 @@ typedef struct {
     int        intypes[5];//names, vectors, mcols, textcols, weights.
     int        current, thisrow, error_thrown;
     const char *instring;
+    apop_text_builder *text;
 } apop_qt;
 /** \endcond */
 
@@ -252,8 +254,7 @@ static void count_types(apop_qt *in, const char *intypes){
 static int multiquery_callback(void *instruct, int argc, char **argv, char **column){
     apop_qt *in = instruct;
     char c;
-    int thistcol    = 0, 
-        thismcol    = 0,
+    int thismcol    = 0,
         colct       = 0,
         i, addnames = 0;
     in->thisrow ++;
@@ -263,19 +264,11 @@ static int multiquery_callback(void *instruct, int argc, char **argv, char **col
                 : apop_data_alloc(in->intypes[1]);
         if (in->intypes[4])
             in->d->weights  = gsl_vector_alloc(1);
-        if (in->intypes[3]){
-            in->d->textsize[0]  = 1;
-            in->d->textsize[1]  = in->intypes[3];
-            in->d->text         = malloc(sizeof(char***));
-        }
+        if (in->intypes[3])
+            in->text = apop_text_builder_alloc(in->intypes[3], 'a');
     }
     if (!(in->d->names->colct + in->d->names->textct + (in->d->names->vector!=NULL)))
         addnames++;
-    if (in->d->textsize[1]){
-        in->d->textsize[0]         = in->thisrow;
-        in->d->text                = realloc(in->d->text, sizeof(char ***)*in->thisrow);
-        in->d->text[in->thisrow-1] = malloc(sizeof(char**) * in->d->textsize[1]);
-    }
     if (in->intypes[2])
         apop_matrix_realloc(in->d->matrix, in->thisrow, in->intypes[2]);
     for (i=in->current=0; i< argc; i++){
@@ -296,8 +289,7 @@ static int multiquery_callback(void *instruct, int argc, char **argv, char **col
             if(addnames)
                 apop_name_add(in->d->names, column[i], 'c'); 
         } else if (c=='t'||c=='T'){
-            Asprintf(&(in->d->text[in->thisrow-1][thistcol++]), "%s", 
-			                        argv[i] ? argv[i] : "NaN");
+            apop_text_builder_add(in->text, argv[i] ? argv[i] : "NaN");
             if(addnames)
                 apop_name_add(in->d->names, column[i], 't'); 
         } else if (c=='w'||c=='W'){
@@ -322,6 +314,7 @@ apop_data *apop_sqlite_multiquery(const char *intypes, char *query){
     count_types(&info, intypes);
 	if (!db) apop_db_open(NULL);
     sqlite3_exec(db, query, multiquery_callback, &info, &err); 
+    if (info.d) apop_text_builder_finish(info.text, info.d);
     Apop_stopif(info.error_thrown, if (!info.d) apop_data_alloc(); info.d->error='d'; return info.d,
             0, "dimension error");
     ERRCHECK_SET_ERROR(info.d)
@@ -28,18 +28,26 @@ float fmax2(float a, float b){return (a>b) ? a : b;}
 float fmin2(float a, float b){return (a<b) ? a : b;}
 /* end R-to-Apophenia additions */
 
+/* The state that the original code kept in static variables, now carried
+   per call so that several tests can run at once. f3xact keeps its stack
+   counters across calls; f5xact remembers where the last PSH call landed. */
+typedef struct {
+    int nst, nitc; /* f3xact */
+    int itp;       /* f5xact */
+} fexact_state;
+
 static void f2xact(int nrow, int ncol, int *table, int ldtabl,
 		   double *expect, double *percnt, double *emin,
 		   double *prt, double *pre, double *fact, int *ico, int *iro,
 		   int *kyy, int *idif, int *irn, int *key,
 		   int *ldkey, int *ipoin, double *stp, int *ldstp,
 		   int *ifrq, double *LP, double *SP, double *tm,
-		   int *key2, int *iwk, double *rwk);
+		   int *key2, int *iwk, double *rwk, fexact_state *state);
 static double f3xact(int nrow, int *irow, int ncol, int *icol, int ntot,
 		     double *fact, int *ico, int *iro,
 		     int *it, int *lb, int *nr, int *nt, int *nu,
 		     int *itc, int *ist, double *stv, double *alen,
-		     const double *tol);
+		     const double *tol, fexact_state *state);
 static double f4xact(int nrow, int *irow, int ncol, int *icol, double dspt,
 		     double *fact, int *icstk, int *ncstk,
 		     int *lstk, int *mstk, int *nstk, int *nrstk, int *irstk,
@@ -47,7 +55,7 @@ static double f4xact(int nrow, int *irow, int ncol, int *icol, double dspt,
 static void f5xact(double *pastp, const double *tol, int *kval, int *key,
 		   int *ldkey, int *ipoin, double *stp, int *ldstp,
 		   int *ifrq, int *npoin, int *nr, int *nl, int *ifreq,
-		   int *itop, Rboolean psh);
+		   int *itop, Rboolean psh, fexact_state *state);
 static Rboolean f6xact(int nrow, int *irow, int *kyy,
 		       int *key, int *ldkey, int *last, int *ipn);
 static void f7xact(int nrow, int *imax, int *idif, int *k, int *ks,
@@ -62,10 +70,14 @@ static int iwork(int iwkmax, int *iwkpt, int number, int itype);
 static void isort(int *n, int *ix);
 static double gammds(double *y, double *p, int *ifault);
 
-threadlocal bool has_error;
+threadlocal bool has_error, out_of_workspace;
 void prterr(int icode, const char *mes) {
     has_error++;
-    Apop_notify(1, "FEXACT error %d.\n%s", icode, mes);
+    if (icode == 6 || icode == 7){ //the caller can retry with more space.
+        out_of_workspace = true;
+        Apop_notify(2, "FEXACT error %d.\n%s", icode, mes);
+    } else
+        Apop_notify(1, "FEXACT error %d.\n%s", icode, mes);
 }
 
 /* The interface to the original code, which apop_test_fisher_exact calls: */
@@ -267,6 +279,11 @@ static void fexact(int *nrow, int *ncol, int *table, int *ldtabl,
     ikh = ldkey << 1;	i9  = iwork(iwkmax, &iwkpt, ikh, i_real);
     ikh = ldkey << 1;	i9a = iwork(iwkmax, &iwkpt, ikh, i_real);
     ikh = ldkey << 1;	i10 = iwork(iwkmax, &iwkpt, ikh, i_int);
+    if (ldkey < 1 || out_of_workspace){
+        out_of_workspace = has_error = true;
+        free(equiv);
+        return;
+    }
 
     /* To convert to double precision, change RWRK to DWRK in the next CALL.
      */
@@ -296,7 +313,8 @@ static void fexact(int *nrow, int *ncol, int *table, int *ldtabl,
 	   dwrk + i9a,
 	   iwrk + i10,
 	   iwrk + iiwk,
-	   dwrk + irwk);
+	   dwrk + irwk,
+	   &(fexact_state){ });
 
     free(equiv);
 }
@@ -310,7 +328,7 @@ static void f2xact(int nrow, int ncol, int *table, int ldtabl,
        double *pre, double *fact, int *ico, int *iro, int *kyy,
        int *idif, int *irn, int *key, int *ldkey, int *ipoin,
        double *stp, int *ldstp, int *ifrq, double *LP, double *SP,
-       double *tm, int *key2, int *iwk, double *rwk) {
+       double *tm, int *key2, int *iwk, double *rwk, fexact_state *state) {
 /* -----------------------------------------------------------------------
   Name:		F2XACT
   Purpose:	Computes Fisher's exact test for a contingency table,
@@ -626,6 +644,7 @@ L150:
            */
         prterr(6, "LDKEY is too small for this problem.\n"
                "Try increasing the size of the workspace.");
+        return;
     }
 
 L240:
@@ -646,9 +665,9 @@ L240:
             LP[itp] = f3xact(nro2, &irn[nrb], k1, &ico[kb + 1], ntot, fact,
                       &iwk[i31], &iwk[i32], &iwk[i33], &iwk[i34],
                       &iwk[i35], &iwk[i36], &iwk[i37], &iwk[i38],
-                      &iwk[i39], &rwk[i310], &rwk[i311], &tol);
+                      &iwk[i39], &rwk[i310], &rwk[i311], &tol, state);
             if(LP[itp] > 0.) {/* can this happen? */
-                printf("___ LP[itp=%d] = %g > 0\n", itp, LP[itp]);
+                Apop_notify(2, "LP[itp=%d] = %g > 0; setting it to zero.", itp, LP[itp]);
                 LP[itp] = 0.;
             }
 
@@ -658,7 +677,7 @@ L240:
                       &iwk[i44], &iwk[i45], &iwk[i46], &rwk[i48], &tol);
             /* SP[itp] = fmin2(0., SP[itp] - dspt);*/
             if(SP[itp] > 0.) { /* can this happen? */
-                printf("___ SP[itp=%d] = %g > 0\n", itp, SP[itp]);
+                Apop_notify(2, "SP[itp=%d] = %g > 0; setting it to zero.", itp, SP[itp]);
                 SP[itp] = 0.;
             }
 
@@ -719,7 +738,8 @@ L300:
             d1 = pastp + ddf;
             f5xact(&d1, &tol, &kval, &key[jkey], ldkey, &ipoin[jkey],
                &stp[jstp], ldstp, &ifrq[jstp], &ifrq[jstp2],
-               &ifrq[jstp3], &ifrq[jstp4], &ifreq, &itop, psh);
+               &ifrq[jstp3], &ifrq[jstp4], &ifreq, &itop, psh, state);
+            if (out_of_workspace) return;
             psh = FALSE;
         }
     }
@@ -760,7 +780,7 @@ L310:
 static double f3xact(int nrow, int *irow, int ncol, int *icol,
        int ntot, double *fact, int *ico, int *iro, int *it,
        int *lb, int *nr, int *nt, int *nu, int *itc, int *ist,
-       double *stv, double *alen, const double *tol) {
+       double *stv, double *alen, const double *tol, fexact_state *state) {
 /* -----------------------------------------------------------------------
   Name:	      F3XACT
   Purpose:    Computes the longest path length for a given table.
@@ -793,9 +813,7 @@ static double f3xact(int nrow, int *irow, int ncol, int *icol,
   */
 
     const int ldst = 200;/* half stack size */
-    /* Initialized data */
-    static int nst = 0;
-    static int nitc = 0;
+    int *nst = &state->nst, *nitc = &state->nitc;
 
     int i, k;
     int n11, n12, ii, nn, ks, ic1, ic2, nc1, nn1;
@@ -1006,8 +1024,8 @@ LoopNode: /* Generate a node */
 L180: /* Push onto stack */
 	ist[ii] = key;
 	stv[ii] = v;
-	++nst;
-	ii = nst + ks;
+	++*nst;
+	ii = *nst + ks;
 	itc[ii] = itp;
 	goto LoopNode;
 
@@ -1018,10 +1036,10 @@ L190: /* Marginals already on stack */
 
 
 L200: /* Pop item from stack */
-    if (nitc > 0) {
+    if (*nitc > 0) {
 	/* Stack index */
-	itp = itc[nitc + k] + k;
-	--nitc;
+	itp = itc[*nitc + k] + k;
+	--*nitc;
 	val = stv[itp];
 	key = ist[itp];
 	ist[itp] = -1;
@@ -1052,10 +1070,10 @@ L200: /* Pop item from stack */
 	}
 	else goto LnewNode;
 
-    } else if (nro > 2 && nst > 0) {
+    } else if (nro > 2 && *nst > 0) {
         /* Go to next level */
-        nitc = nst;
-        nst = 0;
+        *nitc = *nst;
+        *nst = 0;
         k = ks;
         ks = ldst - ks;
         nn -= iro[irl];
@@ -1264,7 +1282,7 @@ static double f4xact(int nrow, int *irow, int ncol, int *icol, double dspt,
 
 void f5xact(double *pastp, const double *tol, int *kval, int *key, int *ldkey,
        int *ipoin, double *stp, int *ldstp, int *ifrq, int *npoin,
-       int *nr, int *nl, int *ifreq, int *itop, Rboolean psh) {
+       int *nr, int *nl, int *ifreq, int *itop, Rboolean psh, fexact_state *state) {
 /* -----------------------------------------------------------------------
   Name:	      F5XACT aka "PUT"
   Purpose:    Put node on stack in network algorithm.
@@ -1294,10 +1312,10 @@ void f5xact(double *pastp, const double *tol, int *kval, int *key, int *ldkey,
 	      If PSH is true, the past path length is found in the
 	      table KEY.  Otherwise the location of the past path
 	      length is assumed known and to have been found in
-	      a previous call. ==>>>>> USING "static" variables
+	      a previous call, and is read from STATE.
   ----------------------------------------------------------------------- */
 
-    static int itmp, ird, ipn, itp; /* << *need* static, see PSH above */
+    int itmp, ird, ipn, itp = state->itp;
     double test1, test2;
 
     --nl;
@@ -1334,10 +1352,10 @@ void f5xact(double *pastp, const double *tol, int *kval, int *key, int *ldkey,
 	  */
 	prterr(6, "LDKEY is too small for this problem.\n"
 	       "Try increasing the size of the workspace.");
-
+	return;
 
 L30: /* Update KEY */
-
+	state->itp = itp;
 	key[itp] = *kval;
 	++(*itop);
 	ipoin[itp] = *itop;
@@ -1351,6 +1369,7 @@ L30: /* Update KEY */
 	       */
 	    prterr(7, "LDSTP is too small for this problem.\n"
 		   "Try increasing the size of the workspace.");
+	    return;
 	}
 	/* Update STP, etc. */
 	npoin[*itop] = -1;
@@ -1362,6 +1381,7 @@ L30: /* Update KEY */
     }
 
 L40: /* Find location, if any, of pastp */
+    state->itp = itp;
 
     ipn = ipoin[itp];
     test1 = *pastp - *tol;
@@ -1722,7 +1742,10 @@ static int iwork(int iwkmax, int *iwkpt, int number, int itype) {
         *iwkpt += (number << 1);
         i /= 2;
     }
-    Apop_stopif(*iwkpt >iwkmax, has_error=true;return i, 0, "Out of workspace: %i > %i", *iwkpt, iwkmax);
+    if (*iwkpt > iwkmax){
+        Apop_notify(2, "Out of workspace: %i > %i", *iwkpt, iwkmax);
+        out_of_workspace = has_error = true;
+    }
     return i;
 }
 
@@ -1737,7 +1760,7 @@ void isort(int *n, int *ix) {
      N	    - Lenth of vector IX.	(Input)
      IX	    - Vector to be sorted.	(in/out)
   ----------------------------------------------------------------------- */
-    static int ikey, i, j, m, il[10], kl, it, iu[10], ku;
+    int ikey, i, j, m, il[10], kl, it, iu[10], ku;
 
     /* Parameter adjustments */
     --ix;
@@ -1825,7 +1848,7 @@ static double gammds(double *y, double *p, int *ifault) {
   using and infinite series.
   */
 
-    static double a, c, f, g;
+    double a, c, f, g;
 
     /* Checks for the admissibility of arguments and value of F */
     *ifault = 1;
@@ -1876,6 +1899,40 @@ static int *apop_data_to_int_array(apop_data *intab){
     return out;
 }
 
+/* Run fexact on one table, doubling the workspace whenever the hash tables
+   fill up. The first try uses the 200,000-int workspace R uses; we give up at
+   2^27 ints (512MB). Returns nonzero on error. */
+static int fisher_one(apop_data *intab, double *prt, double *pre){
+    double  expect  = -1,
+            percent = 80,
+            emin    = 1;
+    int     *intified = apop_data_to_int_array(intab),
+            workspace = 200000,
+            mult      = 30,
+            rowct     = intab->matrix->size1,
+            colct     = intab->matrix->size2;
+    const int max_workspace = 1<<27;
+    do {
+        has_error = out_of_workspace = false;
+        fexact(&rowct, 
+           &colct,
+           intified,
+           &rowct,
+           // Cochran condition for asym.chisq. decision:
+           &expect,
+           &percent,
+           &emin,
+           prt,
+           pre,
+           &workspace,
+           &mult);
+    } while (out_of_workspace && (workspace *= 2) <= max_workspace);
+    free(intified);
+    if (out_of_workspace) Apop_notify(1, "Ran out of workspace even at %i ints.", workspace/2);
+    if (has_error) *prt = *pre = GSL_NAN;
+    return has_error;
+}
+
 /** Run the Fisher exact test on an input contingency table.
 
 \return     An \ref apop_data set with two rows:<br>
@@ -1892,35 +1949,50 @@ For example:
 \include test_fisher.c
 */
 apop_data *apop_test_fisher_exact(apop_data *intab){
-    double  prt, pre,
-            expect  = -1,
-            percent = 80,
-            emin    = 1;
-    int     *intified = apop_data_to_int_array(intab),
-            workspace = 200000,
-            mult      = 30,
-            rowct     = intab->matrix->size1,
-            colct     = intab->matrix->size2;
-    has_error=0;
-OMP_critical (fexact) //f3xact and f5exact use static vars for some state-keeping.
-    fexact(&rowct, 
-       &colct,
-       intified,
-       &rowct,
-       // Cochran condition for asym.chisq. decision:
-       &expect,
-       &percent,
-       &emin,
-       &prt,
-       &pre,
-       &workspace,
-       &mult);
-    free(intified);
+    double prt, pre;
+    int err = fisher_one(intab, &prt, &pre);
     apop_data *out = apop_data_alloc();
     Asprintf(&out->names->title, "Fisher Exact test");
     apop_data_add_named_elmt(out, "probability of table", prt);
     apop_data_add_named_elmt(out, "p value", pre);
-    Apop_stopif(has_error, out->error='p'; return out, 0, "processing error; don't trust the results.");
+    Apop_stopif(err, out->error='p'; return out, 0, "processing error; don't trust the results.");
+    return out;
+}
+
+/** Run the Fisher exact test on each of a set of contingency tables. The tables
+are pages of the input, linked via the <tt>->more</tt> pointer, as produced by
+(for example) \ref apop_data_add_page. The tables are processed in parallel if
+Apophenia was compiled with OpenMP.
+
+\param tables The first table; subsequent tables are at <tt>tables->more</tt>, <tt>tables->more->more</tt>, ....
+\return An \ref apop_data set with one row per table, in input order, and two
+columns: "probability of table" and "p value", as per \ref apop_test_fisher_exact.
+Row names are the page titles of the input tables, if any.
+
+\li If a table can not be processed, its row is NaN.
+
+\exception out->error=='p' Processing error in the test for at least one table.
+*/
+apop_data *apop_test_fisher_exact_batch(apop_data *tables){
+    Apop_stopif(!tables, return NULL, 0, "NULL input. Returning NULL.");
+    int ct = 0, errs = 0;
+    for (apop_data *t=tables; t; t=t->more) ct++;
+    apop_data *list[ct];
+    ct = 0;
+    for (apop_data *t=tables; t; t=t->more) list[ct++] = t;
+
+    apop_data *out = apop_data_alloc(ct, 2);
+    Asprintf(&out->names->title, "Fisher Exact tests");
+    apop_name_add(out->names, "probability of table", 'c');
+    apop_name_add(out->names, "p value", 'c');
+    for (int i=0; i< ct; i++)
+        apop_name_add(out->names, (list[i]->names && list[i]->names->title) 
+                                    ? list[i]->names->title : "", 'r');
+    OMP_for_reduce(+:errs, int i=0; i< ct; i++)
+        errs += fisher_one(list[i], gsl_matrix_ptr(out->matrix, i, 0), 
+                                    gsl_matrix_ptr(out->matrix, i, 1));
+    Apop_stopif(errs, out->error='p'; return out, 0, "processing error in %i of %i tables; "
+                                                      "don't trust those results.", errs, ct);
     return out;
 }
 #endif /* not USING_R */
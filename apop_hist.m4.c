@@ -9,6 +9,7 @@ Copyright (c) 2006--2007, 2010, 2013 by Ben Klemens.  Licensed under the GPLv2;
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_sort_vector.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /** Make random draws from an \ref apop_model, and bin them using a binspec in the style
  of \ref apop_data_to_bins. If you have a data set that used the same binspec, you now have synced histograms, which you can plot or sensibly test hypotheses about.
@@ -20,7 +21,7 @@ Copyright (c) 2006--2007, 2010, 2013 by Ben Klemens.  Licensed under the GPLv2;
 \param draws The number of random draws to make. (arbitrary default = 10,000)
 \param bin_count If no bin spec, the number of bins to use (default: as per \ref apop_data_to_bins, \f$\sqrt(N)\f$)
 
-\return An \ref apop_pmf model, with a new binned data set attached (which you may
+\return An \ref apop_pmf model, with a new binned data set attached, one row per nonempty bin (which you may
 have to <tt>apop_data_free(output_model->data)</tt> to prevent memory leaks). The
 weights on the data set are normalized to sum to one.
 
@@ -36,7 +37,7 @@ APOP_VAR_HEAD apop_model *apop_model_to_pmf(apop_model *model, apop_data *binspe
 APOP_VAR_ENDHEAD
     Get_vmsizes(binspec);
     apop_data *outd = apop_model_draws(model, draws);
-    apop_data *outbinned = apop_data_to_bins(outd, binspec, .bin_count=bin_count);
+    apop_data *outbinned = apop_data_histogram(outd, binspec, .bin_count=bin_count);
     apop_data_free(outd);
     apop_vector_normalize(outbinned->weights);
     return apop_estimate(outbinned, apop_pmf);
@@ -212,6 +213,153 @@ static double psmirnov2x(double x, int m, int n) {
     return u[n];
 }
 
+/* The limiting Kolmogorov distribution, P(K <= lambda), via the two series in
+   Numerical Recipes, 3rd ed., sec 6.14; each is accurate to double precision on its half. */
+static double kolmogorov_limit(double lambda){
+    if (lambda < 0.04) return 0;
+    if (lambda < 1.18){
+        double y = exp(-M_PI*M_PI/(8*lambda*lambda));
+        return sqrt(2*M_PI)/lambda * (y + pow(y, 9) + pow(y, 25) + pow(y, 49));
+    }
+    double x = exp(-2*lambda*lambda);
+    return 1 - 2*(x - pow(x, 4) + pow(x, 9));
+}
+
+/* P(D <= d) for effective sample size en, with Stephens' (1970) small-sample correction. */
+static double ks_asymptotic(double d, double en){
+    double rt = sqrt(en);
+    return kolmogorov_limit(d*(rt + 0.12 + 0.11/rt));
+}
+
+/* Above these sizes, the exact distributions cost more than they're worth. psmirnov2x
+   is O(mn); kolmogorov_2x takes powers of a (2nd+1)-square matrix. */
+static const double ks_exact_two_sample_max = 1e7;
+static const double ks_exact_one_sample_max = 1e2;
+
+/* P(D <= d) for samples of size m and n, or a one-sample test of a sample of size m
+   (in which case n is ignored). */
+static double ks_confidence(double d, size_t m, size_t n, bool two_sample, char exact){
+    Apop_stopif(!m || (two_sample && !n), return GSL_NAN, 0, "Empty sample; returning NaN.");
+    if (two_sample){
+        if (exact=='y' || (exact=='a' && (double)m*n <= ks_exact_two_sample_max))
+            return psmirnov2x(d, m, n);
+        return ks_asymptotic(d, m*(double)n/(m+n));
+    }
+    if (exact=='y' || (exact=='a' && m*d <= ks_exact_one_sample_max && m <= 1e5))
+        return kolmogorov_2x(m, d);
+    return ks_asymptotic(d, m);
+}
+
+static apop_data *ks_output(double d, double ps){
+    apop_data *out = apop_data_alloc();
+    Asprintf(&out->names->title, "Kolmogorov-Smirnov test");
+    apop_data_add_named_elmt(out, "max distance", d);
+    apop_data_add_named_elmt(out, "p value, 2 tail", 1-ps);
+    apop_data_add_named_elmt(out, "confidence, 2 tail", ps);
+    return out;
+}
+
+static gsl_vector *sorted_copy(gsl_vector const *v){
+    gsl_vector *out = gsl_vector_alloc(v->size);
+    gsl_vector_memcpy(out, v);
+    gsl_sort_vector(out);
+    return out;
+}
+
+/* Evaluate the reference model's CDF at every point of a sorted vector. A closed-form
+   CDF is called on each point in parallel. Otherwise, apop_cdf would count the draws
+   below each point one point at a time; for one-dimensional models, sort the draws
+   once and merge them with the sorted points instead. */
+static void batch_cdf(gsl_vector const *sorted, apop_model *m, double *cdfs){
+    apop_data *wrapper = &(apop_data){.vector=(gsl_vector*)sorted};
+    if (m->cdf){
+        OMP_for (size_t i=0; i< sorted->size; i++)
+            cdfs[i] = m->cdf(Apop_r(wrapper, i), m);
+        return;
+    }
+    cdfs[0] = apop_cdf(Apop_r(wrapper, 0), m); //generates and caches the draws
+    apop_cdf_settings *cs = Apop_settings_get_group(m, apop_cdf);
+    if (!cs || !cs->draws_made || cs->draws_made->size2 != 1){
+        for (size_t i=1; i< sorted->size; i++)
+            cdfs[i] = apop_cdf(Apop_r(wrapper, i), m);
+        return;
+    }
+    gsl_vector *draws = sorted_copy(Apop_mcv(cs->draws_made, 0));
+    size_t below = 0;
+    for (size_t i=0; i< sorted->size; i++){
+        double x = gsl_vector_get(sorted, i);
+        while (below < draws->size && gsl_vector_get(draws, below) <= x) below++;
+        cdfs[i] = below/(double)draws->size;
+    }
+    gsl_vector_free(draws);
+}
+
+/** Run the Kolmogorov-Smirnov test on raw, unsorted data: either a two-sample test
+that \c x and \c y come from the same distribution, or a one-sample test that \c x
+comes from the \c reference model.
+
+\param x A vector of data. It is copied and sorted; the original is not modified. (No default, must not be \c NULL.)
+\param y A second vector of data, for a two-sample test. (Default: \c NULL)
+\param reference If \c y is \c NULL, the model to test \c x against. It needs a CDF,
+either closed-form or via random draws; see \ref apop_cdf. (Default: \c NULL)
+\param exact <tt>'y'</tt>: use the exact distribution of the test statistic.
+<tt>'n'</tt>: use the limiting Kolmogorov distribution, with Stephens' small-sample correction.
+<tt>'a'</tt>: use the exact distribution for small samples and the limiting distribution
+for large ones. The exact two-sample distribution takes time proportional to the product of the
+sample sizes. (Default: <tt>'a'</tt>)
+
+\return An \ref apop_data set with the same elements as \ref apop_test_kolmogorov: the
+max distance, the \f$p\f$-value, and the confidence.
+\exception out->error='n'  Input was \c NULL, or neither \c y nor \c reference was given.
+
+\li The samples are sorted and the distance is found in one merge, so the statistic costs
+\f$O(n\log n)\f$ for a sample of size \f$n\f$. The reference CDF is evaluated at every
+point in parallel if Apophenia was compiled with OpenMP.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data *apop_test_kolmogorov_vector(gsl_vector const *x, gsl_vector const *y, apop_model *reference, char exact){
+    gsl_vector const * apop_varad_var(x, NULL);
+    gsl_vector const * apop_varad_var(y, NULL);
+    apop_model * apop_varad_var(reference, NULL);
+    Apop_stopif(!x || !x->size, apop_return_data_error('n'), 0, "No data in the x vector.");
+    Apop_stopif(y && !y->size, apop_return_data_error('n'), 0, "No data in the y vector.");
+    Apop_stopif(!y && !reference, apop_return_data_error('n'), 0, "I need either a second data vector or a reference model.");
+    char apop_varad_var(exact, 'a');
+APOP_VAR_ENDHEAD
+    gsl_vector *xs = sorted_copy(x);
+    size_t m = xs->size;
+    double largest_diff = 0;
+    if (y){
+        gsl_vector *ys = sorted_copy(y);
+        size_t n = ys->size;
+        for (size_t i=0, j=0; i< m && j< n; ){
+            double next = GSL_MIN(gsl_vector_get(xs, i), gsl_vector_get(ys, j));
+            while (i < m && gsl_vector_get(xs, i) == next) i++; //step both ECDFs past ties
+            while (j < n && gsl_vector_get(ys, j) == next) j++;
+            largest_diff = GSL_MAX(largest_diff, fabs(i/(double)m - j/(double)n));
+        }
+        gsl_vector_free(ys);
+        gsl_vector_free(xs);
+        return ks_output(largest_diff, ks_confidence(largest_diff, m, n, true, exact));
+    }
+    double *cdfs = malloc(sizeof(double)*m);
+    batch_cdf(xs, reference, cdfs);
+    for (size_t i=0; i< m; i++)
+        largest_diff = GSL_MAX(largest_diff, GSL_MAX((i+1.)/m - cdfs[i], cdfs[i] - i/(double)m));
+    free(cdfs);
+    gsl_vector_free(xs);
+    return ks_output(largest_diff, ks_confidence(largest_diff, m, 0, false, exact));
+}
+
+//If a PMF's data is a single unweighted column, return it; else NULL.
+static gsl_vector *pmf_as_raw_column(apop_model *m){
+    apop_data *d = m->data;
+    if (!d || d->weights || d->more) return NULL;
+    if (d->vector && !d->matrix) return d->vector;
+    if (!d->vector && d->matrix && d->matrix->size2 == 1) return Apop_cv(d, 0);
+    return NULL;
+}
+
 /** Run the Kolmogorov-Smirnov test to determine whether two distributions are identical.
 
 \param m1 A sorted PMF model. I.e., a model estimated via something like 
@@ -230,8 +378,10 @@ by checking whether <tt>m1->cdf == apop_pmf->cdf</tt>.
 you set up the model, as per the example below. See \ref apop_data_sort and the
 discussion of CDFs in the \ref apop_pmf documentation. If you don't do this, the test
 will almost certainly reject the null hypothesis that \c m1 and \c m2 are identical.
-A future version of Apophenia may implement a mechanism to allow this function to test
-for sorted data, but it currently can't.
+The exception is a PMF whose data is a single unweighted column (e.g., raw draws); such
+PMFs are handed to \ref apop_test_kolmogorov_vector, which sorts a copy itself.
+\li For large samples, the \f$p\f$-value is from the limiting distribution; see
+\ref apop_test_kolmogorov_vector, which also takes raw vectors directly.
 
 Here is an example, which tests whether a set of draws from a Normal(0, 1) matches a
 sequence of Normal distributions with increasing mean.
@@ -243,6 +393,10 @@ apop_data *apop_test_kolmogorov(apop_model *m1, apop_model *m2){
             0, "First model has to be a PMF. I check whether m1->cdf == apop_pmf->cdf.");
     bool m2_is_pmf = (m2->cdf == apop_pmf->cdf);
 
+    gsl_vector *raw1 = pmf_as_raw_column(m1), *raw2 = m2_is_pmf ? pmf_as_raw_column(m2) : NULL;
+    if (raw1 && (raw2 || !m2_is_pmf))
+        return apop_test_kolmogorov_vector(raw1, raw2, m2_is_pmf ? NULL : m2);
+
     int maxsize1, maxsize2;
     {Get_vmsizes(m1->data); maxsize1 = maxsize;} //copy one of the macro's variables 
     {Get_vmsizes(m2->data); maxsize2 = maxsize;} //to the full function's scope.
@@ -261,14 +415,7 @@ apop_data *apop_test_kolmogorov(apop_model *m1, apop_model *m2){
             largest_diff = GSL_MAX(largest_diff, fabs(sum-apop_cdf(arow, m2)));
         }
     }
-    apop_data *out = apop_data_alloc();
-    Asprintf(&out->names->title, "Kolmogorov-Smirnov test");
-    apop_data_add_named_elmt(out, "max distance", largest_diff);
-    double ps = m2_is_pmf ? psmirnov2x(largest_diff, maxsize1, maxsize2)
-                          : kolmogorov_2x(maxsize1, largest_diff);
-    apop_data_add_named_elmt(out, "p value, 2 tail", 1-ps);
-    apop_data_add_named_elmt(out, "confidence, 2 tail", ps);
-    return out;
+    return ks_output(largest_diff, ks_confidence(largest_diff, maxsize1, maxsize2, m2_is_pmf, 'a'));
 }
 
 /** Create a histogram from data by putting data into bins of fixed width. Your input
@@ -358,23 +505,358 @@ APOP_VAR_ENDHEAD
     return out;
 }
 
+/* Partial histograms for apop_data_histogram. Each chunk of rows counts into its own
+   table, keyed by the bin's position in the row-major grid of all bins; the tables are
+   summed at the end. Small grids get a dense array; large, sparse ones a hash table. */
+typedef struct {
+    size_t size, ct;   //size is a power of two, or zero for a dense table
+    uint64_t *keys;    //stored as key+1, so zero marks an empty slot
+    double *w;
+} bin_table;
+
+static void bin_hash_add(bin_table *t, uint64_t key, double w);
+
+static void bin_hash_grow(bin_table *t){
+    bin_table bigger = {.size= t->size ? 2*t->size : 1024};
+    bigger.keys = calloc(bigger.size, sizeof(uint64_t));
+    bigger.w = malloc(sizeof(double)*bigger.size);
+    for (size_t i=0; i< t->size; i++)
+        if (t->keys[i]) bin_hash_add(&bigger, t->keys[i]-1, t->w[i]);
+    free(t->keys); free(t->w);
+    *t = bigger;
+}
+
+static void bin_hash_add(bin_table *t, uint64_t key, double w){
+    if (2*(t->ct+1) > t->size) bin_hash_grow(t);
+    size_t i = (key * 0x9E3779B97F4A7C15ull) & (t->size-1);
+    while (t->keys[i] && t->keys[i] != key+1) i = (i+1) & (t->size-1);
+    if (!t->keys[i]) {
+        t->keys[i] = key+1;
+        t->w[i] = 0;
+        t->ct++;
+    }
+    t->w[i] += w;
+}
+
+typedef struct {
+    uint64_t key;
+    double w;
+} bin_total;
+
+static int bin_total_cmp(const void *a, const void *b){
+    uint64_t x = ((bin_total const*)a)->key, y = ((bin_total const*)b)->key;
+    return (x > y) - (x < y);
+}
+
+/** Build a histogram directly: find the bin for each row of the data, count the rows in
+each bin, and return the list of nonempty bins with their counts, ready for use as
+an \ref apop_pmf. For data without NaNs, this produces the same bins as
+<tt>apop_data_pmf_compress(apop_data_to_bins(indata, ...))</tt> followed by a sort, but
+never makes the full-size binned copy of the data. The exception: given a \c binspec
+and <tt>close_top_bin='y'</tt>, this function pulls each column's maximum down into the
+bin below as described for \ref apop_data_to_bins, where \ref apop_data_to_bins
+only does so for values equal to zero.
+
+\param indata The input data, one observation per row. Not modified. (No default)
+\param binspec As in \ref apop_data_to_bins: the first row gives the bin width for each
+column, and an optional second row the offset. (default: NULL)
+\param bin_count If you don't provide a bin spec, I'll provide this many evenly-sized bins to cover the data set. (Default: \f$\sqrt{N}\f$)
+\param close_top_bin As in \ref apop_data_to_bins. (default: \c 'y' if \c binspec==NULL, else \c 'n')
+
+\return An \ref apop_data set with one row per nonempty bin, sorted by the vector, then
+each matrix column. Each cell gives the lower bound of its bin, and the weights
+give the number of input rows in the bin (or their total weight, if the input has weights).
+Iff you didn't give me a binspec, the one I made is attached as a page named \c \<binspec\>,
+as with \ref apop_data_to_bins.
+\exception out->error='b' The grid of bins is too large to index.
+
+\li Rows with a NaN are skipped, as are bins whose total weight is zero.
+\li If a column's bin width is not a positive, finite number, every value in that column goes into a single bin.
+\li The text segment is not binned. The \c more pointer, if any, is not followed.
+\li Rows are split into chunks that are counted in parallel, if Apophenia was compiled
+with OpenMP, and the partial counts are summed.
+\li To use the output as a PMF, normalize the weights if you like, then <tt>apop_estimate(out, apop_pmf)</tt>.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data *apop_data_histogram(apop_data const *indata, apop_data const *binspec, int bin_count, char close_top_bin){
+    apop_data const *apop_varad_var(indata, NULL);
+    Apop_assert_c(indata, NULL, 2, "NULL input data set, so returning NULL output data set.");
+    apop_data const *apop_varad_var(binspec, NULL);
+    char apop_varad_var(close_top_bin, binspec==NULL ? 'y' : 'n');
+    int apop_varad_var(bin_count, 0);
+APOP_VAR_ENDHEAD
+    Get_vmsizes(indata); //firstcol, vsize, msize1, msize2, maxsize
+    int dims = msize2 - firstcol;
+    double width[dims], offset[dims], max[dims], min[dims];
+    long lo[dims];
+    uint64_t range[dims], stride[dims];
+    apop_data *spec = binspec ? NULL : apop_data_alloc(vsize? 2: 0, msize1? 2: 0, indata->matrix ? msize2: 0);
+
+    OMP_for (int d=0; d< dims; d++){
+        gsl_vector *datacol = Apop_cv(indata, d+firstcol);
+        min[d] = GSL_POSINF; max[d] = GSL_NEGINF;
+        for (size_t i=0; i< datacol->size; i++){
+            double val = gsl_vector_get(datacol, i);
+            if (val < min[d]) min[d] = val;
+            if (val > max[d]) max[d] = val;
+        }
+        if (binspec){
+            width[d] = apop_data_get(binspec, 0, d+firstcol);
+            offset[d] = ((binspec->vector && binspec->vector->size==2 )
+                   ||(binspec->matrix && binspec->matrix->size1==2)) ? apop_data_get(binspec, 1, d+firstcol) : 0;
+        } else {
+            offset[d] = min[d];
+            width[d] = (max[d] - min[d])/(bin_count ? bin_count : sqrt(datacol->size));
+            apop_data_set(spec, 0, d+firstcol, width[d]);
+            apop_data_set(spec, 1, d+firstcol, offset[d]);
+        }
+        if (!(width[d] > 0) || !gsl_finite(width[d])) width[d] = GSL_POSINF; //one bin for everything
+        double adjust = (close_top_bin=='y' && min[d] == max[d] && min[d]!=offset[d]) ? 2*GSL_DBL_EPSILON : 0;
+        lo[d] = gsl_finite(min[d]) ? floor((min[d]-offset[d]-adjust)/width[d]) : 0;
+        range[d] = (gsl_finite(max[d]) ? floor((max[d]-offset[d])/width[d]) : 0) - lo[d] + 1;
+    }
+    double bins = 1;
+    for (int d=dims-1; d>= 0; d--){
+        stride[d] = bins;
+        bins *= range[d];
+    }
+    Apop_stopif(bins > 0x1p62, apop_data_free(spec); apop_return_data_error('b'),
+            0, "The grid has %g bins, which is too many for me to index.", bins);
+
+    int chunks = GSL_MIN(64, maxsize/8192 + 1);
+    bool dense = bins * chunks <= (1<<22);
+    bin_table tables[chunks];
+    OMP_for (int c=0; c< chunks; c++){
+        bin_table *t = tables+c;
+        *t = dense ? (bin_table){.w=calloc(bins, sizeof(double))} : (bin_table){};
+        for (int i=c*(long)maxsize/chunks; i< (c+1)*(long)maxsize/chunks; i++){
+            uint64_t key = 0;
+            for (int d=0; d< dims; d++){
+                double val = (d+firstcol==-1) ? gsl_vector_get(indata->vector, i)
+                                              : gsl_matrix_get(indata->matrix, i, d+firstcol);
+                if (gsl_isnan(val)) goto skip;
+                double adjust = (close_top_bin=='y' && val == max[d] && val!=offset[d]) ? 2*GSL_DBL_EPSILON : 0;
+                long index = gsl_isinf(width[d]) ? lo[d] : floor((val-offset[d]-adjust)/width[d]);
+                key += (index - lo[d]) * stride[d];
+            }
+            double w = indata->weights ? gsl_vector_get(indata->weights, i) : 1;
+            if (dense) t->w[key] += w;
+            else       bin_hash_add(t, key, w);
+            skip:;
+        }
+    }
+
+    size_t ct = 0;
+    bin_total *list;
+    if (dense){
+        for (int c=1; c< chunks; c++){
+            for (size_t k=0; k< bins; k++) tables[0].w[k] += tables[c].w[k];
+            free(tables[c].w);
+        }
+        for (size_t k=0; k< bins; k++) ct += !!tables[0].w[k];
+        list = malloc(sizeof(bin_total)*ct);
+        ct = 0;
+        for (size_t k=0; k< bins; k++)
+            if (tables[0].w[k]) list[ct++] = (bin_total){.key=k, .w=tables[0].w[k]};
+        free(tables[0].w);
+    } else {
+        for (int c=1; c< chunks; c++){
+            for (size_t i=0; i< tables[c].size; i++)
+                if (tables[c].keys[i]) bin_hash_add(tables, tables[c].keys[i]-1, tables[c].w[i]);
+            free(tables[c].keys); free(tables[c].w);
+        }
+        list = malloc(sizeof(bin_total)*tables[0].ct);
+        for (size_t i=0; i< tables[0].size; i++)
+            if (tables[0].keys[i] && tables[0].w[i])
+                list[ct++] = (bin_total){.key=tables[0].keys[i]-1, .w=tables[0].w[i]};
+        free(tables[0].keys); free(tables[0].w);
+        qsort(list, ct, sizeof(bin_total), bin_total_cmp);
+    }
+
+    apop_data *out = apop_data_alloc(vsize ? ct : 0, msize1 ? ct : 0, indata->matrix ? msize2 : 0);
+    out->weights = gsl_vector_alloc(ct);
+    for (size_t r=0; r< ct; r++){
+        gsl_vector_set(out->weights, r, list[r].w);
+        for (int d=0; d< dims; d++){
+            long index = lo[d] + (list[r].key / stride[d]) % range[d];
+            apop_data_set(out, r, d+firstcol, gsl_isinf(width[d]) ? (gsl_finite(min[d]) ? min[d] : offset[d])
+                                                                 : index*width[d] + offset[d]);
+        }
+    }
+    free(list);
+    if (indata->names){
+        apop_name_stack(out->names, indata->names, 'v');
+        apop_name_stack(out->names, indata->names, 'c');
+    }
+    if (spec) apop_data_add_page(out, spec, "<binspec>");
+    return out;
+}
+
 /** Return a new vector that is the moving average of the input vector.
 
 \param v The input vector, unsmoothed
 \param bandwidth An integer \f$\geq 1\f$ giving the number of elements to be averaged to produce one number.
 \return A smoothed vector of size <tt>v->size - (bandwidth/2)*2</tt>.
+
+\li This is <tt>apop_vector_rolling(v, bandwidth, 'm')</tt>; see \ref apop_vector_rolling for other windowed statistics.
  */
 gsl_vector *apop_vector_moving_average(gsl_vector *v, size_t bandwidth){
     Apop_stopif(!v, return NULL, 0, "You asked me to smooth a NULL vector; returning NULL.");
     Apop_stopif(!bandwidth, return apop_vector_copy(v), 0, "Bandwidth must be >=1. Returning a copy of original vector with no smoothing.");
-    int halfspan = bandwidth/2;
-    Apop_stopif((v->size - halfspan*2)<=0, return NULL, 0, "Bandwidth wider than the vector. Returning NULL.");
-    gsl_vector *vout = gsl_vector_calloc(v->size - halfspan*2);
-    for(size_t i=0; i < vout->size; i ++){
-        double *item = gsl_vector_ptr(vout, i);
-        for (int j=-halfspan; j < halfspan+1; j ++)
-            *item += gsl_vector_get(v, j+ i+ halfspan);
-        *item /= halfspan*2 +1;
+    return apop_vector_rolling(v, bandwidth, 'm');
+}
+
+//One window's statistic, computed directly; for windows holding a NaN or infinity.
+static double window_direct(double const *x, size_t st, size_t w, char stat){
+    long double sum = 0, ss = 0;
+    for (size_t j=0; j< w; j++) sum += x[j*st];
+    if (stat=='s') return sum;
+    long double mean = sum/w;
+    if (stat=='m') return mean;
+    for (size_t j=0; j< w; j++) ss += (x[j*st] - mean)*(x[j*st] - mean);
+    return ss/(w-1.L);
+}
+
+/* The windowed statistics share one loop shape: output i summarizes x[i..i+w), so
+   each step adds x[i+w-1] and drops x[i-1]. Sums are kept in long double, relative to
+   the first finite element. That keeps the add-one-drop-one updates exact for integer
+   data, but keeps the cancellation in the variance small only for data near that
+   element. A NaN or infinity would never cancel out of the running sums, so they
+   count only finite values; a window holding any others is summarized directly. */
+static void roll_sums(double const *x, size_t st, size_t n, size_t w, char stat, double *out, size_t ost){
+    long double shift = 0, s1 = 0, s2 = 0;
+    long nonfinite = 0;
+    for (size_t j=0; j< n; j++)
+        if (gsl_finite(x[j*st])) {shift = x[j*st]; break;}
+    #define Roll_in(val, sign) {double v_ = (val);                 \
+            if (!gsl_finite(v_)) nonfinite += sign;                \
+            else {long double d_ = v_ - shift; s1 += sign*d_; s2 += sign*d_*d_;}}
+    for (size_t j=0; j< w; j++) Roll_in(x[j*st], 1)
+    for (size_t i=0; i+w <= n; i++){
+        if (i){
+            Roll_in(x[(i+w-1)*st], 1)
+            Roll_in(x[(i-1)*st], -1)
+        }
+        out[i*ost] = nonfinite  ? window_direct(x+i*st, st, w, stat)
+                   : stat=='s' ? s1 + shift*w
+                   : stat=='m' ? shift + s1/w
+                   : (double)((w*s2 - s1*s1)/(w*(w-1.L)));
+    }
+    #undef Roll_in
+}
+
+/* Running min/max via a monotone deque: dq holds indices into the current window
+   whose values are strictly better than every later entry, so the front is the
+   extreme of the window. Each index is pushed and popped at most once. */
+static void roll_extreme(double const *x, size_t st, size_t n, size_t w, char stat, double *out, size_t ost){
+    size_t *dq = malloc(sizeof(size_t)*(w+1)), head = 0, ct = 0, cap = w+1;
+    #define Deque(k) dq[(head + (k)) % cap]
+    #define Beats(a, b) (stat=='<' ? (a) <= (b) : (a) >= (b))
+    for (size_t j=0; j< n; j++){
+        double xj = x[j*st];
+        while (ct && Beats(xj, x[Deque(ct-1)*st])) ct--;
+        Deque(ct) = j; ct++;
+        if (Deque(0) + w <= j) {head = (head+1) % cap; ct--;}
+        if (j+1 >= w) out[(j+1-w)*ost] = x[Deque(0)*st];
+    }
+    #undef Deque
+    #undef Beats
+    free(dq);
+}
+
+static void roll_ewma(double const *x, size_t st, size_t n, double lambda, double *out, size_t ost){
+    long double m = x[0];
+    for (size_t i=0; i< n; i++){
+        m += lambda * (x[i*st] - m);
+        out[i*ost] = m;
+    }
+}
+
+static size_t roll_out_size(size_t n, size_t bandwidth, char stat){
+    return stat=='e' ? n : n - (bandwidth/2)*2;
+}
+
+static void roll_into(gsl_vector const *v, gsl_vector *out, size_t bandwidth, char stat, double lambda){
+    size_t w = (bandwidth/2)*2 + 1;
+    if (stat=='e')                    roll_ewma(v->data, v->stride, v->size, lambda, out->data, out->stride);
+    else if (stat=='<' || stat=='>')  roll_extreme(v->data, v->stride, v->size, w, stat, out->data, out->stride);
+    else                              roll_sums(v->data, v->stride, v->size, w, stat, out->data, out->stride);
+}
+
+#define Check_rolling_args(size)                                                                  \
+    Apop_stopif(!strchr("smv<>e", stat) || !stat, return NULL, 0, "I don't know the windowed statistic '%c'. " \
+            "Options are 's' (sum), 'm' (mean), 'v' (variance), '<' (min), '>' (max), 'e' (exponentially weighted mean). Returning NULL.", stat); \
+    Apop_stopif(stat!='e' && !bandwidth, return NULL, 0, "Bandwidth must be >=1. Returning NULL."); \
+    Apop_stopif(stat=='v' && bandwidth < 2, return NULL, 0, "A windowed variance needs a bandwidth of at least two. Returning NULL."); \
+    Apop_stopif(stat!='e' && (size) < (bandwidth/2)*2 + 1, return NULL, 0, "Bandwidth wider than the vector. Returning NULL."); \
+    if (stat=='e' && gsl_isnan(lambda)) lambda = 2./(bandwidth+1.);                               \
+    Apop_stopif(stat=='e' && (lambda <= 0 || lambda > 1), return NULL, 0, "The smoothing weight lambda must be in (0, 1]. Returning NULL.");
+
+/** Windowed statistics in a single pass: each output element summarizes a centered window of
+the input, and the whole run takes time proportional to the length of the vector, not
+to the length times the bandwidth.
+
+\param v The input vector. (No default, must not be \c NULL.)
+\param bandwidth The width of the window. As with \ref apop_vector_moving_average, an even bandwidth is
+widened by one, so the window is centered. For the exponentially-weighted mean, this sets the default \c lambda. (Default: 3)
+\param stat Which statistic to calculate: <tt>'s'</tt>=sum; <tt>'m'</tt>=mean; <tt>'v'</tt>=sample variance;
+<tt>'<'</tt>=min; <tt>'>'</tt>=max; <tt>'e'</tt>=exponentially weighted mean. (Default: <tt>'m'</tt>)
+\param lambda For <tt>stat='e'</tt>, the weight on each new observation: \f$m_i = \lambda x_i + (1-\lambda)m_{i-1}\f$,
+with \f$m_0=x_0\f$. (Default: \f$2/({\rm bandwidth}+1)\f$)
+\return A vector of size <tt>v->size - (bandwidth/2)*2</tt>, where element \f$i\f$ summarizes
+input elements \f$i\f$ through \f$i+2\lfloor{\rm bandwidth}/2\rfloor\f$. For <tt>stat='e'</tt>, the output is the same size as the input.
+Returns \c NULL on bad input.
+
+\li Sums and variances are updated by adding the element entering the window and dropping the one leaving it, in <tt>long double</tt>.
+A \c NaN or infinity affects only the windows that include it.
+\li Min and max use a monotone deque, so they are also linear-time for any bandwidth.
+\li To apply these to every column of a data set in parallel, see \ref apop_data_rolling.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD gsl_vector *apop_vector_rolling(gsl_vector const *v, size_t bandwidth, char stat, double lambda){
+    gsl_vector const * apop_varad_var(v, NULL);
+    Apop_stopif(!v, return NULL, 0, "You asked me to smooth a NULL vector; returning NULL.");
+    size_t apop_varad_var(bandwidth, 3);
+    char apop_varad_var(stat, 'm');
+    double apop_varad_var(lambda, GSL_NAN);
+APOP_VAR_ENDHEAD
+    Check_rolling_args(v->size)
+    gsl_vector *out = gsl_vector_alloc(roll_out_size(v->size, bandwidth, stat));
+    roll_into(v, out, bandwidth, stat, lambda);
+    return out;
+}
+
+/** Apply \ref apop_vector_rolling to the vector and every column of the matrix of a data
+set. Columns are processed in parallel if Apophenia was compiled with OpenMP.
+
+\param d The input data set. (No default, must not be \c NULL.)
+\param bandwidth, stat, lambda As in \ref apop_vector_rolling. (Defaults: 3, <tt>'m'</tt>, \f$2/({\rm bandwidth}+1)\f$)
+\return A new data set with the vector and matrix smoothed, and the column names copied.
+Weights, text, and row names are not carried over. Returns \c NULL on bad input.
+
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data *apop_data_rolling(apop_data const *d, size_t bandwidth, char stat, double lambda){
+    apop_data const * apop_varad_var(d, NULL);
+    Apop_stopif(!d, return NULL, 0, "You asked me to smooth a NULL data set; returning NULL.");
+    Apop_stopif(!d->vector && !d->matrix, return NULL, 0, "Input data set has neither vector nor matrix; returning NULL.");
+    size_t apop_varad_var(bandwidth, 3);
+    char apop_varad_var(stat, 'm');
+    double apop_varad_var(lambda, GSL_NAN);
+APOP_VAR_ENDHEAD
+    size_t rows = d->vector ? d->vector->size : d->matrix->size1;
+    Check_rolling_args(rows)
+    size_t outrows = roll_out_size(rows, bandwidth, stat);
+    apop_data *out = apop_data_alloc(d->vector ? outrows : 0,
+                                     d->matrix ? outrows : 0, d->matrix ? d->matrix->size2 : 0);
+    if (d->names){
+        apop_name_stack(out->names, d->names, 'v');
+        apop_name_stack(out->names, d->names, 'c');
+        if (d->names->title) apop_name_add(out->names, d->names->title, 'h');
     }
-    return vout;
+    if (d->vector) roll_into(d->vector, out->vector, bandwidth, stat, lambda);
+    if (d->matrix)
+        OMP_for (size_t j=0; j< d->matrix->size2; j++)
+            roll_into(Apop_cv(d, j), Apop_cv(out, j), bandwidth, stat, lambda);
+    return out;
 }
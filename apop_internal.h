@@ -59,8 +59,10 @@ void apop_gsl_error(char const *reason, char const *file, int line, int gsl_errn
 #define OMP_critical(tag) PRAGMA(omp critical ( tag ))
 #define OMP_for(...) _Pragma("omp parallel for") for(__VA_ARGS__)
 #define OMP_for_reduce(red, ...) PRAGMA(omp parallel for reduction( red )) for(__VA_ARGS__)
+#define OMP_atomic(kind) PRAGMA(omp atomic kind)
 #else
 #define OMP_critical(tag)
+#define OMP_atomic(kind)
 #define OMP_for(...) for(__VA_ARGS__)
 #define OMP_for_reduce(red, ...) for(__VA_ARGS__)
 #endif
@@ -82,5 +84,55 @@ extern int vasprintf (char **res, const char *format, va_list args)
 
 #include "apop.h"
 void add_info_criteria(apop_data *d, apop_model *m, apop_model *est, double ll, int param_ct); //In apop_mle.c
+size_t apop_data_pack_size(const apop_data *in); //In apop_conversions.c
+
+//Copy-on-write sharing of row names and text grids. In apop_name.c and apop_data.c.
+void apop_ref_add(int *refs);
+int apop_ref_release(int *refs);
+int apop_ref_shared(int *refs);
+void apop_name_unshare_rows(apop_name *n);
+void apop_name_own_rows(apop_name *n);
+void apop_name_copy_to(apop_name *out, apop_name *in);
+void apop_text_unshare(apop_data *d);
+
+//The rows not marked in gone, as a new set. In apop_data.c, for apop_missing_data.c.
+apop_data *apop_data_gather_rows(apop_data *in, int const *gone, size_t len);
+
+//Build a packed text grid cell by cell, in row-major order. In apop_data.c.
+typedef struct apop_text_builder apop_text_builder;
+apop_text_builder *apop_text_builder_alloc(size_t cols, char dictionary);
+void apop_text_builder_add(apop_text_builder *b, char const *s);
+void apop_text_builder_finish(apop_text_builder *b, apop_data *d);
+
+#include <stdint.h>
+/* A hash set of distinct numbers or strings, for factors and crosstabs. In apop_regression.c.
+   Open addressing with linear probing; the slots hold 1+the index of the key in the key
+   list (zero marks an empty slot), so the key list is in order of first appearance.
+   Numeric keys compare as in apop_vector_unique_elements (so all NaNs are one key and
+   -0==0); text keys via strcmp. Text keys are not copied: they point to the caller's strings. */
+typedef struct {
+    char type;            //'d' or 't'
+    size_t count, cap;    //cap is always a power of two
+    size_t *slots;
+    uint64_t *hashes;     //one per slot, to skip most key comparisons
+    double *dkeys;
+    char const **tkeys;
+    size_t keycap;
+} apop_distinct;
+int apop_distinct_init(apop_distinct *h, char type, size_t expected);
+void apop_distinct_free(apop_distinct *h);
+ptrdiff_t apop_distinct_find(apop_distinct const *h, double dv, char const *tv); //-1 if absent
+ptrdiff_t apop_distinct_add(apop_distinct *h, double dv, char const *tv); //-1 on allocation failure
+
+//Each row's index in the sorted list of a column's distinct values, whose labels are added to names.
+size_t *apop_factor_index(apop_data *d, int col, char type, apop_name *names, char nametype, size_t *ct);
+
+//Build a crosstab from (row label, column label, value) triples. In apop_conversions.c.
+//A label's kind is 'n' for a NULL, 'd' for a number, or 't' for text, and sorts in that order.
+typedef struct apop_crosstab_builder apop_crosstab_builder;
+apop_crosstab_builder *apop_crosstab_builder_alloc(void);
+int apop_crosstab_builder_add(apop_crosstab_builder *b, char const *labels[2], char const kinds[2], double val);
+apop_data *apop_crosstab_builder_finish(apop_crosstab_builder *b);
+int apop_query_to_crosstab_builder(char const *query, apop_crosstab_builder *b); //In apop_db.c
 
 apop_model *maybe_prep(apop_data *d, apop_model *m, _Bool *is_a_copy); //in apop_mcmc, for apop_update.
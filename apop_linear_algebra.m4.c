@@ -6,6 +6,9 @@ columns, check bounds, et cetera.
 /* Copyright (c) 2006--2007, 2012 by Ben Klemens.  Licensed under the GPLv2; see COPYING.  */
 
 #include "apop_internal.h"
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
 void apop_gsl_error(const char *reason, const char *file, int line, int gsl_errno){
     Apop_notify(1, "%s: %s", file, reason);
@@ -85,6 +88,256 @@ double apop_matrix_determinant(const gsl_matrix *in) {
     return apop_det_and_inv(in, NULL, 1, 0);
 }
 
+/* Cholesky-decompose \c m in place. Failure just means \c m is not positive definite
+   and the caller will fall back to LU, so the GSL error handler is off for the attempt. */
+static int cholesky_quietly(gsl_matrix *m){
+    gsl_error_handler_t *prior_handler = gsl_set_error_handler_off();
+    int status = gsl_linalg_cholesky_decomp(m);
+    gsl_set_error_handler(prior_handler);
+    return status;
+}
+
+/**
+Calculate the log determinant of a symmetric positive definite matrix, its inverse, or
+both, via Cholesky decomposition. The \c in matrix is not destroyed in the process.
+
+This is the routine to use for covariance matrices, \f$X'X\f$, and other symmetric
+positive definite matrices. The Cholesky decomposition takes about half the flops
+of the LU decomposition used by \ref apop_det_and_inv, and the log determinant is
+the sum of logs of the factor's diagonal, so it does not overflow or underflow for
+large matrices the way the determinant itself does.
+
+\see apop_matrix_spd_inverse, apop_matrix_spd_logdet, apop_matrix_spd_solve
+
+\param in The symmetric matrix to be inverted/determined. Only the lower triangle is read.
+\param out If you want an inverse, this is where to place the matrix to be filled with the inverse. Will be allocated by the function.
+\param calc_logdet 0: Do not calculate the log determinant. 1: Do.
+\param calc_inv 0: Do not calculate the inverse. 1: Do.
+
+\return If <tt>calc_logdet == 1</tt>, then return the natural log of the determinant. Otherwise, just returns zero.
+If <tt>calc_inv!=0</tt>, then \c *out is pointed to the matrix inverse. In case of difficulty, I will set <tt>*out=NULL</tt> and return \c NaN.
+
+\li If \c in is not positive definite, I fall back to the LU decomposition, so you
+still get an inverse for any nonsingular matrix. The log determinant is then
+\c -INFINITY if the matrix is singular and \c NaN if the determinant is negative.
+*/
+double apop_spd_logdet_and_inv(const gsl_matrix *in, gsl_matrix **out, int calc_logdet, int calc_inv){
+    if (out) *out = NULL;
+    Apop_stopif(in->size1 != in->size2, return GSL_NAN, 0, "You asked me to invert a %zu X %zu matrix, "
+            "but inversion requires a square matrix.", in->size1, in->size2);
+    Set_gsl_handler
+    size_t n = in->size1;
+    double logdet = calc_logdet ? GSL_NAN : 0;
+    gsl_permutation *perm = NULL;
+    gsl_matrix *factor = gsl_matrix_alloc(n, n);
+    gsl_matrix_memcpy(factor, in);
+    if (!cholesky_quietly(factor)){
+        if (calc_logdet){
+            long double total = 0;
+            for (size_t i=0; i< n; i++)
+                total += log(gsl_matrix_get(factor, i, i));
+            logdet = 2*total;
+        }
+        if (calc_inv){
+            Checkgsl(gsl_linalg_cholesky_invert(factor))
+            *out = factor;
+            factor = NULL;
+        }
+    } else {
+        Apop_notify(2, "The %zu X %zu matrix is not positive definite; falling back to LU decomposition.", n, n);
+        int sign;
+        perm = gsl_permutation_alloc(n);
+        gsl_matrix_memcpy(factor, in);
+        Checkgsl(gsl_linalg_LU_decomp(factor, perm, &sign))
+        if (calc_logdet){
+            double lndet = gsl_linalg_LU_lndet(factor);
+            logdet = isinf(lndet) || gsl_linalg_LU_sgndet(factor, sign) > 0 ? lndet : GSL_NAN;
+        }
+        if (calc_inv){
+            *out = gsl_matrix_alloc(n, n);
+            Check_gsl_with_outmp(gsl_linalg_LU_invert(factor, perm, *out))
+        }
+    }
+    done:
+    if (factor) gsl_matrix_free(factor);
+    if (perm) gsl_permutation_free(perm);
+    Unset_gsl_handler
+    return logdet;
+}
+
+/**
+Invert a symmetric positive definite matrix via Cholesky decomposition. The \c in matrix is not destroyed in the process.
+If \c in is not positive definite, this falls back to the LU decomposition, as per \ref apop_spd_logdet_and_inv.
+
+\param in The matrix to be inverted.
+\return Its inverse, or \c NULL on failure.
+*/
+gsl_matrix * apop_matrix_spd_inverse(const gsl_matrix *in){
+    gsl_matrix *out = NULL;
+    apop_spd_logdet_and_inv(in, &out, 0, 1);
+    return out;
+}
+
+/**
+Find the natural log of the determinant of a symmetric positive definite matrix, via Cholesky decomposition.
+The \c in matrix is not destroyed in the process.
+
+\param in The matrix to be determined.
+\return The log determinant. If the matrix is singular, \c -INFINITY; if the determinant is negative, \c NaN.
+*/
+double apop_matrix_spd_logdet(const gsl_matrix *in){
+    return apop_spd_logdet_and_inv(in, NULL, 1, 0);
+}
+
+/**
+Solve \f$Ax = b\f$ for a symmetric positive definite \f$A\f$, without forming \f$A^{-1}\f$.
+Neither \c A nor \c b is destroyed in the process.
+
+If all you need from an inverse is its product with a vector, as with \f$(X'X)^{-1}X'y\f$,
+this is both faster and more accurate than \ref apop_matrix_spd_inverse followed by a
+matrix-vector product.
+
+\param A The symmetric, square matrix. Only the lower triangle is read.
+\param b The right-hand side.
+\param x The output vector, already allocated to the same size as \c b.
+\return Zero on success; a GSL error code on failure.
+
+\li If \c A is not positive definite, I fall back to the LU decomposition.
+*/
+int apop_matrix_spd_solve(const gsl_matrix *A, const gsl_vector *b, gsl_vector *x){
+    Apop_stopif(A->size1 != A->size2 || A->size1 != b->size || b->size != x->size, return GSL_EBADLEN,
+            0, "I need a square matrix and two vectors of matching size; got a %zu X %zu matrix "
+            "and vectors of size %zu and %zu.", A->size1, A->size2, b->size, x->size);
+    size_t n = A->size1;
+    int status;
+    gsl_matrix *factor = gsl_matrix_alloc(n, n);
+    gsl_matrix_memcpy(factor, A);
+    if (!cholesky_quietly(factor))
+        status = gsl_linalg_cholesky_solve(factor, b, x);
+    else {
+        Apop_notify(2, "The %zu X %zu matrix is not positive definite; falling back to LU decomposition.", n, n);
+        Set_gsl_handler
+        int sign;
+        gsl_permutation *perm = gsl_permutation_alloc(n);
+        gsl_matrix_memcpy(factor, A);
+        status = gsl_linalg_LU_decomp(factor, perm, &sign);
+        if (!status) status = gsl_linalg_LU_solve(factor, perm, b, x);
+        gsl_permutation_free(perm);
+        Unset_gsl_handler
+    }
+    gsl_matrix_free(factor);
+    return status;
+}
+
+/* Truncated PCA via randomized subspace iteration; see Halko, Martinsson, and Tropp,
+   <em>Finding structure with randomness</em>, SIAM Review 53(2), 2011. A random d X l
+   basis is repeatedly multiplied by the covariance and re-orthonormalized; the top
+   eigenvectors of the small l X l projection of the covariance onto that basis,
+   rotated back to d dimensions, are the top eigenvectors of the covariance. The
+   covariance is only ever applied to a d X l matrix, via the apply function. */
+typedef void (*pca_apply_fn)(void const *aux, gsl_matrix const *q, gsl_matrix *z);
+
+static const size_t pca_oversample = 10;
+static const int pca_power_iterations = 4;
+static const size_t pca_chunk_doubles = 1<<18; //rows per chunk are set so a chunk is about 2MB.
+
+//Modified Gram-Schmidt, twice, on the columns of q. A column that has collapsed is redrawn.
+static void orthonormalize(gsl_matrix *q, gsl_rng *r){
+    for (size_t j=0; j< q->size2; j++){
+        gsl_vector *qj = Apop_mcv(q, j);
+        for (int tries=0; tries< 3; tries++){
+            for (int pass=0; pass< 2; pass++)
+                for (size_t i=0; i< j; i++){
+                    double dot;
+                    gsl_blas_ddot(Apop_mcv(q, i), qj, &dot);
+                    gsl_blas_daxpy(-dot, Apop_mcv(q, i), qj);
+                }
+            double norm = gsl_blas_dnrm2(qj);
+            if (norm > 1e-12){
+                gsl_vector_scale(qj, 1/norm);
+                break;
+            }
+            for (size_t i=0; i< qj->size; i++) gsl_vector_set(qj, i, gsl_ran_gaussian(r, 1));
+        }
+    }
+}
+
+static void randomized_pca(pca_apply_fn apply, void const *aux, double total, apop_data *pc_space){
+    size_t d = pc_space->matrix->size1, k = pc_space->matrix->size2;
+    size_t l = GSL_MIN(k + pca_oversample, d);
+    gsl_rng *r = apop_rng_get_thread();
+    gsl_matrix *q = gsl_matrix_alloc(d, l), *z = gsl_matrix_alloc(d, l);
+    gsl_matrix *t = gsl_matrix_alloc(l, l), *u = gsl_matrix_alloc(l, l);
+    gsl_vector *evalues = gsl_vector_alloc(l);
+    for (size_t i=0; i< d; i++)
+        for (size_t j=0; j< l; j++)
+            gsl_matrix_set(q, i, j, gsl_ran_gaussian(r, 1));
+    orthonormalize(q, r);
+    for (int pass=0; ; pass++){
+        apply(aux, q, z);
+        if (pass == pca_power_iterations) break;
+        gsl_matrix_memcpy(q, z);
+        orthonormalize(q, r);
+    }
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, q, z, 0, t); //Q'CQ
+    for (size_t i=0; i< l; i++)
+        for (size_t j=0; j< i; j++){
+            double mean = (gsl_matrix_get(t, i, j) + gsl_matrix_get(t, j, i))/2;
+            gsl_matrix_set(t, i, j, mean);
+            gsl_matrix_set(t, j, i, mean);
+        }
+    gsl_eigen_symmv_workspace *w = gsl_eigen_symmv_alloc(l);
+    gsl_eigen_symmv(t, evalues, u, w);
+    gsl_eigen_symmv_free(w);
+    gsl_eigen_symmv_sort(evalues, u, GSL_EIGEN_SORT_VAL_DESC);
+    gsl_matrix_view top_u = gsl_matrix_submatrix(u, 0, 0, l, k);
+    gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, q, &top_u.matrix, 0, pc_space->matrix);
+    for (size_t i=0; i< k; i++)
+        gsl_vector_set(pc_space->vector, i, gsl_vector_get(evalues, i)/total);
+    gsl_matrix_free(q); gsl_matrix_free(z);
+    gsl_matrix_free(t); gsl_matrix_free(u);
+    gsl_vector_free(evalues);
+}
+
+static int pca_thread_ct(void){
+    #ifdef _OPENMP
+        return omp_get_max_threads();
+    #else
+        return 1;
+    #endif
+}
+
+//z = X'XQ for column-centered X, reading X in row slabs, one slab per thread.
+static void pca_apply_data(void const *x_in, gsl_matrix const *q, gsl_matrix *z){
+    gsl_matrix const *x = x_in;
+    size_t n = x->size1, d = x->size2, l = q->size2;
+    size_t slab_ct = GSL_MIN(pca_thread_ct(), n);
+    size_t chunk_rows = GSL_MAX(64, pca_chunk_doubles/GSL_MAX(l, 1));
+    gsl_matrix_set_zero(z);
+    OMP_for (size_t s=0; s< slab_ct; s++){
+        size_t first = n*s/slab_ct, last = n*(s+1)/slab_ct;
+        apop_arena_begin();
+        gsl_matrix *local = apop_arena_matrix(d, l);
+        gsl_matrix *xq = apop_arena_matrix(GSL_MIN(chunk_rows, last-first), l);
+        gsl_matrix_set_zero(local);
+        for (size_t i=first; i< last; i+=chunk_rows){
+            size_t rows = GSL_MIN(chunk_rows, last-i);
+            gsl_matrix_const_view xc = gsl_matrix_const_submatrix(x, i, 0, rows, d);
+            gsl_matrix_view xqc = gsl_matrix_submatrix(xq, 0, 0, rows, l);
+            gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, &xc.matrix, q, 0, &xqc.matrix);
+            gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, &xc.matrix, &xqc.matrix, 1, local);
+        }
+        OMP_critical(pca_apply_data)
+        gsl_matrix_add(z, local);
+        apop_arena_end();
+    }
+}
+
+//z = CQ for a symmetric C held in full.
+static void pca_apply_cov(void const *c, gsl_matrix const *q, gsl_matrix *z){
+    gsl_blas_dsymm(CblasLeft, CblasLower, 1, c, q, 0, z);
+}
+
 /** Principal component analysis: hand in a matrix and (optionally) a number of desired dimensions, and I'll return a data set where each column of the matrix is an eigenvector. The columns are sorted, so column zero has the greatest weight. The vector element of the data set gives the weights.
 
 You may also specify the number of elements your principal component space should have. If
@@ -99,6 +352,16 @@ mean zero. (No default. If \c NULL, return \c NULL and print a warning iff
 
 \param dimensions_we_want The singular value decomposition will return this many of the eigenvectors with the largest eigenvalues. (default: the size of the covariance matrix, i.e. <tt>data->size2</tt>)
 
+\param method \c 'd': Dense. Form the full \f$X'X\f$ matrix and find its complete
+singular value decomposition.<br>
+\c 'r': Randomized. Find only the requested components, via randomized subspace iteration
+(Halko, Martinsson, and Tropp, 2011). Each of the five passes through the data is a pair of
+blocked matrix multiplications against a <tt>data->size2</tt> \f$\times\f$ (<tt>dimensions_we_want</tt>+10)
+matrix, with blocks of rows handled in parallel, and \f$X'X\f$ is never formed.
+For a few components of wide data, this is far faster than the dense decomposition.
+The result is approximate, but for data with any gap between the wanted eigenvalues and the
+rest, it matches the dense result to many digits. (default: \c 'd')
+
 \return  Returns an \ref apop_data set whose matrix is the principal component
 space. Each column of the returned matrix will be another eigenvector; the columns
 will be ordered by the eigenvalues.
@@ -106,11 +369,17 @@ will be ordered by the eigenvalues.
 The data set's vector will be the largest eigenvalues, scaled by the total of all eigenvalues (including those that were thrown out). The sum of these returned values will give you the percentage of variance explained by the factor analysis.
 
 \exception out->error=='a'  Allocation error.
+
+\li For data too large to hold in memory, see \ref apop_pca_blocks_alloc.
+\li This function uses the \ref designated syntax for inputs.
 */
-APOP_VAR_HEAD apop_data * apop_matrix_pca(gsl_matrix *data, int const dimensions_we_want) {
+APOP_VAR_HEAD apop_data * apop_matrix_pca(gsl_matrix *data, int const dimensions_we_want, char method) {
     gsl_matrix * apop_varad_var(data, NULL);
     Apop_stopif(!data, return NULL, 1, "NULL data input");
     int const apop_varad_var(dimensions_we_want, data->size2);
+    Apop_stopif(dimensions_we_want < 1 || dimensions_we_want > data->size2, return NULL, 0,
+            "You asked for %i dimensions of %zu-dimensional data.", dimensions_we_want, data->size2);
+    char apop_varad_var(method, 'd');
 APOP_VAR_ENDHEAD
     Set_gsl_handler
     apop_data *pc_space	= apop_data_alloc(0, data->size2, dimensions_we_want);
@@ -118,6 +387,19 @@ APOP_VAR_ENDHEAD
 	pc_space->vector = gsl_vector_alloc(dimensions_we_want);
     Apop_stopif(!pc_space->vector, pc_space->error='a'; return pc_space, 
                 0, "Allocation error setting up a %i vector.", dimensions_we_want);
+    for (int i=0; i< data->size2; i++)
+        apop_vector_normalize(Apop_mcv(data, i), NULL, 'm');
+    if (method == 'r'){
+        long double total = 0; //trace of X'X
+        for (size_t i=0; i< data->size1; i++){
+            double ss;
+            gsl_blas_ddot(Apop_mrv(data, i), Apop_mrv(data, i), &ss);
+            total += ss;
+        }
+        randomized_pca(pca_apply_data, data, total, pc_space);
+        Unset_gsl_handler
+        return pc_space;
+    }
     gsl_matrix *eigenvectors = gsl_matrix_alloc(data->size2, data->size2);
     gsl_vector *dummy_v 	 = gsl_vector_alloc(data->size2);
     gsl_vector *all_evalues  = gsl_vector_alloc(data->size2);
@@ -125,8 +407,6 @@ APOP_VAR_ENDHEAD
     Apop_stopif(!eigenvectors || !dummy_v || !all_evalues || !square, pc_space->error='a'; return pc_space, 
                 0, "Allocation error setting up workspace for %zu dimensions.", data->size2);
     double eigentotals	= 0;
-    for (int i=0; i< data->size2; i++)
-        apop_vector_normalize(Apop_mcv(data, i), NULL, 'm');
 
 	Checkgsl(gsl_blas_dgemm(CblasTrans,CblasNoTrans, 1, data, data, 0, square))
 	Checkgsl(gsl_linalg_SV_decomp(square, eigenvectors, all_evalues, dummy_v))
@@ -144,6 +424,156 @@ APOP_VAR_ENDHEAD
     return pc_space;
 }
 
+/** Allocate an accumulator for principal component analysis of data sent in blocks of
+rows, for data sets too large to hold in memory. Send each block to \ref
+apop_pca_blocks_add, then call \ref apop_pca_blocks_estimate.
+
+\code
+apop_pca_blocks *acc = apop_pca_blocks_alloc();
+apop_query_to_blocks(1e5, apop_pca_blocks_add, acc, "select * from bigtable");
+apop_data *pcs = apop_pca_blocks_estimate(acc, 3, 'r');
+apop_pca_blocks_free(acc);
+\endcode
+
+Only one pass through the data is made. Each block is centered on its own mean, its
+cross-product matrix is found with blocks of rows in parallel, and it is merged into the
+running total via the pairwise update of Chan, Golub, and LeVeque, which avoids the
+cancellation error of accumulating raw sums of squares. Memory use is one
+<tt>columns</tt> \f$\times\f$ <tt>columns</tt> matrix, regardless of the number of rows.
+
+\return An empty accumulator.
+*/
+apop_pca_blocks *apop_pca_blocks_alloc(void){
+    apop_pca_blocks *out = malloc(sizeof(apop_pca_blocks));
+    *out = (apop_pca_blocks){.d=0};
+    return out;
+}
+
+void apop_pca_blocks_free(apop_pca_blocks *acc){
+    if (!acc) return;
+    if (acc->cross) gsl_matrix_free(acc->cross);
+    if (acc->mean) gsl_vector_free(acc->mean);
+    free(acc);
+}
+
+/* Fold a group of n_b rows with mean mean_b and centered cross-products cross_b (lower
+   triangle) into the running n, mean, and cross. delta is scratch space. */
+static void pca_merge(size_t *n, gsl_vector *mean, gsl_matrix *cross, size_t n_b,
+                        gsl_vector const *mean_b, gsl_matrix const *cross_b, gsl_vector *delta){
+    if (!n_b) return;
+    double total = *n + n_b;
+    gsl_vector_memcpy(delta, mean_b);
+    gsl_vector_sub(delta, mean);
+    gsl_matrix_add(cross, cross_b);
+    gsl_blas_dsyr(CblasLower, *n*(double)n_b/total, delta, cross);
+    gsl_blas_daxpy(n_b/total, delta, mean);
+    *n += n_b;
+}
+
+/** Add a block of rows to a principal component accumulator. See \ref apop_pca_blocks_alloc.
+
+\param block The data. Only the \c matrix is used, and it is not modified.
+\param acc The \ref apop_pca_blocks accumulator. This is a <tt>void*</tt> so that this
+    function can be sent directly to \ref apop_query_to_blocks.
+\return Zero on success; \c 'd' if the block has a different number of columns than the first block.
+*/
+int apop_pca_blocks_add(apop_data *block, void *acc_in){
+    apop_pca_blocks *acc = acc_in;
+    Apop_stopif(!acc, return 'n', 0, "NULL accumulator.");
+    if (!block || !block->matrix) return 0;
+    size_t n = block->matrix->size1, d = block->matrix->size2;
+    if (!acc->cross){
+        acc->d = d;
+        acc->cross = gsl_matrix_calloc(d, d);
+        acc->mean = gsl_vector_calloc(d);
+    }
+    Apop_stopif(d != acc->d, acc->error='d'; return 'd', 0,
+            "This block has %zu columns, but the first had %zu.", d, acc->d);
+    size_t slab_ct = GSL_MIN(pca_thread_ct(), n);
+    size_t chunk_rows = GSL_MAX(64, pca_chunk_doubles/d);
+    OMP_for (size_t s=0; s< slab_ct; s++){
+        size_t first = n*s/slab_ct, last = n*(s+1)/slab_ct, slab_n = 0;
+        apop_arena_begin();
+        gsl_matrix *slab_cross = apop_arena_matrix(d, d);
+        gsl_matrix *chunk_cross = apop_arena_matrix(d, d);
+        gsl_matrix *centered = apop_arena_matrix(GSL_MIN(chunk_rows, last-first), d);
+        gsl_vector *slab_mean = apop_arena_vector(d);
+        gsl_vector *chunk_mean = apop_arena_vector(d);
+        gsl_vector *delta = apop_arena_vector(d);
+        gsl_matrix_set_zero(slab_cross);
+        gsl_vector_set_zero(slab_mean);
+        for (size_t i=first; i< last; i+=chunk_rows){
+            size_t rows = GSL_MIN(chunk_rows, last-i);
+            gsl_matrix_view c = gsl_matrix_submatrix(centered, 0, 0, rows, d);
+            gsl_matrix_const_view xc = gsl_matrix_const_submatrix(block->matrix, i, 0, rows, d);
+            gsl_matrix_memcpy(&c.matrix, &xc.matrix);
+            gsl_vector_set_zero(chunk_mean);
+            for (size_t r=0; r< rows; r++)
+                gsl_vector_add(chunk_mean, Apop_mrv(&c.matrix, r));
+            gsl_vector_scale(chunk_mean, 1./rows);
+            for (size_t r=0; r< rows; r++)
+                gsl_vector_sub(Apop_mrv(&c.matrix, r), chunk_mean);
+            gsl_blas_dsyrk(CblasLower, CblasTrans, 1, &c.matrix, 0, chunk_cross);
+            pca_merge(&slab_n, slab_mean, slab_cross, rows, chunk_mean, chunk_cross, delta);
+        }
+        OMP_critical(pca_blocks_add)
+        pca_merge(&acc->n, acc->mean, acc->cross, slab_n, slab_mean, slab_cross, delta);
+        apop_arena_end();
+    }
+    return 0;
+}
+
+/** Principal component analysis on the data accumulated via \ref apop_pca_blocks_add.
+The output is as per \ref apop_matrix_pca, and the accumulator is not modified, so you
+can keep adding blocks and estimate again.
+
+\param acc The accumulator. (No default.)
+\param dimensions_we_want The number of components to return. (default: all of them, \c acc->d)
+\param method \c 'd': find the complete eigendecomposition of the accumulated covariance
+    matrix. \c 'r': find only the wanted components, via randomized subspace iteration on
+    the covariance. See \ref apop_matrix_pca. (default: \c 'd')
+
+\return An \ref apop_data set whose matrix columns are the eigenvectors and whose vector is the
+    share of total variance each explains. \c NULL if no data has been accumulated.
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD apop_data * apop_pca_blocks_estimate(apop_pca_blocks *acc, int dimensions_we_want, char method){
+    apop_pca_blocks * apop_varad_var(acc, NULL);
+    Apop_stopif(!acc || !acc->cross, return NULL, 1, "No data has been accumulated.");
+    int apop_varad_var(dimensions_we_want, acc->d);
+    Apop_stopif(dimensions_we_want < 1 || dimensions_we_want > acc->d, return NULL, 0,
+            "You asked for %i dimensions of %zu-dimensional data.", dimensions_we_want, acc->d);
+    char apop_varad_var(method, 'd');
+APOP_VAR_ENDHEAD
+    size_t d = acc->d;
+    apop_data *pc_space = apop_data_alloc(dimensions_we_want, d, dimensions_we_want);
+    Apop_stopif(pc_space->error, return pc_space, 0, "Allocation error.");
+    gsl_matrix *cov = apop_matrix_copy(acc->cross);
+    for (size_t i=0; i< d; i++)
+        for (size_t j=i+1; j< d; j++)
+            gsl_matrix_set(cov, i, j, gsl_matrix_get(cov, j, i));
+    gsl_vector_view diag = gsl_matrix_diagonal(cov);
+    double total = apop_sum(&diag.vector);
+    if (method == 'r')
+        randomized_pca(pca_apply_cov, cov, total, pc_space);
+    else {
+        gsl_vector *evalues = gsl_vector_alloc(d);
+        gsl_matrix *evectors = gsl_matrix_alloc(d, d);
+        gsl_eigen_symmv_workspace *w = gsl_eigen_symmv_alloc(d);
+        gsl_eigen_symmv(cov, evalues, evectors, w); //destroys the lower triangle of cov.
+        gsl_eigen_symmv_free(w);
+        gsl_eigen_symmv_sort(evalues, evectors, GSL_EIGEN_SORT_VAL_DESC);
+        for (int i=0; i< dimensions_we_want; i++){
+            gsl_matrix_set_col(pc_space->matrix, i, Apop_mcv(evectors, i));
+            gsl_vector_set(pc_space->vector, i, gsl_vector_get(evalues, i)/total);
+        }
+        gsl_vector_free(evalues);
+        gsl_matrix_free(evectors);
+    }
+    gsl_matrix_free(cov);
+    return pc_space;
+}
+
 static void l10(double *d){ *d = log10(*d); }
 static void ln(double *d){ *d = log(*d); }
 static void ex(double *d){ *d = exp(*d); }
@@ -319,14 +749,101 @@ APOP_VAR_END_HEAD
 }
 
 
-static gsl_vector* dot_for_apop_dot(const gsl_matrix *m, const gsl_vector *v, 
-                             const CBLAS_TRANSPOSE_t flip){
-    #define Check_gslv(...) if (__VA_ARGS__) {gsl_vector_free(out); out=NULL;}
-    gsl_vector *out = (flip ==CblasNoTrans)
-                        ? gsl_vector_calloc(m->size1)
-                        : gsl_vector_calloc(m->size2);
-    Check_gslv(gsl_blas_dgemv (flip, 1.0, m, v, 0.0, out))
-    return out;
+//Use the caller's output element if it exists and is the right size; else allocate it.
+static gsl_matrix *dot_out_matrix(apop_data *out, size_t rows, size_t cols){
+    if (!out->matrix) return (out->matrix = gsl_matrix_calloc(rows, cols));
+    Apop_stopif(out->matrix->size1 != rows || out->matrix->size2 != cols, out->error='d'; return NULL,
+            0, "The output matrix is %zuX%zu, but the product is %zuX%zu.",
+            out->matrix->size1, out->matrix->size2, rows, cols);
+    return out->matrix;
+}
+
+static gsl_vector *dot_out_vector(apop_data *out, size_t size){
+    if (!out->vector) return (out->vector = gsl_vector_calloc(size));
+    Apop_stopif(out->vector->size != size, out->error='d'; return NULL,
+            0, "The output vector has size %zu, but the product has size %zu.", out->vector->size, size);
+    return out->vector;
+}
+
+//X'X or XX': compute one triangle via dsyrk and reflect it.
+static int dot_syrk(const gsl_matrix *m, CBLAS_TRANSPOSE_t t, double alpha, gsl_matrix *out){
+    int err = gsl_blas_dsyrk(CblasLower, t, alpha, m, 0, out);
+    for (size_t i=0; i< out->size1; i++)
+        for (size_t j=i+1; j< out->size2; j++)
+            gsl_matrix_set(out, i, j, gsl_matrix_get(out, j, i));
+    return err;
+}
+
+#define Is_tri(hint) ((hint)=='l' || (hint)=='u')
+#define Uplo(hint) ((hint)=='u' ? CblasUpper : CblasLower)
+
+/* Fill in the triangle of m that its hint says is not to be read: mirror the read
+   triangle for a symmetric matrix, zero it for a triangular one. If m is a transposed
+   copy, the read triangle has moved to the other side. */
+static void dot_fill_triangle(gsl_matrix *m, char hint, int transposed){
+    int lower_read = (hint == 'u') == transposed;
+    for (size_t i=0; i< m->size1; i++)
+        for (size_t j=i+1; j< m->size2; j++){
+            double *lo = gsl_matrix_ptr(m, j, i), *up = gsl_matrix_ptr(m, i, j);
+            if (lower_read) *up = hint == 's' ? *lo : 0;
+            else            *lo = hint == 's' ? *up : 0;
+        }
+}
+
+//Copy op(m) to out, with the unread triangle (if any) filled in.
+static int dot_copy_op(gsl_matrix *out, const gsl_matrix *m, CBLAS_TRANSPOSE_t t, char hint){
+    int err = t == CblasTrans ? gsl_matrix_transpose_memcpy(out, m) : gsl_matrix_memcpy(out, m);
+    if (!err && hint) dot_fill_triangle(out, hint, t == CblasTrans);
+    return err;
+}
+
+/* alpha op(tri) op(other) (or the reverse, for side=CblasRight) + beta out. dtrmm works
+   in place, so op(other) goes to the output, or to scratch if beta needs the output. */
+static int dot_trmm(CBLAS_SIDE_t side, const gsl_matrix *tri, CBLAS_TRANSPOSE_t tt, char hint,
+                    const gsl_matrix *other, CBLAS_TRANSPOSE_t ot, char ohint,
+                    double alpha, double beta, gsl_matrix *out){
+    gsl_matrix *work = beta ? gsl_matrix_alloc(out->size1, out->size2) : out;
+    if (!work) return GSL_ENOMEM;
+    int err = dot_copy_op(work, other, ot, ohint);
+    if (!err) err = gsl_blas_dtrmm(side, Uplo(hint), tt, CblasNonUnit, alpha, tri, work);
+    if (!err && beta){
+        gsl_matrix_scale(out, beta);
+        err = gsl_matrix_add(out, work);
+    }
+    if (beta) gsl_matrix_free(work);
+    return err;
+}
+
+/* alpha sym op(other) (or the reverse) + beta out. dsymm can't transpose the other
+   operand or fill in its triangle, so those cases go via a copy. */
+static int dot_symm(CBLAS_SIDE_t side, const gsl_matrix *sym, const gsl_matrix *other,
+                    CBLAS_TRANSPOSE_t ot, char ohint, double alpha, double beta, gsl_matrix *out){
+    gsl_matrix *copy = NULL;
+    if (ot == CblasTrans || ohint){
+        copy = ot == CblasTrans ? gsl_matrix_alloc(other->size2, other->size1)
+                                : gsl_matrix_alloc(other->size1, other->size2);
+        if (!copy) return GSL_ENOMEM;
+        dot_copy_op(copy, other, ot, ohint);
+        other = copy;
+    }
+    int err = gsl_blas_dsymm(side, CblasLower, alpha, sym, other, beta, out);
+    if (copy) gsl_matrix_free(copy);
+    return err;
+}
+
+//alpha op(tri) v + beta out, via dtrmv, which also works in place.
+static int dot_trmv(const gsl_matrix *tri, CBLAS_TRANSPOSE_t t, char hint, const gsl_vector *v,
+                    double alpha, double beta, gsl_vector *out){
+    gsl_vector *work = beta ? gsl_vector_alloc(out->size) : out;
+    if (!work) return GSL_ENOMEM;
+    int err = gsl_vector_memcpy(work, v);
+    if (!err) err = gsl_blas_dtrmv(Uplo(hint), t, CblasNonUnit, tri, work);
+    if (!err && beta){
+        gsl_vector_scale(out, beta);
+        err = gsl_blas_daxpy(alpha, work, out);
+    } else if (!err && alpha != 1) gsl_vector_scale(out, alpha);
+    if (beta) gsl_vector_free(work);
+    return err;
 }
 
 /** A convenience function for dot products, which requires less prep and typing than the <tt>gsl_cblas_dgexx</tt> functions.
@@ -340,7 +857,19 @@ It makes use of the semi-overloading of the \ref apop_data structure. \c d1 may
                     'v': ignore the matrix and use the vector.
 
 \param form2 As above, with \c d2.
-\return     an \ref apop_data set. If two matrices come in, the vector element is \c NULL and the 
+\param out If not \c NULL, write the product here instead of allocating a new \ref
+apop_data set. The product goes to <tt>out->matrix</tt> or <tt>out->vector</tt> as
+below; if that element is \c NULL, I allocate it, and if not, it must be the right size. The
+names of \c out are not modified. (default: \c NULL)
+\param alpha Scale the product by this. (default: 1)
+\param beta If nonzero, add \c beta times the prior contents of the output, giving
+\f$\alpha d1\cdot d2 + \beta out\f$. (default: 0)
+\param hint1 \c 'l' or \c 'u': the matrix of \c d1 is square and lower- or
+upper-triangular, and the other triangle is not read; \c 's': the matrix is symmetric,
+and only its lower triangle is read. Lets me call a cheaper BLAS routine. These hold with
+or without \c beta and transposition. (default: 0, a general matrix)
+\param hint2 As above, with \c d2.
+\return     an \ref apop_data set (\c out, if you provided one). If two matrices come in, the vector element is \c NULL and the 
             matrix has the dot product; if either or both are vectors,
             the vector has the output and the matrix is \c NULL.
 
@@ -372,18 +901,37 @@ for function calls. Notably, in the case where <tt>d1</tt> is a vector and <tt>d
 a matrix, then <tt>apop_dot(d1,d2,'t')</tt> won't work, because <tt>'t'</tt> now refers
 to <tt>d1</tt>. Instead use <tt>apop_dot(d1,d2,.form2='t')</tt> or  <tt>apop_dot(d1,d2,0,
 't')</tt>
+\li To reuse buffers in a loop, send in an output set, which is overwritten (or added
+to, with \c beta) on every call:
+\code
+apop_data *cr = apop_data_alloc(n, n), *crr = apop_data_alloc(n, n);
+for (int i=0; i< reps; i++){
+    //...fill the lower-triangular chol and rand...
+    apop_dot(chol, rand, .out=cr, .hint1='l', .hint2='l');
+    apop_dot(cr, rand, .form2='t', .out=crr, .hint2='l');
+}
+\endcode
+\li The output may not share data with either input, because BLAS does not allow it.
+\li If \c d1 and \c d2 are the same matrix, one of them transposed (e.g.,
+<tt>apop_dot(x, x, .form1='t')</tt>), \c beta is zero, and there are no hints, I compute
+only one triangle of the symmetric product.
 \li This function uses the \ref designated syntax for inputs.
 
 Sample code:
 \include dot_products.c
 */
-APOP_VAR_HEAD apop_data * apop_dot(const apop_data *d1, const apop_data *d2, char form1, char form2){
+APOP_VAR_HEAD apop_data * apop_dot(const apop_data *d1, const apop_data *d2, char form1, char form2, apop_data *out, double alpha, double beta, char hint1, char hint2){
     const apop_data * apop_varad_var(d1, NULL)
     const apop_data * apop_varad_var(d2, NULL)
     Apop_stopif(!d1, return NULL, 1, "d1 is NULL; returning NULL");
     Apop_stopif(!d2, return NULL, 1, "d2 is NULL; returning NULL");
     char apop_varad_var(form1, 0)
     char apop_varad_var(form2, 0)
+    apop_data * apop_varad_var(out, NULL)
+    double apop_varad_var(alpha, 1)
+    double apop_varad_var(beta, 0)
+    char apop_varad_var(hint1, 0)
+    char apop_varad_var(hint2, 0)
 APOP_VAR_ENDHEAD
     Set_gsl_handler
     int         uselm, userm;
@@ -410,11 +958,14 @@ APOP_VAR_ENDHEAD
         Apop_stopif(1, return NULL, 0, "The right data set has neither non-NULL "
                                   "matrix nor vector. Returning NULL.");
     }
-    apop_data *out = apop_data_alloc();
+    int fresh = !out;
+    if (fresh) out = apop_data_alloc();
     #define Dimcheck(lr, lc, rr, rc) Apop_stopif((lc)!=(rr), out->error='d'; goto done,\
         0, "mismatched dimensions: %zuX%zu dot %zuX%zu. %s", (lr), (lc), (rr), (rc),\
         ((lr)==(rr)) ? " Maybe transpose the first?" \
         : ((rc)==(lc)) ? " Maybe transpose the second?" : "");
+    #define Aliascheck(o, in) Apop_stopif((in) && (o)->data == (in)->data, out->error='d'; goto done,\
+        0, "The output may not share data with an input.");
 
     CBLAS_TRANSPOSE_t lt, rt;
     lt  = (form1 == 'p' || form1 == 't' || form1 == 1) 
@@ -422,14 +973,28 @@ APOP_VAR_ENDHEAD
     rt  = (form2 == 'p' || form2 == 't' || form2 == 1) 
             ? CblasTrans: CblasNoTrans;
     if (uselm && userm){
-        Dimcheck((lt== CblasNoTrans) ? lm->size1:lm->size2,
-                 (lt== CblasNoTrans) ? lm->size2:lm->size1,
-                 (rt== CblasNoTrans) ? rm->size1:rm->size2,
-                 (rt== CblasNoTrans) ? rm->size2:rm->size1)
-        gsl_matrix *outm = gsl_matrix_calloc((lt== CblasTrans)? lm->size2: lm->size1, 
-                                             (rt== CblasTrans)? rm->size1: rm->size2);
-        Check_gsl_with_out(gsl_blas_dgemm (lt,rt, 1, lm, rm, 0, outm))
-        out->matrix = outm;
+        size_t lr = (lt== CblasNoTrans) ? lm->size1:lm->size2,
+               lc = (lt== CblasNoTrans) ? lm->size2:lm->size1,
+               rr = (rt== CblasNoTrans) ? rm->size1:rm->size2,
+               rc = (rt== CblasNoTrans) ? rm->size2:rm->size1;
+        Dimcheck(lr, lc, rr, rc)
+        gsl_matrix *outm = dot_out_matrix(out, lr, rc);
+        if (!outm) goto done;
+        Aliascheck(outm, lm)
+        Aliascheck(outm, rm)
+        if (lm == rm && lt != rt && !beta && !hint1 && !hint2){
+            Check_gsl_with_out(dot_syrk(lm, lt, alpha, outm))
+        } else if (Is_tri(hint1) && lr == lc){
+            Check_gsl_with_out(dot_trmm(CblasLeft, lm, lt, hint1, rm, rt, hint2, alpha, beta, outm))
+        } else if (Is_tri(hint2) && rr == rc){
+            Check_gsl_with_out(dot_trmm(CblasRight, rm, rt, hint2, lm, lt, hint1, alpha, beta, outm))
+        } else if (hint1 == 's'){
+            Check_gsl_with_out(dot_symm(CblasLeft, lm, rm, rt, hint2, alpha, beta, outm))
+        } else if (hint2 == 's'){
+            Check_gsl_with_out(dot_symm(CblasRight, rm, lm, lt, hint1, alpha, beta, outm))
+        } else {
+            Check_gsl_with_out(gsl_blas_dgemm (lt,rt, alpha, lm, rm, beta, outm))
+        }
     } else if (!uselm && userm){
         Dimcheck((size_t)1, lv->size,
                  (rt== CblasNoTrans) ? rm->size1:rm->size2,
@@ -437,28 +1002,45 @@ APOP_VAR_ENDHEAD
         //dgemv is always matrix first, then vector, so reverse from vm to mv:
         // if output vector has dimension matrix->size2, send CblasTrans
         // if output vector has dimension matrix->size1, send CblasNoTrans
-        out->vector = dot_for_apop_dot(rm, lv
-                        , (rt == CblasNoTrans) ? CblasTrans : CblasNoTrans);
-        Apop_stopif(!out->vector, out->error='m'; goto done, 0, "GSL-level math error");
+        CBLAS_TRANSPOSE_t flip = (rt == CblasNoTrans) ? CblasTrans : CblasNoTrans;
+        gsl_vector *outv = dot_out_vector(out, (rt== CblasNoTrans) ? rm->size2:rm->size1);
+        if (!outv) goto done;
+        Aliascheck(outv, lv)
+        if (Is_tri(hint2) && rm->size1 == rm->size2){
+            Check_gsl_with_out(dot_trmv(rm, flip, hint2, lv, alpha, beta, outv))
+        } else if (hint2 == 's'){
+            Check_gsl_with_out(gsl_blas_dsymv(CblasLower, alpha, rm, lv, beta, outv))
+        } else {
+            Check_gsl_with_out(gsl_blas_dgemv(flip, alpha, rm, lv, beta, outv))
+        }
     } else if (uselm && !userm){
         Dimcheck((lt== CblasNoTrans) ? lm->size1:lm->size2,
                  (lt== CblasNoTrans) ? lm->size2:lm->size1,
                   rv->size , (size_t)1)
-        out->vector = dot_for_apop_dot(lm, rv , lt);
-        Apop_stopif(!out->vector, out->error='m'; goto done, 0, "GSL-level math error");
+        gsl_vector *outv = dot_out_vector(out, (lt== CblasNoTrans) ? lm->size1:lm->size2);
+        if (!outv) goto done;
+        Aliascheck(outv, rv)
+        if (Is_tri(hint1) && lm->size1 == lm->size2){
+            Check_gsl_with_out(dot_trmv(lm, lt, hint1, rv, alpha, beta, outv))
+        } else if (hint1 == 's'){
+            Check_gsl_with_out(gsl_blas_dsymv(CblasLower, alpha, lm, rv, beta, outv))
+        } else {
+            Check_gsl_with_out(gsl_blas_dgemv(lt, alpha, lm, rv, beta, outv))
+        }
     } else if (!uselm && !userm){ 
         double outd;
         Check_gsl_with_out(gsl_blas_ddot(lv, rv, &outd))
-        out->vector = gsl_vector_alloc(1);
-        gsl_vector_set(out->vector, 0, outd);
+        gsl_vector *outv = dot_out_vector(out, 1);
+        if (!outv) goto done;
+        gsl_vector_set(outv, 0, alpha*outd + (beta ? beta*gsl_vector_get(outv, 0) : 0));
     }
 
     //If using the vector, there's no meaningful name to assign.
-    if (d1->names && uselm){
+    if (fresh && d1->names && uselm){
         if (lt == CblasTrans) apop_name_stack(out->names, d1->names, 'r', 'c');
         else                  apop_name_stack(out->names, d1->names, 'r');
     }
-    if (d2->names && userm){
+    if (fresh && d2->names && userm){
         if (rt == CblasTrans) apop_name_stack(out->names, d2->names, 'c', 'r');
         else                  apop_name_stack(out->names, d2->names, 'c');
     }
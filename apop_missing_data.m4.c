@@ -3,18 +3,17 @@
 
 #include "apop_internal.h"
 #include <regex.h>
+#include <stdbool.h>
 
 
 /** If there is an NaN anywhere in the row of data (including the matrix, the vector, the weights, and the text) then delete the row from the data set.
 
 \li If every row has a NaN, then this returns \c NULL.
 \li If \c apop_opts.nan_string is not \c NULL, then I will make case-insensitive comparisons to the text elements to check for bad data as well.
-\li If \c inplace = 'y', then I'll free each element of the input data
-    set and refill it with the pruned elements. I'll still take up (up to)
-    twice the size of the data set in memory during the function. If
-    every row has a NaN, then your \c apop_data set will end up with
+\li If \c inplace = 'y', then I'll compact the input data set in place, via \ref
+    apop_data_rm_rows. If every row has a NaN, then your \c apop_data set will end up with
     \c NULL vector, matrix, .... if \c inplace = 'n', then the original data set is
-    left where it was, though internal elements may be moved.
+    left unchanged, and only the rows without NaNs are copied to the output.
 \li I only look at the first page of data (i.e. the \c more element is ignored).
 \li Listwise deletion is often not a statistically valid means of dealing with missing data.
     It is typically better to impute the data (preferably multiple times). See \ref
@@ -39,42 +38,41 @@ APOP_VAR_ENDHEAD
     Apop_stopif(!msize1 && !vsize && !*d->textsize, return NULL, 0, 
             "You sent to apop_data_listwise_delete a data set with NULL matrix, NULL vector, and no text. "
             "Confused, it is returning NULL.");
-    //find out where the NaNs are
-    int len = GSL_MAX(vsize ? vsize : msize1, d->textsize[0]); //still some size assumptions here.
-    int not_empty = 0;
-    int *marked = calloc(len, sizeof(int));
-    for (int i=0; i< (vsize ? vsize: msize1); i++)
-        for (int j=firstcol; j <msize2; j++){
-            if (gsl_isnan(apop_data_get(d, i, j))){
-                    marked[i] = 1;
-                    break;
-            }
-        }
-    for (int i=0; i< wsize; i++)
-        if (gsl_isnan(gsl_vector_get(d->weights, i)))
-            marked[i] = 1;
+    //find out where the NaNs are. Each matrix row is contiguous, so test it without branching.
+    int len = maxsize;
+    int *marked = calloc(GSL_MAX(len, 1), sizeof(int));
+    Apop_stopif(!marked, return NULL, 0, "calloc failed. Probably out of memory.");
+    OMP_for (int i=0; i< msize1; i++){
+        double const *row = gsl_matrix_const_ptr(d->matrix, i, 0);
+        int bad = 0;
+        for (int j=0; j< msize2; j++) bad |= isnan(row[j]);
+        marked[i] = bad;
+    }
+    for (int i=0; i< vsize; i++)
+        marked[i] |= isnan(gsl_vector_get(d->vector, i));
+    for (int i=0; i< GSL_MIN(wsize, len); i++)
+        marked[i] |= isnan(gsl_vector_get(d->weights, i));
     if (d->textsize[0] && apop_opts.nan_string){
-        for(int i=0; i< d->textsize[0]; i++)
+        OMP_for (int i=0; i< (int)d->textsize[0]; i++)
             if (!marked[i])
-                for(int j=0; j< d->textsize[1]; j++)
+                for(int j=0; j< (int)d->textsize[1]; j++)
                     if (!strcasecmp(apop_opts.nan_string, d->text[i][j])){
-                        marked[i] ++;
+                        marked[i] = 1;
                         break;
                     }
     }
 
     //check that at least something isn't NULL.
-    for (int i=0; i< len; i++)
-        if (!marked[i]){
-            not_empty ++;
-            break;
-        }
+    int not_empty = 0;
+    for (int i=0; i< len && !not_empty; i++)
+        not_empty = !marked[i];
     if (!not_empty){
         free(marked);
         return NULL;
     }
-    apop_data *out = (inplace=='y'|| inplace=='Y') ? d : apop_data_copy(d);
-    apop_data_rm_rows(out, marked);
+    //Copy only the surviving rows, rather than copying everything and then deleting.
+    apop_data *out = (inplace=='y'|| inplace=='Y') ? apop_data_rm_rows(d, marked)
+                                                   : apop_data_gather_rows(d, marked, len);
     free(marked);
     return out;
 }
@@ -115,21 +113,166 @@ static long double i_constraint(apop_data *d, apop_model *ml_model){
 
 apop_model *apop_swap_model = &(apop_model){"Model with data and params swapped", .estimate=i_est, .p = i_p, .log_likelihood=i_ll, .constraint = i_constraint};
 
+/* One missingness pattern for the Normal imputation: the missing and observed columns,
+   the observed means, and B = Sigma_MO Sigma_OO^{-1}, so that the conditional mean is
+   x_M = mu_M + B (x_O - mu_O). */
+typedef struct {
+    size_t *miss, *obs, mct, oct;
+    gsl_matrix *b;
+} missing_pattern;
+
+typedef struct {
+    size_t row;
+    char *mask;
+} row_mask;
+
+static int mask_cmp(const void *a, const void *b){
+    return strcmp(((row_mask const*)a)->mask, ((row_mask const*)b)->mask);
+}
+
+static void pattern_setup(missing_pattern *p, char const *mask, size_t k, apop_data *params){
+    p->miss = malloc(sizeof(size_t)*k);
+    p->obs = malloc(sizeof(size_t)*k);
+    p->mct = p->oct = 0;
+    p->b = NULL;
+    for (size_t j=0; j< k; j++)
+        if (mask[j]=='1') p->miss[p->mct++] = j;
+        else              p->obs[p->oct++] = j;
+    if (!p->oct) return;
+
+    gsl_matrix *soo = gsl_matrix_alloc(p->oct, p->oct);
+    gsl_matrix *smo = gsl_matrix_alloc(p->mct, p->oct);
+    for (size_t i=0; i< p->oct; i++)
+        for (size_t j=0; j< p->oct; j++)
+            gsl_matrix_set(soo, i, j, gsl_matrix_get(params->matrix, p->obs[i], p->obs[j]));
+    for (size_t i=0; i< p->mct; i++)
+        for (size_t j=0; j< p->oct; j++)
+            gsl_matrix_set(smo, i, j, gsl_matrix_get(params->matrix, p->miss[i], p->obs[j]));
+    gsl_matrix *inv = apop_matrix_spd_inverse(soo);
+    if (inv){
+        p->b = gsl_matrix_alloc(p->mct, p->oct);
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, smo, inv, 0, p->b);
+    } else Apop_notify(1, "The covariance among the observed columns in pattern %s is singular; "
+                          "imputing the unconditional mean for rows with that pattern.", mask);
+    gsl_matrix_free(inv);
+    gsl_matrix_free(soo);
+    gsl_matrix_free(smo);
+}
+
+static void pattern_impute(missing_pattern const *p, gsl_vector *row, gsl_vector const *mu){
+    for (size_t i=0; i< p->mct; i++){
+        long double x = gsl_vector_get(mu, p->miss[i]);
+        if (p->b)
+            for (size_t j=0; j< p->oct; j++)
+                x += gsl_matrix_get(p->b, i, j)
+                      * (gsl_vector_get(row, p->obs[j]) - gsl_vector_get(mu, p->obs[j]));
+        gsl_vector_set(row, p->miss[i], x);
+    }
+}
+
+/* Rows of Normal data are independent, and the most likely value of the missing part
+   of a row is its conditional mean given the observed part. Sort the incomplete rows by
+   which columns are missing, invert the observed block of the covariance once per
+   pattern, then fill rows in parallel. */
+static void mvn_impute(apop_data *d, apop_model *mvn){
+    size_t k = d->matrix->size2, ct = 0;
+    row_mask *rows = malloc(sizeof(row_mask)*d->matrix->size1);
+    for (size_t i=0; i< d->matrix->size1; i++){
+        gsl_vector *onerow = Apop_rv(d, i);
+        char *mask = NULL;
+        for (size_t j=0; j< k; j++)
+            if (gsl_isnan(gsl_vector_get(onerow, j))){
+                if (!mask) {
+                    mask = malloc(k+1);
+                    memset(mask, '0', k);
+                    mask[k] = '\0';
+                }
+                mask[j] = '1';
+            }
+        if (mask) rows[ct++] = (row_mask){.row=i, .mask=mask};
+    }
+    qsort(rows, ct, sizeof(row_mask), mask_cmp);
+
+    size_t *pattern_of = malloc(sizeof(size_t)*ct), pct = 0;
+    missing_pattern *patterns = NULL;
+    for (size_t i=0; i< ct; i++){
+        if (!i || strcmp(rows[i].mask, rows[i-1].mask)){
+            patterns = realloc(patterns, sizeof(missing_pattern)*++pct);
+            pattern_setup(patterns+pct-1, rows[i].mask, k, mvn->parameters);
+        }
+        pattern_of[i] = pct-1;
+    }
+    OMP_for (size_t i=0; i< ct; i++)
+        pattern_impute(patterns + pattern_of[i], Apop_rv(d, rows[i].row), mvn->parameters->vector);
+
+    for (size_t i=0; i< pct; i++){
+        free(patterns[i].miss);
+        free(patterns[i].obs);
+        gsl_matrix_free(patterns[i].b);
+    }
+    for (size_t i=0; i< ct; i++) free(rows[i].mask);
+    free(patterns); free(pattern_of); free(rows);
+}
+
+static bool row_has_nan(apop_data const *d, size_t i){
+    if (d->vector && gsl_isnan(gsl_vector_get(d->vector, i))) return true;
+    if (d->matrix)
+        for (size_t j=0; j< d->matrix->size2; j++)
+            if (gsl_isnan(gsl_matrix_get(d->matrix, i, j))) return true;
+    return false;
+}
+
+/* For other models, assume rows are independent and search for the most likely
+   values of each incomplete row on its own, in parallel. Each row gets its own copy
+   of the base model, because the swap model points the base's parameters around. */
+static void ml_impute_by_row(apop_data *d, apop_model *base){
+    Get_vmsizes(d); //maxsize
+    OMP_for (int i=0; i< maxsize; i++){
+        if (!row_has_nan(d, i)) continue;
+        apop_data *onerow = Apop_r(d, i);
+        apop_model *impute_me = apop_model_copy(apop_swap_model);
+        apop_model *rowbase = apop_model_copy(base);
+        impute_me->parameters = onerow;
+        impute_me->more = rowbase;
+        apop_model *fixed = apop_model_fix_params(impute_me);
+        Apop_model_add_group(fixed, apop_parts_wanted);
+        apop_model *m = apop_estimate(rowbase->parameters, fixed);
+        apop_model_free(m);
+        apop_model_free(fixed);
+        apop_model_free(rowbase);
+        impute_me->parameters = NULL; //a view of d
+        apop_model_free(impute_me);
+    }
+}
+
 /** Impute the most likely data points to replace NaNs in the data, and insert them into 
 the given data. That is, the data set is modified in place.
 
-How it works: this uses the machinery for \ref apop_model_fix_params. The only difference is 
+How it works: rows are taken to be independent given the model, so each row with NaNs is
+imputed on its own.
+
+\li If the model is an \ref apop_multivariate_normal, the most likely values are the
+conditional means, which I calculate directly. Rows are grouped by which columns are
+missing, so the observed block of the covariance matrix is inverted once per pattern, not
+once per row, and rows are then filled in parallel.
+\li For other models, this uses the machinery for \ref apop_model_fix_params. The only difference is 
 that this searches over the data space and takes the parameter space as fixed, while basic 
 fix params model searches parameters and takes data as fixed. So this function just does the
-necessary data-parameter switching to make that happen.
+necessary data-parameter switching to make that happen, with one small search per
+incomplete row. The searches run in parallel if Apophenia was compiled with OpenMP.
 
 \param  d       The data set. It comes in with NaNs and leaves entirely filled in.
 \param  mvn A parametrized \ref apop_model from which you expect the data was derived.
 if \c NULL, then I'll use the Multivariate Normal that best fits the data after listwise deletion.
 
-\return An estimated \ref apop_model. Also, the data input will be filled in and ready to use.
+\return A copy of the model used for imputation (or the Multivariate Normal estimated after listwise deletion, if \c mvn was \c NULL),
+which you may free when done. The data input will be filled in and ready to use.
+\li This function used to return the fixed-parameter model from a single search over
+every \c NaN, whose parameter vector held the imputed values. It now returns the model
+the data was imputed from, so read the imputed values from the filled-in data set.
 */
 apop_model * apop_ml_impute(apop_data *d,  apop_model* mvn){
+    Apop_stopif(!d, return NULL, 0, "NULL data; nothing to impute. Returning NULL.");
     if (!mvn){
         apop_data *list_d = apop_data_listwise_delete(d);
         Apop_stopif(!list_d, return NULL, 0, "Listwise deletion returned no whole rows, "
@@ -137,13 +280,12 @@ apop_model * apop_ml_impute(apop_data *d,  apop_model* mvn){
                             "Please provide a pre-estimated initial model.");
         mvn = apop_estimate(list_d, apop_multivariate_normal);
         apop_data_free(list_d);
-    }
-    apop_model *impute_me = apop_model_copy(apop_swap_model);
-    impute_me->parameters = d;
-    impute_me->more = mvn;
-    apop_model *fixed = apop_model_fix_params(impute_me);
-    Apop_model_add_group(fixed, apop_parts_wanted);
-    apop_model *m = apop_estimate(mvn->parameters, fixed);
-    apop_model_free(fixed);
-    return m;
+    } else mvn = apop_model_copy(mvn);
+    if (mvn->log_likelihood == apop_multivariate_normal->log_likelihood
+            && d->matrix && mvn->parameters && mvn->parameters->vector
+            && mvn->parameters->vector->size == d->matrix->size2)
+        mvn_impute(d, mvn);
+    else
+        ml_impute_by_row(d, mvn);
+    return mvn;
 }
@@ -3,6 +3,7 @@
 #include "apop_internal.h"
 #include <setjmp.h>
 #include <signal.h>
+#include <limits.h>
 #include <gsl/gsl_deriv.h>
 #include <gsl/gsl_siman.h>
 #include <gsl/gsl_randist.h>
@@ -19,6 +20,23 @@ typedef struct {
 	int		    dimension;
 } grad_params;
 
+/* Where each element of a packed parameter vector lives in the parameter set: a list of
+   strided runs of doubles, in apop_data_pack order. Compiled once per search, so each
+   evaluation copies the parameters in place without allocating. Before each use, the
+   runs are checked against the current parameter set, so a page, vector, or matrix
+   that was replaced, resized, or reallocated by the model triggers a recompile. */
+typedef struct {
+    double *data;
+    size_t len, stride;
+} param_run;
+
+typedef struct {
+    apop_data   *params;
+    param_run   *runs;
+    size_t      run_ct, size;
+    gsl_vector  *beta_scratch, *grad_scratch; //for apop_internal_numerical_gradient
+} param_layout;
+
 typedef struct {
     apop_model *model;
     apop_data *data;
@@ -30,6 +48,9 @@ typedef struct {
     char        want_cov, want_predicted, want_tests, want_info;
     jmp_buf     bad_eval_jump;
     apop_data** path;
+    apop_mle_settings *mp;  //cached, so evaluations needn't look these up.
+    apop_score_type score;
+    param_layout *layout;   //NULL outside of apop_maximum_likelihood.
 }   infostruct;
 /** \endcond */ //End of Doxygen ignore.
 
@@ -58,6 +79,10 @@ Apop_settings_init(apop_mle,
     Apop_varad_set(step_size, 0.05);
     Apop_varad_set(delta, default_delta);
     Apop_varad_set(dim_cycle_tolerance, 0);
+    Apop_varad_set(dim_cycle_blocks, 0);
+    Apop_varad_set(starts, 1);
+    Apop_varad_set(start_draws, 'l');
+    Apop_varad_set(start_range, 1);
 //siman:
     //siman also uses step_size  = 1.;  
     Apop_varad_set(n_tries, 5);  //The number of points to try for each step. 
@@ -75,11 +100,116 @@ Apop_settings_init(apop_mle,
 
 static void apop_annealing(infostruct*); //below.
 
+static void layout_add_run(param_layout *l, double *data, size_t len, size_t stride){
+    if (!len) return;
+    l->runs = realloc(l->runs, sizeof(param_run)*++l->run_ct);
+    l->runs[l->run_ct-1] = (param_run){.data=data, .len=len, .stride=stride};
+    l->size += len;
+}
+
+static int is_info_page(apop_data *d){
+    char *t = d->names ? d->names->title : NULL;
+    size_t len = t ? strlen(t) : 0;
+    return len && t[0]=='<' && t[len-1]=='>';
+}
+
+static void layout_free(param_layout *l){
+    free(l->runs);
+    if (l->beta_scratch) gsl_vector_free(l->beta_scratch);
+    if (l->grad_scratch) gsl_vector_free(l->grad_scratch);
+    *l = (param_layout){};
+}
+
+//Add a run to the layout, or if check=='y', confirm that the next run already there matches it.
+static int layout_run(param_layout *l, double *data, size_t len, size_t stride, char check, size_t *ct){
+    if (!len) return 1;
+    if (check != 'y'){
+        layout_add_run(l, data, len, stride);
+        return 1;
+    }
+    if (*ct >= l->run_ct) return 0;
+    param_run r = l->runs[(*ct)++];
+    return r.data == data && r.len == len && r.stride == stride;
+}
+
+/* Follows the page-walking rules of apop_data_pack with use_info_pages='n', either
+   building the list of runs or checking that the list matches params. */
+static int layout_walk(param_layout *l, apop_data *params, char check){
+    size_t ct = 0;
+    for (apop_data *d = params; d; ){
+        gsl_vector *v = d->vector, *w = d->weights;
+        gsl_matrix *m = d->matrix;
+        if (v && !layout_run(l, v->data, v->size, v->stride, check, &ct)) return 0;
+        if (m){
+            if (m->tda == m->size2){
+                if (!layout_run(l, m->data, m->size1*m->size2, 1, check, &ct)) return 0;
+            } else for (size_t i=0; i< m->size1; i++)
+                if (!layout_run(l, m->data + i*m->tda, m->size2, 1, check, &ct)) return 0;
+        }
+        if (w && !layout_run(l, w->data, w->size, w->stride, check, &ct)) return 0;
+        d = d->more;
+        while (d && is_info_page(d)) d = d->more;
+    }
+    return check != 'y' || ct == l->run_ct;
+}
+
+static void layout_compile(param_layout *l, apop_data *params){
+    layout_free(l);
+    *l = (param_layout){.params=params};
+    if (!params) return;
+    layout_walk(l, params, 'n');
+    if (l->size){
+        l->beta_scratch = gsl_vector_alloc(l->size);
+        l->grad_scratch = gsl_vector_alloc(l->size);
+    }
+}
+
+static param_layout *current_layout(infostruct *i){
+    param_layout *l = i->layout;
+    if (!l) return NULL;
+    apop_data *p = i->model->parameters;
+    if (l->params != p || !layout_walk(l, p, 'y'))
+        layout_compile(l, p);
+    return l;
+}
+
+//Equivalent to apop_data_unpack(beta, i->model->parameters), but without allocation.
+static void unpack_beta(infostruct *i, const gsl_vector *beta){
+    param_layout *l = current_layout(i);
+    if (!l || l->size != beta->size){
+        apop_data_unpack(beta, i->model->parameters);
+        return;
+    }
+    const double *src = beta->data;
+    for (size_t r=0; r< l->run_ct; r++){
+        param_run run = l->runs[r];
+        if (run.stride == 1 && beta->stride == 1) memcpy(run.data, src, sizeof(double)*run.len);
+        else for (size_t j=0; j< run.len; j++) run.data[j*run.stride] = src[j*beta->stride];
+        src += run.len*beta->stride;
+    }
+}
+
+//Equivalent to apop_data_pack(i->model->parameters, beta).
+static void pack_beta(infostruct *i, gsl_vector *beta){
+    param_layout *l = current_layout(i);
+    if (!l || l->size != beta->size){
+        apop_data_pack(i->model->parameters, beta);
+        return;
+    }
+    double *dest = beta->data;
+    for (size_t r=0; r< l->run_ct; r++){
+        param_run run = l->runs[r];
+        if (run.stride == 1 && beta->stride == 1) memcpy(dest, run.data, sizeof(double)*run.len);
+        else for (size_t j=0; j< run.len; j++) dest[j*beta->stride] = run.data[j*run.stride];
+        dest += run.len*beta->stride;
+    }
+}
+
 static double one_d(double b, void *in){
     infostruct *i  = in;
     long double penalty = 0;
     gsl_vector_set(i->gp->beta, i->gp->dimension, b);
-    apop_data_unpack(i->gp->beta, i->model->parameters);
+    unpack_beta(i, i->gp->beta);
 	if (i->model->constraint)
 		penalty	= i->model->constraint(i->data, i->model);
 	return (*(i->f))(i->data, i->model) + penalty;
@@ -92,10 +222,13 @@ static double one_d(double b, void *in){
 static void apop_internal_numerical_gradient(apop_fn_with_params ll, 
                             infostruct* info, gsl_vector *out, double delta){
     double result, err;
-    gsl_vector *beta = apop_data_pack(info->model->parameters);
+    param_layout *l = current_layout(info);
+    if (l && !l->size) l = NULL;
+    gsl_vector *beta = l ? l->beta_scratch : apop_data_pack(info->model->parameters);
+    if (l) pack_beta(info, beta);
     infostruct i = *info;
     i.f = &ll;
-    i.gp = &(grad_params){ .beta = gsl_vector_alloc(beta->size)};
+    i.gp = &(grad_params){ .beta = l ? l->grad_scratch : gsl_vector_alloc(beta->size)};
     gsl_function F = { .function= one_d, 
                        .params	= &i };
 	for (size_t j=0; j< beta->size; j++){
@@ -104,7 +237,10 @@ static void apop_internal_numerical_gradient(apop_fn_with_params ll,
 		gsl_deriv_central(&F, gsl_vector_get(beta,j), delta, &result, &err);
 		gsl_vector_set(out, j, result);
 	}
-    gsl_vector_free(beta);
+    if (!l){
+        gsl_vector_free(beta);
+        gsl_vector_free(i.gp->beta);
+    }
 }
 
 /**
@@ -252,8 +388,8 @@ APOP_VAR_ENDHEAD
         apop_data_show(hessian);
     }
     apop_data *out = apop_data_alloc();
-    out->matrix = apop_matrix_inverse(hessian->matrix);
-    gsl_matrix_scale(out->matrix, -1);
+    gsl_matrix_scale(hessian->matrix, -1); //near the optimum, -H is positive definite.
+    out->matrix = apop_matrix_spd_inverse(hessian->matrix);
     if (hessian->names->row){
         apop_name_stack(out->names, hessian->names, 'r');
         apop_name_stack(out->names, hessian->names, 'c');
@@ -301,10 +437,10 @@ static double negshell (const gsl_vector *beta, void * in){
     f = i->model->log_likelihood? i->model->log_likelihood : i->model->p;
     Apop_stopif(!f, longjmp(i->bad_eval_jump, -1),
                 0, "The model you sent to the MLE function has neither log_likelihood element nor p element.");
-    apop_data_unpack(beta, i->model->parameters);
+    unpack_beta(i, beta);
 	if (i->use_constraint && i->model->constraint)
 		penalty	= i->model->constraint(i->data, i->model);
-    if (penalty) apop_data_pack(i->model->parameters, (gsl_vector*) beta);
+    if (penalty) pack_beta(i, (gsl_vector*) beta);
     double f_val = f(i->data, i->model);
     out = penalty - f_val; //negative llikelihood
     Apop_stopif(gsl_isnan(out), longjmp(i->bad_eval_jump, -1),
@@ -341,14 +477,13 @@ If the constraint binds
 Finally, reverse the sign, since the GSL is trying to minimize instead of maximize.
 */
     infostruct *i = in;
-    apop_mle_settings *mp =  apop_settings_get_group(i->model, apop_mle);
-    apop_data_unpack(beta, i->model->parameters);
+    apop_mle_settings *mp = i->mp;
+    unpack_beta(i, beta);
     /* In all cases, negshell gets called first, so the constraint is already
        checked and beta nudged accordingly.
     if(i->model->constraint && i->model->constraint(i->data, i->model))
             apop_data_pack(i->model->parameters, (gsl_vector *) beta); */
-    apop_score_type ms = apop_score_vtable_get(i->model);
-    if (ms) ms(i->data, g, i->model);
+    if (i->score) i->score(i->data, g, i->model);
     else {
         apop_fn_with_params ll = i->model->log_likelihood ? i->model->log_likelihood : i->model->p;
         apop_internal_numerical_gradient(ll, i, g, mp->delta);
@@ -535,40 +670,219 @@ static double get_ll(apop_data *d, apop_model *est){
     return apop_log_likelihood(d, est);
 }
 
+/* For dimension cycling. Each block of coordinates gets a fixed-parameter wrapper,
+   built once and reused for every cycle. The wrapper reads the fixed coordinates from
+   its base model's parameters, so reusing it only requires updating those and the
+   starting point. */
+typedef struct {
+    apop_model *base, *fixed;
+    double *start;
+    int first, len;
+} cycle_block;
+
+static void cycle_block_setup(cycle_block *b, apop_data *d, apop_model *base, gsl_vector *beta, int first, int len){
+    *b = (cycle_block){.base=base, .first=first, .len=len, .start=malloc(sizeof(double)*len)};
+    gsl_vector *marked = apop_vector_copy(beta);
+    for (int j=first; j< first+len; j++) gsl_vector_set(marked, j, GSL_NAN);
+    apop_data_unpack(marked, base->parameters);
+    gsl_vector_free(marked);
+    b->fixed = apop_model_fix_params(base);
+    Apop_settings_add_group(b->fixed, apop_parts_wanted, .info='y'); //only the LL is used.
+    apop_prep(d, b->fixed);
+    Apop_settings_set(b->fixed, apop_mle, starting_pt, b->start);
+    apop_data_unpack(beta, base->parameters);
+}
+
+//Optimize the block's coordinates, starting at (and holding the rest at) beta. Return the LL.
+static double cycle_block_run(cycle_block *b, apop_data *d, gsl_vector *beta){
+    for (int j=0; j< b->len; j++) b->start[j] = gsl_vector_get(beta, b->first+j);
+    apop_data_unpack(beta, b->base->parameters);
+    apop_data_free(b->fixed->info); //else stale LLs from the last cycle.
+    apop_maximum_likelihood(d, b->fixed);
+    apop_model_fix_params_get_base(b->fixed);
+    return get_ll(d, b->fixed);
+}
+
+static void cycle_block_read(cycle_block *b, gsl_vector *beta){
+    for (int j=0; j< b->len; j++)
+        gsl_vector_set(beta, b->first+j, gsl_vector_get(b->fixed->parameters->vector, j));
+}
+
 static void dim_cycle(apop_data *d, apop_model *est, infostruct info){
     double last_ll, this_ll = GSL_NEGINF;
     int iteration = 0;
     apop_mle_settings *mp = Apop_settings_get_group(est, apop_mle);
     double tol = mp->dim_cycle_tolerance;
     int betasize = info.beta->size;
-    Apop_settings_set(est, apop_mle, dim_cycle_tolerance, 0);//so sub-estimations won't use this function.
-    gsl_vector *paramv = apop_data_pack(est->parameters);
-    apop_model *full_est = NULL; //an alias
+    int parallel = mp->dim_cycle_blocks > 1 && betasize > 1;
+    int block_ct = parallel ? GSL_MIN(mp->dim_cycle_blocks, betasize) : betasize;
+    mp->dim_cycle_tolerance = 0; //so sub-estimations won't use this function.
+
+    /* Sequential cycling works directly on est; parallel blocks each need their own copy,
+       which, as with multistart, gets its own RNG seeded from the search's, and no path.
+       The block searches run at once, so they stay quiet; the LL of each is listed below. */
+    cycle_block blocks[block_ct];
+    gsl_rng *rngs[block_ct];
+    gsl_rng *r = mp->rng ? mp->rng : apop_rng_get_thread();
+    for (int b=0; b< block_ct; b++){
+        int first = parallel ? b*betasize/block_ct : b;
+        int len = parallel ? (b+1)*betasize/block_ct - first : 1;
+        apop_model *base = est;
+        if (parallel){
+            base = apop_model_copy(est);
+            apop_mle_settings *cp = Apop_settings_get_group(base, apop_mle);
+            cp->path = NULL;
+            cp->verbose = 0;
+            cp->rng = rngs[b] = apop_rng_alloc(gsl_rng_uniform_int(r, INT_MAX));
+        }
+        cycle_block_setup(blocks+b, d, base, info.beta, first, len);
+    }
+    gsl_vector *candidate = parallel ? gsl_vector_alloc(betasize) : NULL;
     do {
         if (mp->verbose){
             if (!(iteration++))
-                printf("Cycling toward an optimum. Listing (dim):log likelihood.\n");
+                printf("Cycling toward an optimum. Listing (%s):log likelihood.\n", parallel ? "block" : "dim");
             printf("Iteration %i:\n", iteration);
         }
         last_ll = this_ll;
-        for (int i=0; i< betasize; i++){
-            gsl_vector_set(info.beta, i, GSL_NAN);
-            apop_data_unpack(info.beta, est->parameters);
-            apop_model *m_onedim = apop_model_fix_params(est);
-            apop_prep(d, m_onedim);
-            apop_maximum_likelihood(d, m_onedim);
-            gsl_vector_set(info.beta, i, m_onedim->parameters->vector->data[0]);
-            full_est = apop_model_fix_params_get_base(m_onedim);//points to est, but filled.
-            this_ll = get_ll(d, full_est);//only used on the last iteration.
-            if (mp->verbose) printf("(%i):%g\t", i, this_ll), fflush(NULL);
-            apop_model_free(m_onedim);
+        if (!parallel)
+            for (int b=0; b< block_ct; b++){
+                this_ll = cycle_block_run(blocks+b, d, info.beta);
+                cycle_block_read(blocks+b, info.beta);
+                if (mp->verbose) printf("(%i):%g\t", b, this_ll), fflush(NULL);
+            }
+        else {
+            double block_ll[block_ct];
+            OMP_for (int b=0; b< block_ct; b++)
+                block_ll[b] = cycle_block_run(blocks+b, d, info.beta);
+            int best = 0;
+            gsl_vector_memcpy(candidate, info.beta);
+            for (int b=0; b< block_ct; b++){
+                cycle_block_read(blocks+b, candidate);
+                if (block_ll[b] > block_ll[best]) best = b;
+                if (mp->verbose) printf("(%i):%g\t", b, block_ll[b]);
+            }
+            apop_data_unpack(candidate, est->parameters);
+            int infeasible = est->constraint && est->constraint(d, est);
+            this_ll = infeasible ? GSL_NAN : apop_log_likelihood(d, est);
+            if (gsl_isnan(this_ll) || this_ll < block_ll[best]){
+                //the blocks interact; fall back to the best single-block update.
+                cycle_block_read(blocks+best, info.beta);
+                this_ll = block_ll[best];
+            } else gsl_vector_memcpy(info.beta, candidate);
+            if (mp->verbose) printf("combined:%g", this_ll), fflush(NULL);
         }
         if (mp->verbose) printf("\n");
-        apop_data_pack(full_est->parameters, paramv);
-        Apop_settings_add(est, apop_mle, starting_pt, paramv->data);
     } while (fabs(this_ll - last_ll) > tol);
-    Apop_settings_set(est, apop_mle, dim_cycle_tolerance, tol);
-    gsl_vector_free(paramv);
+    apop_data_unpack(info.beta, est->parameters);
+    mp->dim_cycle_tolerance = tol;
+
+    for (int b=0; b< block_ct; b++){
+        apop_model_free(blocks[b].fixed);
+        if (parallel){
+            apop_model_free(blocks[b].base);
+            gsl_rng_free(rngs[b]);
+        }
+        free(blocks[b].start);
+    }
+    if (candidate) gsl_vector_free(candidate);
+    auxinfo(est->parameters, &info, 0, this_ll);
+    gsl_vector_free(info.beta);
+}
+
+/* Build the list of starting points for a multi-start search, one per row. The first
+   row is the usual starting point; the rest are drawn around it, either as a Latin
+   hypercube (each dimension cut into starts-1 strata, each stratum used once) or as
+   independent uniform draws. */
+static gsl_matrix *multistart_points(apop_mle_settings *mp, gsl_vector *x0){
+    int ct = mp->starts, strata_ct = mp->starts - 1;
+    gsl_matrix *out = gsl_matrix_alloc(ct, x0->size);
+    gsl_rng *r = mp->rng ? mp->rng : apop_rng_get_thread();
+    int strata[strata_ct];
+    gsl_matrix_set_row(out, 0, x0);
+    for (size_t j=0; j< x0->size; j++){
+        for (int i=0; i< strata_ct; i++) strata[i] = i;
+        if (mp->start_draws != 'r') gsl_ran_shuffle(r, strata, strata_ct, sizeof(int));
+        for (int i=1; i< ct; i++){
+            double u = (mp->start_draws == 'r') ? gsl_rng_uniform(r)
+                                                : (strata[i-1] + gsl_rng_uniform(r))/strata_ct;
+            gsl_matrix_set(out, i, j, gsl_vector_get(x0, j) + mp->start_range*(2*u - 1));
+        }
+    }
+    return out;
+}
+
+/* Run one search per starting point, each on its own copy of the model (with its own
+   RNG, seeded from the search's RNG, so apop_opts.rng_seed is left alone), in parallel.
+   The best estimate's parameters and info page are swapped into the input model, and
+   the full list of endpoints goes on a <Multistart> info page. */
+static void multistart(apop_data *d, apop_model *est, infostruct info){
+    apop_mle_settings *mp = Apop_settings_get_group(est, apop_mle);
+    int betasize = info.beta->size;
+    Apop_stopif(mp->start_list && (!mp->start_list->matrix || mp->start_list->matrix->size2 != betasize),
+            est->error='s'; gsl_vector_free(info.beta); return,
+            0, "The start_list for the multi-start search should have a matrix with one "
+               "column for each of the %i parameters.", betasize);
+    Apop_stopif(mp->start_list && !mp->start_list->matrix->size1,
+            est->error='s'; gsl_vector_free(info.beta); return,
+            0, "The start_list for the multi-start search has no rows, so there is nowhere to start.");
+    gsl_matrix *starts = mp->start_list ? mp->start_list->matrix : multistart_points(mp, info.beta);
+    int search_ct = starts->size1;
+    apop_model *copies[search_ct];
+    gsl_rng *rngs[search_ct];
+    gsl_rng *r = mp->rng ? mp->rng : apop_rng_get_thread();
+    for (int i=0; i< search_ct; i++){
+        copies[i] = apop_model_copy(est);
+        apop_mle_settings *cp = Apop_settings_get_group(copies[i], apop_mle);
+        cp->starts = 1;
+        cp->start_list = NULL;
+        cp->path = NULL;
+        cp->starting_pt = gsl_matrix_ptr(starts, i, 0);
+        cp->rng = rngs[i] = apop_rng_alloc(gsl_rng_uniform_int(r, INT_MAX));
+        //Covariance only for the winner, below; the log likelihood is needed to pick it.
+        Apop_settings_add_group(copies[i], apop_parts_wanted, .info='y');
+    }
+
+    OMP_for (int i=0; i< search_ct; i++)
+        apop_maximum_likelihood(d, copies[i]);
+
+    apop_data *ends = apop_data_alloc(search_ct, search_ct, betasize);
+    apop_name_add(ends->names, "log likelihood", 'v');
+    apop_name_add(ends->names, "endpoint", 'm');
+    int best = -1;
+    double best_ll = GSL_NEGINF;
+    for (int i=0; i< search_ct; i++){
+        double ll = get_ll(d, copies[i]);
+        gsl_vector_set(ends->vector, i, ll);
+        apop_data_pack(copies[i]->parameters, Apop_rv(ends, i));
+        if (!gsl_isnan(ll) && ll > best_ll){
+            best = i;
+            best_ll = ll;
+        }
+        Apop_notify((mp->verbose ? 0 : 2), "Search %i: log likelihood=%g", i, ll);
+    }
+    Apop_stopif(best == -1, best = 0, 0, "All %i searches ended with a NaN log likelihood.", search_ct);
+
+    apop_data *swap = est->parameters;
+    est->parameters = copies[best]->parameters;
+    copies[best]->parameters = swap;
+    swap = est->info;
+    est->info = copies[best]->info;
+    copies[best]->info = swap;
+    est->error = copies[best]->error;
+    if (info.want_cov=='y'){
+        apop_model_numerical_covariance(d, est, mp->delta);
+        if (info.want_tests=='y') apop_estimate_parameter_tests(est);
+    }
+    if (!est->info) est->info = apop_data_alloc();
+    apop_data_add_page(est->info, ends, "<Multistart>");
+
+    for (int i=0; i< search_ct; i++){
+        apop_model_free(copies[i]);
+        gsl_rng_free(rngs[i]);
+    }
+    if (!mp->start_list) gsl_matrix_free(starts);
+    gsl_vector_free(info.beta);
 }
 
 void get_desires(apop_model *m, infostruct *info){
@@ -645,18 +959,24 @@ void apop_maximum_likelihood(apop_data * data, apop_model *dist){
     infostruct info = {.data           = data,
                        .use_constraint = 1,
                        .path           = mp->path,
+                       .mp             = mp,
+                       .score          = ms,
+                       .layout         = &(param_layout){},
                        .model          = dist};
     get_desires(dist, &info);
     info.beta = apop_data_pack(dist->parameters);
     if (setup_starting_point(mp, info.beta)) return;
     info.model->data = data;
-    if (mp->dim_cycle_tolerance)            dim_cycle(data, dist, info);
+    layout_compile(info.layout, dist->parameters);
+    if (mp->starts > 1 || mp->start_list)   multistart(data, dist, info);
+    else if (mp->dim_cycle_tolerance)       dim_cycle(data, dist, info);
     else if (!strcasecmp(mp->method, "annealing"))   apop_annealing(&info);  //below.
     else if (!strcasecmp(mp->method, "NM simplex"))  apop_maximum_likelihood_no_d(data, &info);
     else if (!strcasecmp(mp->method, "Newton") ||
             !strcasecmp(mp->method, "Newton hybrid")||
             !strcasecmp(mp->method, "Newton hybrid no scale")) find_roots (info);
     else   /* Conjugate Gradient*/   apop_maximum_likelihood_w_d(data, &info);
+    layout_free(info.layout);
 }
 
 /** Maximum likelihod searches are not guaranteed to find a global optimum, and it can be
@@ -769,9 +1089,9 @@ static double annealing_distance(void *xin, void *yin) {
 }
 
 static void annealing_check_constraint(infostruct *i){
-    apop_data_unpack(i->beta, i->model->parameters);
+    unpack_beta(i, i->beta);
     if (i->model->constraint && i->model->constraint(i->data, i->model))
-        apop_data_pack(i->model->parameters, i->beta);
+        pack_beta(i, i->beta);
 }
 
 static void annealing_step(const gsl_rng * r, void *in, double step_size){
@@ -826,7 +1146,7 @@ static void annealing_free(void *xp){
 //I abuse the starting point element to hold the list of scaling factors. They can't be zero.
 static double set_start(double in){ return in ? in : 1; }
 
-jmp_buf anneal_jump;
+static threadlocal jmp_buf anneal_jump;
 static void anneal_sigint(int){ longjmp(anneal_jump,1); }
 
 static void apop_annealing(infostruct *i){
@@ -35,6 +35,80 @@ static unsigned long apop_name_hash(char const *str){
     return hash;
 }
 
+/* Row names are the one part of a name struct that can be long, so copies share them,
+   counting references in rowrefs, and anything about to write to the rows calls
+   apop_name_unshare_rows first. A struct whose rowrefs is NULL (e.g., a view) owns its
+   rows outright and is deep-copied. The same counting is used for text grids in apop_data.c.
+   Counts are read and written atomically, so threads may copy and free sharing sets
+   at once, and checking for sharing is cheap. */
+void apop_ref_add(int *refs){
+    OMP_atomic(update)
+    (*refs)++;
+}
+
+//Returns 1 if this was the last reference, so the caller should free the shared block.
+int apop_ref_release(int *refs){
+    int left;
+    OMP_atomic(capture)
+    left = --*refs;
+    return !left;
+}
+
+int apop_ref_shared(int *refs){
+    int count;
+    OMP_atomic(read)
+    count = *refs;
+    return count > 1;
+}
+
+static void free_rows(char **row, unsigned long *rowhash, int rowct){
+	for (int i=0; i < rowct; i++) free(row[i]);
+	free(row);  free(rowhash);
+}
+
+/* Give n its own copy of any row names it shares with other name structs.  Copy first,
+   then release, so a concurrent last release can't free the rows from under us. */
+void apop_name_unshare_rows(apop_name *n){
+    if (!n || !n->rowrefs || !apop_ref_shared(n->rowrefs)) return;
+    char **row = malloc(sizeof(char*) * n->rowct);
+    unsigned long *rowhash = malloc(sizeof(unsigned long) * n->rowct);
+    Apop_stopif(n->rowct && (!row || !rowhash), free(row); free(rowhash); return,
+            0, "malloc failed. Probably out of memory.");
+    for (int i=0; i < n->rowct; i++){
+        row[i] = strdup(n->row[i]);
+        rowhash[i] = n->rowhash ? n->rowhash[i] : apop_name_hash(n->row[i]);
+    }
+    if (apop_ref_release(n->rowrefs)){
+        free_rows(n->row, n->rowhash, n->rowct);
+        *n->rowrefs = 1;
+    } else {
+        n->rowrefs = malloc(sizeof(int));
+        *n->rowrefs = 1;
+    }
+    n->row = row;
+    n->rowhash = rowhash;
+}
+
+/* Give n its own copy of row names borrowed from a parent set, so they can be
+   reallocated; see apop_data_split. Writes in place still go to the parent. */
+void apop_name_own_rows(apop_name *n){
+    if (!n || !n->borrowed) return;
+    char **row = malloc(sizeof(char*) * n->rowct);
+    unsigned long *rowhash = malloc(sizeof(unsigned long) * n->rowct);
+    int *rowrefs = malloc(sizeof(int));
+    Apop_stopif((n->rowct && (!row || !rowhash)) || !rowrefs, free(row); free(rowhash); free(rowrefs); return,
+            0, "malloc failed. Probably out of memory.");
+    for (int i=0; i < n->rowct; i++){
+        row[i] = strdup(n->row[i]);
+        rowhash[i] = n->rowhash ? n->rowhash[i] : apop_name_hash(n->row[i]);
+    }
+    *rowrefs = 1;
+    n->row = row;
+    n->rowhash = rowhash;
+    n->rowrefs = rowrefs;
+    n->borrowed = 0;
+}
+
 /** Adds a name to the \ref apop_name structure. Puts it at the end of the given list.
 
 \param n 	An existing, allocated \ref apop_name structure.
@@ -60,6 +134,12 @@ int apop_name_add(apop_name * n, char const *add_me, char type){
 		return 1;
 	} 
 	if (type == 'r'){
+        apop_name_own_rows(n);
+        apop_name_unshare_rows(n);
+        if (!n->row && !n->rowrefs){
+            n->rowrefs = malloc(sizeof(int));
+            *n->rowrefs = 1;
+        }
 		n->rowct++;
 		n->row	= realloc(n->row, sizeof(char*) * n->rowct);
 		n->row[n->rowct -1]	= malloc(strlen(add_me) + 1);
@@ -124,16 +204,24 @@ void apop_name_print(apop_name * n){
 	}
 }
 	
-/** Free the memory used by an \ref apop_name structure. */
+/** Free the memory used by an \ref apop_name structure.
+
+\li Row names shared with copies (see \ref apop_name_copy) are freed only when the last
+struct using them is freed. Row names borrowed from a parent set, as in a view from
+\ref apop_data_split, are never freed here.
+*/
 void  apop_name_free(apop_name * free_me){
     if (!free_me) return; //only needed if users are doing tricky things like newdata = (apop_data){.matrix=...};
 	for (size_t i=0; i < free_me->colct; i++)  free(free_me->col[i]);
 	for (size_t i=0; i < free_me->textct; i++) free(free_me->text[i]);
-	for (size_t i=0; i < free_me->rowct; i++)  free(free_me->row[i]);
     if (free_me->vector) free(free_me->vector);
 	free(free_me->col);  free(free_me->colhash);
 	free(free_me->text); free(free_me->texthash);
-	free(free_me->row);  free(free_me->rowhash);
+    if (!free_me->borrowed && (!free_me->rowrefs || apop_ref_release(free_me->rowrefs))){
+        free_rows(free_me->row, free_me->rowhash, free_me->rowct);
+        free(free_me->rowrefs);
+    }
+    free(free_me->title);
 	free(free_me);
 }
 
@@ -160,6 +248,23 @@ APOP_VAR_ENDHEAD
     apop_name counts = (apop_name){.rowct=nadd->rowct, .textct = nadd->textct, .colct = nadd->colct};//Necessary when stacking onto self.;
     if (typeadd == 'v')
         apop_name_add(n1, nadd->vector, 'v');
+    else if (typeadd == 'r' && type1 == 'r' && counts.rowct){ //grow the lists once, not once per name.
+        apop_name_own_rows(n1);
+        apop_name_unshare_rows(n1);
+        if (!n1->row && !n1->rowrefs){
+            n1->rowrefs = malloc(sizeof(int));
+            *n1->rowrefs = 1;
+        }
+        int base = n1->rowct;
+        n1->row = realloc(n1->row, sizeof(char*) * (base + counts.rowct));
+        n1->rowhash = realloc(n1->rowhash, sizeof(unsigned long) * (base + counts.rowct));
+        Apop_stopif(!n1->row || !n1->rowhash, return, 0, "realloc failed. Probably out of memory.");
+        for (i=0; i< counts.rowct; i++){
+            n1->row[base+i] = strdup(nadd->row[i]);
+            n1->rowhash[base+i] = nadd->rowhash ? nadd->rowhash[i] : apop_name_hash(nadd->row[i]);
+        }
+        n1->rowct = base + counts.rowct;
+    }
     else if (typeadd == 'r')
         for (i=0; i< counts.rowct; i++)
             apop_name_add(n1, nadd->row[i], type1);
@@ -173,7 +278,28 @@ APOP_VAR_ENDHEAD
                         "valid options are r t c v. Doing nothing.", typeadd);
 }
 
-/** Copy one \ref apop_name structure to another. That is, all data is duplicated.
+/* Copy in's names into the empty struct out, sharing the row names where in allows it. */
+void apop_name_copy_to(apop_name *out, apop_name *in){
+    apop_name_stack(out, in, 'v');
+    apop_name_stack(out, in, 'c');
+    apop_name_stack(out, in, 't');
+    if (in->rowrefs && !out->rowct && !out->rowrefs){
+        apop_ref_add(in->rowrefs);
+        out->row = in->row;
+        out->rowhash = in->rowhash;
+        out->rowct = in->rowct;
+        out->rowrefs = in->rowrefs;
+    } else apop_name_stack(out, in, 'r');
+    Asprintf(&out->title, "%s", in->title);
+}
+
+/** Copy one \ref apop_name structure to another. 
+
+The title, vector, column, and text names are duplicated. The row names, which may run
+to millions of entries, are shared between the input and the copy until either one
+adds a row name or is otherwise modified, at which point that one gets its own copy.
+So treat the copy as fully independent, but write to row names only via the functions
+of this library, like \ref apop_name_add, not by assigning to <tt>n->row[i]</tt>.
 
 Used internally by \ref apop_data_copy, but sometimes useful by itself. For example,
 say that we have an \ref apop_data struct named \c d and a \ref gsl_matrix of the same
@@ -189,11 +315,7 @@ apop_name_free(wrapped->names); //wrapped itself is auto-allocated; do not free.
 */
 apop_name * apop_name_copy(apop_name *in){
     apop_name *out = apop_name_alloc();
-    apop_name_stack(out, in, 'v');
-    apop_name_stack(out, in, 'c');
-    apop_name_stack(out, in, 'r');
-    apop_name_stack(out, in, 't');
-    Asprintf(&out->title, "%s", in->title);
+    apop_name_copy_to(out, in);
     return out;
 }
 
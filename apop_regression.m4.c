@@ -2,7 +2,6 @@
 /* Copyright (c) 2006--2007 by Ben Klemens.  Licensed under the GPLv2; see COPYING.  */
 
 #include "apop_internal.h"
-#include <search.h> //lsearch; bsearch is in stdlib.
 
 /* For use by MLE, OLS, et al. Available for public use, but undocumented. */
 void apop_estimate_parameter_tests (apop_model *est){
@@ -50,6 +49,132 @@ static int strcmpwrap(const void *a, const void *b){
     return strcmp(*aa, *bb);
 }
 
+//The splitmix64 finalizer, to spread the bits before masking to the table size.
+static uint64_t hash_mix(uint64_t h){
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+static uint64_t hash_double(double x){
+    if (gsl_isnan(x)) return 0x7ff8000000000000ULL;
+    if (x == 0) x = 0; //-0 and 0 are one key.
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(double));
+    return hash_mix(bits);
+}
+
+static uint64_t hash_text(char const *s){
+    uint64_t h = 5381; //The Bernstein hash, as in apop_name_hash.
+    for (int c; (c = *s++); ) h = h*33 + c;
+    return hash_mix(h);
+}
+
+int apop_distinct_init(apop_distinct *h, char type, size_t expected){
+    *h = (apop_distinct){.type=type, .cap=16};
+    while (h->cap < 2*expected) h->cap *= 2;
+    h->slots = calloc(h->cap, sizeof(size_t));
+    h->hashes = malloc(h->cap * sizeof(uint64_t));
+    h->keycap = h->cap/2;
+    if (type=='d') h->dkeys = malloc(h->keycap * sizeof(double));
+    else           h->tkeys = malloc(h->keycap * sizeof(char*));
+    Apop_stopif(!h->slots || !h->hashes || !(h->dkeys || h->tkeys), return 1,
+                0, "Allocation error building a table of distinct elements.");
+    return 0;
+}
+
+void apop_distinct_free(apop_distinct *h){
+    free(h->slots); free(h->hashes); free(h->dkeys); free(h->tkeys);
+}
+
+//Return the slot holding this key, or the empty slot where it would go.
+static size_t distinct_slot(apop_distinct const *h, double dv, char const *tv, uint64_t hash){
+    size_t mask = h->cap-1;
+    for (size_t i = hash & mask; ; i = (i+1) & mask){
+        if (!h->slots[i]) return i;
+        if (h->hashes[i] != hash) continue;
+        size_t k = h->slots[i]-1;
+        if (h->type=='d' ? !compare_doubles(&dv, h->dkeys+k) : !strcmp(tv, h->tkeys[k]))
+            return i;
+    }
+}
+
+//Return the key's index, or -1 if it isn't in the table. Read-only, so threads may share a table.
+ptrdiff_t apop_distinct_find(apop_distinct const *h, double dv, char const *tv){
+    uint64_t hash = h->type=='d' ? hash_double(dv) : hash_text(tv);
+    return (ptrdiff_t)h->slots[distinct_slot(h, dv, tv, hash)] - 1;
+}
+
+static int distinct_grow(apop_distinct *h){
+    size_t newcap = h->cap*2, mask = newcap-1;
+    size_t *slots = calloc(newcap, sizeof(size_t));
+    uint64_t *hashes = malloc(newcap * sizeof(uint64_t));
+    Apop_stopif(!slots || !hashes, free(slots); free(hashes); return 1,
+                0, "Allocation error growing a table of distinct elements.");
+    for (size_t i=0; i< h->cap; i++){
+        if (!h->slots[i]) continue;
+        size_t j = h->hashes[i] & mask;
+        while (slots[j]) j = (j+1) & mask;
+        slots[j] = h->slots[i];
+        hashes[j] = h->hashes[i];
+    }
+    free(h->slots); free(h->hashes);
+    h->slots = slots; h->hashes = hashes; h->cap = newcap;
+    return 0;
+}
+
+//Add the key if it is new; return its index, or -1 on allocation failure.
+ptrdiff_t apop_distinct_add(apop_distinct *h, double dv, char const *tv){
+    uint64_t hash = h->type=='d' ? hash_double(dv) : hash_text(tv);
+    size_t i = distinct_slot(h, dv, tv, hash);
+    if (h->slots[i]) return h->slots[i]-1;
+    if (h->count == h->keycap){
+        size_t newkeycap = h->keycap*2;
+        void *keys = h->type=='d' ? realloc(h->dkeys, newkeycap * sizeof(double))
+                                  : realloc(h->tkeys, newkeycap * sizeof(char*));
+        Apop_stopif(!keys, return -1, 0, "Allocation error growing a table of distinct elements.");
+        if (h->type=='d') h->dkeys = keys; else h->tkeys = keys;
+        h->keycap = newkeycap;
+    }
+    if (h->type=='d') h->dkeys[h->count] = dv; else h->tkeys[h->count] = tv;
+    h->slots[i] = ++h->count;
+    h->hashes[i] = hash;
+    if (h->count*2 > h->cap && distinct_grow(h)) return -1;
+    return h->count-1;
+}
+
+#define Distinct_block 65536
+
+/* Collect the distinct elements of a vector (when v!=NULL) or of a text column.
+   Each block of rows gets its own table, filled in parallel; the blocks are then merged
+   into the first table in block order, so the key list stays in order of first appearance. */
+static int distinct_elements(apop_distinct *out, gsl_vector const *v, apop_data const *d, size_t col){
+    size_t n = v ? v->size : d->textsize[0];
+    size_t block_ct = n ? (n + Distinct_block - 1)/Distinct_block : 1;
+    char type = v ? 'd' : 't';
+    apop_distinct *blocks = malloc(sizeof(apop_distinct) * block_ct);
+    Apop_stopif(!blocks, return 1, 0, "Allocation error.");
+    int err = 0;
+    OMP_for (size_t b=0; b< block_ct; b++){
+        size_t end = GSL_MIN(n, (b+1)*Distinct_block);
+        int failed = apop_distinct_init(blocks+b, type, 16);
+        for (size_t i=b*Distinct_block; !failed && i< end; i++)
+            failed = apop_distinct_add(blocks+b, v ? gsl_vector_get(v, i) : 0,
+                                            v ? NULL : d->text[i][col]) < 0;
+        if (failed) OMP_critical(distinct_elements) {err = 1;}
+    }
+    for (size_t b=1; b< block_ct; b++){
+        for (size_t k=0; !err && k< blocks[b].count; k++)
+            err = apop_distinct_add(blocks, type=='d' ? blocks[b].dkeys[k] : 0,
+                                       type=='t' ? blocks[b].tkeys[k] : NULL) < 0;
+        apop_distinct_free(blocks+b);
+    }
+    *out = blocks[0];
+    free(blocks);
+    if (err) apop_distinct_free(out);
+    return err;
+}
+
 /** Give me a vector of numbers, and I'll give you a sorted list of the unique elements.
   This is basically running <tt>select distinct datacol from data order by datacol</tt>,
   but without the aid of the database.
@@ -57,23 +182,17 @@ static int strcmpwrap(const void *a, const void *b){
   \param v a vector of items
   \return a sorted vector of the distinct elements that appear in the input.
   \li NaNs (if any) appear at the end of the sort order.
+  \li The distinct elements are found via a hash table, one per block of rows in
+  parallel if OpenMP is enabled, and the list of distinct elements is sorted once at the end.
   \see apop_text_unique_elements 
 */
 gsl_vector * apop_vector_unique_elements(const gsl_vector *v){
-    size_t prior_elmt_ctr = 107;
-    size_t elmt_ctr = 0;
-    double *elmts = NULL;
-    for (size_t i=0; i< v->size; i++){
-        if (prior_elmt_ctr != elmt_ctr)
-            elmts = realloc(elmts, sizeof(double)*(elmt_ctr+1));
-        prior_elmt_ctr = elmt_ctr;
-        double val = gsl_vector_get(v, i);
-        lsearch(&val, elmts, &elmt_ctr, sizeof(double), compare_doubles);
-        if (prior_elmt_ctr < elmt_ctr)
-            qsort(elmts, elmt_ctr, sizeof(double), compare_doubles);
-    }
-    gsl_vector *out = apop_array_to_vector(elmts, elmt_ctr);
-    free(elmts);
+    Apop_stopif(!v, return NULL, 1, "You sent me a NULL vector. Returning NULL.");
+    apop_distinct h;
+    Apop_stopif(distinct_elements(&h, v, NULL, 0), return NULL, 0, "Error finding distinct elements.");
+    qsort(h.dkeys, h.count, sizeof(double), compare_doubles);
+    gsl_vector *out = h.count ? apop_array_to_vector(h.dkeys, h.count) : NULL;
+    apop_distinct_free(&h);
     return out;
 }
 
@@ -84,34 +203,55 @@ gsl_vector * apop_vector_unique_elements(const gsl_vector *v){
   \param d An \ref apop_data set with a text component
   \param col The text column you want me to use.
   \return An \ref apop_data set with a single sorted column of text, where each unique text input appears once.
+  \li As with \ref apop_vector_unique_elements, this uses hash tables over blocks of rows and sorts the distinct list once.
   \see apop_vector_unique_elements
 */
 apop_data * apop_text_unique_elements(const apop_data *d, size_t col){
-  char   **tval;
-
-  //first element for free
-  size_t prior_elmt_ctr, elmt_ctr = 1;
-  char **telmts = malloc(sizeof(char**)*2);
-  telmts[0] = d->text[0][col];
-
-    for (int i=1; i< d->textsize[0]; i++){
-        prior_elmt_ctr  = elmt_ctr;
-        tval    =  &(d->text[i][col]);
-        lsearch (tval, telmts, &elmt_ctr, sizeof(char*), strcmpwrap);
-        if (prior_elmt_ctr  < elmt_ctr){
-            qsort(telmts, elmt_ctr, sizeof(char*), strcmpwrap);
-            telmts = realloc(telmts, sizeof(char**)*(elmt_ctr+1));
-        }
-    }
+    Apop_stopif(!d || col >= d->textsize[1], return NULL, 1,
+                "You asked for text column %zu, which isn't present. Returning NULL.", col);
+    apop_distinct h;
+    Apop_stopif(distinct_elements(&h, NULL, d, col), return NULL, 0, "Error finding distinct elements.");
+    qsort(h.tkeys, h.count, sizeof(char*), strcmpwrap);
 
     //pack and ship
-    apop_data *out = apop_text_alloc(NULL, elmt_ctr, 1);
-    for (int j=0; j< elmt_ctr; j++)
-        apop_text_set(out, j, 0, telmts[j]);
-    free(telmts);
+    apop_data *out = apop_text_alloc(NULL, h.count, 1);
+    for (size_t j=0; j< h.count; j++)
+        apop_text_set(out, j, 0, h.tkeys[j]);
+    apop_distinct_free(&h);
     return out;
 }
 
+/* Factor a column without touching the data set: return each row's index in the sorted
+   list of distinct values, and add the list to names as row or column names. Used by
+   apop_data_to_crosstab. */
+size_t *apop_factor_index(apop_data *d, int col, char type, apop_name *names, char nametype, size_t *ct){
+    gsl_vector *v = type == 'd' ? (col == -1 ? d->vector : Apop_cv(d, col)) : NULL;
+    size_t n = v ? v->size : d->textsize[0];
+    apop_distinct h, sorted;
+    Apop_stopif(distinct_elements(&h, v, d, col), return NULL, 0, "Error finding distinct elements.");
+    if (v) qsort(h.dkeys, h.count, sizeof(double), compare_doubles);
+    else   qsort(h.tkeys, h.count, sizeof(char*), strcmpwrap);
+    Apop_stopif(apop_distinct_init(&sorted, h.type, h.count), apop_distinct_free(&h); return NULL, 0, "Allocation error.");
+    for (size_t k=0; k< h.count; k++){
+        apop_distinct_add(&sorted, v ? h.dkeys[k] : 0, v ? NULL : h.tkeys[k]);
+        if (v){
+            char *label;
+            Asprintf(&label, "%g", h.dkeys[k]);
+            apop_name_add(names, label, nametype);
+            free(label);
+        } else apop_name_add(names, h.tkeys[k], nametype);
+    }
+    size_t *index = malloc(sizeof(size_t) * (n ? n : 1));
+    if (index)
+        OMP_for (size_t i=0; i< n; i++)
+            index[i] = apop_distinct_find(&sorted, v ? gsl_vector_get(v, i) : 0, v ? NULL : d->text[i][col]);
+    *ct = h.count;
+    apop_distinct_free(&sorted);
+    apop_distinct_free(&h);
+    Apop_stopif(!index, return NULL, 0, "Allocation error.");
+    return index;
+}
+
 static char *apop_get_factor_basename(apop_data *d, int col, char type){
     char *name;
     char *catname =   d->names == NULL ? NULL
@@ -171,15 +311,16 @@ apop_data * create_factor_list(apop_data *d, int col, char type){
         factor_list = apop_data_add_page(d, apop_text_unique_elements(d, col), catname);
         size_t elmt_ctr = factor_list->textsize[0];
         //awkward format conversion:
-        factor_list->vector = gsl_vector_alloc(elmt_ctr);
-        for (size_t i=0; i< factor_list->vector->size; i++)
+        factor_list->vector = elmt_ctr ? gsl_vector_alloc(elmt_ctr) : NULL;
+        for (size_t i=0; i< elmt_ctr; i++)
             apop_data_set(factor_list, i, -1, i);
     } else {
+        //NULL for an empty column, in which case the list is empty too.
         gsl_vector *delmts = apop_vector_unique_elements(Apop_cv(d, col));
         factor_list = apop_data_add_page(d, apop_data_alloc(), catname);
         factor_list->vector = delmts;
-        apop_text_alloc(factor_list, delmts->size, 1);
-        for (size_t i=0; i< factor_list->vector->size; i++){
+        if (delmts) apop_text_alloc(factor_list, delmts->size, 1);
+        for (size_t i=0; delmts && i< delmts->size; i++){
             //shift to the text, for conformity with the more common text version.
             apop_text_set(factor_list, i, 0, "%g", gsl_vector_get(delmts, i));
         }
@@ -193,6 +334,10 @@ apop_data * create_factor_list(apop_data *d, int col, char type){
  Producing factors consists of finding the index and then setting (i, datacol) to index.
  Otherwise the work is basically identical.
  Also, add a ->more page to the input data giving the translation.
+
+ The factor list is loaded into a hash table, and rows look up their index in parallel.
+ Values missing from a preexisting factor list are appended to it in order of first
+ appearance, so the output grid is allocated once, at its final width.
  */
 static apop_data * dummies_and_factors_core(apop_data *d, int col, char type,
                             int keep_first, int datacol, char dummyfactor,
@@ -202,73 +347,77 @@ static apop_data * dummies_and_factors_core(apop_data *d, int col, char type,
     Get_vmsizes((*factor_list)); //maxsize
     size_t elmt_ctr = maxsize;
 
-    //copy the strings to a single list-of-strings
-    apop_data *telmts = *(*factor_list)->textsize ? apop_data_transpose(*factor_list, .inplace='n'):NULL;
-    gsl_vector *delmts = (*factor_list)->vector;
-
-    //Now go through the input vector, and for row i find the posn of the vector's
-    //name in the element list created above (j), then change (i,j) in
-    //the dummy matrix to one.
-    int s = type == 't' 
-            ? d->textsize[0]
-            : (col >=0 ? d->matrix->size1 : d->vector->size);
-    apop_data *out = (dummyfactor == 'd')
-                ? apop_data_calloc(0, s, (keep_first!='n' ? elmt_ctr : elmt_ctr-1))
-                : d;
-    size_t index;
-    for (size_t i=0; i< s; i++){
-        if (type == 'd'){
-            double val = apop_data_get(d, i, col);
-            size_t posn = (size_t)bsearch(&val, delmts->data, elmt_ctr, sizeof(double), compare_doubles);
-            if (posn )
-                index = (posn - (size_t)delmts->data)/sizeof(double);
-            else {
-                index = elmt_ctr++;
-                (*factor_list)->vector = apop_vector_realloc((*factor_list)->vector, elmt_ctr);
-                gsl_vector_set((*factor_list)->vector, index, val);
-                out->matrix = apop_matrix_realloc(out->matrix, out->matrix->size1, elmt_ctr);
-                gsl_vector_set_zero(Apop_cv(out, index));
-            }
-        } else {
-            size_t posn = (size_t)bsearch(&(d->text[i][col]), *telmts->text, elmt_ctr, sizeof(char**), strcmpwrap);
-            if (posn)
-                index = (posn - (size_t)*telmts->text)/sizeof(char**);
-            else {
-                index = elmt_ctr++;
-                *factor_list = apop_text_alloc(*factor_list, elmt_ctr, 1);
-                apop_text_set(*factor_list, index, 0, d->text[i][col]);
-                (*factor_list)->vector = apop_vector_realloc((*factor_list)->vector, elmt_ctr);
-                apop_data_set(*factor_list, index, -1, index);
-
-                telmts = apop_text_alloc(telmts, 1, elmt_ctr);
-                apop_text_set(telmts, 0, index, d->text[i][col]);
-                if (dummyfactor == 'd'){
-                    out->matrix = apop_matrix_realloc(out->matrix, out->matrix->size1, out->matrix->size2+1);
-                    gsl_vector_set_zero(Apop_cv(out, out->matrix->size2-1));
-                }
+    gsl_vector *dv = type == 'd' ? (col == -1 ? d->vector : Apop_cv(d, col)) : NULL;
+    size_t s = type == 't' ? d->textsize[0] : dv->size;
+    apop_distinct h;
+    Apop_stopif(apop_distinct_init(&h, type, elmt_ctr), return NULL, 0, "Allocation error.");
+    for (size_t i=0; i< elmt_ctr; i++)
+        apop_distinct_add(&h, type == 'd' ? gsl_vector_get((*factor_list)->vector, i) : 0,
+                         type == 't' ? (*factor_list)->text[i][0] : NULL);
+
+    //Find the posn of row i's value in the element list created above.
+    size_t *index = malloc(sizeof(size_t) * (s ? s : 1));
+    Apop_stopif(!index, apop_distinct_free(&h); return NULL, 0, "Allocation error.");
+    OMP_for (size_t i=0; i< s; i++)
+        index[i] = apop_distinct_find(&h, type == 'd' ? gsl_vector_get(dv, i) : 0,
+                                     type == 't' ? d->text[i][col] : NULL);
+
+    //Values not in a preexisting list get appended to it.
+    for (size_t i=0; i< s; i++)
+        if (index[i] == (size_t)-1)
+            index[i] = apop_distinct_add(&h, type == 'd' ? gsl_vector_get(dv, i) : 0,
+                                        type == 't' ? d->text[i][col] : NULL);
+    if (h.count > elmt_ctr){
+        (*factor_list)->vector = apop_vector_realloc((*factor_list)->vector, h.count);
+        apop_text_alloc(*factor_list, h.count, 1);
+        for (size_t k=elmt_ctr; k< h.count; k++){
+            if (type == 'd'){
+                gsl_vector_set((*factor_list)->vector, k, h.dkeys[k]);
+                apop_text_set(*factor_list, k, 0, "%g", h.dkeys[k]);
+            } else {
+                gsl_vector_set((*factor_list)->vector, k, k);
+                apop_text_set(*factor_list, k, 0, h.tkeys[k]);
             }
         }
-        if (dummyfactor == 'd'){
+        elmt_ctr = h.count;
+    }
+    apop_distinct_free(&h);
+
+    //Now go through the input, and for row i with index j, change (i,j) in
+    //the dummy matrix to one, or write j to the factor column.
+    apop_data *out = (dummyfactor == 'd') ? apop_data_calloc(0, s, (keep_first!='n' || !elmt_ctr ? elmt_ctr : elmt_ctr-1))
+                   : (dummyfactor == 's') ? apop_data_alloc(s)
+                   : d;
+    if (dummyfactor == 's'){ //the column holding the one, or -1 for an all-zero row.
+        OMP_for (size_t i=0; i< s; i++)
+            gsl_vector_set(out->vector, i, (keep_first!='n') ? (double)index[i] : (double)index[i]-1);
+    } else if (dummyfactor == 'd'){
+        OMP_for (size_t i=0; i< s; i++)
             if (keep_first!='n')
-                gsl_matrix_set(out->matrix, i, index,1); 
-            else if (index > 0)   //else don't keep first and index==0; throw it out. 
-                gsl_matrix_set(out->matrix, i, index-1, 1); 
-        } else
-            apop_data_set(out, i, datacol, index); 
+                gsl_matrix_set(out->matrix, i, index[i], 1);
+            else if (index[i] > 0)   //else don't keep first and index==0; throw it out. 
+                gsl_matrix_set(out->matrix, i, index[i]-1, 1);
+    } else {
+        gsl_vector *outv = datacol == -1 ? out->vector : Apop_cv(out, datacol);
+        OMP_for (size_t i=0; i< s; i++)
+            gsl_vector_set(outv, i, index[i]);
     }
+    free(index);
+
     //Add names:
-    if (dummyfactor == 'd'){
+    if (dummyfactor == 'd' || dummyfactor == 's'){
         char *basename = apop_get_factor_basename(d, col, type);
         for (size_t i = (keep_first!='n') ? 0 : 1; i< elmt_ctr; i++){
-            char n[1000];
-            if (type =='d'){
-                sprintf(n, "%s dummy %g", basename, gsl_vector_get(delmts,i));
-            } else
-                sprintf(n, "%s", telmts->text[0][i]);
+            char *n;
+            if (type =='d')
+                Asprintf(&n, "%s dummy %g", basename, gsl_vector_get((*factor_list)->vector, i));
+            else
+                Asprintf(&n, "%s", (*factor_list)->text[i][0]);
             apop_name_add(out->names, n, 'c');
+            free(n);
         }
+        free(basename);
     }
-    apop_data_free(telmts);
     return out;
 }
 
@@ -297,6 +446,19 @@ Bear in mind that if there are two or more dummy columns, adding columns will ch
 \li If <tt>.append='i'</tt> and you asked for a text column, I will append to the end of
 the table, which is equivalent to <tt>append='e'</tt>.
 
+\li With many categories, the grid of dummies is mostly zeros and can be far larger than
+the data. Set <tt>.sparse='y'</tt> to get an index-coded form instead: the output's \c
+vector gives, for each row, the number of the dummy column holding the one, or -1 if the
+row is all zeros (i.e., it is in the dropped first category). The column names are those
+the dense grid would have had, so <tt>out->names->colct</tt> is the number of dummy
+columns. \ref apop_ols and \ref apop_iv accept this form via the \c fixed_effects
+element of \ref apop_lm_settings, and absorb the dummies without ever building the grid:
+\code
+apop_data *fe = apop_data_to_dummies(d, .col=2, .type='t', .sparse='y');
+apop_model *est = apop_estimate(d, apop_ols, .fixed_effects=fe);
+\endcode
+The sparse form is never appended to the input data, so <tt>.append</tt> is ignored.
+
 \param  d The data set with the column to be dummified (No default.)
 \param col The column number to be transformed; -1==vector (default = 0)
 \param type 'd'==data column, 't'==text column. (default = 't')
@@ -308,6 +470,7 @@ the table, which is equivalent to <tt>append='e'</tt>.
 \param append If \c 'e' or \c 'y', append the dummy grid to the end of the original data
 matrix. If \c 'i', insert in place, immediately after the original data column. (default = \c 'n')
 \param remove If \c 'y', remove the original data or text column. (default = \c 'n')
+\param sparse If \c 'y', return the index-coded form described above rather than a matrix of dummies. (default = \c 'n')
 
 \return An \ref apop_data set whose \c matrix element is the one-zero
 matrix of dummies. If you used <tt>.append</tt>, then this is the main matrix.
@@ -323,7 +486,7 @@ Also, I add a page named <tt>"\<categories for your_var\>"</tt> giving a referen
 
 \see \ref apop_data_to_factors
 */
-APOP_VAR_HEAD apop_data * apop_data_to_dummies(apop_data *d, int col, char type, int keep_first, char append, char remove){
+APOP_VAR_HEAD apop_data * apop_data_to_dummies(apop_data *d, int col, char type, int keep_first, char append, char remove, char sparse){
     apop_data *apop_varad_var(d, NULL)
     Apop_stopif(!d, return NULL, 1, "You sent me a NULL data set for apop_data_to_dummies. Returning NULL.");
     int apop_varad_var(col, 0)
@@ -331,7 +494,9 @@ APOP_VAR_HEAD apop_data * apop_data_to_dummies(apop_data *d, int col, char type,
     int apop_varad_var(keep_first, 'n')
     char apop_varad_var(append, 'n')
     char apop_varad_var(remove, 'n')
+    char apop_varad_var(sparse, 'n')
     if (remove =='y' && type == 't') Apop_notify(1, "Remove isn't implemented for text source columns yet.");
+    if (sparse =='y' && append != 'n') Apop_notify(1, "Sparse dummies are never appended; ignoring .append.");
 APOP_VAR_ENDHEAD
     if (type == 'd'){
         Apop_stopif((col == -1) && d->vector, apop_return_data_error(d),
@@ -344,7 +509,8 @@ APOP_VAR_ENDHEAD
                                 0, "You asked for the text element %i but "
                                     "the data's text element has only %zu elements.", col, d->textsize[1]);
     apop_data *fdummy;
-    apop_data *dummies= dummies_and_factors_core(d, col, type, keep_first, 0, 'd', &fdummy);
+    apop_data *dummies= dummies_and_factors_core(d, col, type, keep_first, 0, sparse=='y' ? 's' : 'd', &fdummy);
+    if (sparse=='y') append = 'n';
     //Now process the append and remove options.
     size_t orig_size = d->matrix ? d->matrix->size1 : 0;
     int rm_list[orig_size+1];
@@ -516,6 +682,9 @@ whether such a thing is appropriate to your given models and situation.
 \li The number of independent variables, needed only for the adjusted \f$R^2\f$, is from the
 number of columns in the main data set's matrix (i.e. the first page; i.e. the set of
 parameters if this is the \c parameters output from a model estimation). 
+\li If the parameters have a <tt>"<Fixed effects>"</tt> page, as from a regression with
+absorbed fixed effects (see \ref apop_ols), each non-\c NaN effect there also counts as an
+independent variable.
 \li If your data (first page again) has a \c weights vector, I will find weighted SSE,
 SST, and SSR (and calculate the \f$R^2\f$s using those values).
   */
@@ -527,6 +696,10 @@ apop_data *apop_estimate_coefficient_of_determination (apop_model *m){
     apop_data *expected = apop_data_get_page(m->info, "<Predicted>");
     Apop_stopif(!expected, return NULL, 0, "I couldn't find a \"<Predicted>\" page in your data set. Returning NULL.\n");
     size_t obs = expected->matrix->size1;
+    apop_data *effects = m->parameters ? apop_data_get_page(m->parameters, "<Fixed effects>") : NULL;
+    if (effects)
+        for (size_t i=0; i< effects->vector->size; i++)
+            indep_ct += !gsl_isnan(gsl_vector_get(effects->vector, i));
     Apop_col_tv(expected, "residual", v)
     if (!weights)
         gsl_blas_ddot(v, v, &sse);
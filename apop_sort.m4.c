@@ -81,6 +81,8 @@ static int compare_strings(const void *a, const void *b) {
 }
 
 static void rearrange(apop_data *data, size_t height, size_t *perm){
+    apop_text_unshare(data); //we write through views, so copies must not see the changes.
+    apop_name_unshare_rows(data->names);
     size_t i, start=0;
     size_t *sorted = calloc(height, sizeof(size_t));
     while (1){
@@ -5,6 +5,9 @@
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_eigen.h>
 
+#define Set_gsl_handler gsl_error_handler_t *prior_handler = gsl_set_error_handler(apop_gsl_error);
+#define Unset_gsl_handler gsl_set_error_handler(prior_handler);
+
 #define Check_vw    \
     Apop_stopif(!v, return GSL_NAN, 0, "data vector is NULL. Returning NaN.\n");            \
     Apop_stopif(!v->size, return GSL_NAN, 0, "data vector has size 0. Returning NaN.\n");   \
@@ -372,22 +375,89 @@ void apop_matrix_mean_and_var(const gsl_matrix *data, double *mean, double *var)
     *var  = avg2 - gsl_pow_2(avg); //E[x^2] - E^2[x]
 }
 
+/* Selection. select_kth partially orders a[lo..hi) so that a[k] holds the value it
+would have if the array were sorted, everything before it is <= a[k], and everything
+after is >= a[k]. This is Hoare's FIND, with a median-of-three pivot. */
+static void select_kth(double *a, long lo, long hi, long k){
+    while (hi - lo > 1){
+        double x = a[lo], y = a[lo + (hi-lo)/2], z = a[hi-1];
+        double pivot = (x < y) ? ((y < z) ? y : (x < z) ? z : x)
+                               : ((x < z) ? x : (y < z) ? z : y);
+        long i = lo, j = hi-1;
+        while (i <= j){
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+            if (i <= j){
+                double t = a[i]; a[i] = a[j]; a[j] = t;
+                i++; j--;
+            }
+        }
+        if (k <= j) hi = j+1;
+        else if (k >= i) lo = i;
+        else return; //a[j+1..i-1] all equal the pivot.
+    }
+}
+
+/* Put every position listed in targets[tlo..thi) (sorted, possibly repeated) in sorted
+   position, recursing on the sub-arrays between them: O(n log(#targets)), not O(n log n). */
+static void multiselect(double *a, long lo, long hi, long const *targets, int tlo, int thi){
+    while (tlo < thi && targets[tlo] < lo) tlo++;
+    while (tlo < thi && targets[thi-1] >= hi) thi--;
+    if (tlo >= thi || hi - lo < 2) return;
+    int tmid = (tlo + thi)/2, tleft = tmid, tright = tmid;
+    long k = targets[tmid];
+    select_kth(a, lo, hi, k);
+    while (tleft > tlo && targets[tleft-1] == k) tleft--;
+    while (tright < thi && targets[tright] == k) tright++;
+    multiselect(a, lo, k, targets, tlo, tleft);
+    multiselect(a, k+1, hi, targets, tright, thi);
+}
+
+static double *vector_to_array(gsl_vector const *v){
+    double *out = malloc(sizeof(double)*v->size);
+    if (v->stride == 1) memcpy(out, v->data, sizeof(double)*v->size);
+    else for (size_t i=0; i< v->size; i++) out[i] = gsl_vector_get(v, i);
+    return out;
+}
+
+//The element that would be at position k in a sorted copy of v.
+static double vector_kth(gsl_vector const *v, long k){
+    double *a = vector_to_array(v);
+    select_kth(a, 0, v->size, k);
+    double out = a[k];
+    free(a);
+    return out;
+}
+
 /** Put summary information about the columns of a table (mean, std dev, variance, min, median, max) in a table.
 
-\param indata The table to be summarized. An \ref apop_data structure. May have a <tt>weights</tt> element.
+The mean, variance, min, and max of each column are found in one pass over the data,
+and columns are summarized in parallel if Apophenia was compiled with OpenMP.
+
+\param data The table to be summarized. An \ref apop_data structure. May have a <tt>weights</tt> element.
+\param error If zero, the median is exact, found via selection rather than by sorting
+the column. If positive, the median is read from an \ref apop_sketch with this rank
+error, so every statistic comes from a single pass over the data. (Default: 0)
 \return     An \ref apop_data structure with one row for each column in the original
             table, and a column for each summary statistic.
 \exception out->error='a'  Allocation error.
 
+\li The median ignores the weights.
+\li If a column has any \c NaN, every statistic for that column is \c NaN, as with
+\ref apop_vector_mean. To summarize only the complete rows, use \ref apop_data_listwise_delete first.
 \li This function gives more columns than you probably want; use \ref apop_data_prune_columns to pick the ones you want to see.
-
 \li See apop_data_prune_columns for an example.
+\li For data that arrives in chunks, build an \ref apop_sketch for each column of each chunk and use \ref apop_sketch_merge.
+\li This function uses the \ref designated syntax for inputs.
 */
-apop_data * apop_data_summarize(apop_data *indata){
-    Apop_stopif(!indata, return NULL, 0, "You sent me a NULL apop_data set. Returning NULL.");
-    Apop_stopif(!indata->matrix, return NULL, 0, "You sent me an apop_data set with a NULL matrix. Returning NULL.");
+APOP_VAR_HEAD apop_data * apop_data_summarize(apop_data *data, double error){
+    apop_data * apop_varad_var(data, NULL);
+    Apop_stopif(!data, return NULL, 0, "You sent me a NULL apop_data set. Returning NULL.");
+    Apop_stopif(!data->matrix, return NULL, 0, "You sent me an apop_data set with a NULL matrix. Returning NULL.");
+    double apop_varad_var(error, 0);
+APOP_VAR_ENDHEAD
+    apop_data *indata = data;
     apop_data *out = apop_data_alloc(indata->matrix->size2, 6);
-    double mean, var;
     char rowname[10000]; //crashes on more than 10^9995 columns.
 	apop_name_add(out->names, "mean", 'c');
 	apop_name_add(out->names, "std dev", 'c');
@@ -409,23 +479,31 @@ apop_data * apop_data_summarize(apop_data *indata){
 			sprintf(rowname, "col %zu", i);
 			apop_name_add(out->names, rowname, 'r');
 		}
-	for (size_t i=0; i< indata->matrix->size2; i++){
+    size_t rows = indata->matrix->size1;
+	OMP_for (size_t i=0; i< indata->matrix->size2; i++){
         gsl_vector *v = Apop_cv(indata, i);
-        if (!indata->weights){
-            mean = apop_vector_mean(v);
-            var  = apop_vector_var_m(v, mean);
-        } else {
-            mean = apop_vector_mean(v, indata->weights);
-            var  = apop_vector_var(v, indata->weights);
-        } 
-        double *pctiles = apop_vector_percentiles(v);
-		gsl_matrix_set(out->matrix, i, 0, mean);
+        apop_sketch *s = apop_sketch_alloc(error > 0 ? error : 0);
+        int has_nan = 0;
+        for (size_t j=0; j< rows; j++){
+            double x = gsl_vector_get(v, j);
+            has_nan |= gsl_isnan(x); //the sketch would skip it.
+            apop_sketch_add(s, x, indata->weights ? gsl_vector_get(indata->weights, j) : 1);
+        }
+        if (has_nan){
+            for (int k=0; k< 6; k++) gsl_matrix_set(out->matrix, i, k, GSL_NAN);
+            apop_sketch_free(s);
+            continue;
+        }
+        double var = apop_sketch_var(s);
+		gsl_matrix_set(out->matrix, i, 0, apop_sketch_mean(s));
 		gsl_matrix_set(out->matrix, i, 1, sqrt(var));
 		gsl_matrix_set(out->matrix, i, 2, var);
-		gsl_matrix_set(out->matrix, i, 3, pctiles[0]);
-		gsl_matrix_set(out->matrix, i, 4, pctiles[50]);
-		gsl_matrix_set(out->matrix, i, 5, pctiles[100]);
-        free(pctiles);
+		gsl_matrix_set(out->matrix, i, 3, s->min);
+		gsl_matrix_set(out->matrix, i, 4, !rows ? GSL_NAN
+                                           : error > 0 ? apop_sketch_quantile(s, 0.5)
+                                           : vector_kth(v, (rows-1)/2));
+		gsl_matrix_set(out->matrix, i, 5, s->max);
+        apop_sketch_free(s);
 	}
 	return out;
 }
@@ -443,30 +521,226 @@ up (use the next highest value); if \c 'd', round down to the next lowest value;
 \li If the rounding method is \c 'u' or \c 'a', then you can say "5% or more  of
 the sample is below returned_vector[5]"; if \c 'd' or \c 'a', then you can say "5%
 or more of the sample is above returned_vector[5]".
+\li The percentiles are found via selection on a copy of the data, not a full sort.
+For an approximate version that needs only one pass and constant memory, see \ref apop_sketch_quantile.
 \li You may eventually want to \c free() the array returned by this function.
 \li This function uses the \ref designated syntax for inputs.
 */ 
 APOP_VAR_HEAD double * apop_vector_percentiles(gsl_vector *data, char rounding){
     gsl_vector *apop_varad_var(data, NULL);
     Apop_stopif(!data, return NULL, 0, "You gave me NULL data.");
+    Apop_stopif(!data->size, return NULL, 0, "You gave me a zero-length vector.");
     char apop_varad_var(rounding, 'd');
 APOP_VAR_ENDHEAD
-    gsl_vector *sorted	= gsl_vector_alloc(data->size);
-    double     *pctiles = malloc(sizeof(double) * 101);
-	gsl_vector_memcpy(sorted,data);
-	gsl_sort_vector(sorted);
+    double *pctiles = malloc(sizeof(double) * 101);
+    double *sorted  = vector_to_array(data);
+    long index[101], targets[202];
+    int tct = 0;
 	for(int i=0; i<101; i++){
-		int index = i*(data->size-1)/100.0;
-		if (rounding == 'u' && index != i*(data->size-1)/100.0)
-			index ++; //index was rounded down, but should be rounded up.
-		if (rounding == 'a' && index != i*(data->size-1)/100.0)
-            pctiles[i]	= (gsl_vector_get(sorted, index)+gsl_vector_get(sorted, index+1))/2.;
-        else pctiles[i]	= gsl_vector_get(sorted, index);
+		index[i] = i*(data->size-1)/100.0;
+        targets[tct++] = index[i];
+		if (rounding != 'd' && index[i] != i*(data->size-1)/100.0)
+            targets[tct++] = index[i]+1;
 	}
-	gsl_vector_free(sorted);
+    multiselect(sorted, 0, data->size, targets, 0, tct);
+	for(int i=0; i<101; i++){
+		long ix = index[i];
+		if (rounding == 'u' && ix != i*(data->size-1)/100.0)
+			ix ++; //index was rounded down, but should be rounded up.
+		if (rounding == 'a' && ix != i*(data->size-1)/100.0)
+            pctiles[i]	= (sorted[ix] + sorted[ix+1])/2.;
+        else pctiles[i]	= sorted[ix];
+	}
+	free(sorted);
 	return pctiles;
 }
 
+/** Allocate a sketch: a one-pass, mergeable summary of a stream of numbers. It keeps
+the count, the weighted mean and variance, the min and max, and (if \c error is
+positive) a KLL quantile sketch [Karnin, Lang, and Liberty, 2016].
+
+The quantile sketch holds a hierarchy of compactors. New items go in at the bottom level;
+when a level fills, it is sorted and every other item (starting from a randomly chosen
+first or second) moves up a level, where it stands for twice as many inputs. Memory use
+is \f$O(1/{\rm error})\f$ regardless of how many items are added.
+
+\param error The approximate rank error of quantiles: with high probability, the item
+returned for quantile \f$q\f$ has rank within \f$({\rm error})n\f$ of \f$qn\f$. If zero,
+no quantile sketch is kept, and you get only the count, moments, min, and max.
+\return A new sketch, to be filled via \ref apop_sketch_add and freed via \ref apop_sketch_free.
+
+\code
+apop_sketch *s = apop_sketch_alloc(0.01);
+for (size_t i=0; i< v->size; i++) apop_sketch_add(s, gsl_vector_get(v, i));
+printf("mean %g; median roughly %g\n", apop_sketch_mean(s), apop_sketch_quantile(s, .5));
+apop_sketch_free(s);
+\endcode
+*/
+apop_sketch *apop_sketch_alloc(double error){
+    Apop_stopif(error < 0, error=0, 0, "Error bound is negative; treating it as zero (no quantile sketch).");
+    apop_sketch *out = malloc(sizeof(apop_sketch));
+    *out = (apop_sketch){.min=GSL_POSINF, .max=GSL_NEGINF, .coin=1};
+    if (error > 0) out->k = GSL_MAX(8, ceil(3.3/error));
+    return out;
+}
+
+/** Free a sketch allocated via \ref apop_sketch_alloc. */
+void apop_sketch_free(apop_sketch *s){
+    if (!s) return;
+    for (int h=0; h< s->levels; h++) free(s->items[h]);
+    free(s->items); free(s->len); free(s->space);
+    free(s);
+}
+
+static size_t sketch_capacity(apop_sketch const *s, int h){
+    return GSL_MAX(2, (size_t)(s->k * pow(2/3., s->levels - 1 - h)));
+}
+
+static void sketch_push(apop_sketch *s, int h, double x){
+    if (h >= s->levels){
+        s->levels = h+1;
+        s->items = realloc(s->items, sizeof(double*)*s->levels);
+        s->len   = realloc(s->len, sizeof(size_t)*s->levels);
+        s->space = realloc(s->space, sizeof(size_t)*s->levels);
+        s->items[h] = NULL;
+        s->len[h] = s->space[h] = 0;
+    }
+    if (s->len[h] == s->space[h]){
+        s->space[h] = GSL_MAX(2*s->space[h], 8);
+        s->items[h] = realloc(s->items[h], sizeof(double)*s->space[h]);
+    }
+    s->items[h][s->len[h]++] = x;
+}
+
+static int dcomp(const void *a, const void *b){
+    double x = *(double const*)a, y = *(double const*)b;
+    return (x > y) - (x < y);
+}
+
+//Halve every over-full level, from the bottom up.
+static void sketch_compress(apop_sketch *s){
+    for (int h=0; h< s->levels; h++){
+        if (s->len[h] < sketch_capacity(s, h)) continue;
+        qsort(s->items[h], s->len[h], sizeof(double), dcomp);
+        s->coin = s->coin*1103515245u + 12345u;
+        size_t even = s->len[h] & ~(size_t)1, offset = (s->coin >> 16) & 1;
+        for (size_t i=offset; i< even; i+=2)
+            sketch_push(s, h+1, s->items[h][i]);
+        if (even < s->len[h]) s->items[h][0] = s->items[h][even];
+        s->len[h] -= even;
+    }
+}
+
+/** Add an item to a sketch.
+
+\param s The sketch, from \ref apop_sketch_alloc. (No default, must not be \c NULL.)
+\param x The item. NaNs are skipped.
+\param weight A weight for the mean and variance. The quantiles ignore weights. (Default: 1)
+\li This function uses the \ref designated syntax for inputs.
+*/
+APOP_VAR_HEAD void apop_sketch_add(apop_sketch *s, double x, double weight){
+    apop_sketch *apop_varad_var(s, NULL);
+    Apop_stopif(!s, return, 0, "NULL sketch.");
+    double apop_varad_var(x, GSL_NAN);
+    double apop_varad_var(weight, 1);
+APOP_VAR_ENDHEAD
+    if (gsl_isnan(x)) return;
+    if (!s->n) s->shift = x;
+    s->n++;
+    s->wsum += weight;
+    long double d = x - s->shift;
+    s->s1 += weight * d;
+    s->s2 += weight * d * d;
+    if (x < s->min) s->min = x;
+    if (x > s->max) s->max = x;
+    if (!s->k) return;
+    sketch_push(s, 0, x);
+    if (s->len[0] >= sketch_capacity(s, 0)) sketch_compress(s);
+}
+
+/** Fold the contents of one sketch into another, so that \c into summarizes both
+streams. Use this to summarize data that arrives in chunks, or to combine sketches
+built in parallel.
+
+\param into The sketch to add to; modified in place.
+\param from The sketch to add; not modified.
+\return \c into.
+\li The merged quantile sketch keeps \c into's error bound. If \c from has no quantile
+sketch but \c into does, the quantiles will not reflect \c from's items.
+*/
+apop_sketch *apop_sketch_merge(apop_sketch *into, apop_sketch const *from){
+    Apop_stopif(!into, return NULL, 0, "NULL sketch to merge into.");
+    if (!from || !from->n) return into;
+    if (!into->n) into->shift = from->shift;
+    long double delta = from->shift - into->shift; //re-center from's sums on into's shift
+    into->s2 += from->s2 + 2*delta*from->s1 + delta*delta*from->wsum;
+    into->s1 += from->s1 + delta*from->wsum;
+    into->wsum += from->wsum;
+    into->n += from->n;
+    into->min = GSL_MIN(into->min, from->min);
+    into->max = GSL_MAX(into->max, from->max);
+    if (!into->k) return into;
+    for (int h=0; h< from->levels; h++)
+        for (size_t i=0; i< from->len[h]; i++)
+            sketch_push(into, h, from->items[h][i]);
+    sketch_compress(into);
+    return into;
+}
+
+/** The weighted mean of the items added to a sketch. */
+double apop_sketch_mean(apop_sketch const *s){
+    Apop_stopif(!s || !s->n, return GSL_NAN, 1, "Empty sketch; returning NaN.");
+    return s->shift + s->s1/s->wsum;
+}
+
+/** The sample variance of the items added to a sketch, following the same rules for
+weights as \ref apop_vector_var. */
+double apop_sketch_var(apop_sketch const *s){
+    Apop_stopif(!s || !s->n, return GSL_NAN, 1, "Empty sketch; returning NaN.");
+    long double n = s->n;
+    if (s->wsum == n) return (double)(n*s->s2 - s->s1*s->s1) / (n*(n-1.));
+    //weighted: apop_vector_var's E(x^2) - E^2(x) form, which isn't shift-invariant when the weights sum to one.
+    long double sum   = s->s1 + s->shift*s->wsum,
+                sumsq = s->s2 + 2*s->shift*s->s1 + gsl_pow_2(s->shift)*s->wsum,
+                len   = (s->wsum < 1.1 ? n : s->wsum);
+    return (sumsq/len - gsl_pow_2(sum/len)) * len/(len -1.);
+}
+
+typedef struct { double x, w; } weighted_item;
+
+static int wcomp(const void *a, const void *b){ return dcomp(a, b); }
+
+/** An approximate quantile of the items added to a sketch.
+
+\param s A sketch built with a positive error bound.
+\param q The quantile, in [0, 1]. Zero and one give the exact min and max.
+\return The item whose approximate rank is the first to reach \f$qn\f$, or NaN if the sketch is empty or has no quantile sketch.
+*/
+double apop_sketch_quantile(apop_sketch const *s, double q){
+    Apop_stopif(!s || !s->n, return GSL_NAN, 1, "Empty sketch; returning NaN.");
+    if (q <= 0) return s->min;
+    if (q >= 1) return s->max;
+    Apop_stopif(!s->k, return GSL_NAN, 0, "This sketch was allocated with zero error, "
+                                         "so it keeps no quantile information. Returning NaN.");
+    size_t ct = 0;
+    for (int h=0; h< s->levels; h++) ct += s->len[h];
+    weighted_item *all = malloc(sizeof(weighted_item)*ct);
+    long double total = 0;
+    ct = 0;
+    for (int h=0; h< s->levels; h++)
+        for (size_t i=0; i< s->len[h]; i++){
+            all[ct++] = (weighted_item){.x=s->items[h][i], .w=ldexp(1, h)};
+            total += ldexp(1, h);
+        }
+    qsort(all, ct, sizeof(weighted_item), wcomp);
+    long double cum = 0;
+    double out = s->max;
+    for (size_t i=0; i< ct; i++)
+        if ((cum += all[i].w) >= q*total) {out = all[i].x; break;}
+    free(all);
+    return out;
+}
+
 /** Find the mean, weighted or unweighted. 
 
 \param v        The data vector
@@ -826,6 +1100,14 @@ static double biggest_elmt(gsl_matrix *d){
     return  GSL_MAX(fabs(gsl_matrix_max(d)), fabs(gsl_matrix_min(d)));
 }
 
+static int is_symmetric(gsl_matrix *m){
+    if (m->size1 != m->size2) return 0;
+    for (size_t i=0; i< m->size1; i++)
+        for (size_t j=0; j< i; j++)
+            if (gsl_matrix_get(m, i, j) != gsl_matrix_get(m, j, i)) return 0;
+    return 1;
+}
+
 /** Test whether the input matrix is positive semidefinite (PSD).
 
 A covariance matrix will always be PSD, so this function can tell you whether your matrix is a valid covariance matrix.
@@ -847,6 +1129,17 @@ APOP_VAR_HEAD int apop_matrix_is_positive_semidefinite(gsl_matrix *m, char semi)
     Apop_stopif(!m, return 0, 1, "You gave me a NULL matrix. I will take this as not positive semidefinite; returning zero.");
     char apop_varad_var(semi, 's');
 APOP_VAR_ENDHEAD
+    /* For a symmetric matrix, one Cholesky decomposition settles the common positive
+       definite case. The decomposition reads only the lower triangle, so anything
+       else goes straight to the minors test. */
+    if (is_symmetric(m)){
+        gsl_matrix *copy = apop_matrix_copy(m);
+        Set_gsl_handler
+        int not_pd = gsl_linalg_cholesky_decomp(copy);
+        Unset_gsl_handler
+        gsl_matrix_free(copy);
+        if (!not_pd) return 1;
+    }
     for (int i=1; i<= m->size1; i++){
         gsl_matrix mv =gsl_matrix_submatrix (m, 0, 0, i, i).matrix;
         double det = apop_matrix_determinant(&mv);
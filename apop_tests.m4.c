@@ -184,12 +184,12 @@ APOP_VAR_ENDHEAD
             apop_data_set(xpx, i, j, total);
         }
 
-    apop_data xpxinv = (apop_data){.matrix=apop_matrix_inverse(xpx->matrix)};
+    apop_data xpxinv = (apop_data){.matrix=apop_matrix_spd_inverse(xpx->matrix)};
     Apop_stopif(!xpxinv.matrix, out->error='i'; return out, 0, "inversion of X'X error");
     apop_data *qprimexpxinv = apop_dot(contrast, &xpxinv, 'm', 'm');
     apop_data *qprimexpxinvq = apop_dot(qprimexpxinv, contrast, 'm', 't');
     Apop_stopif(qprimexpxinvq->error || qprimexpxinv->error, out->error='m'; return out, 0, "broken dot");
-    apop_data qprimexpxinvqinv = (apop_data){.matrix=apop_matrix_inverse(qprimexpxinvq->matrix)};
+    apop_data qprimexpxinvqinv = (apop_data){.matrix=apop_matrix_spd_inverse(qprimexpxinvq->matrix)};
     Apop_stopif(!qprimexpxinvqinv.matrix, out->error='i'; return out, 0, "inversion of Q'(X'X)^{-1}Q error");
     apop_data_free(qprimexpxinvq);
     apop_data_free(qprimexpxinv);
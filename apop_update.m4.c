@@ -4,6 +4,9 @@
 
 #include "apop_internal.h"
 #include <stdbool.h>
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
 /* This file in four parts:
    --an apop_model named product, purpose-built for apop_update to send to apop_model_metropolis
@@ -119,6 +122,164 @@ likelihood. If you give me a parametrized normal, with no data, then I'll take t
     return outp;
 }
 
+/* The multivariate conjugates below reduce a batch of data to a precision matrix
+   P and a precision-weighted sum h. Given prior N(mu_0, Sigma_0), the posterior
+   is N(Sigma_n (Sigma_0^{-1} mu_0 + h), Sigma_n), where Sigma_n = (Sigma_0^{-1} + P)^{-1}.
+   Overwrites h. */
+static apop_model *mvn_posterior(apop_model *prior, gsl_matrix *P, gsl_vector *h){
+    apop_model *outp = apop_model_copy(prior);
+    gsl_matrix *precision = apop_matrix_spd_inverse(prior->parameters->matrix);
+    gsl_blas_dgemv(CblasNoTrans, 1, precision, prior->parameters->vector, 1, h);
+    gsl_matrix_add(precision, P);
+    gsl_matrix *post_cov = apop_matrix_spd_inverse(precision);
+    gsl_blas_dgemv(CblasNoTrans, 1, post_cov, h, 0, outp->parameters->vector);
+    gsl_matrix_memcpy(outp->parameters->matrix, post_cov);
+    gsl_matrix_free(precision);
+    gsl_matrix_free(post_cov);
+    return outp;
+}
+
+static apop_model *mvnmvn(apop_data *data, apop_model *prior, apop_model *likelihood){
+/* Sufficient statistics: n and the column sums. The likelihood's covariance is taken as
+   known; if the likelihood has no parameters, use the sample covariance. */
+    size_t k = prior->parameters->vector->size;
+    Apop_stopif(!data || !data->matrix || data->matrix->size2 != k,
+            return apop_model_copy(&(apop_model){.error='d'}), 0,
+            "I need a data matrix with one column per dimension of the prior (%zu).", k);
+    apop_data *sample_cov = (likelihood->parameters && likelihood->parameters->matrix)
+                                ? NULL : apop_data_covariance(data);
+    gsl_matrix *P = apop_matrix_spd_inverse(sample_cov ? sample_cov->matrix : likelihood->parameters->matrix);
+    gsl_vector *sums = gsl_vector_calloc(k);
+    for (size_t i=0; i< data->matrix->size1; i++)
+        gsl_vector_add(sums, Apop_mrv(data->matrix, i));
+    gsl_vector *h = gsl_vector_alloc(k);
+    gsl_blas_dgemv(CblasNoTrans, 1, P, sums, 0, h);
+    gsl_matrix_scale(P, data->matrix->size1);
+    apop_model *outp = mvn_posterior(prior, P, h);
+    apop_data_free(sample_cov);
+    gsl_matrix_free(P);
+    gsl_vector_free(sums);
+    gsl_vector_free(h);
+    return outp;
+}
+
+static apop_model *mvnols(apop_data *data, apop_model *prior, apop_model *likelihood){
+/* Sufficient statistics: X'X, X'y, y'y, n. The data is read as by the OLS log
+   likelihood: if the vector is filled, it is y and the matrix is X; else column zero
+   of the matrix is y, and stands in for a column of ones. The data is not modified. */
+    Apop_stopif(!data || !data->matrix, return apop_model_copy(&(apop_model){.error='d'}),
+            0, "No data for the regression.");
+    size_t n = data->matrix->size1, k = data->matrix->size2;
+    Apop_stopif(prior->parameters->vector->size != k, return apop_model_copy(&(apop_model){.error='d'}),
+            0, "The prior has %zu dimensions, but the regression has %zu coefficients.",
+            prior->parameters->vector->size, k);
+    gsl_matrix *xpx = gsl_matrix_alloc(k, k);
+    gsl_vector *xpy = gsl_vector_alloc(k);
+    double ypy;
+    gsl_blas_dsyrk(CblasLower, CblasTrans, 1, data->matrix, 0, xpx);
+    for (size_t i=0; i< k; i++)
+        for (size_t j=i+1; j< k; j++)
+            gsl_matrix_set(xpx, i, j, gsl_matrix_get(xpx, j, i));
+    if (data->vector){
+        gsl_blas_dgemv(CblasTrans, 1, data->matrix, data->vector, 0, xpy);
+        gsl_blas_ddot(data->vector, data->vector, &ypy);
+    } else { //M'M for M=[y X], then replace y with the ones column.
+        gsl_vector *sums = gsl_vector_calloc(k);
+        for (size_t i=0; i< n; i++)
+            gsl_vector_add(sums, Apop_mrv(data->matrix, i));
+        ypy = gsl_matrix_get(xpx, 0, 0);
+        gsl_matrix_get_col(xpy, xpx, 0);
+        gsl_vector_set(xpy, 0, gsl_vector_get(sums, 0));
+        gsl_vector_set(sums, 0, n);
+        gsl_matrix_set_col(xpx, 0, sums);
+        gsl_matrix_set_row(xpx, 0, sums);
+        gsl_vector_free(sums);
+    }
+
+    apop_data *err = likelihood->parameters
+                        ? apop_data_get_page(likelihood->parameters, "<Error variance>") : NULL;
+    double s_sq;
+    if (err) s_sq = apop_data_get(err);
+    else {
+        Apop_stopif(n <= k, gsl_matrix_free(xpx); gsl_vector_free(xpy);
+                return apop_model_copy(&(apop_model){.error='d'}), 0,
+                "The likelihood has no <Error variance> page, and with %zu observations "
+                "and %zu coefficients I can't estimate one.", n, k);
+        gsl_vector *b = gsl_vector_alloc(k);
+        double bxpy;
+        apop_matrix_spd_solve(xpx, xpy, b);
+        gsl_blas_ddot(b, xpy, &bxpy);
+        s_sq = (ypy - bxpy)/(n - k);
+        gsl_vector_free(b);
+    }
+    gsl_matrix_scale(xpx, 1/s_sq);
+    gsl_vector_scale(xpy, 1/s_sq);
+    apop_model *outp = mvn_posterior(prior, xpx, xpy);
+    gsl_matrix_free(xpx);
+    gsl_vector_free(xpy);
+    return outp;
+}
+
+static apop_model *gammanormal(apop_data *data, apop_model *prior, apop_model *likelihood){
+/* The Gamma prior describes the precision 1/sigma^2 of a Normal with known mean.
+   Posterior k = k_0 + n/2; posterior theta = 1/(1/theta_0 + sum (x-mu)^2/2).
+   If the likelihood has no parameters, mu is the sample mean. */
+    Get_vmsizes(data); //vsize, msize1, msize2, tsize
+    Apop_stopif(!tsize, return apop_model_copy(&(apop_model){.error='d'}), 0, "No data for the update.");
+    long double sum = 0, sumsq = 0;
+    for (int i=0; i< vsize; i++){
+        double x = gsl_vector_get(data->vector, i);
+        sum += x; sumsq += x*x;
+    }
+    for (int i=0; i< msize1; i++)
+        for (int j=0; j< msize2; j++){
+            double x = gsl_matrix_get(data->matrix, i, j);
+            sum += x; sumsq += x*x;
+        }
+    double mu = likelihood->parameters ? likelihood->parameters->vector->data[0] : sum/tsize;
+    long double ss = sumsq - 2*mu*sum + tsize*gsl_pow_2(mu);
+
+    apop_model *outp = apop_model_copy(prior);
+    *gsl_vector_ptr(outp->parameters->vector, 0) += tsize/2.;
+    double *theta = gsl_vector_ptr(outp->parameters->vector, 1);
+    *theta = 1./(1./ *theta + ss/2.);
+    return outp;
+}
+
+static apop_model *dirichletmultinom(apop_data *data, apop_model *prior, apop_model *likelihood){
+/* Posterior alpha_i = alpha_i + (count of draws in bin i). Data is as per apop_multinomial:
+   one row per observation, bin zero in the vector (if any), then the matrix columns.
+   As with betabinom, no data and a parametrized likelihood count as n draws at its
+   expected proportions. */
+    apop_model *outp = apop_model_copy(prior);
+    gsl_vector *alpha = outp->parameters->vector;
+    if (!data && likelihood->parameters){
+        gsl_vector *v = likelihood->parameters->vector;
+        Apop_stopif(v->size != alpha->size, outp->error='d'; return outp, 0,
+                "The prior has %zu bins, but the likelihood has %zu.", alpha->size, v->size);
+        double n = v->data[0], p0 = 1;
+        for (size_t i=1; i< v->size; i++){
+            *gsl_vector_ptr(alpha, i) += n*v->data[i];
+            p0 -= v->data[i];
+        }
+        *gsl_vector_ptr(alpha, 0) += n*p0;
+        return outp;
+    }
+    Apop_stopif(!data, outp->error='d'; return outp, 0, "No data, and no parameters for the likelihood.");
+    Get_vmsizes(data); //vsize, msize1, msize2
+    size_t bins = (vsize ? 1 : 0) + msize2;
+    Apop_stopif(bins != alpha->size, outp->error='d'; return outp, 0,
+            "The prior has %zu bins, but the data has %zu columns.", alpha->size, bins);
+    if (vsize) *gsl_vector_ptr(alpha, 0) += apop_sum(data->vector);
+    if (msize1){
+        int first = vsize ? 1 : 0;
+        gsl_vector *alpha_m = Apop_subvector(alpha, first, msize2);
+        for (int i=0; i< msize1; i++)
+            gsl_vector_add(alpha_m, Apop_mrv(data->matrix, i));
+    }
+    return outp;
+}
+
 /** Take in a prior and likelihood distribution, and output a posterior distribution.
 
 \li This function first checks a table of conjugate distributions for the pair you sent
@@ -135,6 +296,14 @@ apop_model_metropolis documentation.
 element, then make draws from the prior and weight them by the \c p given by the
 likelihood distribution. This is not a rejection sampling method, so the burnin
 is ignored.
+All draws are made from the prior, in order, using \c rng. If the likelihood model
+has no settings groups and no \c more element, its state is entirely in its parameters,
+so the draws' likelihoods are calculated in parallel, each thread using its own copy of the
+likelihood; otherwise (e.g., for a model from \ref apop_model_fix_params, whose copies
+share a base model) they are calculated one at a time. Weights are calculated in log space and
+normalized to sum to one, so they do not underflow when the data set is large. The
+output model's \c info page lists the <tt>effective sample size</tt>, \f$1/\sum w_i^2\f$,
+and the <tt>log marginal likelihood</tt>, the log of the mean likelihood over the draws.
 
 \param data     The input data, that will be used by the likelihood function (default = \c NULL.)
 \param  prior   The prior \ref apop_model. If the system needs to
@@ -162,9 +331,23 @@ function, so you can chain Bayesian updating procedures.
 <td> \ref apop_normal "Normal" <td></td> \ref apop_normal "Normal" <td></td>  Assumes prior with fixed \f$\sigma\f$; updates distribution for \f$\mu\f$
 </td></tr> <tr>
 <td> \ref apop_gamma "Gamma" <td></td> \ref apop_poisson "Poisson" <td></td> Uses sum and size of the data  
+</td></tr> <tr>
+<td> \ref apop_gamma "Gamma" <td></td> \ref apop_normal "Normal" <td></td> Gamma prior represents the distribution of the precision \f$1/\sigma^2\f$; the likelihood's \f$\mu\f$ is fixed (the sample mean if the likelihood has no parameters)
+</td></tr> <tr>
+<td> \ref apop_dirichlet "Dirichlet" <td></td> \ref apop_multinomial "Multinomial" <td></td> Adds the count in each bin to its \f$\alpha\f$. If the data is \c NULL and the likelihood has parameters \f$(n, p_1, \dots)\f$, adds the expected counts, \f$n p_i\f$, instead, as with the Beta/Binomial pair
+</td></tr> <tr>
+<td> \ref apop_multivariate_normal "Multivariate Normal" <td></td> \ref apop_multivariate_normal "Multivariate Normal" <td></td> Assumes the likelihood's covariance is fixed (the sample covariance if the likelihood has no parameters); updates the distribution of the mean
+</td></tr> <tr>
+<td> \ref apop_multivariate_normal "Multivariate Normal" <td></td> \ref apop_ols "OLS" <td></td> Bayesian linear regression; the prior describes the coefficients. The error variance is taken from the likelihood's <tt>\<Error variance\></tt> page if it has one, else estimated from the data
 </td></tr>
 </table>
 
+\li Every conjugate update reduces the data to sufficient statistics (counts, sums,
+cross-products) and returns a model of the same family as the prior. So you can feed
+data in batches, using the posterior from one batch as the prior for the next, and
+get the same result as a single update on all of the data (except for the OLS case
+where the error variance is estimated, which estimates it separately for each batch).
+
 Here is a test function that compares the output via conjugate table and via
 Metropolis-Hastings sampling: 
 \include test_updating.c
@@ -192,6 +375,10 @@ APOP_VAR_END_HEAD
         apop_update_vtable_add(gammaexpo, apop_gamma, apop_exponential);
         apop_update_vtable_add(gammapoisson, apop_gamma, apop_poisson);
         apop_update_vtable_add(normnorm, apop_normal, apop_normal);
+        apop_update_vtable_add(mvnmvn, apop_multivariate_normal, apop_multivariate_normal);
+        apop_update_vtable_add(mvnols, apop_multivariate_normal, apop_ols);
+        apop_update_vtable_add(gammanormal, apop_gamma, apop_normal);
+        apop_update_vtable_add(dirichletmultinom, apop_dirichlet, apop_multinomial);
     }
     apop_update_type conj = apop_update_vtable_get(prior, likelihood);
     if (conj) return conj(data, prior, likelihood);
@@ -229,31 +416,76 @@ APOP_VAR_END_HEAD
 
     if (!s) s = Apop_model_add_group(prior, apop_mcmc);
 
-    gsl_vector *draw = gsl_vector_alloc(tsize);
     apop_data *out = apop_data_alloc(s->periods, tsize);
     out->weights = gsl_vector_alloc(s->periods);
 
-    apop_draw(draw->data, rng, prior); //set starting point.
-    apop_data_unpack(draw, likelihood->parameters);
+    //Draws are made serially, because draw methods often set up internal state on first
+    //use (like a PMF's CDF). Likelihoods are then evaluated in parallel if it is safe.
+    for (int i=0; i< s->periods; i++)
+        apop_draw(Apop_rv(out, i)->data, rng, prior);
+
+    int threads = 1;
+    #ifdef _OPENMP
+    if (!likelihood->more && (!likelihood->settings || !likelihood->settings[0].name[0]))
+        threads = omp_get_max_threads();
+    #endif
+    //Each thread unpacks its draws into its own copy of the likelihood's parameters.
+    apop_model *likes[threads];
+    likes[0] = likelihood;
+    for (int t=1; t< threads; t++) likes[t] = apop_model_copy(likelihood);
+
+    OMP_for (int i=0; i< (threads > 1 ? s->periods : 0); i++){
+        int t = 0;
+        #ifdef _OPENMP
+            t = omp_get_thread_num();
+        #endif
+        apop_data_unpack(Apop_rv(out, i), likes[t]->parameters);
+        gsl_vector_set(out->weights, i, apop_log_likelihood(data, likes[t]));
+    }
+    for (int t=1; t< threads; t++) apop_model_free(likes[t]);
 
     for (int i=0; i< s->periods; i++){
-        newdraw:
-        apop_draw(draw->data, rng, prior);
-        apop_data_unpack(draw, likelihood->parameters);
-        long double p = apop_p(data, likelihood);
-
-        Apop_notify(3, "p=%Lg for parameters:\t", p);
-        if (apop_opts.verbose >=3) apop_data_print(likelihood->parameters);
-
-        Apop_stopif(gsl_isnan(p), goto newdraw,
-                1, "Trouble evaluating the "
-                "likelihood function at vector beginning with %g. "
-                "Throwing it out and trying again.\n"
-                , likelihood->parameters->vector->data[0]);
-        apop_data_pack(likelihood->parameters, Apop_rv(out, i));
-        gsl_vector_set(out->weights, i, p);
+        gsl_vector *draw = Apop_rv(out, i);
+        double ll = (threads > 1) ? gsl_vector_get(out->weights, i) : GSL_NAN;
+        if (threads == 1){
+            apop_data_unpack(draw, likelihood->parameters);
+            ll = apop_log_likelihood(data, likelihood);
+        }
+        while (gsl_isnan(ll)) {
+            Apop_notify(1, "Trouble evaluating the "
+                    "likelihood function at vector beginning with %g. "
+                    "Throwing it out and trying again.\n", draw->data[0]);
+            apop_draw(draw->data, rng, prior);
+            apop_data_unpack(draw, likelihood->parameters);
+            ll = apop_log_likelihood(data, likelihood);
+        }
+        Apop_notify(3, "ll=%g for the draw beginning with %g.", ll, draw->data[0]);
+        gsl_vector_set(out->weights, i, ll);
+    }
+
+    //Log-sum-exp: shift by the largest log likelihood before exponentiating.
+    double max_ll = gsl_vector_max(out->weights);
+    Apop_stopif(!isfinite(max_ll), apop_data_free(out); return apop_model_copy(&(apop_model){.error='p'}),
+            0, "The largest log likelihood over the draws from the prior is %g, "
+               "so I can't weight the draws.", max_ll);
+    long double total = 0, sumsq = 0;
+    for (int i=0; i< s->periods; i++){
+        double *w = gsl_vector_ptr(out->weights, i);
+        *w = exp(*w - max_ll);
+        total += *w;
+    }
+    for (int i=0; i< s->periods; i++){
+        double *w = gsl_vector_ptr(out->weights, i);
+        *w /= total;
+        sumsq += gsl_pow_2(*w);
     }
     apop_model *outp = apop_estimate(out, apop_pmf);
-    gsl_vector_free(draw);
+    if (!outp->info){
+        outp->info = apop_data_alloc();
+        Asprintf(&outp->info->names->title, "<Info>");
+    }
+    apop_data_add_named_elmt(outp->info, "effective sample size", 1/sumsq);
+    apop_data_add_named_elmt(outp->info, "log marginal likelihood", max_ll + logl(total/s->periods));
+    Apop_notify(2, "Effective sample size of the %li weighted draws: %Lg.", s->periods, 1/sumsq);
     return outp;
 }
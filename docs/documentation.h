@@ -93,7 +93,9 @@ fixed, that parameter is optimized, then all but the second parameter are fixed,
 parameter is optimized, ..., looping through dimensions until the change in objective
 across cycles is less than <tt>eps</tt>), add a settings group specifying the
 tolerance at which the cycle should stop: <tt>Apop_settings_add_group(your_model,
-apop_mle, .dim_cycle_tolerance=eps)</tt>.
+apop_mle, .dim_cycle_tolerance=eps)</tt>. If blocks of parameters are nearly
+independent, add <tt>.dim_cycle_blocks=n</tt> to optimize \c n blocks in parallel
+on each cycle.
   \li The Iterative Proportional Fitting algorithm, \ref apop_rake, is best-in-breed,
 designed to handle large, sparse matrices.
 
@@ -856,6 +858,7 @@ manipulate the \ref apop_data structure and its components.
 \li\ref apop_data_sort
 \li\ref apop_data_split
 \li\ref apop_data_stack
+\li\ref apop_data_unshare : before writing through views, take ownership of text and row names shared with copies
 \li\ref apop_data_transpose : transpose matrices (square or not) and text grids
 \li\ref apop_data_unpack
 \li\ref apop_matrix_copy
@@ -914,6 +917,7 @@ Examples of use can be found throughout the documentation; for example, see \ref
 \li\ref apop_data_alloc
 \li\ref apop_data_calloc
 \li\ref apop_data_free
+\li\ref apop_arena_begin, \ref apop_arena_end, \ref apop_arena_alloc, \ref apop_arena_vector, \ref apop_arena_matrix, \ref apop_arena_data : scoped scratch space for temporaries in tight loops
 \li\ref apop_text_alloc : allocate or resize the text part of an \ref apop_data set.
 \li\ref apop_text_free
 
@@ -1218,6 +1222,7 @@ See also:
 \li\ref apop_matrix_determinant
 \li\ref apop_matrix_inverse
 \li\ref apop_det_and_inv : find determinant and inverse at the same time
+\li\ref apop_matrix_spd_inverse, \ref apop_matrix_spd_logdet, \ref apop_spd_logdet_and_inv, \ref apop_matrix_spd_solve : the same for symmetric positive definite matrices, via a Cholesky decomposition
 
 See the GSL documentation for myriad further options.
 
@@ -1226,8 +1231,10 @@ See the GSL documentation for myriad further options.
 
 \li\ref apop_data_summarize
 \li\ref apop_vector_moving_average
+\li\ref apop_vector_rolling, \ref apop_data_rolling : windowed sums, means, variances, min/max, and exponentially weighted means
 \li\ref apop_vector_percentiles
 \li\ref apop_vector_bounded
+\li\ref apop_sketch_alloc, \ref apop_sketch_add, \ref apop_sketch_merge, \ref apop_sketch_quantile, \ref apop_sketch_mean, \ref apop_sketch_var, \ref apop_sketch_free: one-pass, mergeable summaries
 
 See also:
 
@@ -1388,6 +1395,11 @@ point to <em>the same</em> static empty string, meaning that freeing cells must
 done with care. Your best bet is to rely on \ref apop_text_set, \ref apop_text_alloc,
 and \ref apop_text_free to do the memory management for you.
 
+Large text grids can be stored compactly, with all strings in one pool and each
+repeated string in a column stored once; see \ref apop_text_pack. Query output is
+already stored this way. Reading via <tt>dataset->text[i][j]</tt> works as usual, but
+this is one more reason to leave the freeing to \ref apop_data_free.
+
 Here is a sample program that uses these forms, plus a few text-handling functions.
 
 \include eg/text_demo.c
@@ -1402,6 +1414,7 @@ functions.
 \li\ref apop_query_to_text
 \li\ref apop_text_alloc : allocate or resize the text part of an \ref apop_data set.
 \li\ref apop_text_set : replace a single cell of the text grid with new text.
+\li\ref apop_text_pack : store the text grid in one block, with optional dictionary encoding of repeated strings.
 \li\ref apop_text_paste : convert a table of strings into one long string.
 \li\ref apop_text_unique_elements : get a sorted list of unique elements for one column of text.
 \li\ref apop_text_free : you may never need this, because \ref apop_data_free calls it.
@@ -1480,6 +1493,8 @@ to read in data and write final output tables.
 \section edftd Extracting data from the database
 
 \li\ref apop_db_to_crosstab : take up to three columns in the database (row, column, value) and produce a table of values.
+\li\ref apop_data_to_crosstab : the same, for two columns of an in-memory data set.
+\li\ref apop_query_to_blocks : send the output of a query to a function one block of rows at a time.
 \li\ref apop_query_to_data
 \li\ref apop_query_to_float
 \li\ref apop_query_to_mixed_data
@@ -1919,7 +1934,9 @@ output, typically as a row in the \c info element of the output \ref apop_model.
 \li\ref apop_t_test
 \li\ref apop_test_anova_independence
 \li\ref apop_test_fisher_exact
+\li\ref apop_test_fisher_exact_batch
 \li\ref apop_test_kolmogorov
+\li\ref apop_test_kolmogorov_vector
 \li\ref apop_estimate_coefficient_of_determination
 \li\ref apop_estimate_r_squared
 
@@ -2043,7 +2060,9 @@ which you can get via \ref apop_data_to_bins. It requires a bin specification. I
 send a \c NULL binspec, then the offset is zero and the bin size is big enough to ensure
 that there are \f$\sqrt{N}\f$ bins from minimum to maximum. The binspec will be added
 as a page to the data set, named <tt>"<binspec>"</tt>. See the \ref apop_data_to_bins
-documentation on how to write a custom bin spec.
+documentation on how to write a custom bin spec. If what you want is the histogram
+itself, \ref apop_data_histogram takes the same binspec and returns one row per
+nonempty bin with its count as the weight, without building a binned copy of the data.
 
 
 There are a few ways of testing the claim that one distribution equals another, typically an empirical PMF versus a smooth theoretical distribution. In both cases, you will need two distributions based on the same binspec. 
@@ -2063,6 +2082,7 @@ Or, use \ref apop_vector_moving_average for a simpler smoothing method.
 
 \li\ref apop_data_pmf_compress() : merge together redundant rows in a data set before calling 
                 \ref apop_estimate(\c your_data, \ref apop_pmf); optional.
+\li\ref apop_data_histogram() : bin and count a data set in one step, producing a compressed, weighted data set for a PMF.
 \li\ref apop_vector_moving_average() : smooth a vector (e.g., <tt>your_pmf->data->weights</tt>) via moving average.
 \li\ref apop_histograms_test_goodness_of_fit() : goodness-of-fit via \f$\chi^2\f$ statistic
 \li\ref apop_test_kolmogorov() : goodness-of-fit via Kolmogorov-Smirnov statistic
@@ -2187,6 +2207,33 @@ function is globally convex (as are most standard probability functions), then t
 method is overkill.
 
 
+\section multistart Multiple starting points
+
+Conjugate gradient and simplex searches find a local optimum near where they start. If
+you suspect your likelihood has several modes (mixtures are the typical case), set the
+\c starts element of the \ref apop_mle_settings group to run several searches at once:
+
+\code
+Apop_settings_add_group(your_model, apop_mle, .starts=20, .start_range=3);
+apop_model *est = apop_estimate(your_data, your_model);
+apop_data_show(apop_data_get_page(est->info, "<Multistart>"));
+\endcode
+
+\li The first search begins at \c starting_pt (or all ones), and the others begin at
+points within \c start_range of it in each dimension, drawn from a Latin hypercube
+by default. Set <tt>.start_draws='r'</tt> for plain uniform draws, or give your own
+list of starting points, one per row, in the <tt>.start_list</tt> matrix.
+\li Each search runs on its own copy of the model, with its own RNG, so with OpenMP the
+searches run in parallel. Those RNGs are seeded by draws from the \c rng element of the
+settings, so a given \c rng gives the same searches every time.
+\li The estimate with the highest log likelihood is returned, along with its \c error
+code. With \c verbose set in the settings, each search's log likelihood is reported via
+the usual notification channel, \ref apop_opts.log_file. The <tt>\<Multistart\></tt>
+page of the output model's \c info element lists every search's endpoint in its
+\c matrix and the log likelihood at that point in its \c vector.
+\li The covariance and tests (if requested via \ref apop_parts_wanted_settings) are
+calculated only for the winning estimate.
+
 \section mlfns Useful functions
 
 \li\ref apop_estimate_restart : Restarting an MLE with different settings can improve results.
@@ -2206,6 +2253,7 @@ Some functions for missing data:
 A few more descriptive methods:
 
 \li\ref apop_matrix_pca : Principal component analysis
+\li\ref apop_pca_blocks_alloc : Principal component analysis on data read in blocks
 \li\ref apop_anova : One-way or two-way ANOVA tables
 \li\ref apop_rake : Iterative proportional fitting on large, sparse tables
 
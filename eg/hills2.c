@@ -41,7 +41,7 @@ int main(){
     gsl_matrix_set_all(x->matrix, NAN);
 
     apop_opts.stop_on_warning='v';
-    apop_ml_impute(x, many_humps);
+    apop_model_free(apop_ml_impute(x, many_humps));
 
     printf("Optimum found at:\n");
     apop_data_show(x);
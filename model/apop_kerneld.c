@@ -145,12 +145,13 @@ static int kernel_draw(double *d, gsl_rng *r, apop_model *m){
     //randomly select a point, using the weights.
     apop_kernel_density_settings *ks = apop_settings_get_group(m, apop_kernel_density);
     apop_model *pmf = apop_settings_get(m, apop_kernel_density, base_pmf);
-    apop_data *point = apop_data_alloc(1, pmf->dsize);
-    Apop_stopif(apop_draw(Apop_rv(point, 0)->data, r, pmf), return 1, 0, "Unable to use the PMF over kernels to select a kernel from which to draw.");
+    apop_arena_begin();
+    apop_data *point = apop_arena_data(1, pmf->dsize);
+    Apop_stopif(apop_draw(Apop_rv(point, 0)->data, r, pmf), apop_arena_end(); return 1, 0, "Unable to use the PMF over kernels to select a kernel from which to draw.");
     (ks->set_fn)(point, ks->kernel);
+    apop_arena_end();
     //Now draw from the distribution around that point.
     Apop_stopif(apop_draw(d, r, ks->kernel), return 2, 0, "unable to draw from a single selected kernel.");
-    apop_data_free(point);
     return 0;
 }
 
@@ -13,8 +13,8 @@ Provenance:
             Those BK edits made during time working as a gov't
             employee are public domain.
 
-    By the way, search the code for execnt: many functions will let you
-    query how many times they have been hit, which you might find to be useful.
+    Locals are automatic and the state the C wrapper once kept in globals
+    is in a per-fit \c loess_ws, so several loess fits can run at once.
 
 \amodel apop_loess Regression via loess smoothing
 
@@ -66,6 +66,9 @@ apop_data set named "<Confidence>" with a lower and upper CI for each point.
 \adoc    settings \ref apop_loess_settings */
 
 #include "apop_internal.h"
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
 
 ////////////a few lines from f2c.h
 #define TRUE_ (1)
@@ -233,10 +236,10 @@ static void dqrsl_(double *x, integer *ldx, integer *n, integer * k, double *qra
         double *qy, double *qty, double *b, double *rsd, double *xb, integer job, integer *info) {
 
     integer x_dim1, i__1, i__2;
-    static integer i__, j;
-    static double t, temp;
-    static integer jj, ju, kp1;
-    static logical cb, cr, cxb, cqy, cqty;
+    integer i__, j;
+    double t, temp;
+    integer jj, ju, kp1;
+    logical cb, cr, cxb, cqy, cqty;
 
     x_dim1 = *ldx;
     x -= 1 + x_dim1;
@@ -453,11 +456,11 @@ static void dsvdc_(double *x, integer *ldx, integer *n, integer * p, double *s,
         double *v, integer *ldv, double *work, integer *job, integer * info) {
     integer x_dim1, u_dim1, v_dim1, i__2, i__3;
     double d__1;
-    static double b, c__, f, g, t, t1, el, cs, sl, sm, sn, acc, emm1, smm1;
-    static double test, scale, shift, ztest;
-    static integer i__, j, k, l, m, kk, ll, mm, ls, lu, lm1, mm1, lp1, mp1, nct, ncu, lls, nrt;
-    static integer kase, jobu, iter, nctp1, nrtp1, maxit;
-    static logical wantu, wantv;
+    double b, c__, f, g, t, t1, el, cs, sl, sm, sn, acc, emm1, smm1;
+    double test, scale, shift, ztest;
+    integer i__, j, k, l, m, kk, ll, mm, ls, lu, lm1, mm1, lp1, mp1, nct, ncu, lls, nrt;
+    integer kase, jobu, iter, nctp1, nrtp1, maxit;
+    logical wantu, wantv;
 
     x_dim1 = *ldx;
     x -= 1 + x_dim1;
@@ -828,8 +831,61 @@ L610:
 #define	GAUSSIAN	1
 #define SYMMETRIC	0
 
-static long	*iv, liv, lv, tau;
-static double *v;
+/* The workspace for one fit, formerly a set of file-scope globals. */
+typedef struct {
+    long *iv, liv, lv, tau;
+    double *v;
+} loess_ws;
+
+/* Scratch for fitting at one vertex (ehg139_) or evaluation point (ehg136_). The fits
+   run in parallel, and each thread reuses one of these for all of its points. */
+typedef struct {
+    integer *psi, *diag_at;
+    double *dist, *eta, *b, *w, *vval2, *diag_term;
+} vertex_ws;
+
+static int vertex_ws_count(void){
+    #ifdef _OPENMP
+        return omp_get_max_threads();
+    #endif
+    return 1;
+}
+
+static vertex_ws *vertex_ws_this_thread(vertex_ws *ws){
+    #ifdef _OPENMP
+        return ws + omp_get_thread_num();
+    #endif
+    return ws;
+}
+
+/* vval2_ct is zero unless the caller accumulates the trace. vval2 starts zeroed, and
+   ehg139_ zeroes each vertex's slot after using it, so it stays zeroed between vertices. */
+static vertex_ws *vertex_ws_alloc(int ct, integer n, integer nf, integer vval2_ct){
+    vertex_ws *out = calloc(ct, sizeof(vertex_ws));
+    for (int t=0; t< ct; t++){
+        vertex_ws *w = out+t;
+        w->psi = malloc(sizeof(integer) * n);
+        w->dist = malloc(sizeof(double) * (n + 1)); //ehg127_ uses dist[1..n]
+        w->eta = malloc(sizeof(double) * nf);
+        w->b = malloc(sizeof(double) * nf * 15);
+        w->w = malloc(sizeof(double) * nf);
+        if (vval2_ct){
+            w->vval2 = calloc(vval2_ct, sizeof(double));
+            w->diag_term = malloc(sizeof(double) * nf);
+            w->diag_at = malloc(sizeof(integer) * nf);
+        }
+    }
+    return out;
+}
+
+static void vertex_ws_free(vertex_ws *ws, int ct){
+    for (int t=0; t< ct; t++){
+        free(ws[t].psi); free(ws[t].dist); free(ws[t].eta);
+        free(ws[t].b); free(ws[t].w);
+        free(ws[t].vval2); free(ws[t].diag_term); free(ws[t].diag_at);
+    }
+    free(ws);
+}
 
 /* begin ehg's FORTRAN-callable C-codes */
 
@@ -910,17 +966,15 @@ static integer ifloor(double x) {
 
 static void ehg126_(integer *d__, integer *n, integer *vc, double *x, double *v, integer *nvmax) {
     integer v_dim1, x_dim1;
-    static integer execnt = 0, i__, j, k;
-    static double t, mu, beta, alpha, machin;
+    integer i__, j, k;
+    double t, mu, beta, alpha, machin;
 
     x_dim1 = *n;
     x -= 1 + x_dim1;
     v_dim1 = *nvmax;
     v -= 1 + v_dim1;
 
-    ++execnt;
-    if (execnt == 1)
-        machin = DBL_MAX;
+    machin = DBL_MAX;
 /*     fill in vertices for bounding box of $x$ */
 /*     lower left, upper right */
     for (k = 1; k <= *d__; ++k) {
@@ -953,8 +1007,8 @@ static void ehg125_(integer *p, integer *nv, double *v, integer *vhit, integer n
        integer k, double *t, integer *r__, integer *s, integer *f, integer *l, integer *u) {
 
     integer f_dim1, l_dim1, u_dim1, v_dim1;
-    static integer h__, i__, j, m, i3, mm, execnt = 0;
-    static logical match;
+    integer h__, i__, j, m, i3, mm;
+    logical match;
 
     --vhit;
     v_dim1 = nvmax;
@@ -966,7 +1020,6 @@ static void ehg125_(integer *p, integer *nv, double *v, integer *vhit, integer n
     f_dim1 = *r__;
     f -= 1 + (f_dim1 << 1);
 
-    ++execnt;
     h__ = *nv;
     for (i__ = 1; i__ <= *r__; ++i__)
         for (j = 1; j <= *s; ++j) {
@@ -1004,14 +1057,13 @@ static void ehg125_(integer *p, integer *nv, double *v, integer *vhit, integer n
 static void find_kth_smallest(integer il, integer ir, integer k, integer nk, double *p, integer *pi) {
     //Formerly ehg106
     integer p_dim1;
-    static integer execnt = 0, i__, j, l, r, ii;
-    static double t;
+    integer i__, j, l, r, ii;
+    double t;
 
     --pi;
     p_dim1 = nk;
     p -= 1 + p_dim1;
 
-    ++execnt;
     /*     find the $k$-th smallest of $n$ elements */
     /*     Floyd+Rivest, CACM Mar '75, Algorithm 489 */
     l = il;
@@ -1062,8 +1114,8 @@ static integer idamax(integer n, double *dx, integer incx) {
     /*     Finds the index of element having max. absolute value. */
     /*     jack dongarra, linpack, 3/11/78. */
     int ret_val = 1;
-    static integer i__, ix;
-    static double dmax__;
+    integer i__, ix;
+    double dmax__;
     --dx;
 
     if (n < 1)
@@ -1095,9 +1147,9 @@ static void ehg124_(integer *ll, integer *uu, integer d__, integer n, integer *n
         integer *lo, integer *hi, integer *c__, double *v, integer *vhit, integer nvmax, integer *
         fc, double *fd, integer *dd) {
     integer c_dim1, v_dim1, v_offset, x_dim1, x_offset, i__1, i__3;
-    static integer execnt = 0, k, l, m, p, u, i4, check, lower, upper, inorm2, offset;
-    static logical i1, i2, leaf;
-    static double diag[8], diam, sigma[8];
+    integer k, l, m, p, u, i4, check, lower, upper, inorm2, offset;
+    logical i1, i2, leaf;
+    double diag[8], diam, sigma[8];
 
     --pi; --hi; --lo; --xi; --a; --vhit;
     x_dim1 = n;
@@ -1107,7 +1159,6 @@ static void ehg124_(integer *ll, integer *uu, integer d__, integer n, integer *n
     v_dim1 = nvmax;
     v -= v_offset = 1 + v_dim1;
 
-    ++execnt;
     p = 1;
     l = *ll;
     u = *uu;
@@ -1198,8 +1249,8 @@ static void ehg127_(double *q, integer *n, integer *d__, integer *nf, double *f,
 
     integer b_dim1, x_dim1, b_offset;
     double d__1;
-    static integer execnt = 0, i__, j, i3, i9, jj, info, jpvt, inorm2, column;
-    static double g[15], i2, rho, scal, machep, colnor[15];
+    integer i__, j, i3, i9, jj, info, jpvt, inorm2, column;
+    double g[15], i2, rho, scal, machep, colnor[15];
 
     --rw; --y; --psi;
     x_dim1 = *n;
@@ -1214,9 +1265,7 @@ static void ehg127_(double *q, integer *n, integer *d__, integer *nf, double *f,
     e -= 16;
     --dgamma; --qraux; --work; --cdeg;
 
-    ++execnt;
-    if (execnt == 1)
-        machep = DBL_EPSILON;
+    machep = DBL_EPSILON;
     /*     sort by distance */
     for (i3 = 1; i3 <= *n; ++i3)
         dist[i3] = 0.;
@@ -1333,15 +1382,12 @@ static void ehg127_(double *q, integer *n, integer *d__, integer *nf, double *f,
 
 static void ehg129_(integer *l, integer *u, integer *d__, double *x, integer *pi, integer n, double *sigma) {
     integer x_dim1;
-    static integer execnt = 0;
-    static double t, beta, alpha, machin;
+    double t, beta, alpha, machin;
     --sigma;
     --pi;
     x_dim1 = n;
     x -= 1 + x_dim1;
-    ++execnt;
-    if (execnt == 1)
-        machin = DBL_MAX;
+    machin = DBL_MAX;
     for (integer k = 1; k <= *d__; ++k) {
         alpha = machin;
         beta = -machin;
@@ -1366,9 +1412,9 @@ static void ehg131_(double *x, double *y, double *rw, double *trl,
     integer lq_dim1, lq_offset, c_dim1, c_offset, lf_dim1, lf_dim2, lf_offset,
 	     v_dim1, v_offset, vval_dim1, vval_offset, vval2_dim1, vval2_offset, x_dim1, x_offset;
 
-    static integer execnt = 0, j, i1, i2;
-    static double delta[8];
-    static integer identi;
+    integer j, i1, i2;
+    double delta[8];
+    integer identi;
 
     --psi; --pi; 
     x_dim1 = *n;
@@ -1393,7 +1439,6 @@ static void ehg131_(double *x, double *y, double *rw, double *trl,
     lq -= lq_offset = 1 + lq_dim1;
     --w; --eta; --b; --cdeg;
 
-    ++execnt;
     if (! (*d__ <= 8))
         loess_error(101);
 /*     build $k$-d tree */
@@ -1427,8 +1472,8 @@ static void ehg133_(integer *n, integer *d__, integer *vc, integer *nvmax, integ
         double *vval, double *xi, integer m, double *z__, double *s) {
     integer c_dim1, c_offset, v_dim1, v_offset, vval_dim1, vval_offset, z_dim1, z_offset;
 
-    static integer execnt = 0, i__, i1;
-    static double delta[8];
+    integer i__, i1;
+    double delta[8];
 
     vval_dim1 = *d__ - 0 + 1;
     vval -= vval_offset = 0 + vval_dim1;
@@ -1440,7 +1485,6 @@ static void ehg133_(integer *n, integer *d__, integer *vc, integer *nvmax, integ
     z_dim1 = m;
     z__ -= z_offset = 1 + z_dim1;
 
-    ++execnt;
     for (i__ = 1; i__ <= m; ++i__) {
         for (i1 = 1; i1 <= *d__; ++i1)
             delta[i1 - 1] = z__[i__ + i1 * z_dim1];
@@ -1472,8 +1516,8 @@ static void set_cs(integer d, integer i, double *c1, double *c2, double *c3){
 static void ehg141_(double *trl, integer *n, integer *deg, integer *k, integer *d,
         integer *nsing, integer *dk, double * delta1, double *delta2) {
 
-    static integer i;
-    static double z, c1, c2, c3, c4, corx;
+    integer i;
+    double z, c1, c2, c3, c4, corx;
 
 /*     coef, d, deg, del */
     if (*deg == 0)
@@ -1497,43 +1541,36 @@ static void ehg141_(double *trl, integer *n, integer *deg, integer *k, integer *
 } /* ehg141_ */
 
 static void lowesc_(integer *n, double *l, double *ll, double *trl, double *delta1, double *delta2) {
-    static integer execnt = 0, i__, j;
-    integer l_dim1, ll_dim1;
+    integer N = *n;
+    double tr = 0, d1 = 0, d2 = 0;
 
-    ll_dim1 = *n;
-    ll -= 1 + ll_dim1;
-    l_dim1 = *n;
-    l -= 1 + l_dim1;
-
-    ++execnt;
 /*     compute $LL~=~(I-L)(I-L)'$ */
-    for (i__ = 1; i__ <= *n; ++i__)
-        --l[i__ + i__ * l_dim1];
-    for (i__ = 1; i__ <= *n; ++i__)
-        for (j = 1; j <= i__; ++j)
-            ll[i__ + j * ll_dim1] = ddot_(n, &l[i__ + l_dim1], n, &l[j + l_dim1], n);
-    for (i__ = 1; i__ <= *n; ++i__)
-        for (j = i__ + 1; j <= *n; ++j)
-            ll[i__ + j * ll_dim1] = ll[j + i__ * ll_dim1];
-    for (i__ = 1; i__ <= *n; ++i__)
-        ++l[i__ + i__ * l_dim1];
+    for (integer i = 0; i < N; ++i)
+        --l[i + i * N];
+    cblas_dsyrk(CblasColMajor, CblasLower, CblasNoTrans, N, N, 1, l, N, 0, ll, N);
+    for (integer i = 0; i < N; ++i)
+        ++l[i + i * N];
+    OMP_for (integer j = 1; j < N; ++j)
+        for (integer i = 0; i < j; ++i)
+            ll[i + j * N] = ll[j + i * N];
 /*     accumulate first two traces */
-    *trl = 0.;
-    *delta1 = 0.;
-    for (i__ = 1; i__ <= *n; ++i__) {
-        *trl += l[i__ + i__ * l_dim1];
-        *delta1 += ll[i__ + i__ * ll_dim1];
+    for (integer i = 0; i < N; ++i) {
+        tr += l[i + i * N];
+        d1 += ll[i + i * N];
     }
-/*     $delta sub 2 = "tr" LL sup 2$ */
-    *delta2 = 0.;
-    for (i__ = 1; i__ <= *n; ++i__)
-        *delta2 += ddot_(n, &ll[i__ + ll_dim1], n, &ll[i__ * ll_dim1 + 1], & c__1);
+/*     $delta sub 2 = "tr" LL sup 2$; LL is symmetric, so this is the sum of its squares */
+    OMP_for_reduce(+:d2, integer j = 0; j < N; ++j)
+        for (integer i = 0; i < N; ++i)
+            d2 += gsl_pow_2(ll[i + j * N]);
+    *trl = tr;
+    *delta1 = d1;
+    *delta2 = d2;
 } /* lowesc_ */
 
 static void ehg169_(integer d__, integer *vc, integer *nc, integer *ncmax, integer *nv, 
         integer nvmax, double *v, integer *a, double *xi, integer *c__, integer *hi, integer *lo) {
     integer c_dim1, v_dim1, v_offset, i__1, i__3;
-    static integer execnt = 0, i__, j, k, p, mc, mv, novhit[1];
+    integer i__, j, k, p, mc, mv, novhit[1];
 
     --lo;
     --hi;
@@ -1544,7 +1581,6 @@ static void ehg169_(integer d__, integer *vc, integer *nc, integer *ncmax, integ
     v_dim1 = nvmax;
     v -= v_offset = 1 + v_dim1;
 
-    ++execnt;
     /*     as in bbox */
     /*     remaining vertices */
     for (i__ = 2; i__ <= *vc - 1; ++i__) {
@@ -1630,10 +1666,9 @@ static double ehg176_(double *z) {
 
 static void lowesa_(double *trl, integer *n, integer *d__,
             integer *tau, integer *nsing, double *delta1, double *delta2) {
-    static integer execnt = 0, dka, dkb;
-    static double d1a, d1b, d2a, d2b, alpha;
+    integer dka, dkb;
+    double d1a, d1b, d2a, d2b, alpha;
 
-    ++execnt;
     ehg141_(trl, n, &c__1, tau, d__, nsing, &dka, &d1a, &d2a);
     ehg141_(trl, n, &c__2, tau, d__, nsing, &dkb, &d1b, &d2b);
     alpha = (double) (*tau - dka) / (double) (dkb - dka);
@@ -1647,8 +1682,8 @@ static void ehg191_(integer *m, double *z__, double *l, integer *d__, integer *n
 
     integer lq_dim1, c_offset, l_dim1, lf_dim1, lf_dim2, v_offset, vval2_dim1, vval2_offset, z_dim1;
 
-    static integer execnt = 0, i__, j, p, i1, i2, lq1;
-    static double zi[8];
+    integer i__, j, p, i1, i2, lq1;
+    double zi[8];
     z_dim1 = *m;
     z__ -= 1 + z_dim1;
     l_dim1 = *m;
@@ -1667,7 +1702,6 @@ static void ehg191_(integer *m, double *z__, double *l, integer *d__, integer *n
     vval2 -= vval2_offset = 0 + vval2_dim1;
     v -= v_offset = 1 + *nvmax;
 
-    ++execnt;
     for (j = 1; j <= *n; ++j) {
         for (i2 = 1; i2 <= *nv; ++i2)
             for (i1 = 0; i1 <= *d__; ++i1)
@@ -1693,10 +1727,9 @@ static void ehg191_(integer *m, double *z__, double *l, integer *d__, integer *n
 } /* ehg191_ */
 
 static void ehg196_(integer tau, integer d__, double f, double *trl) {
-    static integer execnt = 0, dka, dkb;
-    static double trla, trlb, alpha;
+    integer dka, dkb;
+    double trla, trlb, alpha;
 
-    ++execnt;
     ehg197(1, d__, f, &dka, &trla);
     ehg197(2, d__, f, &dkb, &trlb);
     alpha = (double) (tau - dka) / (double) (dkb - dka);
@@ -1742,11 +1775,11 @@ static double ehg128_(double *z__, integer *d__, integer *ncmax, integer *vc,
         integer *a, double *xi, integer *lo, integer *hi, integer *c__,
         double *v, integer *nvmax, double *vval) {
     integer c_dim1, v_dim1, vval_dim1;
-    static double g[2304]	/* was [9][256] */, h__;
-    static logical i2;
-    static integer execnt = 0, t[20], i__, j, m, i1, i11, i12, ig, ii, lg, ll, nt, ur;
-    static double g0[9], g1[9], s, v0, v1, ge, gn, gs, gw;
-    static double gpe, gpn, gps, gpw, sew, sns, phi0, phi1, psi0, psi1, xibar;
+    double g[2304]	/* was [9][256] */, h__;
+    logical i2;
+    integer t[20], i__, j, m, i1, i11, i12, ig, ii, lg, ll, nt, ur;
+    double g0[9], g1[9], s, v0, v1, ge, gn, gs, gw;
+    double gpe, gpn, gps, gpw, sew, sns, phi0, phi1, psi0, psi1, xibar;
 
     --z__; --hi; --lo; --xi; --a;
     c_dim1 = *vc;
@@ -1756,7 +1789,6 @@ static double ehg128_(double *z__, integer *d__, integer *ncmax, integer *vc,
     v_dim1 = *nvmax;
     v -= 1 + v_dim1;
 
-    ++execnt;
     /*     locate enclosing cell */
     nt = 1;
     t[nt - 1] = 1;
@@ -1952,47 +1984,54 @@ static double ehg128_(double *z__, integer *d__, integer *ncmax, integer *vc,
     return s;
 }
 
+//Each evaluation point is fit independently, in parallel, with per-thread psi/dist/eta/b/w
+//scratch; rcond and sing are merged once per point.
 static void ehg136_(double *u, integer *lm, integer *m, integer *n, integer *d__, integer *nf, 
         double *f, double *x, integer *psi, double *y, double *rw, integer *kernel, integer *k, 
         double *dist, double *eta, double *b, integer *od, double *o, integer *ihat, double *w, 
         double *rcond, integer *sing, integer *dd, integer *tdeg, integer *cdeg, double * s) {
 
-    static integer execnt = 0;
-    integer o_dim1, b_dim1, b_offset, s_dim1, u_dim1, x_dim1, x_offset;
-    static integer i__, j, l, i1, info, identi;
-    static double q[8], tol, work[15], scale, sigma[15], qraux[15], dgamma[15];
-    static double e[225]	/* was [15][15] */, g[225]	/* was [15][15] */;
+    integer o_dim1, b_dim1, s_dim1, u_dim1, x_dim1, x_offset;
 
     o_dim1 = *m;
     o -= 1 + o_dim1;
-    --dist;
     --rw;
-    --psi;
     x_dim1 = *n;
     x -= x_offset = 1 + x_dim1;
     u_dim1 = *lm;
     u -= 1 + u_dim1;
-    --w;
-    --eta;
     b_dim1 = *nf;
-    b -= b_offset = 1 + b_dim1;
     s_dim1 = *od - 0 + 1;
     s -= 0 + s_dim1;
     --cdeg;
 
-    ++execnt;
     if (! (*k <= *nf - 1))
         loess_error(104);
     if (! (*k <= 15))
         loess_error(105);
-    for (identi = 1; identi <= *n; ++identi)
-        psi[identi] = identi;
-    for (l = 1; l <= *m; ++l) {
+    int ws_ct = vertex_ws_count();
+    vertex_ws *ws = vertex_ws_alloc(ws_ct, *n, *nf, 0);
+    OMP_for (integer l = 1; l <= *m; ++l) {
+        integer i__, j, i1, info, kl = *k, sing_l;
+        double q[8], tol, work[15], scale, sigma[15], qraux[15], dgamma[15], rcond_l;
+        double e[225]	/* was [15][15] */, g[225]	/* was [15][15] */;
+        vertex_ws *mine = vertex_ws_this_thread(ws);
+        integer *psi_l = mine->psi - 1; //1-offset, as FORTRAN had it
+        double *dist_l = mine->dist, *eta_l = mine->eta - 1,
+               *b_l = mine->b - (1 + b_dim1), *w_l = mine->w - 1;
+        OMP_critical(ehg136_merge) {
+            rcond_l = *rcond;
+            sing_l = *sing;
+        }
+        integer sing_in = sing_l;
+
+        for (integer identi = 1; identi <= *n; ++identi)
+            psi_l[identi] = identi;
         for (i1 = 1; i1 <= *d__; ++i1)
             q[i1 - 1] = u[l + i1 * u_dim1];
-        ehg127_(q, n, d__, nf, f, &x[x_offset], &psi[1], y, &rw[1],
-            kernel, k, &dist[1], &eta[1], &b[b_offset], od, &w[1], rcond,
-            sing, sigma, e, g, dgamma, qraux, work, &tol, dd, tdeg, &cdeg[1], &s[l * s_dim1]);
+        ehg127_(q, n, d__, nf, f, &x[x_offset], &psi_l[1], y, &rw[1],
+            kernel, &kl, dist_l, &eta_l[1], &b_l[1 + b_dim1], od, &w_l[1], &rcond_l,
+            &sing_l, sigma, e, g, dgamma, qraux, work, &tol, dd, tdeg, &cdeg[1], &s[l * s_dim1]);
         if (*ihat == 1) {
     /*           $L sub {l,l} = */
     /*           V sub {1,:} SIGMA sup {+} U sup T */
@@ -2001,59 +2040,64 @@ static void ehg136_(double *u, integer *lm, integer *m, integer *n, integer *d__
                 loess_error(123);
     /*           find $i$ such that $l = psi sub i$ */
             i__ = 1;
-            while  (l != psi[i__]) {
+            while  (l != psi_l[i__]) {
                 ++i__;
                 if (! (i__ < *nf))
                     loess_error(123);
             }
             for (i1 = 1; i1 <= *nf; ++i1)
-                eta[i1] = 0.;
-            eta[i__] = w[i__];
+                eta_l[i1] = 0.;
+            eta_l[i__] = w_l[i__];
     /*           $eta = Q sup T W e sub i$ */
-            dqrsl_(&b[b_offset], nf, nf, k, qraux, &eta[1], &eta[1], &eta[1],
-                &eta[1], &eta[1], &eta[1], 1000, &info);
+            dqrsl_(&b_l[1 + b_dim1], nf, nf, &kl, qraux, &eta_l[1], &eta_l[1], &eta_l[1],
+                &eta_l[1], &eta_l[1], &eta_l[1], 1000, &info);
     /*           $gamma = U sup T eta sub {1:k}$ */
-            for (i1 = 1; i1 <= *k; ++i1)
+            for (i1 = 1; i1 <= kl; ++i1)
                 dgamma[i1 - 1] = 0.;
-            for (j = 1; j <= *k; ++j)
-                for (i1 = 1; i1 <= *k; ++i1)
-                        dgamma[i1 - 1] += eta[j] * e[j + i1 * 15 - 16];
+            for (j = 1; j <= kl; ++j)
+                for (i1 = 1; i1 <= kl; ++i1)
+                        dgamma[i1 - 1] += eta_l[j] * e[j + i1 * 15 - 16];
     /*           $gamma = SIGMA sup {+} gamma$ */
-            for (j = 1; j <= *k; ++j)
+            for (j = 1; j <= kl; ++j)
                 if (tol < sigma[j - 1])
                          dgamma[j - 1] /= sigma[j - 1];
                 else
                         dgamma[j - 1] = 0.;
-            o[l + o_dim1] = ddot_(k, g, &c__15, dgamma, &c__1);
+            o[l + o_dim1] = ddot_(&kl, g, &c__15, dgamma, &c__1);
         } else if (*ihat == 2) {
             /*     $L sub {l,:} = */
             /*     V sub {1,:} SIGMA sup {+} */
             /*     ( U sup T Q sup T ) W $ */
             for (i1 = 1; i1 <= *n; ++i1)
                     o[l + i1 * o_dim1] = 0.;
-            for (j = 1; j <= *k; ++j) {
+            for (j = 1; j <= kl; ++j) {
                 for (i1 = 1; i1 <=  *nf; ++i1)
-                    eta[i1] = 0.;
-                for (i1 = 1; i1 <=  *k; ++i1)
-                    eta[i1] = e[i1 + j * 15 - 16];
-                dqrsl_(&b[b_offset], nf, nf, k, qraux, &eta[1], &eta[1],
+                    eta_l[i1] = 0.;
+                for (i1 = 1; i1 <=  kl; ++i1)
+                    eta_l[i1] = e[i1 + j * 15 - 16];
+                dqrsl_(&b_l[1 + b_dim1], nf, nf, &kl, qraux, &eta_l[1], &eta_l[1],
                     work, work, work, work, 10000, &info);
                 if (tol < sigma[j - 1])
                     scale = 1. / sigma[j - 1];
                 else
                     scale = 0.;
                 for (i1 = 1; i1 <=  *nf; ++i1)
-                    eta[i1] *= scale * w[i1];
+                    eta_l[i1] *= scale * w_l[i1];
                 for (i__ = 1; i__ <= *nf; ++i__)
-                    o[l + psi[i__] * o_dim1] += g[j * 15 - 15] * eta[i__];
+                    o[l + psi_l[i__] * o_dim1] += g[j * 15 - 15] * eta_l[i__];
             }
         }
+        OMP_critical(ehg136_merge) {
+            *rcond = GSL_MIN(*rcond, rcond_l);
+            *sing += sing_l - sing_in;
+        }
     }
+    vertex_ws_free(ws, ws_ct);
 } /* ehg136_ */
 
 static void ehg137_(double *z__, integer *kappa, integer *leaf, integer *nleaf, integer *d__, 
         integer *nv, integer *nvmax, integer * ncmax, integer *a, double *xi, integer *lo, integer *hi) {
-    static integer execnt = 0, p, pstack[20], stackt;
+    integer p, pstack[20], stackt;
 
     --leaf;
     --z__;
@@ -2062,7 +2106,6 @@ static void ehg137_(double *z__, integer *kappa, integer *leaf, integer *nleaf,
     --xi;
     --a;
     /*     stacktop -> stackt */
-    ++execnt;
     /*     find leaf cells affected by $z$ */
     stackt = 0;
     p = 1;
@@ -2100,6 +2143,10 @@ static void ehg137_(double *z__, integer *kappa, integer *leaf, integer *nleaf,
 
 //BK: Changed phi (the 17th input) from integer to double, because this fn is only called
 //once, and there, dist==phi.
+//The vertex fits are independent, so they run in parallel. Each thread has its own
+//psi/dist/eta/b/w scratch and, when computing the trace, its own zeroed copy of vval2,
+//so the incoming psi, dist, phi, eta, b, w, and vval2 are not touched. Contributions to
+//diagl, rcond, and sing are merged once per vertex.
 static void ehg139_(double *v, integer *nvmax, integer *nv, integer *n, integer *d__, 
         integer *nf, double *f, double *x, integer *pi, integer *psi, double *y, 
         double *rw, double *trl, integer *kernel, integer *k, double *dist, double *phi,
@@ -2108,19 +2155,12 @@ static void ehg139_(double *v, integer *nvmax, integer *nv, integer *n, integer
         integer *vhit, double *rcond, integer *sing, integer *dd, integer
         *tdeg, integer *cdeg, integer *lq, double *lf, logical *setlf, double *s) {
 
-    integer lq_dim1, c_dim1, c_offset, lf_dim1, lf_dim2, b_dim1, b_offset, 
-            s_dim1, v_dim1, v_offset, vval2_dim1, vval2_offset, x_dim1, x_offset, i__1, i__3;
+    integer lq_dim1, c_dim1, c_offset, lf_dim1, lf_dim2, b_dim1, 
+            s_dim1, v_dim1, v_offset, vval2_dim1, x_dim1, x_offset;
 
-    static integer execnt = 0;
-    static double e[225]	/* was [15][15] */;
-    static double q[8], u[225]	/* was [15][15] */, z__[8], i4, i7, tol;
-    static integer i__, j, l, i5, i6, ii, leaf[256], info, ileaf, nleaf, identi;
-    static double term, work[15], scale, sigma[15], qraux[15], dgamma[15];
-
-    --vhit; --diagl; --phi; --dist; --rw; --y;
-    --psi; --pi; --w; --eta; --hi; --lo; --xi; --cdeg;
+    --vhit; --diagl; --rw; --y;
+    --pi; --hi; --lo; --xi; --cdeg;
     vval2_dim1 = *d__ - 0 + 1;
-    vval2 -= vval2_offset = 0 + vval2_dim1;
     x_dim1 = *n;
     x -= x_offset = 1 + x_dim1;
     v_dim1 = *nvmax;
@@ -2131,108 +2171,130 @@ static void ehg139_(double *v, integer *nvmax, integer *nv, integer *n, integer
     lq_dim1 = *nvmax;
     lq -= 1 + lq_dim1;
     b_dim1 = *nf;
-    b -= b_offset = 1 + b_dim1;
     s_dim1 = *od - 0 + 1;
     s -= 0 + s_dim1;
     c_dim1 = *vc;
     c__ -= c_offset = 1 + c_dim1;
 
-    ++execnt;
     /*     l2fit with trace(L) */
     if (! (*k <= *nf - 1))
         loess_error(104);
     if (! (*k <= 15))
         loess_error(105);
-    if (*trl != 0.) {
-        for (i5 = 1; i5 <= *n; ++i5)
+    if (*trl != 0.)
+        for (integer i5 = 1; i5 <= *n; ++i5)
             diagl[i5] = 0.;
-        for (i6 = 1; i6 <= *nv; ++i6)
-            for (i5 = 0; i5 <= *d__; ++i5)
-                vval2[i5 + i6 * vval2_dim1] = 0.;
-    }
-    for (identi = 1; identi <= *n; ++identi)
-        psi[identi] = identi;
-    i__1 = *nv;
-    for (l = 1; l <= i__1; ++l) {
+
+    int ws_ct = vertex_ws_count();
+    vertex_ws *ws = vertex_ws_alloc(ws_ct, *n, *nf, (*trl != 0.) ? *nv * vval2_dim1 : 0);
+    OMP_for (integer l = 1; l <= *nv; ++l) {
+        double e[225]	/* was [15][15] */;
+        double q[8], u[225]	/* was [15][15] */, z__[8], i4, i7, tol;
+        integer i__, j, i5, i6, ii, leaf[256], info, ileaf, nleaf, kl = *k, sing_l;
+        double term, work[15], scale, sigma[15], qraux[15], dgamma[15], rcond_l;
+        vertex_ws *mine = vertex_ws_this_thread(ws);
+        integer *psi_l = mine->psi - 1; //1-offset, as FORTRAN had it
+        double *dist_l = mine->dist, *eta_l = mine->eta - 1,
+               *b_l = mine->b - (1 + b_dim1), *w_l = mine->w - 1,
+               *vval2_base = mine->vval2,
+               *vval2_l = vval2_base ? vval2_base - vval2_dim1 : NULL,
+               *diag_term = mine->diag_term;
+        integer *diag_at = mine->diag_at, diag_ct = 0;
+        OMP_critical(ehg139_merge) {
+            rcond_l = *rcond;
+            sing_l = *sing;
+        }
+        integer sing_in = sing_l;
+
+        for (integer identi = 1; identi <= *n; ++identi)
+            psi_l[identi] = identi;
         for (i5 = 1; i5 <= *d__; ++i5)
             q[i5 - 1] = v[l + i5 * v_dim1];
-        ehg127_(q, n, d__, nf, f, &x[x_offset], &psi[1], &y[1], &rw[1],
-            kernel, k, dist, &eta[1], &b[b_offset], od, &w[1], rcond,
-            sing, sigma, u, e, dgamma, qraux, work, &tol, dd, tdeg, &cdeg[1], &s[l * s_dim1]);
+        ehg127_(q, n, d__, nf, f, &x[x_offset], &psi_l[1], &y[1], &rw[1],
+            kernel, &kl, dist_l, &eta_l[1], &b_l[1 + b_dim1], od, &w_l[1], &rcond_l,
+            &sing_l, sigma, u, e, dgamma, qraux, work, &tol, dd, tdeg, &cdeg[1], &s[l * s_dim1]);
         if (*trl != 0.) { // invert $psi$
+            double *phi_l = dist_l - 1; //as in the caller, phi and dist share space.
             for (i5 = 1; i5 <= *n; ++i5)
-                phi[i5] = 0;
+                phi_l[i5] = 0;
             for (i__ = 1; i__ <= *nf; ++i__)
-                phi[psi[i__]] = i__;
+                phi_l[psi_l[i__]] = i__;
             for (i5 = 1; i5 <= *d__; ++i5)
                 z__[i5 - 1] = v[l + i5 * v_dim1];
             ehg137_(z__, &vhit[l], leaf, &nleaf, d__, nv, nvmax, ncmax, a, &xi[1], &lo[1], &hi[1]);
             for (ileaf = 1; ileaf <= nleaf; ++ileaf) {
-                i__3 = hi[leaf[ileaf - 1]];
-                for (ii = lo[leaf[ileaf - 1]]; ii <= i__3; ++ii) {
-                    i__ = phi[pi[ii]];
+                for (ii = lo[leaf[ileaf - 1]]; ii <= hi[leaf[ileaf - 1]]; ++ii) {
+                    i__ = phi_l[pi[ii]];
                     if (i__ != 0) {
-                        if (! (psi[i__] == pi[ii]))
+                        if (! (psi_l[i__] == pi[ii]))
                             loess_error(194);
                         for (i5 = 1; i5 <= *nf; ++i5)
-                            eta[i5] = 0.;
-                        eta[i__] = w[i__];
+                            eta_l[i5] = 0.;
+                        eta_l[i__] = w_l[i__];
                         /*                    $eta = Q sup T W e sub i$ */
-                        dqrsl_(&b[b_offset], nf, nf, k, qraux, &eta[1], work,
-                            &eta[1], &eta[1], work, work, 1000, &info);
-                        for (j = 1; j <= *k; ++j) {
+                        dqrsl_(&b_l[1 + b_dim1], nf, nf, &kl, qraux, &eta_l[1], work,
+                            &eta_l[1], &eta_l[1], work, work, 1000, &info);
+                        for (j = 1; j <= kl; ++j) {
                             i4 = (tol < sigma[j - 1])
-                                ? ddot_(k, &u[j * 15 - 15], &c__1, &eta[1], &c__1) / sigma[j - 1]
+                                ? ddot_(&kl, &u[j * 15 - 15], &c__1, &eta_l[1], &c__1) / sigma[j - 1]
                                 : 0.;
                             dgamma[j - 1] = i4;
                         }
                         for (j = 1; j <= *d__ + 1; ++j) // bug fix 2006-07-15 for k=1, od>1.   (thanks btyner@gmail.com) */
-                            vval2[j - 1 + l * vval2_dim1] = (j <= *k)
-                                        ? ddot_(k, &e[j - 1], &c__15, dgamma, &c__1)
+                            vval2_l[j - 1 + l * vval2_dim1] = (j <= kl)
+                                        ? ddot_(&kl, &e[j - 1], &c__15, dgamma, &c__1)
                                         : 0.;
                         for (i5 = 1; i5 <= *d__; ++i5)
                             z__[i5 - 1] = x[pi[ii] + i5 * x_dim1];
                         term = ehg128_(z__, d__, ncmax, vc, a, &xi[1], &
                             lo[1], &hi[1], &c__[c_offset], &v[v_offset],
-                            nvmax, &vval2[vval2_offset]);
-                        diagl[pi[ii]] += term;
+                            nvmax, vval2_base);
+                        diag_at[diag_ct] = pi[ii];
+                        diag_term[diag_ct++] = term;
                         for (i5 = 0; i5 <= *d__; ++i5)
-                            vval2[i5 + l * vval2_dim1] = 0.;
+                            vval2_l[i5 + l * vval2_dim1] = 0.;
                     }
                 }
             }
         }
         if (*setlf) {
             /*           $Lf sub {:,l,:} = V SIGMA sup {+} U sup T Q sup T W$ */
-            if (! (*k >= *d__ + 1))
+            if (! (kl >= *d__ + 1))
                 loess_error(196);
             for (i5 = 1; i5 <= *nf; ++i5)
-                lq[l + i5 * lq_dim1] = psi[i5];
+                lq[l + i5 * lq_dim1] = psi_l[i5];
             for (i6 = 1; i6 <= *nf; ++i6)
                 for (i5 = 0; i5 <= *d__; ++i5)
                     lf[i5 + (l + i6 * lf_dim2) * lf_dim1] = 0.;
-            for (j = 1; j <= *k; ++j) {
+            for (j = 1; j <= kl; ++j) {
                 for (i5 = 1; i5 <= *nf; ++i5)
-                    eta[i5] = 0.;
-                for (i5 = 1; i5 <= *k; ++i5)
-                    eta[i5] = u[i5 + j * 15 - 16];
-                dqrsl_(&b[b_offset], nf, nf, k, qraux, &eta[1], &eta[1], work, work, work, work, 10000, &info);
+                    eta_l[i5] = 0.;
+                for (i5 = 1; i5 <= kl; ++i5)
+                    eta_l[i5] = u[i5 + j * 15 - 16];
+                dqrsl_(&b_l[1 + b_dim1], nf, nf, &kl, qraux, &eta_l[1], &eta_l[1], work, work, work, work, 10000, &info);
                 scale = (tol < sigma[j - 1])
                         ? 1. / sigma[j - 1]
                         : 0.;
                 for (i5 = 1; i5 <= *nf; ++i5)
-                    eta[i5] *= scale * w[i5];
+                    eta_l[i5] *= scale * w_l[i5];
                 for (i__ = 1; i__ <= *nf; ++i__) {
-                    i7 = eta[i__];
+                    i7 = eta_l[i__];
                     for (i5 = 0; i5 <= *d__; ++i5)
-                        if (i5 < *k)
+                        if (i5 < kl)
                             lf[i5 + (l + i__ * lf_dim2) * lf_dim1] += e[i5 + 1 + j * 15 - 16] * i7;
                         else
                             lf[i5 + (l + i__ * lf_dim2) * lf_dim1] = 0.;
                 }
             }
         }
+        OMP_critical(ehg139_merge) {
+            *rcond = GSL_MIN(*rcond, rcond_l);
+            *sing += sing_l - sing_in;
+            for (integer t = 0; t < diag_ct; t++)
+                diagl[diag_at[t]] += diag_term[t];
+        }
     }
+    vertex_ws_free(ws, ws_ct);
     if (*trl != 0.) {
         if (*n <= 0)
             *trl = 0.;
@@ -2249,9 +2311,9 @@ static void dqrdc_(double *x, integer *ldx, integer *n, integer *p, double *qrau
     integer x_dim1, i__2, i__3;
     double d__2;
 
-    static integer j, l, jj, jp, pl, pu, lp1, lup, maxj;
-    static logical negj, swapj;
-    static double t, tt, nrmxl, maxnrm;
+    integer j, l, jj, jp, pl, pu, lp1, lup, maxj;
+    logical negj, swapj;
+    double t, tt, nrmxl, maxnrm;
 
 /*     dqrdc uses householder transformations to compute the qr 
      factorization of an n by p matrix x.  column pivoting 
@@ -2461,11 +2523,10 @@ L60:
 
 static void lowesb_(double *xx, double *yy, double *ww, double *diagl, double trl,
         integer *iv, integer *liv, integer * lv, double *wv) {
-    static integer execnt = 0, setlf;
+    integer setlf;
     --wv;
     --iv;
 
-    ++execnt;
     if (! (iv[28] != 173))
         loess_error(174);
     if (iv[28] != 172 && !(iv[28] == 171))
@@ -2486,11 +2547,10 @@ static void lowesb_(double *xx, double *yy, double *ww, double *diagl, double tr
 
 static void lowesd_(integer *iv, integer *liv, integer *lv, double *v, 
         integer d__, integer n, double f, integer ideg, integer *nvmax, logical *setlf) {
-    static integer execnt = 0, i__, j, i1, i2, nf, vc, ncmax, bound;
+    integer i__, j, i1, i2, nf, vc, ncmax, bound;
     --iv;
     --v;
 
-    ++execnt;
     iv[28] = 171;
     iv[2] = d__;
     iv[3] = n;
@@ -2509,6 +2569,10 @@ static void lowesd_(integer *iv, integer *liv, integer *lv, double *v,
             i1 = d__ + 1;
         else if (ideg == 2)
             i1 = (integer) ((double) ((d__ + 2) * (d__ + 1)) / 2.);
+        else {
+            loess_error(195);
+            i1 = 1;
+        }
     }
     iv[29] = i1;
     iv[21] = 1;
@@ -2563,8 +2627,6 @@ static void lowesd_(integer *iv, integer *liv, integer *lv, double *v,
 } /* lowesd_ */
 
 static void lowese_(integer *iv, integer *liv, integer *lv, double *wv, integer m, double *z, double *s) {
-    static integer execnt = 0;
-    ++execnt;
     --iv;
     --wv;
 
@@ -2578,9 +2640,8 @@ static void lowese_(integer *iv, integer *liv, integer *lv, double *wv, integer
 
 static void lowesf_(double *xx, double *yy, double *ww, integer *iv, integer *liv, 
         integer *lv, double *wv, integer *m, double *z__, double *l, integer ihat, double *s) {
-    static integer execnt = 0;
     integer l_dim1, l_offset, z_dim1, z_offset;
-    static logical i1;
+    logical i1;
     --xx;
     --yy;
     --ww;
@@ -2591,7 +2652,6 @@ static void lowesf_(double *xx, double *yy, double *ww, integer *iv, integer *li
     z_dim1 = *m;
     z__ -= z_offset = 1 + z_dim1;
 
-    ++execnt;
     i1 = (171 <= iv[28])
           ? iv[28] <= 174
 	      : FALSE_;
@@ -2606,7 +2666,6 @@ static void lowesf_(double *xx, double *yy, double *ww, integer *iv, integer *li
 } /* lowesf_ */
 
 static void lowesl_(integer *iv, integer *liv, integer *lv, double *wv, integer *m, double *z__, double *l) {
-    static integer execnt = 0;
     integer l_dim1, l_offset, z_dim1, z_offset;
 
     --iv;
@@ -2616,7 +2675,6 @@ static void lowesl_(integer *iv, integer *liv, integer *lv, double *wv, integer
     z_dim1 = *m;
     z__ -= z_offset = 1 + z_dim1;
 
-    ++execnt;
     if (! (iv[28] != 172))
         loess_error(172);
     if (! (iv[28] == 173))
@@ -2629,12 +2687,11 @@ static void lowesl_(integer *iv, integer *liv, integer *lv, double *wv, integer
 } /* lowesl_ */
 
 static void lowesw_(double *res, integer *n, double *rw, integer *pi) {
-    static integer i1, nh, execnt = 0, identi;
-    static double cmad, rsmall;
+    integer i1, nh, identi;
+    double cmad, rsmall;
     --pi;
     --rw;
     --res;
-    ++execnt;
 /*     tranliterated from Devlin's ratfor */
 /*     find median of absolute residuals */
     for (i1 = 1; i1 <= *n; ++i1)
@@ -2665,8 +2722,8 @@ static void lowesw_(double *res, integer *n, double *rw, integer *pi) {
 
 static void pseudovals(integer n, double *y, double *yhat, double *pwgts,  //formerly lowesp
                 double *rwgts, integer *pi, double *ytilde) {
-    static integer m, i5, identi, execnt = 0;
-    static double i4, mad;
+    integer m, i5, identi;
+    double i4, mad;
 
     --ytilde;
     --pi;
@@ -2675,7 +2732,6 @@ static void pseudovals(integer n, double *y, double *yhat, double *pwgts,  //for
     --yhat;
     --y;
 
-    ++execnt;
     /*     median absolute deviation */
     for (i5 = 1; i5 <= n; ++i5)
         ytilde[i5] = abs(y[i5] - yhat[i5]) * sqrt(pwgts[i5]);
@@ -2706,55 +2762,57 @@ static void pseudovals(integer n, double *y, double *yhat, double *pwgts,  //for
 }
 
 ////// Back to loessc.c
-static void loess_workspace(long D, long N, double	span, long degree,
+static void loess_workspace(loess_ws *ws, long D, long N, double	span, long degree,
 			long *nonparametric, long *drop_square, long *sum_drop_sqr, long setLf){
 	long tau0, nvmax, nf, i;
 	nvmax = max(200, N);
         nf = min(N, floor(N * span));
         tau0 = (degree > 1) ? ((D + 2) * (D + 1) * 0.5) : (D + 1);
-        tau = tau0 - (*sum_drop_sqr);
-        lv = 50 + (3 * D + 3) * nvmax + N + (tau0 + 2) * nf;
-	liv = 50 + ((long)pow((double)2, (double)D) + 4) * nvmax + 2 * N;
+        ws->tau = tau0 - (*sum_drop_sqr);
+        ws->lv = 50 + (3 * D + 3) * nvmax + N + (tau0 + 2) * nf;
+	ws->liv = 50 + ((long)pow((double)2, (double)D) + 4) * nvmax + 2 * N;
 	if(setLf) {
-		lv = lv + (D + 1) * nf * nvmax;
-		liv = liv + nf * nvmax;	
+		ws->lv = ws->lv + (D + 1) * nf * nvmax;
+		ws->liv = ws->liv + nf * nvmax;	
 	}
-    iv = Calloc(liv, long);
-    v = Calloc(lv, double);
+    ws->iv = Calloc(ws->liv, long);
+    ws->v = Calloc(ws->lv, double);
 
-    lowesd_(iv, &liv, &lv, v, D, N, span, degree, &nvmax, &setLf);
-    iv[32] = *nonparametric;
+    lowesd_(ws->iv, &ws->liv, &ws->lv, ws->v, D, N, span, degree, &nvmax, &setLf);
+    ws->iv[32] = *nonparametric;
     for(i = 0; i < D; i++)
-        iv[i + 40] = drop_square[i];
+        ws->iv[i + 40] = drop_square[i];
 }
 
-static void loess_free() {
-    free(v);
-    free(iv);
+static void loess_free(loess_ws *ws) {
+    free(ws->v);
+    free(ws->iv);
 }
 
 static void loess_dfit( double	*y, double *x, double *x_evaluate, double *weights,
 			double span, long degree, long *nonparametric, long *drop_square,
 			long *sum_drop_sqr, long d, long n, long *m, double *fit) {
-    loess_workspace(d, n, span, degree, nonparametric, drop_square, sum_drop_sqr, 0);
-	lowesf_(x, y, weights, iv, &liv, &lv, v, m, x_evaluate, &doublepluszero, 0, fit);
-	loess_free();
+    loess_ws ws;
+    loess_workspace(&ws, d, n, span, degree, nonparametric, drop_square, sum_drop_sqr, 0);
+	lowesf_(x, y, weights, ws.iv, &ws.liv, &ws.lv, ws.v, m, x_evaluate, &doublepluszero, 0, fit);
+	loess_free(&ws);
 }
 
 static void loess_dfitse( double	*y, double *x, double *x_evaluate, double *weights, double *robust,
         int	family, double span, long degree, long *nonparametric, long *drop_square,
          long *sum_drop_sqr, long d, long n, long *m, double *fit, double *L) {
-    loess_workspace(d, n, span, degree, nonparametric, drop_square, sum_drop_sqr, 0);
+    loess_ws ws;
+    loess_workspace(&ws, d, n, span, degree, nonparametric, drop_square, sum_drop_sqr, 0);
 	if(family == GAUSSIAN)
-		lowesf_(x, y, weights, iv, &liv, &lv, v, m, x_evaluate, L, 2, fit);
+		lowesf_(x, y, weights, ws.iv, &ws.liv, &ws.lv, ws.v, m, x_evaluate, L, 2, fit);
 	else if(family == SYMMETRIC) {
-		lowesf_(x, y, weights, iv, &liv, &lv, v, m, x_evaluate, L, 2, fit);
-		lowesf_(x, y, robust, iv, &liv, &lv, v, m, x_evaluate, &doublepluszero, 0, fit);
+		lowesf_(x, y, weights, ws.iv, &ws.liv, &ws.lv, ws.v, m, x_evaluate, L, 2, fit);
+		lowesf_(x, y, robust, ws.iv, &ws.liv, &ws.lv, ws.v, m, x_evaluate, &doublepluszero, 0, fit);
 	}	
-	loess_free();
+	loess_free(&ws);
 }
 
-static void loess_grow(long	const * restrict parameter,long const*restrict a,
+static void loess_grow(loess_ws *ws, long	const * restrict parameter,long const*restrict a,
                        double	const *restrict xi, double const *restrict vert, 
                        const double *restrict vval) {
 	long	d, vc, nc, nv, a1, v1, xi1, vv1, i, k;
@@ -2762,10 +2820,10 @@ static void loess_grow(long	const * restrict parameter,long const*restrict a,
 	vc = parameter[2];
 	nc = parameter[3];
 	nv = parameter[4];
-	liv = parameter[5];
-	lv = parameter[6];
-	iv = Calloc(liv, long);
-	v = Calloc(lv, double);
+	ws->liv = parameter[5];
+	ws->lv = parameter[6];
+	long *iv = ws->iv = Calloc(ws->liv, long);
+	double *v = ws->v = Calloc(ws->lv, double);
 
 	iv[1] = d;
 	iv[2] = parameter[1];
@@ -2804,23 +2862,27 @@ static void loess_grow(long	const * restrict parameter,long const*restrict a,
 static void loess_ifit(long const * restrict parameter, long const *restrict a, 
                 double const *restrict xi, double const *restrict vert,
                  const double *restrict vval, long m, double *x_evaluate, double *fit) {
-	loess_grow(parameter, a, xi, vert, vval);
-	lowese_(iv, &liv, &lv, v, m, x_evaluate, fit);
-	loess_free();
+    loess_ws ws;
+	loess_grow(&ws, parameter, a, xi, vert, vval);
+	lowese_(ws.iv, &ws.liv, &ws.lv, ws.v, m, x_evaluate, fit);
+	loess_free(&ws);
 }
 
 static void loess_ise( double	*y, double *x, double *x_evaluate, double *weights, double span, long degree,
              long int *nonparametric, long int *drop_square, long int *sum_drop_sqr, double *cell, long int d,
              long int n, long int *m, double *fit, double *L) {
-    loess_workspace(d, n, span, degree, nonparametric, drop_square, sum_drop_sqr, 1);
-	v[1] = *cell;
-	lowesb_(x, y, weights, &doublepluszero, 0, iv, &liv, &lv, v);
-	lowesl_(iv, &liv, &lv, v, m, x_evaluate, L);
-	loess_free();
+    loess_ws ws;
+    loess_workspace(&ws, d, n, span, degree, nonparametric, drop_square, sum_drop_sqr, 1);
+	ws.v[1] = *cell;
+	lowesb_(x, y, weights, &doublepluszero, 0, ws.iv, &ws.liv, &ws.lv, ws.v);
+	lowesl_(ws.iv, &ws.liv, &ws.lv, ws.v, m, x_evaluate, L);
+	loess_free(&ws);
 }
 
-static void loess_prune( long	*parameter, long *a, double	*xi, double *vert, double *vval) {
+static void loess_prune(loess_ws const *ws, long *parameter, long *a, double *xi, double *vert, double *vval) {
 	long	d, vc, a1, v1, xi1, vv1, nc, nv, nvmax, i, k;
+	long const *iv = ws->iv;
+	double const *v = ws->v;
 	d = iv[1];
 	vc = iv[3] - 1;
 	nc = iv[4];
@@ -2957,8 +3019,6 @@ void pred_free_mem(struct	pred_struct	*pre){
 }
 
  ///// loess.c
-static  char    *surf_stat;
-
 int comp(const void *d1_in, const void *d2_in) {
     const double *d1 = d1_in;
     const double *d2 = d1_in;
@@ -2970,7 +3030,8 @@ int comp(const void *d1_in, const void *d2_in) {
                 return(1);
 }
 
-static void condition(char	**surface, char *new_stat, char **trace_hat_in) {
+static char *condition(char	**surface, char *new_stat, char **trace_hat_in) {
+	char *surf_stat = NULL;
 	if(!strcmp(*surface, "interpolate")) {
 		if(!strcmp(new_stat, "none"))
 			surf_stat = "interpolate/none";
@@ -2992,6 +3053,7 @@ static void condition(char	**surface, char *new_stat, char **trace_hat_in) {
 		else if(!strcmp(new_stat, "approximate"))
 			surf_stat = "direct/approximate";
 	}
+	return surf_stat;
 }
 
 static void loess_raw( double	*y, double *x, double *weights, double *robust, long	*d, 
@@ -3002,12 +3064,15 @@ static void loess_raw( double	*y, double *x, double *weights, double *robust, lo
 	long nsing, i, k;
 	double	*hat_matrix, *LL;
 	*trL = 0;
-	loess_workspace(*d, *n, *span, *degree, nonparametric, drop_square, sum_drop_sqr, *setLf);
+	loess_ws ws;
+	loess_workspace(&ws, *d, *n, *span, *degree, nonparametric, drop_square, sum_drop_sqr, *setLf);
+	long *iv = ws.iv, liv = ws.liv, lv = ws.lv, tau = ws.tau;
+	double *v = ws.v;
         v[1] = *cell;
 	if(!strcmp(*surf_stat, "interpolate/none")) {
 		lowesb_(x, y, robust, &doublepluszero, 0, iv, &liv, &lv, v);
 		lowese_(iv, &liv, &lv, v, *n, x, surface);
-		loess_prune(parameter, a, xi, vert, vval);
+		loess_prune(&ws, parameter, a, xi, vert, vval);
 	}			
 	else if (!strcmp(*surf_stat, "direct/none"))
 		lowesf_(x, y, robust, iv, &liv, &lv, v, n, x, &doublepluszero, 0, surface);
@@ -3017,7 +3082,7 @@ static void loess_raw( double	*y, double *x, double *weights, double *robust, lo
 		nsing = iv[29];
 		for(i = 0; i < *n; i++) *trL = *trL + diagonal[i];
 		lowesa_(trL, n, d, &tau, &nsing, one_delta, two_delta);
-		loess_prune(parameter, a, xi, vert, vval);
+		loess_prune(&ws, parameter, a, xi, vert, vval);
 	}
     else if (!strcmp(*surf_stat, "interpolate/2.approx")) {
 		lowesb_(x, y, robust, &doublepluszero, 0, iv, &liv, &lv, v);
@@ -3025,7 +3090,7 @@ static void loess_raw( double	*y, double *x, double *weights, double *robust, lo
 		nsing = iv[29];
 		ehg196_(tau, *d, *span, trL);
 		lowesa_(trL, n, d, &tau, &nsing, one_delta, two_delta);
-		loess_prune(parameter, a, xi, vert, vval);
+		loess_prune(&ws, parameter, a, xi, vert, vval);
 	}
 	else if (!strcmp(*surf_stat, "direct/approximate")) {
 		lowesf_(x, y, weights, iv, &liv, &lv, v, n, x, diagonal, 1, surface);
@@ -3040,7 +3105,7 @@ static void loess_raw( double	*y, double *x, double *weights, double *robust, lo
 		lowesl_(iv, &liv, &lv, v, n, x, hat_matrix);
 		lowesc_(n, hat_matrix, LL, trL, one_delta, two_delta);
 		lowese_(iv, &liv, &lv, v, *n, x, surface);
-		loess_prune(parameter, a, xi, vert, vval);
+		loess_prune(&ws, parameter, a, xi, vert, vval);
 		free(hat_matrix);
 		free(LL);
 	}
@@ -3056,7 +3121,7 @@ static void loess_raw( double	*y, double *x, double *weights, double *robust, lo
 		free(hat_matrix);
 		free(LL);
 	}
-	loess_free();
+	loess_free(&ws);
 }
 
 static void loess_(double *y, double *x_, long *size_info, double *weights,
@@ -3071,7 +3136,7 @@ static void loess_(double *y, double *x_, long *size_info, double *weights,
                 trL_tmp = 0, d1_tmp = 0, d2_tmp = 0, sum, mean;
 	long	i, j, k, p, N, D, sum_drop_sqr = 0, sum_parametric = 0, setLf,	
                 nonparametric = 0, zero = 0, max_kd;
-	char   *new_stat;
+	char   *new_stat, *surf_stat = NULL;
 
 	D = size_info[0];
 	N = size_info[1];
@@ -3141,7 +3206,7 @@ static void loess_(double *y, double *x_, long *size_info, double *weights,
 		new_stat = j ? "none" : *statistics;
 		for(i = 0; i < N; i++)
 			robust[i] = weights[i] * robust[i];
-		condition(surface, new_stat, trace_hat_in);
+		surf_stat = condition(surface, new_stat, trace_hat_in);
 		setLf = !strcmp(surf_stat, "interpolate/exact");
 		loess_raw(y, x, weights, robust, &D, &N, span, degree, &nonparametric, order_drop_sqr, 
                 &sum_drop_sqr, &new_cell, &surf_stat, fitted_values, parameter, a,
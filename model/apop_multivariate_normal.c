@@ -16,37 +16,37 @@ After estimation, the <tt>\<Covariance\></tt> page gives the covariance matrix o
  
 #include "apop_internal.h"
 
-static double x_prime_sigma_x(gsl_vector *x, gsl_matrix *sigma){
-    gsl_vector * sigma_dot_x = gsl_vector_calloc(x->size);
+//sigma_dot_x is scratch space of the same size as x.
+static double x_prime_sigma_x(gsl_vector *x, gsl_matrix *sigma, gsl_vector *sigma_dot_x){
     double the_result;
     gsl_blas_dsymv(CblasUpper, 1, sigma, x, 0, sigma_dot_x); //sigma should be symmetric
     gsl_blas_ddot(x, sigma_dot_x, &the_result);
-    gsl_vector_free(sigma_dot_x);
     return the_result;
 }
 
 static long double apop_multinormal_ll(apop_data *data, apop_model * m){
     Nullcheck_mpd(data, m, GSL_NAN);
-    double determinant = 0;
     gsl_matrix* inverse = NULL;
     int i, dimensions  = data->matrix->size2;
-    gsl_vector* x_minus_mu= gsl_vector_alloc(data->matrix->size2);
     double ll = 0;
-    determinant = apop_det_and_inv(m->parameters->matrix, &inverse, 1,1);
-    Apop_stopif(isnan(determinant) || determinant == 0,
-        gsl_vector_free(x_minus_mu); return GSL_NEGINF, //tell maximizers to look elsewhere.
+    double logdet = apop_spd_logdet_and_inv(m->parameters->matrix, &inverse, 1,1);
+    Apop_stopif(!inverse || isinf(logdet),
+        gsl_matrix_free(inverse); return GSL_NEGINF, //tell maximizers to look elsewhere.
          1, "the determinant of the given covariance is zero or NaN. Returning GSL_NEGINF."); 
-    Apop_stopif(determinant <= 0, return NAN, 0, "The determinant of the covariance matrix you gave me "
+    Apop_stopif(isnan(logdet), gsl_matrix_free(inverse); return NAN, 0, "The determinant of the covariance matrix you gave me "
             "is negative, but a covariance matrix must always be positive semidefinite "
             "(and so have nonnegative determinant). Maybe run apop_matrix_to_positive_semidefinite?");
+    apop_arena_begin();
+    gsl_vector *x_minus_mu = apop_arena_vector(dimensions);
+    gsl_vector *scratch = apop_arena_vector(dimensions);
     for (i=0; i< data->matrix->size1; i++){
         gsl_vector_memcpy(x_minus_mu, Apop_rv(data, i));
         gsl_vector_sub(x_minus_mu, m->parameters->vector);
-        ll += - x_prime_sigma_x(x_minus_mu, inverse) / 2;
+        ll += - x_prime_sigma_x(x_minus_mu, inverse, scratch) / 2;
     }
-    ll -= data->matrix->size1 * (log(2 * M_PI)* dimensions/2. + .5 * log(determinant));
+    apop_arena_end();
+    ll -= data->matrix->size1 * (log(2 * M_PI)* dimensions/2. + .5 * logdet);
     gsl_matrix_free(inverse);
-    gsl_vector_free(x_minus_mu);
     return ll;
 }
 
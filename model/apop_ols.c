@@ -10,6 +10,20 @@ appropriately. That is, the \ref apop_ols model really implements Weighted Least
 but in most cases <tt>weights==NULL</tt> and the math reduces to the special case of
 Ordinary Least Squares.
 
+For data sets too large to hold in memory, \ref apop_lm_blocks_alloc and its
+companions fit this model (or \ref apop_iv) one block of rows at a time.
+
+For regressions with many fixed effects, such as one dummy per employer or ZIP code,
+don't build the grid of dummies. Get an index-coded form via <tt>apop_data_to_dummies(...,
+.sparse='y')</tt> and send it in via the \c fixed_effects element of the \ref
+apop_lm_settings group. The dummies are then absorbed: the coefficients on the other
+columns are found from within-group deviations, via cross products adjusted by a table
+of group means, and are identical to those from the regression with the full grid. The
+estimated effects themselves are on a page of the parameters named <tt>\<Fixed effects\></tt>,
+one row per dummy column. As with the grid, the dropped first category is covered by
+the constant column, so use the default <tt>.keep_first='n'</tt>. The degrees of
+freedom, error variance, and tests count the absorbed parameters.
+
 \adoc    Parameter_format  A vector of OLS coefficients. Coefficient zero
                 refers to the constant column, if any. 
                 The \c vector of the output will therefore be of size <tt>data->size2</tt>.
@@ -136,6 +150,13 @@ static long double ols_log_likelihood (apop_data *d, apop_model *p){
   gsl_matrix *data = d->matrix;
   gsl_vector *errors;
 
+    //Absorbed fixed effects are part of each row's expected value.
+    apop_data *effects = apop_data_get_page(p->parameters, "<Fixed effects>");
+    gsl_vector const *codes = effects && lms && lms->fixed_effects ? lms->fixed_effects->vector : NULL;
+    Apop_stopif(effects && (!codes || codes->size != data->size1), return GSL_NAN, 0,
+            "The model has absorbed fixed effects, but the fixed_effects element of its "
+            "apop_lm settings doesn't have one code per row of the data (%zu rows).", data->size1);
+
     apop_data *pred = apop_data_get_page(p->info, "<Predicted>");
     if (pred && d==p->data){ //use already-stored errors for this data set.
         gsl_vector *as_errors = Apop_cv(pred, 2);
@@ -152,6 +173,8 @@ static long double ols_log_likelihood (apop_data *d, apop_model *p){
                 actual = gsl_matrix_get(data,i, 0);
                 expected += gsl_vector_get(p->parameters->vector,0) * (1 - actual); //data isn't affine.
             }
+            int g = codes ? gsl_vector_get(codes, i) : -1;
+            if (g >= 0) expected += gsl_vector_get(effects->vector, g);
             gsl_vector_set(errors, i, expected-actual);
         }
     }
@@ -204,28 +227,161 @@ static void ols_score(apop_data *d, gsl_vector *gradient, apop_model *p){
     apop_model_free(norm);
 }
 
-//xpx may be destroyed by the HH transformation.
-static void xpxinvxpy(apop_data const*data, gsl_matrix *xpx, apop_data const* xpy, apop_model *out){
+/* Absorbed fixed effects. Let D be the grid of dummies implied by the index codes of
+apop_lm_settings.fixed_effects. By Frisch-Waugh-Lovell, the coefficients on X in the
+regression on [X D] are those of the regression of the within-group deviations of y
+on those of X, and for any columns a and b of [y X Z],
+    sum_i w_i (a_i - abar_g)(b_i - bbar_g) = a'Wb - sum_g n_g abar_g bbar_g,
+where n_g is group g's total weight. So the cross products only need a K x (1+2k) table
+of group means, not the N x K grid. Rows coded -1 are in the dropped base category,
+which the constant column covers, and are not demeaned. */
+typedef struct {
+    gsl_vector const *codes;
+    gsl_vector const *root_w;   //roots of the weights the data's errors are scaled by, or NULL.
+    size_t k, group_ct;         //group_ct counts the groups with any observations.
+    gsl_vector *n;              //per-group weight totals.
+    gsl_matrix *root_n_means;   //row g: sqrt(n_g) times the means of y, then X, then Z.
+    gsl_vector *alpha;          //the fixed effects, filled in once beta is known.
+} absorbed_s;
+
+static void absorbed_free(absorbed_s *a){
+    if (!a) return;
+    gsl_vector_free(a->n);
+    gsl_matrix_free(a->root_n_means);
+    gsl_vector_free(a->alpha);
+    free(a);
+}
+
+/* z may be NULL, for OLS; w holds the weights as given, and root_w the vector that
+will hold their square roots by the time the errors are calculated.*/
+static absorbed_s *absorbed_alloc(apop_data *fe, apop_data *set, gsl_matrix *z,
+                                    gsl_vector const *w, gsl_vector const *root_w){
+    size_t rows = set->matrix->size1, k = set->matrix->size2;
+    Apop_stopif(!fe->vector || fe->vector->size != rows, return NULL, 0, "The fixed effects "
+            "need a vector of one code per row of data (%zu rows).", rows);
+    size_t K = fe->names->colct;
+    if (!K) K = gsl_vector_max(fe->vector) + 1;
+    for (size_t i=0; i< rows; i++){
+        double g = gsl_vector_get(fe->vector, i);
+        Apop_stopif(!(g >= -1 && g < K) || g != (int)g, return NULL, 0, "Row %zu has fixed-effect "
+                "code %g, but codes must be integers from -1 to %zu.", i, g, K-1);
+    }
+    absorbed_s *a = malloc(sizeof(absorbed_s));
+    *a = (absorbed_s){.codes=fe->vector, .root_w=root_w, .k=k,
+                     .n=gsl_vector_calloc(K), .alpha=gsl_vector_alloc(K),
+                     .root_n_means=gsl_matrix_calloc(K, 1 + k + (z ? k : 0))};
+    for (size_t i=0; i< rows; i++){
+        int g = gsl_vector_get(a->codes, i);
+        if (g >= 0) *gsl_vector_ptr(a->n, g) += w ? gsl_vector_get(w, i) : 1;
+    }
+    for (size_t g=0; g< K; g++) a->group_ct += gsl_vector_get(a->n, g) > 0;
+
+    //Group sums, one column per thread; then sum/sqrt(n) == sqrt(n)*mean.
+    OMP_for (size_t c=0; c< a->root_n_means->size2; c++){
+        gsl_vector *src = (c == 0) ? set->vector : (c <= k) ? Apop_mcv(set->matrix, c-1) : Apop_mcv(z, c-1-k);
+        for (size_t i=0; i< rows; i++){
+            int g = gsl_vector_get(a->codes, i);
+            if (g >= 0) *gsl_matrix_ptr(a->root_n_means, g, c) += (w ? gsl_vector_get(w, i) : 1) * gsl_vector_get(src, i);
+        }
+        for (size_t g=0; g< K; g++)
+            if (gsl_vector_get(a->n, g) > 0) *gsl_matrix_ptr(a->root_n_means, g, c) /= sqrt(gsl_vector_get(a->n, g));
+    }
+    return a;
+}
+
+//Subtract sum_g n_g abar_g bbar_g' from a cross product, where a and b are 'y', 'x', or 'z'.
+static void absorb_cross(absorbed_s const *a, char first, char second, gsl_matrix *cross){
+    size_t k = a->k, K = a->n->size;
+    gsl_matrix_view ma = gsl_matrix_submatrix(a->root_n_means, 0, first=='x' ? 1 : 1+k, K, k);
+    gsl_matrix_view mb = gsl_matrix_submatrix(a->root_n_means, 0, second=='x' ? 1 : 1+k, K, k);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, -1, &ma.matrix, &mb.matrix, 1, cross);
+}
+
+static void absorb_cross_y(absorbed_s const *a, char first, gsl_vector *cross){
+    size_t k = a->k, K = a->n->size;
+    gsl_matrix_view ma = gsl_matrix_submatrix(a->root_n_means, 0, first=='x' ? 1 : 1+k, K, k);
+    gsl_vector_const_view y = gsl_matrix_const_column(a->root_n_means, 0);
+    gsl_blas_dgemv(CblasTrans, -1, &ma.matrix, &y.vector, 1, cross);
+}
+
+//alpha_g = ybar_g - xbar_g beta; NaN for empty groups.
+static void absorb_alpha(absorbed_s *a, gsl_vector const *beta){
+    size_t K = a->n->size;
+    gsl_matrix_view mx = gsl_matrix_submatrix(a->root_n_means, 0, 1, K, a->k);
+    gsl_vector_memcpy(a->alpha, Apop_mcv(a->root_n_means, 0));
+    gsl_blas_dgemv(CblasNoTrans, -1, &mx.matrix, beta, 1, a->alpha);
+    for (size_t g=0; g< K; g++){
+        double n = gsl_vector_get(a->n, g);
+        gsl_vector_set(a->alpha, g, n > 0 ? gsl_vector_get(a->alpha, g)/sqrt(n) : GSL_NAN);
+    }
+}
+
+//The errors calculated from X alone omit each row's fixed effect.
+static void absorb_errors(absorbed_s const *a, gsl_vector *error){
+    OMP_for (size_t i=0; i< error->size; i++){
+        int g = gsl_vector_get(a->codes, i);
+        if (g >= 0) *gsl_vector_ptr(error, i) += gsl_vector_get(a->alpha, g)
+                                                  * (a->root_w ? gsl_vector_get(a->root_w, i) : 1);
+    }
+}
+
+static apop_data *absorbed_page(absorbed_s const *a, apop_data const *fe){
+    apop_data *out = apop_data_alloc(a->alpha->size);
+    gsl_vector_memcpy(out->vector, a->alpha);
+    apop_name_add(out->names, "fixed effects", 'v');
+    for (size_t g=0; g< fe->names->colct && g < a->alpha->size; g++)
+        apop_name_add(out->names, fe->names->col[g], 'r');
+    return out;
+}
+
+/* t tests for each coefficient, given its covariance: a <tt>\<test info\></tt> page and
+the df on the info page. names are stacked onto the test page's rows from the given type. */
+static void lm_t_tests(apop_model *out, gsl_matrix const *cov, apop_name *names, char type, int df){
+    size_t k = cov->size1;
+    gsl_vector const *beta = out->parameters->vector;
+    apop_data *tests = apop_data_add_page(out->info, apop_data_alloc(k, 2), "<test info>");
+    apop_name_add(tests->names, "p value", 'c');
+    apop_name_add(tests->names, "confidence", 'c');
+    apop_name_stack(tests->names, names, 'r', type);
+    for (size_t i=0; i< k; i++){
+        double t = gsl_vector_get(beta, i)/sqrt(gsl_matrix_get(cov, i, i));
+        double conf = 2*fabs(0.5 - gsl_cdf_tdist_P(-t, df));
+        apop_data_set(tests, i, .colname="confidence", .val=conf);
+        apop_data_set(tests, i, .colname="p value",    .val=1-conf);
+    }
+    apop_data_add_named_elmt(out->info, "df", df);
+}
+
+/* fe may be NULL. spd=='y' if xpx is X'X, so the Cholesky routines apply; for IV it is
+Z'X, which isn't symmetric, and which the HH transformation may destroy. */
+static void xpxinvxpy(apop_data const*data, gsl_matrix *xpx, apop_data const* xpy, apop_model *out, absorbed_s *fe, char spd){
     apop_lm_settings   *p =  apop_settings_get_group(out, apop_lm);
     apop_parts_wanted_settings *pwant = apop_settings_get_group(out, apop_parts_wanted);
 	if ( (pwant && pwant->covariance!='y' && pwant->predicted != 'y') 
        ||(!pwant && p && p->want_cov!='y' && p->want_expected_value != 'y')){	
 		//then don't calculate (X'X)^{-1}
-		gsl_linalg_HH_solve (xpx, xpy->vector, out->parameters->vector);
+		if (spd=='y') apop_matrix_spd_solve(xpx, xpy->vector, out->parameters->vector);
+		else          gsl_linalg_HH_solve(xpx, xpy->vector, out->parameters->vector);
+		if (fe) absorb_alpha(fe, out->parameters->vector);
 		return;
 	} //else:
     double s_sq;
     gsl_vector const *y_data = data->vector; //just an alias
     apop_data *cov = apop_data_alloc();
-    double det = apop_det_and_inv(xpx, &cov->matrix, 1, 1);// not yet cov, just (X'X)^-1.
-    if (det < 1e-4) Apop_notify(1, "Determinant of X'X is small (%g), so matrix is near singular. "
-                        "Expect the covariance matrix [based on (X'X)^-1] to be garbage.", det);
+    double logdet = (spd=='y') ? apop_spd_logdet_and_inv(xpx, &cov->matrix, 1, 1)// not yet cov, just (X'X)^-1.
+                               : log(fabs(apop_det_and_inv(xpx, &cov->matrix, 1, 1)));
+    if (!(logdet >= log(1e-4))) Apop_notify(1, "Determinant of X'X is small (%g), so matrix is near singular. "
+                        "Expect the covariance matrix [based on (X'X)^-1] to be garbage.", exp(logdet));
     apop_data_free(out->parameters);
     out->parameters = apop_dot(cov, xpy);               // \beta=(X'X)^{-1}X'Y
     apop_data *error = apop_dot(data, out->parameters); // X\beta ==predicted (not yet error)
 	gsl_vector_sub(error->vector, y_data);              // X'\beta - Y == error
+    if (fe){
+        absorb_alpha(fe, out->parameters->vector);
+        absorb_errors(fe, error->vector);
+    }
     gsl_blas_ddot(error->vector, error->vector, &s_sq); // e'e
-    s_sq /= data->matrix->size1 - data->matrix->size2;  // \sigma^2 = e'e / df
+    s_sq /= data->matrix->size1 - data->matrix->size2 - (fe ? fe->group_ct : 0);  // \sigma^2 = e'e / df
 	gsl_matrix_scale(cov->matrix, s_sq);                // cov = \sigma^2 (X'X)^{-1}
 	if ((pwant && pwant->predicted) || (!pwant && p && p->want_expected_value)){
         apop_data *predicted_page = apop_data_get_page(out->info, "<Predicted>");
@@ -318,6 +474,11 @@ static void apop_estimate_OLS(apop_data *inset, apop_model *ep){
     gsl_vector *weights = olp->destroy_data      //this may be NULL.
                            ? ep->data->weights 
                            : apop_vector_copy(ep->data->weights);
+    absorbed_s *fe = NULL;
+    if (olp->fixed_effects){
+        fe = absorbed_alloc(olp->fixed_effects, set, NULL, ep->data->weights, weights);
+        Apop_stopif(!fe, ep->error='d'; goto done, 0, "Couldn't set up the fixed effects.");
+    }
     if (weights)
         for (size_t i =0; i< weights->size; i++)
             gsl_vector_set(weights, i, sqrt(gsl_vector_get(weights, i)));
@@ -332,20 +493,32 @@ static void apop_estimate_OLS(apop_data *inset, apop_model *ep){
 
     apop_data *xpx_d = apop_dot(set, set, .form1='t'); //(X'X)
     apop_data *xpy_d = apop_dot(set, set, .form1='t', .form2='v'); //(X'y)
-    xpxinvxpy(set, xpx_d->matrix, xpy_d, ep);
+    if (fe){
+        absorb_cross(fe, 'x', 'x', xpx_d->matrix);
+        absorb_cross_y(fe, 'x', xpy_d->vector);
+    }
+    xpxinvxpy(set, xpx_d->matrix, xpy_d, ep, fe, 'y');
     prep_names(ep);
     apop_data_free(xpx_d);
     apop_data_free(xpy_d);
+    size_t param_ct = set->matrix->size2 + (fe ? fe->group_ct : 0);
 
-    if ((pwant &&pwant->covariance) || (!pwant && olp && olp->want_cov=='y'))
-        apop_estimate_parameter_tests(ep);
+    if ((pwant &&pwant->covariance) || (!pwant && olp && olp->want_cov=='y')){
+        apop_data *cov = apop_data_get_page(ep->parameters, "<Covariance>");
+        if (fe && cov)  //the default tests would not count the absorbed parameters' df.
+            lm_t_tests(ep, cov->matrix, ep->parameters->names, 'r', set->matrix->size1 - param_ct);
+        else apop_estimate_parameter_tests(ep);
+    }
+    if (fe) apop_data_add_page(ep->parameters, absorbed_page(fe, olp->fixed_effects), "<Fixed effects>");
 
-    add_info_criteria(ep->data, ep, ep, apop_log_likelihood(ep->data, ep), set->matrix->size2); //in apop_mle.c
+    add_info_criteria(ep->data, ep, ep, apop_log_likelihood(ep->data, ep), param_ct); //in apop_mle.c
 
     apop_data *r_sq = apop_estimate_coefficient_of_determination(ep); //Add R^2-type info to info page.
     apop_data_stack(ep->info, r_sq, .inplace='y');
 
     apop_data_free(r_sq);
+done:
+    absorbed_free(fe);
     if (!olp->destroy_data){
         if (weights) gsl_vector_free(weights);
         apop_data_free(set);
@@ -454,10 +627,18 @@ static void apop_estimate_IV(apop_data *inset, apop_model *ep){
     ep->data = inset;
     if (ep->parameters) apop_data_free(ep->parameters);
     ep->parameters = apop_data_alloc(inset->matrix->size2);
+    Apop_stopif(olp->fixed_effects && inset->weights, ep->error='w'; return, 0,
+            "Fixed effects for weighted IV aren't implemented.");
     apop_data *set = olp->destroy_data ? inset : apop_data_copy(inset); 
     apop_data *z = prep_z(inset, olp->instruments);
+    gsl_vector *weights = NULL;
+    absorbed_s *fe = NULL;
+    if (olp->fixed_effects){
+        fe = absorbed_alloc(olp->fixed_effects, set, z->matrix, NULL, NULL);
+        Apop_stopif(!fe, ep->error='d'; goto done, 0, "Couldn't set up the fixed effects.");
+    }
     
-    gsl_vector *weights = olp->destroy_data      //the weights may be NULL.
+    weights = olp->destroy_data      //the weights may be NULL.
                              ? ep->data->weights 
                              : apop_vector_copy(ep->data->weights);
     if (weights)
@@ -475,13 +656,22 @@ static void apop_estimate_IV(apop_data *inset, apop_model *ep){
 
     apop_data *zpx = apop_dot(z, set, .form1='t');
     apop_data *zpy = apop_dot(z, set, .form1='t', .form2='v'); //z'y
+    if (fe){
+        absorb_cross(fe, 'z', 'x', zpx->matrix);
+        absorb_cross_y(fe, 'z', zpy->vector);
+    }
 
-    xpxinvxpy(inset, zpx->matrix, zpy, ep);
+    xpxinvxpy(inset, zpx->matrix, zpy, ep, fe, 'n');
 
     //covariance matrix right now is sigma (Z'X)^-1. We need
     //sigma (Z'X)^-1 (Z'Z) (X'Z)^-1
 
     apop_data *zpz = apop_dot(z, z, .form1='t');
+    if (fe){
+        absorb_cross(fe, 'z', 'z', zpz->matrix);
+        apop_data_add_page(ep->parameters, absorbed_page(fe, olp->fixed_effects), "<Fixed effects>");
+        absorbed_free(fe);
+    }
     apop_data zpxinv = (apop_data) {.matrix=apop_matrix_inverse(zpx->matrix)};
     apop_data *zpz_xpzinv = apop_dot(zpz, &zpxinv, .form2='t');
     apop_data *halfcov = apop_data_get_page(ep->parameters, "<Covariance>");
@@ -514,9 +704,314 @@ static void apop_estimate_IV(apop_data *inset, apop_model *ep){
     apop_data_free(zpx);// apop_data_free(zpxinv);
     apop_data_free(zpy);
 
-    if (!olp->destroy_data) apop_data_free(set);
+done:
+    apop_data_free(z);
+    if (!olp->destroy_data){
+        if (weights) gsl_vector_free(weights);
+        apop_data_free(set);
+    }
 }
 
 apop_model *apop_iv = &(apop_model){.name="instrumental variables", .vsize = -1, .dsize=-1,
     .estimate =apop_estimate_IV, .prep=ols_prep,
     .log_likelihood = ols_log_likelihood};
+
+
+/* Blocked estimation of OLS and IV. Each block of rows is copied into a row-major
+buffer A = [X y Z_inst 1], scaled by the square root of the weights if any, and A'A is
+accumulated with a symmetric rank-k update. All of the estimation and auxiliary
+statistics can be written in terms of the blocks of the summed A'WA:
+X'X, X'y, y'y, Z'X, Z'y, Z'Z, and the sums of the weights and of wy. */
+
+static const size_t lm_chunk_rows = 4096;
+
+/** Allocate an accumulator for fitting a linear regression in blocks. Send each block
+of rows of data to \ref apop_lm_blocks_add, then call \ref apop_lm_blocks_estimate to
+get the estimated model.
+
+\code
+apop_lm_blocks *acc = apop_lm_blocks_alloc(NULL);
+apop_query_to_blocks(1e5, apop_lm_blocks_add, acc, "select y, x1, x2 from bigtable");
+apop_model *est = apop_lm_blocks_estimate(acc, apop_ols);
+apop_lm_blocks_free(acc);
+\endcode
+
+Only one pass through the data is made, and only a few rows are copied at a time,
+so the regression can be run on data sets far too large to hold in memory. Within each
+block, rows are processed in parallel.
+
+\param instrumented For instrumental variables, a list of the columns of the \f$X\f$
+    matrix to be replaced by instruments, where the dependent variable is column zero and
+    the first independent column is one, as with the \c vector form of \ref apop_iv's
+    <tt>.instruments</tt>. The instruments themselves are given as extra columns at the end
+    of each block's matrix, in the same order as this list. If \c NULL, run OLS. The vector is
+    copied.
+\return An empty accumulator.
+*/
+apop_lm_blocks *apop_lm_blocks_alloc(gsl_vector const *instrumented){
+    apop_lm_blocks *out = malloc(sizeof(apop_lm_blocks));
+    *out = (apop_lm_blocks){.instrumented = apop_vector_copy(instrumented)};
+    return out;
+}
+
+void apop_lm_blocks_free(apop_lm_blocks *acc){
+    if (!acc) return;
+    if (acc->cross) gsl_matrix_free(acc->cross);
+    if (acc->raw_cross) gsl_matrix_free(acc->raw_cross);
+    if (acc->instrumented) gsl_vector_free(acc->instrumented);
+    apop_name_free(acc->names);
+    free(acc);
+}
+
+static void lm_blocks_setup(apop_lm_blocks *acc, apop_data *block){
+    size_t inst_ct = acc->instrumented ? acc->instrumented->size : 0;
+    int has_y = !!block->vector;
+    acc->k = block->matrix->size2 - inst_ct;
+    acc->cross = gsl_matrix_calloc(acc->k + 2 + inst_ct, acc->k + 2 + inst_ct);
+    if (block->weights) acc->raw_cross = gsl_matrix_calloc(acc->k + 1, acc->k + 1);
+    acc->names = apop_name_alloc();
+    if (has_y){
+        apop_name_add(acc->names, block->names->vector ? block->names->vector : "Observed", 'v');
+        for (size_t i=0; i< acc->k; i++)
+            apop_name_add(acc->names, i < block->names->colct ? block->names->col[i] : "", 'c');
+    } else { //as with the prep routine: column zero is y, replaced by a column of ones.
+        apop_name_add(acc->names, block->names->colct ? block->names->col[0] : "Observed", 'v');
+        apop_name_add(acc->names, "1", 'c');
+        for (size_t i=1; i< acc->k; i++)
+            apop_name_add(acc->names, i < block->names->colct ? block->names->col[i] : "", 'c');
+    }
+}
+
+/** Add a block of rows to a linear regression accumulator. See \ref apop_lm_blocks_alloc.
+
+\param block The data. As with \ref apop_ols, if there is a \c vector it is the dependent
+    variable and the \c matrix is \f$X\f$; else column zero of the matrix is the dependent
+    variable, and is treated as a column of ones. If there are \c weights, they are used;
+    either every block or none should have them. Instrument columns, if any, follow the
+    \f$X\f$ columns. The block is not modified.
+\param acc The \ref apop_lm_blocks accumulator. This is a <tt>void*</tt> so that this
+    function can be sent directly to \ref apop_query_to_blocks.
+\return Zero on success; \c 'd' if the block has a different number of columns than the
+    first block; \c 'w' if the block has weights and the first block didn't, or vice versa.
+    On error, the block is not added, and the accumulator's \c error is set to the same code.
+*/
+int apop_lm_blocks_add(apop_data *block, void *acc_in){
+    apop_lm_blocks *acc = acc_in;
+    Apop_stopif(!acc, return 'n', 0, "NULL accumulator.");
+    if (!block || !block->matrix) return 0;
+    if (!acc->cross) lm_blocks_setup(acc, block);
+    size_t inst_ct = acc->instrumented ? acc->instrumented->size : 0;
+    size_t k = acc->k, cols = k + 2 + inst_ct, n = block->matrix->size1;
+    Apop_stopif(block->matrix->size2 != k + inst_ct, acc->error='d'; return 'd', 0,
+            "This block has %zu columns, but the first had %zu.", block->matrix->size2, k + inst_ct);
+    int has_y = !!block->vector;
+    gsl_vector *w = block->weights;
+    Apop_stopif(!w != !acc->raw_cross, acc->error='w'; return 'w', 0, "This block %s weights, but the "
+            "first block %s. Give weights for every block or for none.", w ? "has" : "has no", w ? "didn't" : "did");
+    size_t chunk_ct = (n + lm_chunk_rows - 1)/lm_chunk_rows;
+    int tasks = GSL_MIN(64, chunk_ct);
+    long double sum_log_w = 0;
+    //Each task runs through its share of the chunks with one buffer, summing into its own
+    //cross-products, which are added to the accumulator once at the end.
+    OMP_for_reduce(+:sum_log_w, int t=0; t< tasks; t++){
+        double *buffer = malloc(sizeof(double)*lm_chunk_rows*cols);
+        gsl_matrix *local = gsl_matrix_calloc(cols, cols);
+        gsl_matrix *raw = w ? gsl_matrix_calloc(k+1, k+1) : NULL;
+        for (size_t c=t*chunk_ct/tasks; c< (t+1)*chunk_ct/tasks; c++){
+            size_t first = c*lm_chunk_rows;
+            size_t rows = GSL_MIN(lm_chunk_rows, n - first);
+            gsl_matrix_view a = gsl_matrix_view_array(buffer, rows, cols);
+            for (size_t i=0; i< rows; i++){
+                double *arow = a.matrix.data + i*cols;
+                gsl_vector_const_view xrow = gsl_matrix_const_row(block->matrix, first+i);
+                for (size_t j=0; j< k + inst_ct; j++)
+                    arow[j < k ? j : j+1] = gsl_vector_get(&xrow.vector, j);
+                arow[k] = has_y ? gsl_vector_get(block->vector, first+i) : arow[0];
+                if (!has_y) arow[0] = 1;
+                arow[cols-1] = 1;
+            }
+            if (w){
+                gsl_matrix_view xy = gsl_matrix_submatrix(&a.matrix, 0, 0, rows, k+1);
+                gsl_blas_dsyrk(CblasLower, CblasTrans, 1, &xy.matrix, 1, raw);
+                for (size_t i=0; i< rows; i++){
+                    double wi = gsl_vector_get(w, first+i);
+                    sum_log_w += logl(wi);
+                    gsl_vector_view arow = gsl_matrix_row(&a.matrix, i);
+                    gsl_vector_scale(&arow.vector, sqrt(wi));
+                }
+            }
+            gsl_blas_dsyrk(CblasLower, CblasTrans, 1, &a.matrix, 1, local); //upper triangle stays zero
+        }
+        OMP_critical(lm_blocks_add)
+        {
+            gsl_matrix_add(acc->cross, local);
+            if (w) gsl_matrix_add(acc->raw_cross, raw);
+        }
+        free(buffer);
+        gsl_matrix_free(local);
+        if (raw) gsl_matrix_free(raw);
+    }
+    acc->sum_log_weights += sum_log_w;
+    acc->n += n;
+    return 0;
+}
+
+static void fill_upper(gsl_matrix *m){
+    for (size_t i=0; i< m->size1; i++)
+        for (size_t j=i+1; j< m->size2; j++)
+            gsl_matrix_set(m, i, j, gsl_matrix_get(m, j, i));
+}
+
+//e'e = y'y - 2b'X'y + b'X'Xb, from the lower-left (k+1)x(k+1) of a cross-product matrix.
+static double quadratic_sse(gsl_matrix *cross, gsl_vector *beta){
+    size_t k = beta->size;
+    gsl_matrix_view xx = gsl_matrix_submatrix(cross, 0, 0, k, k);
+    gsl_vector_view ycol = gsl_matrix_column(cross, k);
+    gsl_vector_view xy = gsl_vector_subvector(&ycol.vector, 0, k);
+    gsl_vector *xxb = gsl_vector_alloc(k);
+    gsl_blas_dsymv(CblasLower, 1, &xx.matrix, beta, 0, xxb);
+    double bxy, bxxb;
+    gsl_blas_ddot(beta, &xy.vector, &bxy);
+    gsl_blas_ddot(beta, xxb, &bxxb);
+    gsl_vector_free(xxb);
+    return gsl_matrix_get(cross, k, k) - 2*bxy + bxxb;
+}
+
+/** Estimate a linear regression from the cross-products accumulated via \ref
+apop_lm_blocks_add.
+
+\param acc The accumulator.
+\param m An \ref apop_ols or \ref apop_iv model, possibly with \ref apop_lm_settings or
+    \ref apop_parts_wanted_settings groups attached. If \c NULL, use \ref apop_iv if the
+    accumulator has instruments and \ref apop_ols otherwise.
+\return A copy of \c m, with the parameter vector, a <tt>\<Covariance\></tt> page
+    (if wanted), the <tt>\<Error variance\></tt>, and on the \c info page the log likelihood,
+    AIC, BIC, \f$R^2\f$, SSE, SST, and SSR, as per \ref apop_ols. Because there is no data
+    set, there is no <tt>\<Predicted\></tt> page, and the output model's \c data is \c NULL.
+    On error (no data, no more observations than regressors, or a singular \f$X'X\f$),
+    <tt>out->error='d'</tt>.
+
+\li The log likelihood assumes that the distribution of \f$X\f$ is the default improper uniform.
+*/
+apop_model *apop_lm_blocks_estimate(apop_lm_blocks *acc, apop_model *m){
+    Apop_stopif(!acc, return NULL, 0, "NULL accumulator.");
+    size_t inst_ct = acc->instrumented ? acc->instrumented->size : 0;
+    apop_model *out = apop_model_copy(m ? m : inst_ct ? apop_iv : apop_ols);
+    Apop_stopif(!acc->cross || acc->error, out->error='d'; return out, 0, "No data, or an error in some block.");
+    size_t k = acc->k, n = acc->n, one = k+1+inst_ct;
+    Apop_stopif(n <= k, out->error='d'; return out, 0, "%zu observations and %zu regressors, "
+            "so the regression is underdetermined.", n, k);
+    apop_lm_settings *olp =  apop_settings_get_group(out, apop_lm);
+    apop_parts_wanted_settings *pwant = apop_settings_get_group(out, apop_parts_wanted);
+    int want_cov = (pwant && pwant->covariance=='y') || (pwant && pwant->tests=='y')
+                        || (!pwant && (!olp || olp->want_cov=='y'));
+
+    if (!out->info){
+        out->info = apop_data_alloc();
+        Asprintf(&out->info->names->title, "<Info>");
+    }
+
+    gsl_matrix *cross = apop_matrix_copy(acc->cross);
+    fill_upper(cross);
+
+    //Z'X, Z'y, Z'Z: for uninstrumented columns, Z's column is X's.
+    int zcol[k];
+    for (size_t i=0; i< k; i++) zcol[i] = i;
+    for (size_t t=0; t< inst_ct; t++){
+        int c = gsl_vector_get(acc->instrumented, t);
+        Apop_stopif(c < 0 || c >= k, out->error='d'; gsl_matrix_free(cross); return out,
+                0, "Instrumented column %i is out of range.", c);
+        zcol[c] = k+1+t;
+    }
+    gsl_matrix *zx = gsl_matrix_alloc(k, k), *zz = gsl_matrix_alloc(k, k);
+    gsl_vector *zy = gsl_vector_alloc(k);
+    for (size_t i=0; i< k; i++){
+        gsl_vector_set(zy, i, gsl_matrix_get(cross, zcol[i], k));
+        for (size_t j=0; j< k; j++){
+            gsl_matrix_set(zx, i, j, gsl_matrix_get(cross, zcol[i], j));
+            gsl_matrix_set(zz, i, j, gsl_matrix_get(cross, zcol[i], zcol[j]));
+        }
+    }
+    /* With many rows, the determinant itself overflows, so work with its log. X'X gets
+       the Cholesky routines; Z'X isn't symmetric, so it gets LU, and only the size of
+       its determinant matters. */
+    apop_data *zxinv = apop_data_alloc();
+    double logdet;
+    if (inst_ct){
+        gsl_matrix *lu = apop_matrix_copy(zx);
+        gsl_permutation *perm = gsl_permutation_alloc(k);
+        int sign;
+        gsl_linalg_LU_decomp(lu, perm, &sign);
+        logdet = gsl_linalg_LU_lndet(lu);
+        if (isfinite(logdet)){
+            zxinv->matrix = gsl_matrix_alloc(k, k);
+            gsl_linalg_LU_invert(lu, perm, zxinv->matrix);
+        }
+        gsl_matrix_free(lu);
+        gsl_permutation_free(perm);
+    } else logdet = apop_spd_logdet_and_inv(zx, &zxinv->matrix, 1, 1);
+    Apop_stopif(!isfinite(logdet) || !zxinv->matrix, out->error='d'; goto done, 0, "X'X (or Z'X) is singular.");
+    if (logdet < log(1e-4)) Apop_notify(1, "Determinant of X'X is small (%g), so matrix is near singular. "
+                        "Expect the covariance matrix [based on (X'X)^-1] to be garbage.", exp(logdet));
+
+    apop_data_free(out->parameters);
+    out->parameters = apop_data_alloc(k);
+    gsl_blas_dgemv(CblasNoTrans, 1, zxinv->matrix, zy, 0, out->parameters->vector); // \beta=(Z'X)^{-1}Z'Y
+    Asprintf(&out->parameters->names->title, "Regression of %s", acc->names->vector);
+    apop_name_add(out->parameters->names, "parameters", 'v');
+    apop_name_stack(out->parameters->names, acc->names, 'r', 'c');
+
+    double sse = quadratic_sse(cross, out->parameters->vector);
+    double raw_sse = sse;
+    if (acc->raw_cross){
+        gsl_matrix *raw = apop_matrix_copy(acc->raw_cross);
+        fill_upper(raw);
+        raw_sse = quadratic_sse(raw, out->parameters->vector);
+        gsl_matrix_free(raw);
+    }
+    int df = n - k;
+    double s_sq = (inst_ct ? raw_sse : sse)/df;
+    if (want_cov){ // cov = s^2 (Z'X)^{-1} Z'Z (X'Z)^{-1}; Z'Z=X'X for OLS, so this reduces to s^2 (X'X)^{-1}
+        apop_data *cov = apop_data_alloc();
+        if (inst_ct){
+            gsl_matrix *half = gsl_matrix_alloc(k, k);
+            cov->matrix = gsl_matrix_alloc(k, k);
+            gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, zxinv->matrix, zz, 0, half);
+            gsl_blas_dgemm(CblasNoTrans, CblasTrans, s_sq, half, zxinv->matrix, 0, cov->matrix);
+            gsl_matrix_free(half);
+        } else {
+            cov->matrix = apop_matrix_copy(zxinv->matrix);
+            gsl_matrix_scale(cov->matrix, s_sq);
+        }
+        apop_name_stack(cov->names, acc->names, 'c');
+        apop_name_stack(cov->names, acc->names, 'r', 'c');
+        apop_data_add_page(out->parameters, cov, "<Covariance>");
+        lm_t_tests(out, cov->matrix, acc->names, 'c', df);
+    }
+    apop_data_add_page(out->parameters, apop_data_falloc((1), s_sq), "<Error variance>");
+
+    double ll = -(n/2.)*log(2*M_PI*s_sq) - raw_sse/(2*s_sq) + acc->sum_log_weights;
+    add_info_criteria(NULL, out, out, ll, k); //in apop_mle.c
+    apop_data_add_named_elmt(out->info, "AIC_c", 2*k - 2*ll + 2*k*(k + 1.0)/(n - k - 1.0));
+    apop_data_add_named_elmt(out->info, "BIC", k * log(n) - 2*ll);
+
+    double sum_w = gsl_matrix_get(cross, one, one), sum_wy = gsl_matrix_get(cross, one, k);
+    //SST as from apop_vector_var, as for the in-memory regression: with weights that sum
+    //to less than about one, the sample size stands in for their total.
+    double len = sum_w < 1.1 ? n : sum_w;
+    double sst = (gsl_matrix_get(cross, k, k) - gsl_pow_2(sum_wy)/len) * (n - 1.)/(len - 1.);
+    double rsq = 1. - sse/sst;
+    apop_data_add_named_elmt(out->info, "R squared", rsq);
+    apop_data_add_named_elmt(out->info, "R squared adj", 1 - ((n - 1.)/(n - (k - 1.))) * (1.-rsq));
+    apop_data_add_named_elmt(out->info, "SSE", sse);
+    apop_data_add_named_elmt(out->info, "SST", sst);
+    apop_data_add_named_elmt(out->info, "SSR", sst - sse);
+
+done:
+    apop_data_free(zxinv);
+    gsl_matrix_free(zx);
+    gsl_matrix_free(zz);
+    gsl_vector_free(zy);
+    gsl_matrix_free(cross);
+    return out;
+}
@@ -43,7 +43,6 @@ static void probit_prep(apop_data *d, apop_model *m){
     if (m->data && m->parameters) return; //already prepped; re-prep is a no-op.
     apop_data *factor_list = get_category_table(d);
     apop_score_vtable_add(probit_dlog_likelihood, apop_probit);
-    //apop_score_vtable_add(logit_dlog_likelihood, apop_logit);
     apop_ols->prep(d, m);//also runs the default apop_model_clear.
     int count = factor_list->textsize[0];
     m->parameters = apop_data_alloc(d->matrix->size2, count-1);
@@ -80,77 +79,84 @@ static void probit_prep(apop_data *d, apop_model *m){
     sets->starting_pt= params_as_vector->data;
 }
 
-static double biprobit_ll_row(apop_data *r){
-    long double n = gsl_cdf_gaussian_P(-gsl_matrix_get(r->matrix, 0, 0),1);
-    n = n ? n : 1e-10; //prevent -inf in the next step.
-    n = n<1 ? n : 1-1e-10; 
-    return r->vector->data[0] ?  log(1-n): log(n);
+/* Probit and logit share one kernel. For each block of observations, find Xβ via
+a single dgemm into the block's own buffer, then either sum the model's row function
+(the row's LL) over the block, or, for the score, have the row function overwrite each
+row with dLL/d(Xβ) and accumulate the block's gradient as X'[dLL/d(Xβ)] with another
+dgemm. The score pass does not compute the LL. Blocks run in parallel. */
+
+typedef double (*choice_row_fn)(double *xb, size_t cols, size_t choice, int want_grad);
+
+static const size_t choice_block_rows = 4096;
+
+static size_t find_index(double in, double *m, size_t max){
+    size_t i = 0;
+    while (in !=m[i] && i<max) i++;
+    return i;
 }
 
-//The case where outcome is a single zero/one option.
-static long double biprobit_log_likelihood(apop_data *d, apop_model *p){
-    apop_data *betadotx = apop_dot(d, p->parameters); 
-    betadotx->vector = d->vector;
-    double total_prob = apop_map_sum(betadotx, .fn_r=biprobit_ll_row);
-    betadotx->vector = NULL;
-    apop_data_free(betadotx);
-	return total_prob;
+static long double choice_kernel(apop_data *d, apop_model *p, gsl_vector *categories,
+                                        gsl_vector *gradient, choice_row_fn row_fn){
+    gsl_matrix *x = d->matrix, *beta = p->parameters->matrix;
+    size_t n = x->size1, k = x->size2, cols = beta->size2;
+    size_t block_ct = (n + choice_block_rows - 1)/choice_block_rows;
+    double *cats = categories->data;
+    double *outcomes = d->vector->data;
+    size_t ostride = d->vector->stride;
+    int want_grad = !!gradient;
+    long double ll = 0;
+    if (gradient) gsl_vector_set_all(gradient, 0);
+    OMP_for_reduce(+:ll, size_t b=0; b< block_ct; b++){
+        size_t first = b*choice_block_rows;
+        size_t rows = GSL_MIN(choice_block_rows, n - first);
+        gsl_matrix_view xblock = gsl_matrix_submatrix(x, first, 0, rows, k);
+        double *xb_data = malloc(sizeof(double)*rows*cols);
+        gsl_matrix_view xb = gsl_matrix_view_array(xb_data, rows, cols);
+        gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, &xblock.matrix, beta, 0, &xb.matrix);
+        for (size_t i=0; i< rows; i++) //row_fn returns zero when filling in the gradient.
+            ll += row_fn(xb.matrix.data + i*cols, cols,
+                         find_index(outcomes[(first+i)*ostride], cats, cols), want_grad);
+        if (want_grad){
+            double *g_data = malloc(sizeof(double)*k*cols);
+            gsl_matrix_view g = gsl_matrix_view_array(g_data, k, cols);
+            gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, &xblock.matrix, &xb.matrix, 0, &g.matrix);
+            OMP_critical(choice_gradient)
+            for (size_t j=0; j< k*cols; j++)
+                gradient->data[j*gradient->stride] += g.matrix.data[j];
+            free(g_data);
+        }
+        free(xb_data);
+    }
+    return ll;
 }
 
-static threadlocal double val;
-static double unordered(double in){ return in == val; }
+/* Each column of β is a probit for one non-numeraire option vs. all others. With two
+options, this is the usual binary probit. */
+static double probit_row(double *xb, size_t cols, size_t choice, int want_grad){
+    double ll = 0;
+    for (size_t j=0; j< cols; j++){
+        double cdf = gsl_cdf_gaussian_P(-xb[j], 1);
+        cdf = cdf ? cdf : 1e-10; //prevent -inf in the next step.
+        cdf = cdf<1 ? cdf : 1-1e-10; 
+        int chosen = (choice == j+1);
+        if (want_grad){
+            double pdf = gsl_ran_gaussian_pdf(-xb[j], 1);
+            xb[j] = chosen ? pdf/(1-cdf) : -pdf/cdf;
+        } else ll += chosen ? log(1-cdf) : log(cdf);
+    }
+    return ll;
+}
 
-// This is just a for loop that runs a probit on each column.
 static long double multiprobit_log_likelihood(apop_data *d, apop_model *p){
     Nullcheck_mpd(d, p, GSL_NAN)
-    gsl_vector *val_vector = get_category_table(d)->vector;
-    if (val_vector->size==2) return biprobit_log_likelihood(d, p);
-    //else, multinomial loop
-    static threadlocal apop_model *spare_probit = NULL;
-    if (!spare_probit){
-        spare_probit = apop_model_copy(apop_probit);
-        spare_probit->parameters = apop_data_alloc();
-    }
-    Staticdef(apop_data *, working_data, apop_data_alloc());
-    working_data->matrix = d->matrix;
-    gsl_vector *original_outcome = d->vector;
-    double ll = 0;
-    double *vals = val_vector->data;
-    for(size_t i=0; i < p->parameters->matrix->size2; i++){
-        val = vals[i];
-        working_data->vector = apop_vector_map(original_outcome, unordered);
-        spare_probit->parameters->matrix = apop_vector_to_matrix(Apop_cv(p->parameters, 1));
-        ll  += apop_log_likelihood(working_data, spare_probit);
-        gsl_vector_free(working_data->vector); //yup. It's inefficient.
-        gsl_matrix_free(spare_probit->parameters->matrix);
-    }
-	return ll;
+    Nullcheck(d->matrix, GSL_NAN) Nullcheck(d->vector, GSL_NAN)
+    return choice_kernel(d, p, get_category_table(d)->vector, NULL, probit_row);
 }
 
 static void probit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p){
-    Nullcheck_mp(p, )
-    gsl_vector *val_vector = get_category_table(p->data)->vector;
-    if (val_vector->size!=2){
-        gsl_vector * numeric_default = apop_numerical_gradient(d, p);
-        gsl_vector_memcpy(gradient, numeric_default);
-        gsl_vector_free(numeric_default);
-        return;
-    }
-    long double	cdf, betax, deriv_base;
-    apop_data *betadotx = apop_dot(d, p->parameters); 
-    gsl_vector_set_all(gradient, 0);
-    for (size_t i=0; i< d->matrix->size1; i++){
-        betax = apop_data_get(betadotx, i, 0);
-        cdf = gsl_cdf_gaussian_P(-betax, 1);
-        cdf = cdf ? cdf : 1e-10; //prevent -inf in the next step.
-        cdf = cdf<1 ? cdf : 1-1e-10; 
-        deriv_base = apop_data_get(d, i, -1)
-                       ?  gsl_ran_gaussian_pdf(-betax, 1) /(1-cdf)
-                       : -gsl_ran_gaussian_pdf(-betax, 1) / cdf;
-        for (size_t j=0; j< d->matrix->size2; j++)
-            *gsl_vector_ptr(gradient, j) += apop_data_get(d, i, j) * deriv_base;
-	}
-	apop_data_free(betadotx);
+    Nullcheck_mpd(d, p, )
+    Nullcheck(d->matrix, ) Nullcheck(d->vector, )
+    choice_kernel(d, p, get_category_table(d)->vector, gradient, probit_row);
 }
 
 apop_model *apop_probit = &(apop_model){"Probit", .log_likelihood = multiprobit_log_likelihood,
@@ -198,95 +204,40 @@ static apop_data *multilogit_expected(apop_data *in, apop_model *m){
     return out;
 }
 
+static void logit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p);
+
 static void logit_prep(apop_data *d, apop_model *m){
     probit_prep(d, m);
+    apop_score_vtable_add(logit_dlog_likelihood, apop_logit);
     apop_predict_vtable_add(multilogit_expected, apop_logit);
 }
 
-static size_t find_index(double in, double *m, size_t max){
-    size_t i = 0;
-    while (in !=m[i] && i<max) i++;
-    return i;
-}
-
-double one_logit_row(apop_data *thisobservation, void *factor_list){
-    //get the $x\beta_j$ numerator for the appropriate choice:
-    size_t index   = find_index(gsl_vector_get(thisobservation->vector, 0), 
-                                factor_list, thisobservation->matrix->size2);
-    Apop_row_v(thisobservation, 0, thisrow);
-    double num = (index==0) ? 0 : gsl_vector_get(thisrow, index-1);
-
-    /* Get the denominator, ln(sum(exp(xbeta))) using the subtract-the-max trick 
-     mentioned in the documentation.  Don't forget the implicit beta_0, fixed at 
-     zero (so we need to add exp(0-max)). */
-
-    double max = gsl_vector_max(thisrow);
-    gsl_vector_add_constant(thisrow, -max);
-    apop_vector_exp(thisrow);
-    //return num - (max + log(apop_vector_sum(thisrow) +exp(-max)));
-    long double expmax = expl(-max);
-    return num - (max + (isfinite(expmax)? logl(apop_vector_sum(thisrow) +  expmax) : -max) );
+/* ln(sum(exp(xbeta))) uses the subtract-the-max trick mentioned in the documentation.
+   Don't forget the implicit beta_0, fixed at zero, which is why max starts at zero.
+   The gradient wrt the row's xbeta_j is [j is the choice] - P(j). */
+static double logit_row(double *xb, size_t cols, size_t choice, int want_grad){
+    double max = 0;
+    for (size_t j=0; j< cols; j++) max = GSL_MAX(max, xb[j]);
+    long double total = exp(-max);
+    for (size_t j=0; j< cols; j++) total += exp(xb[j]-max);
+    double log_denom = max + logl(total);
+    if (!want_grad) return (choice ? xb[choice-1] : 0) - log_denom;
+    for (size_t j=0; j< cols; j++)
+        xb[j] = (choice == j+1) - exp(xb[j] - log_denom);
+    return 0;
 }
 
 static long double multilogit_log_likelihood(apop_data *d, apop_model *p){
     Nullcheck_mpd(d, p, GSL_NAN)
-    Nullcheck(d->matrix, GSL_NAN)
-    //Find X\beta_i for each row of X and each column of \beta.
-    apop_data  *xbeta = apop_dot(d, p->parameters);
-    double* factor_list = get_category_table(p->data)->vector->data;
-    xbeta->vector = d->vector; //we'll need this in one_logit_row
-    long double ll = apop_map_sum(xbeta, .fn_rp = one_logit_row, .param=factor_list);
-    xbeta->vector = NULL;
-    apop_data_free(xbeta);
-	return ll;
-}
-
-/*
-static void dlogit_foreach(apop_data *x, apop_data *gmat, gsl_matrix *beta, apop_data *factor_list){
-  //\beta_this = choice for the row.
-  //dLL/d\beta_ij = [(\beta_i==\beta_this) ? x_j : 0] - x_i e^(x\beta_j)/\sum_k e^(x\beta_k)
-  //that last term simplifies: x / \sum_k e^(x(\beta_k - \beta_i))
-    Apop_row_v(x, 0, xdata);
-    assert(gmat->matrix->size1 == x->matrix->size2);     //the j index---input vars (incl. 1 column)
-    assert(gmat->matrix->size2 == beta->size2); //the i index---choices
-    assert(xdata->size == beta->size1);//cols of data=variables; rows of output=var.s (cols=choices)
-    size_t choice = find_index(gsl_vector_get(x->vector, 0), factor_list->vector->data, factor_list->vector->size);
-    for (int i=0; i < beta->size2; i++) { //go through choices.
-        gsl_vector *denom = gsl_vector_alloc(beta->size1);
-        gsl_vector_set_all(denom, 1); //see below
-        for (int other=-1; other < (int)beta->size2; other++){
-            if (other != i) { //this block calculates exp(x (otherbeta-thisbeta))
-                Apop_matrix_col(beta, i, thisbeta); 
-                gsl_vector *diff = apop_vector_copy(thisbeta);
-                gsl_vector_scale(diff, -1);
-                if (other >=0){//the phantom beta_0 == 0, so that term is e^x(0-beta|i)
-                    Apop_matrix_col(beta, other, otherbeta);
-                    gsl_vector_add(diff, otherbeta);
-                }
-                gsl_vector_mul(diff, xdata);
-                apop_vector_exp(diff);
-                gsl_vector_add(denom, diff);
-                gsl_vector_free(diff);
-            } //else, other==i, and \beta_i - \beta_i = 0, and e^{0x} = 1. Thus the gsl_vector_set_all(denom, 1).
-        }
-        for (int j=0; j< xdata->size; j++){ //add to each coefficient of the gradient matrix 
-            double pick = (choice-1 == i) ? gsl_vector_get(xdata,j) : 0; //numeraire has no betas.
-            *gsl_matrix_ptr(gmat->matrix, j, i) += pick - gsl_vector_get(xdata, j)/gsl_vector_get(denom, j));
-        }
-        gsl_vector_free(denom);
-    }
+    Nullcheck(d->matrix, GSL_NAN) Nullcheck(d->vector, GSL_NAN)
+    return choice_kernel(d, p, get_category_table(p->data)->vector, NULL, logit_row);
 }
 
 static void logit_dlog_likelihood(apop_data *d, gsl_vector *gradient, apop_model *p){
-    Nullcheck_mpd(d, p, );
-    apop_data *gradient_matrix = apop_data_calloc(p->parameters->matrix->size1, p->parameters->matrix->size2);
-    apop_data *cats = get_category_table(d);
-    for (int i=0; i< d->matrix->size1; i++)
-        dlogit_foreach(Apop_r(d, i), gradient_matrix, p->parameters->matrix, cats);
-    apop_data_pack(gradient_matrix, gradient);
-    apop_data_free(gradient_matrix);
+    Nullcheck_mpd(d, p, )
+    Nullcheck(d->matrix, ) Nullcheck(d->vector, )
+    choice_kernel(d, p, get_category_table(p->data)->vector, gradient, logit_row);
 }
-*/
 
 //Should this be available everywhere?
 static size_t get_draw_size(apop_model *in){
@@ -307,14 +258,15 @@ static int logit_rng(double *out, gsl_rng *r, apop_model *m){
                                 , .input_distribution= apop_estimate(m->data, apop_pmf));
 
     size_t datasize = get_draw_size(olp->input_distribution);
-    apop_data *x = apop_data_alloc(datasize);
+    apop_arena_begin();
+    apop_data *x = apop_arena_data(datasize);
     apop_draw(x->vector->data, r, olp->input_distribution);
 
-    apop_data *xbeta = apop_dot(x, m->parameters);
-    apop_data *zero = apop_data_calloc(1);
-    apop_data *xbeta_w_numeraire = apop_data_stack(zero, xbeta, 'r');
-    apop_data_free(xbeta);
-    apop_data_free(zero);
+    //X'β for the numeraire is zero; write the others in after it.
+    size_t cols = m->parameters->matrix->size2;
+    apop_data *xbeta_w_numeraire = apop_arena_data(cols+1);
+    gsl_vector_set(xbeta_w_numeraire->vector, 0, 0);
+    apop_dot(x, m->parameters, .out=&(apop_data){.vector=Apop_subvector(xbeta_w_numeraire->vector, 1, cols)});
     apop_vector_exp(xbeta_w_numeraire->vector);
     apop_vector_normalize(xbeta_w_numeraire->vector);
     xbeta_w_numeraire->weights = xbeta_w_numeraire->vector;
@@ -322,11 +274,12 @@ static int logit_rng(double *out, gsl_rng *r, apop_model *m){
 
     Staticdef(apop_model*, a_pmf, apop_model_copy(apop_pmf))
     a_pmf->dsize = 0; //so draws produce a row number
-    a_pmf->data = xbeta_w_numeraire;
-    Apop_stopif(apop_draw(out, r, a_pmf), return 1, 
+    apop_data_free(a_pmf->data); //the last call's; the PMF outlives the arena, so it gets a heap copy.
+    a_pmf->data = apop_data_copy(xbeta_w_numeraire);
+    Apop_stopif(apop_draw(out, r, a_pmf), apop_arena_end(); return 1, 
                         0, "Couldn't draw from a PMF populated using X'β.");
     if (m->dsize>1) memcpy(out+1, x->vector->data, datasize *sizeof(double));
-    apop_data_free(x);
+    apop_arena_end();
     return 0;
 }
 
@@ -384,5 +337,5 @@ A loop then calculates the customary p-values.
 \include logit.c
 */
 apop_model *apop_logit = &(apop_model){.name="Logit", .log_likelihood = multilogit_log_likelihood, .dsize=-1,
-/*.score = logit_dlog_likelihood,*/ .prep = logit_prep, .draw=logit_rng
+    .prep = logit_prep, .draw=logit_rng
 };
@@ -19,15 +19,15 @@ static double one_wishart_row(gsl_vector *in, void *ws_in){
     gsl_matrix *invparams_dot_data = gsl_matrix_alloc(ws->len, ws->len);
     apop_data *square= apop_data_alloc(ws->len, ws->len);
     apop_data_unpack(in, square);
-    double datadet = apop_matrix_determinant(square->matrix);
-    assert(datadet);
+    double logdatadet = apop_matrix_spd_logdet(square->matrix);
+    assert(isfinite(logdatadet));
 
     gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1, ws->paraminv, square->matrix, 0, invparams_dot_data);   
     gsl_vector_view diag = gsl_matrix_diagonal(invparams_dot_data);
     double trace = apop_sum(&diag.vector);
     gsl_matrix_free(invparams_dot_data);
     apop_data_free(square);
-    double out= log(datadet) * (ws->df - ws->len -1.)/2. - trace*ws->df/2.;
+    double out= logdatadet * (ws->df - ws->len -1.)/2. - trace*ws->df/2.;
     assert(isfinite(out));
     return out;
 }
@@ -35,16 +35,16 @@ static double one_wishart_row(gsl_vector *in, void *ws_in){
 static long double wishart_ll(apop_data *in, apop_model *m){
     Nullcheck_mpd(in, m, GSL_NAN);
     wishartstruct_t ws = {
-            .paraminv = apop_matrix_inverse(m->parameters->matrix),
+            .paraminv = apop_matrix_spd_inverse(m->parameters->matrix),
             .len = sqrt(in->matrix->size2),
             .df = m->parameters->vector->data[0]
         };
-    double paramdet = apop_matrix_determinant(m->parameters->matrix);
-    if (paramdet < 1e-3) return GSL_NEGINF;
+    double logparamdet = apop_matrix_spd_logdet(m->parameters->matrix);
+    if (!(logparamdet >= log(1e-3))) return GSL_NEGINF;
     double ll =  apop_map_sum(in, .fn_vp = one_wishart_row, .param=&ws, .part='r');
     double k = log(ws.df)*ws.df/2.;
     k -= M_LN2 * ws.len* ws.df/2.;
-    k -= log(paramdet) * ws.df/2.;
+    k -= logparamdet * ws.df/2.;
     k -= apop_multivariate_lngamma(ws.df/2., ws.len);
     return ll + k*in->matrix->size1;
 }
@@ -252,6 +252,35 @@ void test_crosstabbing() {
     assert(apop_query_to_float("select val from ct where r='r1' and c='c0'")==2);
 }
 
+void test_crosstab_numeric_labels(){
+    apop_data *raw = apop_text_alloc(apop_data_alloc(200, 2), 200, 1);
+    apop_name_add(raw->names, "n", 'c');
+    apop_name_add(raw->names, "v", 'c');
+    apop_name_add(raw->names, "t", 't');
+    for (int i=0; i< 200; i++){
+        apop_data_set(raw, i, 0, (i*7)%12);
+        apop_data_set(raw, i, 1, i);
+        apop_text_set(raw, i, 0, "k%c", 'a' + i%3);
+    }
+    apop_table_exists("ctnum", 'd');
+    apop_data_to_db(raw, "ctnum", 'w');
+    apop_data *from_db = apop_db_to_crosstab("ctnum", "n", "t", "sum(v)");
+    apop_data *in_mem = apop_data_to_crosstab(raw, .row=0, .row_type='d', .col=0, .data=1);
+    assert(from_db->matrix->size1 == 12 && from_db->matrix->size2 == 3);
+    assert(!strcmp(from_db->names->row[10], "10")); //numbers sort as numbers, not text
+    for (int i=0; i< 12; i++){
+        assert(!strcmp(from_db->names->row[i], in_mem->names->row[i]));
+        for (int j=0; j< 3; j++)
+            assert(gsl_matrix_get(from_db->matrix, i, j) == gsl_matrix_get(in_mem->matrix, i, j));
+    }
+    apop_data *counts = apop_data_to_crosstab(raw, .row=0, .row_type='d', .col=0);
+    assert(apop_matrix_sum(counts->matrix) == 200);
+    apop_data_free(raw);
+    apop_data_free(from_db);
+    apop_data_free(in_mem);
+    apop_data_free(counts);
+}
+
 #define do_test(text, fn) {if (verbose) printf("%s:", text); \
                           fflush(NULL);                      \
                           fn;                                \
@@ -264,5 +293,6 @@ int main(){
     do_test("NaN handling", test_nan_data());
     do_test("test printing", test_printing());
     do_test("test db to crosstab", test_crosstabbing());
+    do_test("crosstab with numeric labels", test_crosstab_numeric_labels());
     apop_db_close();
 }
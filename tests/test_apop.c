@@ -154,6 +154,469 @@ void test_score(){
     apop_data_free(data);
 }
 
+/* A normal log likelihood with sigma on a second page, whose vector is swapped for a copy
+   on every call. The top-level parameter pointers never change, so the MLE has to look
+   below them to see that its cached layout is stale. */
+static long double swapped_page_ll(apop_data *d, apop_model *m){
+    apop_data *sigma_page = m->parameters->more;
+    double mu = m->parameters->vector->data[0], sigma = fabs(sigma_page->vector->data[0]);
+    gsl_vector *old = sigma_page->vector;
+    sigma_page->vector = apop_vector_copy(old);
+    gsl_vector_free(old);
+    long double ll = 0;
+    for (size_t i=0; i< d->matrix->size1; i++)
+        ll += log(gsl_ran_gaussian_pdf(gsl_matrix_get(d->matrix, i, 0) - mu, sigma));
+    return ll;
+}
+
+void test_mle_layout_change(gsl_rng *r){
+    int len = 2000;
+    apop_data *data = apop_data_alloc(len, 1);
+    for (size_t j=0; j< len; j++) apop_data_set(data, j, 0, 3 + gsl_ran_gaussian(r, 2));
+    apop_model *m = apop_model_copy(&(apop_model){.name="Normal, sigma on its own page",
+                                          .vsize=1, .log_likelihood=swapped_page_ll});
+    Apop_model_add_group(m, apop_mle, .method="NM simplex");
+    Apop_model_add_group(m, apop_parts_wanted);
+    apop_prep(data, m);
+    apop_data_add_page(m->parameters, apop_data_alloc(1), "sigma");
+    apop_maximum_likelihood(data, m);
+    assert(!m->error);
+    Diff(m->parameters->vector->data[0], 3, tol1);
+    Diff(fabs(m->parameters->more->vector->data[0]), 2, tol1);
+    apop_model_free(m);
+    apop_data_free(data);
+}
+
+void test_multistart(gsl_rng *r){
+    int len = 2000;
+    apop_data *data = apop_data_alloc(len, 1);
+    apop_model *source = apop_model_set_parameters(apop_normal, 3, 2);
+    for (size_t j=0; j< len; j++)
+        apop_draw(gsl_matrix_ptr(data->matrix, j, 0), r, source);
+    apop_model *estme = apop_model_copy(apop_normal);
+    Apop_model_add_group(estme, apop_mle, .starts=5, .start_range=.5, .method="NM simplex");
+    Apop_model_add_group(estme, apop_parts_wanted);
+    apop_prep(data, estme);
+    int seed = apop_opts.rng_seed;
+    apop_maximum_likelihood(data, estme);
+    assert(apop_opts.rng_seed == seed); //the searches' RNGs are seeded locally
+    assert(!estme->error);
+    Diff(estme->parameters->vector->data[0], 3, tol1);
+    Diff(estme->parameters->vector->data[1], 2, tol1);
+
+    apop_data *ends = apop_data_get_page(estme->info, "<Multistart>");
+    assert(ends && ends->matrix->size1 == 5 && ends->matrix->size2 == 2);
+    Diff(gsl_vector_max(ends->vector), apop_data_get(estme->info, .rowname="log likelihood"), 1e-6);
+
+    //A start list with no rows is an error, not a search.
+    apop_model *nostarts = apop_model_copy(apop_normal);
+    apop_data empty = {.matrix=&(gsl_matrix){.size1=0, .size2=2, .tda=2}};
+    Apop_model_add_group(nostarts, apop_mle, .start_list=&empty, .method="NM simplex");
+    apop_prep(data, nostarts);
+    int verbosity = apop_opts.verbose;
+    apop_opts.verbose = -1;
+    apop_maximum_likelihood(data, nostarts);
+    apop_opts.verbose = verbosity;
+    assert(nostarts->error == 's');
+    apop_model_free(nostarts);
+    apop_model_free(estme);
+    apop_model_free(source);
+    apop_data_free(data);
+}
+
+void test_dim_cycle_blocks(gsl_rng *r){
+    int len = 2000;
+    apop_data *data = apop_data_alloc(len, 1);
+    apop_model *source = apop_model_set_parameters(apop_normal, 3, 2);
+    for (size_t j=0; j< len; j++)
+        apop_draw(gsl_matrix_ptr(data->matrix, j, 0), r, source);
+    apop_model *estme = apop_model_copy(apop_normal);
+    Apop_model_add_group(estme, apop_mle, .dim_cycle_tolerance=1e-3, .dim_cycle_blocks=2,
+                                          .method="NM simplex");
+    Apop_model_add_group(estme, apop_parts_wanted, .info='y');
+    apop_prep(data, estme);
+    apop_maximum_likelihood(data, estme);
+    Diff(estme->parameters->vector->data[0], 3, tol1);
+    Diff(estme->parameters->vector->data[1], 2, tol1);
+    Diff(apop_log_likelihood(data, estme), apop_data_get(estme->info, .rowname="log likelihood"), 1e-6);
+    assert(Apop_settings_get(estme, apop_mle, dim_cycle_tolerance) == 1e-3);
+    apop_model_free(estme);
+    apop_model_free(source);
+    apop_data_free(data);
+}
+
+void test_fisher_batch(){
+    apop_data *tables = apop_data_falloc((2, 3), 30, 50, 45, 
+                                                 34, 12, 17 );
+    apop_data_add_page(tables, apop_data_falloc((2, 2), 3, 1,
+                                                        1, 3), "tea");
+    apop_data_add_page(tables, apop_data_falloc((3, 7), 1, 8, 5, 4, 4, 2, 2,
+                                                        5, 3, 3, 4, 3, 1, 0,
+                                                       10, 1, 4, 0, 0, 0, 0), "wide");
+    apop_data *out = apop_test_fisher_exact_batch(tables);
+    assert(!out->error);
+    assert(out->matrix->size1 == 3);
+    Diff(apop_data_get(out, 0, .colname="p value"), 0.0001761, 1e-6);
+    Diff(apop_data_get(out, .rowname="tea", .colname="p value"), 0.4857143, 1e-6);
+    int i = 0;
+    for (apop_data *t=tables; t; t=t->more, i++){
+        apop_data *one = apop_test_fisher_exact(t);
+        Diff(apop_data_get(one, .rowname="p value"), apop_data_get(out, i, 1), 1e-10);
+        Diff(apop_data_get(one, .rowname="probability of table"), apop_data_get(out, i, 0), 1e-10);
+        apop_data_free(one);
+    }
+    apop_data_free(out);
+    apop_data_free(tables);
+
+    /* This table overflows the first two workspace sizes (200,000 and 400,000 ints), so
+       the test has to grow the workspace twice, right after a call that didn't need to.
+       The p value is from a single run with a large workspace. */
+    apop_data *small = apop_data_falloc((2, 2), 3, 1,
+                                                1, 3);
+    apop_data *big = apop_data_falloc((5, 5), 5, 2, 3, 4, 1,
+                                              3, 6, 2, 1, 3,
+                                              2, 3, 7, 3, 2,
+                                              4, 1, 2, 6, 4,
+                                              1, 4, 2, 2, 5);
+    apop_data *first = apop_test_fisher_exact(small), *grown = apop_test_fisher_exact(big),
+              *again = apop_test_fisher_exact(small);
+    assert(!grown->error);
+    Diff(apop_data_get(grown, .rowname="p value"), 0.234098412, 1e-8);
+    Diff(apop_data_get(grown, .rowname="probability of table"), 2.09953e-12, 1e-16);
+    Diff(apop_data_get(again, .rowname="p value"), apop_data_get(first, .rowname="p value"), 1e-12);
+    apop_data_free(first); apop_data_free(grown); apop_data_free(again);
+    apop_data_free(small); apop_data_free(big);
+}
+
+void test_sketch(gsl_rng *r){
+    int n = 20000;
+    apop_data *d = apop_data_alloc(n, 2);
+    for (int i=0; i< n; i++){
+        apop_data_set(d, i, 0, gsl_rng_uniform(r)*100);
+        apop_data_set(d, i, 1, gsl_ran_gaussian(r, 3) + (i%2 ? 50 : -50));
+    }
+    apop_data *exact = apop_data_summarize(d);
+    apop_data *sketched = apop_data_summarize(d, .error=0.01);
+    for (int j=0; j< 6; j++) if (j!=4){
+        Diff(apop_data_get(exact, 0, j), apop_data_get(sketched, 0, j), 1e-8);
+        Diff(apop_data_get(exact, 1, j), apop_data_get(sketched, 1, j), 1e-8);
+    }
+    double *pctiles = apop_vector_percentiles(Apop_cv(d, 0));
+    Diff(apop_data_get(exact, 0, .colname="median"), pctiles[50], 1e-10);
+    Diff(apop_data_get(exact, 0, .colname="min"), pctiles[0], 1e-10);
+    Diff(apop_data_get(exact, 0, .colname="max"), pctiles[100], 1e-10);
+
+    //two half-sketches, merged, should be within the rank error of the exact percentiles.
+    apop_sketch *first = apop_sketch_alloc(.01), *second = apop_sketch_alloc(.01);
+    for (int i=0; i< n; i++) apop_sketch_add(i < n/2 ? first : second, apop_data_get(d, i, 0));
+    apop_sketch_merge(first, second);
+    assert(first->n == n);
+    Diff(apop_sketch_mean(first), apop_data_get(exact, 0, .colname="mean"), 1e-8);
+    Diff(apop_sketch_var(first), apop_data_get(exact, 0, .colname="variance"), 1e-6);
+    for (int q=5; q< 100; q+=5)
+        assert(fabs(apop_sketch_quantile(first, q/100.) - pctiles[q]) < 100*0.03);
+    apop_sketch_free(first);
+    apop_sketch_free(second);
+    free(pctiles);
+    apop_data_free(exact);
+    apop_data_free(sketched);
+
+    //a NaN makes every statistic for its column NaN, sketched or not; the other column is untouched.
+    apop_data_set(d, 17, 1, GSL_NAN);
+    for (int k=0; k< 2; k++){
+        apop_data *withnan = apop_data_summarize(d, .error= k ? 0.01 : 0);
+        for (int j=0; j< 6; j++){
+            assert(gsl_isnan(apop_data_get(withnan, 1, j)));
+            assert(!gsl_isnan(apop_data_get(withnan, 0, j)));
+        }
+        apop_data_free(withnan);
+    }
+    apop_data_free(d);
+}
+
+void test_ks_vectors(){
+    int n = 100;
+    gsl_vector *x = gsl_vector_alloc(n), *y = gsl_vector_alloc(n);
+    for (int i=0; i< n; i++){
+        gsl_vector_set(x, (i*37)%n, i); //a permutation, so x is unsorted.
+        gsl_vector_set(y, i, i+10);
+    }
+    apop_data *exact = apop_test_kolmogorov_vector(x, y, .exact='y');
+    apop_data *approx = apop_test_kolmogorov_vector(x, y, .exact='n');
+    Diff(apop_data_get(exact, .rowname="max distance"), 0.1, 1e-10);
+    Diff(apop_data_get(exact, .rowname="p value, 2 tail"), apop_data_get(approx, .rowname="p value, 2 tail"), 0.05);
+
+    //evenly-spaced Normal quantiles should have distance 1/2n from the Normal CDF,
+    //whether the CDF is closed-form or by sorted random draws.
+    for (int i=0; i< n; i++) gsl_vector_set(x, i, gsl_cdf_gaussian_Pinv((i+.5)/n, 1));
+    apop_model *n01 = apop_model_set_parameters(apop_normal, 0, 1);
+    apop_data *one = apop_test_kolmogorov_vector(x, .reference=n01);
+    Diff(apop_data_get(one, .rowname="max distance"), 0.5/n, 1e-8);
+    assert(apop_data_get(one, .rowname="p value, 2 tail") > 0.99);
+    apop_model *by_draws = apop_model_copy(n01);
+    by_draws->cdf = NULL;
+    apop_data *drawn = apop_test_kolmogorov_vector(x, .reference=by_draws);
+    assert(apop_data_get(drawn, .rowname="max distance") < 0.03);
+    apop_data_free(exact); apop_data_free(approx);
+    apop_data_free(one); apop_data_free(drawn);
+
+    //A weighted PMF against a closed-form model takes the original one-sample path; the
+    //p-value here is the one from the exact distribution for n=8 that it always gave.
+    apop_data *w = apop_data_falloc((8), -0.6, 0.2, 0.7, 1.0, 1.3, 1.8, 2.2, 2.9);
+    w->weights = gsl_vector_alloc(8);
+    gsl_vector_set_all(w->weights, 1./8);
+    apop_model *pmf = apop_estimate(w, apop_pmf);
+    apop_data *weighted = apop_test_kolmogorov(pmf, n01);
+    Diff(apop_data_get(weighted, .rowname="max distance"), 0.383036347776927, 1e-10);
+    Diff(apop_data_get(weighted, .rowname="p value, 2 tail"), 0.145233289070318, 1e-10);
+    apop_data_free(weighted);
+    apop_model_free(pmf);
+    apop_data_free(w);
+    apop_model_free(n01); apop_model_free(by_draws);
+    gsl_vector_free(x); gsl_vector_free(y);
+}
+
+static long double mvn_ll_by_another_name(apop_data *d, apop_model *m){
+    return apop_multivariate_normal->log_likelihood(d, m);
+}
+
+void test_mvn_impute(){
+    apop_model *mvn = apop_model_copy(apop_multivariate_normal);
+    mvn->parameters = apop_data_falloc((2, 2, 2), 1, 2, 1,
+                                                  2, 1, 2);
+    apop_data *d = apop_data_falloc((5, 2), NAN, 4,
+                                            3, NAN,
+                                            NAN, NAN,
+                                            7, 8,
+                                            NAN, 0);
+    apop_model *used = apop_ml_impute(d, mvn);
+    for (int i=0; i< 5; i++) for (int j=0; j< 2; j++)
+        assert(!gsl_isnan(apop_data_get(d, i, j)));
+    Diff(apop_data_get(d, 0, 0), 2, 1e-10);  //1 + (1/2)(4-2)
+    Diff(apop_data_get(d, 1, 1), 3, 1e-10);  //2 + (1/2)(3-1)
+    Diff(apop_data_get(d, 2, 0), 1, 1e-10);
+    Diff(apop_data_get(d, 2, 1), 2, 1e-10);
+    Diff(apop_data_get(d, 4, 0), 0, 1e-10);  //1 + (1/2)(0-2)
+    assert(apop_data_get(d, 3, 1) == 8);
+    apop_model_free(used);
+
+    //The same model under another log likelihood function isn't recognized as a Normal,
+    //so it takes the row-by-row search, which should land on the same conditional means.
+    apop_model *disguised = apop_model_copy(mvn);
+    disguised->log_likelihood = mvn_ll_by_another_name;
+    apop_data *d2 = apop_data_falloc((5, 2), NAN, 4,
+                                             3, NAN,
+                                             NAN, NAN,
+                                             7, 8,
+                                             NAN, 0);
+    used = apop_ml_impute(d2, disguised);
+    assert(used->log_likelihood == mvn_ll_by_another_name);
+    for (int i=0; i< 5; i++) for (int j=0; j< 2; j++)
+        Diff(apop_data_get(d2, i, j), apop_data_get(d, i, j), 1e-3);
+    apop_model_free(used);
+    apop_model_free(disguised);
+    apop_data_free(d2);
+    apop_model_free(mvn);
+    apop_data_free(d);
+}
+
+void test_arena(){
+    apop_arena_begin();
+    apop_data *outer = apop_arena_data(3, 2, 2);
+    gsl_vector_set_all(outer->vector, 1);
+    gsl_matrix_set_all(outer->matrix, 2);
+    for (int i=0; i< 100; i++){ //an inner scope releases only its own allocations
+        apop_arena_begin();
+        gsl_matrix *big = apop_arena_matrix(200, 100); //bigger than one chunk
+        gsl_matrix_set_all(big, i);
+        assert(gsl_matrix_get(big, 199, 99) == i);
+        apop_arena_end();
+    }
+    assert(apop_sum(outer->vector) == 3);
+    assert(apop_matrix_sum(outer->matrix) == 8);
+    apop_arena_end();
+
+    //a set's names are their own allocation, so they can outlive the set.
+    apop_data *d = apop_data_alloc(2, 2);
+    apop_name_add(d->names, "c0", 'c');
+    apop_name *keep = d->names;
+    d->names = NULL;
+    apop_data_free(d);
+    assert(!strcmp(keep->col[0], "c0"));
+    apop_name_free(keep);
+}
+
+void test_shared_copy(){
+    apop_data *d = apop_text_alloc(apop_data_alloc(3), 3, 2);
+    for (int i=0; i< 3; i++){
+        apop_data_set(d, i, -1, 3-i);
+        apop_text_set(d, i, 0, "row %i", i);
+        apop_name_add(d->names, (char*[]){"a", "b", "c"}[i], 'r');
+    }
+    apop_data *c = apop_data_copy(d);
+    assert(c->text == d->text);
+    assert(c->names->row == d->names->row);
+
+    //writing to either side detaches it.
+    apop_text_set(c, 0, 0, "changed");
+    assert(c->text != d->text);
+    assert(!strcmp(d->text[0][0], "row 0"));
+    apop_name_add(d->names, "d", 'r');
+    assert(c->names->rowct == 3 && d->names->rowct == 4);
+    assert(apop_name_find(c->names, "c", 'r') == 2);
+
+    //sorting a copy leaves the original alone.
+    apop_data *c2 = apop_data_copy(c);
+    apop_data_sort(c2);
+    assert(!strcmp(c2->text[0][0], "row 2"));
+    assert(!strcmp(c->text[2][0], "row 2"));
+    assert(!strcmp(c->names->row[0], "a"));
+
+    apop_data *c3 = apop_data_copy(c);
+    apop_data_unshare(c3);
+    apop_text_set(Apop_r(c3, 1), 0, 1, "via a view");
+    assert(!strlen(c->text[1][1]));
+
+    //making a view leaves the viewed set alone, so a read-only view of a copy is free...
+    apop_data *c4 = apop_data_copy(c3);
+    assert(!strcmp(Apop_r(c4, 1)->text[0][0], "row 1") && Apop_r(c4, 0)->names->row[0]);
+    assert(c4->text == c3->text && c4->names->row == c3->names->row);
+
+    //...and a write via a view of a set still sharing its text is refused.
+    assert(apop_text_set(Apop_r(c4, 1), 0, 0, "c4 via a view") == -1);
+    assert(!strcmp(c3->text[1][0], "row 1"));
+    apop_data_unshare(c4);
+    apop_text_set(Apop_r(c4, 1), 0, 0, "c4 via a view");
+    apop_text_set(Apop_rs(c3, 1, 2), 1, 0, "c3 via a view"); //overwrites a pooled cell
+    assert(!strcmp(c3->text[1][0], "row 1") && !strcmp(c3->text[2][0], "c3 via a view"));
+    assert(!strcmp(c4->text[1][0], "c4 via a view") && !strcmp(c4->text[2][0], "row 2"));
+
+    //row names written via a view need the unshare first.
+    apop_data *c5 = apop_data_copy(c4);
+    apop_data_unshare(c5);
+    free(Apop_r(c5, 0)->names->row[0]);
+    Apop_r(c5, 0)->names->row[0] = strdup("via a row view");
+    assert(!strcmp(c4->names->row[0], "a") && !strcmp(c5->names->row[0], "via a row view"));
+    apop_data *m = apop_data_alloc(2, 2);
+    apop_name_add(m->names, "r0", 'r');
+    apop_name_add(m->names, "r1", 'r');
+    apop_data *mcopy = apop_data_copy(m);
+    apop_data_unshare(mcopy);
+    free(Apop_c(mcopy, 1)->names->row[1]);
+    Apop_c(mcopy, 1)->names->row[1] = strdup("via a column view");
+    assert(!strcmp(m->names->row[1], "r1"));
+    apop_data_free(m);
+    apop_data_free(mcopy);
+    apop_data_free(c5);
+    apop_data_free(c4);
+    apop_data_free(d);  //the others still hold their shared parts.
+    apop_data_free(c);
+    assert(!strcmp(c2->names->row[2], "a"));
+    apop_data_free(c2);
+    apop_data_free(c3);
+}
+
+void test_text_pack(){
+    apop_data *d = apop_text_alloc(apop_data_alloc(), 2000, 2);
+    for (int i=0; i< 2000; i++){
+        apop_text_set(d, i, 0, "group %i", i%5);
+        apop_text_set(d, i, 1, "id %i", i);
+    }
+    apop_data *classic = apop_data_copy(d);
+    apop_text_pack(d, .dictionary='y');
+    assert(d->text[0][0] == d->text[5][0]); //one copy per distinct string
+    for (int i=0; i< 2000; i++){
+        assert(!strcmp(d->text[i][0], classic->text[i][0]));
+        assert(!strcmp(d->text[i][1], classic->text[i][1]));
+    }
+
+    //still writable and resizable, via the set or a view.
+    apop_text_set(d, 0, 0, "new");
+    apop_text_set(Apop_r(d, 1), 0, 0, "via view");
+    apop_text_alloc(d, 2001, 3);
+    apop_text_set(d, 2000, 2, "corner");
+    assert(!strcmp(d->text[0][0], "new") && !strcmp(d->text[1][0], "via view"));
+    assert(!strcmp(d->text[1999][1], "id 1999") && !strlen(d->text[1999][2]));
+    apop_data_transpose(d);
+    assert(!strcmp(d->text[2][2000], "corner"));
+    apop_data_free(d);
+    apop_data_free(classic);
+}
+
+void test_factor_hash(){
+    //enough rows for several blocks, and more categories than the old linear search would tolerate.
+    int n = 70000;
+    apop_data *d = apop_text_alloc(apop_data_alloc(n, 2), n, 1);
+    for (int i=0; i< n; i++){
+        apop_text_set(d, i, 0, "k%i", (i*7919)%3000);
+        apop_data_set(d, i, 0, (i*31)%500 - 250);
+        apop_data_set(d, i, 1, i%11 ? i%4 : GSL_NAN);
+    }
+    apop_data *f = apop_data_to_factors(d, .intype='t', .incol=0, .outcol=0);
+    assert(f->textsize[0] == 3000);
+    for (int i=1; i< 3000; i++) assert(strcmp(f->text[i-1][0], f->text[i][0]) < 0);
+    for (int i=0; i< n; i+=97) assert(!strcmp(f->text[(int)apop_data_get(d, i, 0)][0], d->text[i][0]));
+
+    gsl_vector *u = apop_vector_unique_elements(Apop_cv(d, 1));
+    assert(u->size == 5 && gsl_vector_get(u, 3) == 3 && gsl_isnan(gsl_vector_get(u, 4)));
+    gsl_vector_free(u);
+    apop_data *dum = apop_data_to_dummies(d, 1, 'd', .keep_first='y');
+    assert(dum->matrix->size2 == 5);
+    assert(apop_sum(Apop_cv(dum, 4)) == (n+10)/11);
+    assert(apop_matrix_sum(dum->matrix) == n);
+    apop_data_free(dum);
+
+    //A value missing from the existing factor list is appended to the end of it.
+    apop_text_set(d, 5, 0, "a new one");
+    f = apop_data_to_factors(d, .intype='t', .incol=0, .outcol=0);
+    assert(f->textsize[0] == 3001 && !strcmp(f->text[3000][0], "a new one"));
+    assert(apop_data_get(d, 5, 0) == 3000);
+    apop_data_free(d);
+}
+
+void test_histogram(gsl_rng *r){
+    apop_data *d = apop_data_alloc(1000, 2);
+    for (int i=0; i< 1000; i++){
+        apop_data_set(d, i, 0, gsl_rng_uniform(r)*10);
+        apop_data_set(d, i, 1, i%3);
+    }
+    apop_data *h = apop_data_histogram(d);
+    apop_data *b = apop_data_to_bins(d);
+    apop_data_sort(apop_data_pmf_compress(b));
+    assert(h->matrix->size1 == b->matrix->size1);
+    for (int i=0; i< h->matrix->size1; i++){
+        Diff(apop_data_get(h, i, 0), apop_data_get(b, i, 0), 1e-10);
+        Diff(apop_data_get(h, i, 1), apop_data_get(b, i, 1), 1e-10);
+        Diff(gsl_vector_get(h->weights, i), gsl_vector_get(b->weights, i), 1e-10);
+    }
+    assert(apop_data_get_page(h, "<binspec>"));
+
+    //with a binspec and the default close_top_bin='n', the two still agree.
+    apop_data *spec = apop_data_falloc((1, 2), 2, 2);
+    apop_data *hs = apop_data_histogram(d, spec);
+    apop_data *bs = apop_data_to_bins(d, spec);
+    apop_data_sort(apop_data_pmf_compress(bs));
+    assert(hs->matrix->size1 == bs->matrix->size1);
+    for (int i=0; i< hs->matrix->size1; i++){
+        Diff(apop_data_get(hs, i, 0), apop_data_get(bs, i, 0), 1e-10);
+        Diff(apop_data_get(hs, i, 1), apop_data_get(bs, i, 1), 1e-10);
+        Diff(gsl_vector_get(hs->weights, i), gsl_vector_get(bs->weights, i), 1e-10);
+    }
+    apop_data_free(hs);
+    apop_data_free(bs);
+    apop_data_free(spec);
+
+    //a grid far too big for a dense array goes through the hash tables.
+    apop_data *fine = apop_data_histogram(d, apop_data_falloc((1, 2), 1e-6, 1e-6));
+    assert(fine->matrix->size1 == 1000);
+    assert(apop_sum(fine->weights) == 1000);
+    assert(!apop_data_get_page(fine, "<binspec>"));
+    apop_data_free(fine);
+    apop_data_free(h);
+    apop_data_free(b);
+    apop_data_free(d);
+}
+
 void test_normalizations(gsl_vector *v){
     //let's check out normalizations, while we have a vector for it
     gsl_vector_scale(v, 23);
@@ -193,6 +656,74 @@ void test_skew_and_kurt(gsl_rng *r){
     gsl_vector_free(v);
 }
 
+static int drop_multiples_of_three(apop_data *onerow, void *ignore){
+    return !((int)apop_data_get(onerow, .col=-1) % 3);
+}
+
+void test_row_compaction(){
+    int n = 1000;
+    apop_data *d = apop_text_alloc(apop_data_alloc(n, n, 3), n, 2);
+    d->weights = gsl_vector_alloc(n);
+    for (int i=0; i< n; i++){
+        apop_data_set(d, i, -1, i);
+        for (int j=0; j< 3; j++) apop_data_set(d, i, j, i*10+j);
+        gsl_vector_set(d->weights, i, i/2.);
+        apop_text_set(d, i, 0, "%i", i);
+        apop_text_set(d, i, 1, "row %i", i);
+        char name[20];
+        sprintf(name, "r%i", i);
+        apop_name_add(d->names, name, 'r');
+    }
+    //NaNs in the matrix, vector, weights, and text, in runs and alone
+    for (int i=100; i< 150; i++) apop_data_set(d, i, 2, GSL_NAN);
+    apop_data_set(d, 7, -1, GSL_NAN);
+    gsl_vector_set(d->weights, 999, GSL_NAN);
+    apop_text_set(d, 500, 1, "nan"); //apop_opts.nan_string defaults to NaN, case-insensitive
+    apop_data *clean = apop_data_listwise_delete(d);
+    assert(clean->matrix->size1 == n-53 && clean->vector->size == n-53);
+    assert(clean->weights->size == n-53 && clean->textsize[0] == n-53);
+    assert(clean->names->rowct == n-53);
+    int j = 0;
+    for (int i=0; i< n; i++){
+        if (i==7 || (i>=100 && i<150) || i==500 || i==999) continue;
+        assert(apop_data_get(clean, j, -1) == i && apop_data_get(clean, j, 1) == i*10+1);
+        assert(gsl_vector_get(clean->weights, j) == i/2.);
+        assert(atoi(clean->text[j][0]) == i && !strcmp(clean->names->row[j], d->names->row[i]));
+        j++;
+    }
+    assert(d->matrix->size1 == n && gsl_isnan(apop_data_get(d, 7, -1))); //the original is untouched
+
+    apop_data *inplace = apop_data_copy(clean);
+    assert(apop_data_listwise_delete(inplace, 'y') == inplace);
+    assert(inplace->matrix->size1 == n-53);
+    apop_data_rm_rows(inplace, .do_drop=drop_multiples_of_three);
+    for (int i=0; i< inplace->matrix->size1; i++){
+        int orig = apop_data_get(inplace, i, -1);
+        assert(orig % 3 && apop_data_get(inplace, i, 2) == orig*10+2);
+        assert(atoi(inplace->text[i][0]) == orig);
+        assert(atoi(inplace->names->row[i]+1) == orig);
+    }
+    assert(inplace->names->rowct == inplace->matrix->size1 && inplace->textsize[0] == inplace->matrix->size1);
+    assert(clean->names->rowct == n-53 && atoi(clean->text[3][0]) == 3); //the copy is untouched
+
+    //Views share their rows with the parent, so removing rows from one is refused.
+    int verbosity = apop_opts.verbose;
+    apop_opts.verbose = -1;
+    double v10 = apop_data_get(clean, 10, -1), v11 = apop_data_get(clean, 11, -1);
+    int drop_first[20] = {1};
+    apop_data *rows = Apop_rs(clean, 10, 20);
+    assert(apop_data_rm_rows(rows, drop_first)->error == 'v');
+    assert(rows->matrix->size1 == 20 && rows->vector && rows->textsize[0] == 20);
+    apop_data *cols = Apop_cs(clean, 0, 2);
+    assert(apop_data_rm_rows(cols, drop_first)->error == 'v' && cols->matrix);
+    apop_opts.verbose = verbosity;
+    assert(apop_data_get(clean, 10, -1) == v10 && apop_data_get(clean, 11, -1) == v11);
+    assert(clean->matrix->size1 == n-53 && atoi(clean->text[10][0]) == v10);
+    apop_data_free(inplace);
+    apop_data_free(clean);
+    apop_data_free(d);
+}
+
 void test_listwise_delete(){
   apop_data *t1 = apop_data_calloc(10,10);
   apop_text_alloc(t1, 10, 10);
@@ -440,6 +971,72 @@ void test_split_and_stack(gsl_rng *r){
     apop_data_free(nulldata);
 }
 
+void test_split_views(){
+    //many small in-place stacks onto one set
+    apop_data *grow = NULL;
+    apop_data *batch = apop_data_alloc(4, 4, 3);
+    for (int b=0; b< 200; b++){
+        gsl_matrix_set_all(batch->matrix, b);
+        gsl_vector_set_all(batch->vector, -b);
+        grow = apop_data_stack(grow, batch, .inplace='y');
+    }
+    assert(grow->matrix->size1 == 800 && grow->matrix->size2 == 3);
+    assert(grow->vector->size == 800);
+    for (int b=0; b< 200; b++)
+        assert(apop_data_get(grow, 4*b+3, 2) == b && apop_data_get(grow, 4*b, -1) == -b);
+    apop_data *side = apop_data_alloc(800, 800, 2);
+    gsl_vector_set_all(side->vector, 1);
+    gsl_matrix_set_all(side->matrix, 2);
+    apop_data_stack(grow, side, .posn='c', .inplace='y');
+    assert(grow->matrix->size2 == 6); //side's vector is column 3, its matrix columns 4 and 5
+    assert(apop_data_get(grow, 799, 2) == 199 && apop_data_get(grow, 799, -1) == -199);
+    assert(apop_data_get(grow, 799, 3) == 1 && apop_data_get(grow, 0, 5) == 2);
+    apop_data_free(grow);
+    apop_data_free(batch);
+    apop_data_free(side);
+
+    apop_data *d = apop_text_alloc(apop_data_alloc(6, 6, 2), 6, 1);
+    apop_name_add(d->names, "v", 'v');
+    apop_name_add(d->names, "c0", 'c');
+    apop_name_add(d->names, "c1", 'c');
+    for (int i=0; i< 6; i++){
+        apop_data_set(d, i, -1, i);
+        apop_data_set(d, i, 0, 10*i);
+        apop_data_set(d, i, 1, 100*i);
+        apop_text_set(d, i, 0, "t%i", i);
+        char rowname[10];
+        sprintf(rowname, "r%i", i);
+        apop_name_add(d->names, rowname, 'r');
+    }
+    apop_data **rows = apop_data_split(d, 2, 'r', .view='y');
+    assert(rows[0]->matrix->size1 == 2 && rows[1]->matrix->size1 == 4);
+    assert(rows[1]->textsize[0] == 4 && !strcmp(rows[1]->text[0][0], "t2"));
+    assert(rows[1]->names->rowct == 4 && !strcmp(rows[1]->names->row[3], "r5"));
+    assert(!strcmp(rows[0]->names->col[1], "c1") && !strcmp(rows[0]->names->vector, "v"));
+    apop_data_set(rows[1], 0, 1, -7);
+    assert(apop_data_get(d, 2, 1) == -7); //writes go through to the parent
+    apop_data *copied = apop_data_copy(rows[1]);
+    apop_data_set(copied, 0, 1, 7);
+    assert(apop_data_get(d, 2, 1) == -7);
+    apop_name_add(rows[1]->names, "r6", 'r'); //detaches the view's names from d's
+    assert(d->names->rowct == 6 && rows[1]->names->rowct == 5);
+
+    apop_data **cols = apop_data_split(d, 1, 'c', .view='y');
+    assert(cols[0]->vector && cols[0]->matrix->size2 == 1 && !cols[1]->vector);
+    assert(apop_data_get(cols[1], 5, 0) == 500 && !strcmp(cols[1]->names->col[0], "c1"));
+    assert(!strcmp(cols[1]->names->row[4], "r4"));
+
+    for (int i=0; i< 2; i++){
+        apop_data_free(rows[i]);
+        apop_data_free(cols[i]);
+    }
+    free(rows); free(cols);
+    assert(apop_data_get(copied, 3, 0) == 50 && !strcmp(copied->text[3][0], "t5"));
+    assert(apop_data_get(d, 5, 0) == 50 && !strcmp(d->text[5][0], "t5") && !strcmp(d->names->row[5], "r5"));
+    apop_data_free(copied);
+    apop_data_free(d);
+}
+
 /** I claim that the mean residual is near zero, and that the predicted
   value is \f$X'\beta\f$.
   */
@@ -485,6 +1082,298 @@ void test_OLS(gsl_rng *r){
     apop_model_free(out);
 }
 
+//Blocked OLS, from memory and from the database, should match plain OLS.
+void test_lm_blocks(gsl_rng *r){
+    int rows = 5000;
+    apop_data *set = apop_data_alloc(rows, 3);
+    apop_name_add(set->names, "y", 'c');
+    apop_name_add(set->names, "x1", 'c');
+    apop_name_add(set->names, "x2", 'c');
+    for(int i=0; i< rows; i++){
+        apop_data_set(set, i, 1, gsl_rng_uniform(r)*10);
+        apop_data_set(set, i, 2, gsl_rng_uniform(r)*10);
+        apop_data_set(set, i, 0, 1 + 2*apop_data_get(set, i, 1) - 3*apop_data_get(set, i, 2)
+                                   + gsl_ran_gaussian(r, 2));
+    }
+    apop_table_exists("lmblocks", 'd');
+    apop_data_to_db(set, "lmblocks", 'w');
+
+    apop_lm_blocks *from_mem = apop_lm_blocks_alloc(NULL);
+    for (int i=0; i< rows; i+= 2000)
+        apop_lm_blocks_add(Apop_rs(set, i, GSL_MIN(2000, rows-i)), from_mem);
+    apop_lm_blocks *from_db = apop_lm_blocks_alloc(NULL);
+    assert(!apop_query_to_blocks(300, apop_lm_blocks_add, from_db, "select * from lmblocks"));
+    assert(from_db->n == rows);
+
+    apop_data *set_copy = apop_data_copy(set);
+    apop_model *plain = apop_estimate(set_copy, apop_ols);
+    apop_data *plain_cov = apop_data_get_page(plain->parameters, "<Covariance>");
+    apop_lm_blocks *accs[] = {from_mem, from_db};
+    for (int a=0; a< 2; a++){
+        apop_model *est = apop_lm_blocks_estimate(accs[a], apop_ols);
+        assert(!est->error);
+        apop_data *cov = apop_data_get_page(est->parameters, "<Covariance>");
+        for (int i=0; i< 3; i++){
+            Diff(apop_data_get(est->parameters, i, -1), apop_data_get(plain->parameters, i, -1), 1e-6);
+            Diff(apop_data_get(cov, i, i), apop_data_get(plain_cov, i, i), 1e-8);
+        }
+        assert(!strcmp(est->parameters->names->row[1], "x1"));
+        Diff(apop_data_get(est->info, .rowname="log likelihood"),
+             apop_data_get(plain->info, .rowname="log likelihood"), 1e-4);
+        Diff(apop_data_get(est->info, .rowname="R squared"),
+             apop_data_get(plain->info, .rowname="R squared"), 1e-6);
+        apop_model_free(est);
+        apop_lm_blocks_free(accs[a]);
+    }
+
+    //With weights, the blocked fit reports the same R^2 and SST as the in-memory one.
+    set->weights = gsl_vector_alloc(rows);
+    for (int i=0; i< rows; i++) gsl_vector_set(set->weights, i, 0.5 + gsl_rng_uniform(r));
+    apop_lm_blocks *weighted = apop_lm_blocks_alloc(NULL);
+    for (int i=0; i< rows; i+= 2000)
+        assert(!apop_lm_blocks_add(Apop_rs(set, i, GSL_MIN(2000, rows-i)), weighted));
+    apop_model *west = apop_lm_blocks_estimate(weighted, apop_ols);
+    apop_data *wset = apop_data_copy(set);
+    apop_model *wplain = apop_estimate(wset, apop_ols);
+    assert(!west->error);
+    for (int i=0; i< 3; i++)
+        Diff(apop_data_get(west->parameters, i, -1), apop_data_get(wplain->parameters, i, -1), 1e-6);
+    Diff(apop_data_get(west->info, .rowname="R squared"),
+         apop_data_get(wplain->info, .rowname="R squared"), 1e-6);
+    Diff(apop_data_get(west->info, .rowname="SST")/apop_data_get(wplain->info, .rowname="SST"), 1, 1e-8);
+
+    //Fewer rows than regressors is an error, not a fit.
+    apop_lm_blocks *few = apop_lm_blocks_alloc(NULL);
+    apop_lm_blocks_add(Apop_rs(set, 0, 2), few);
+    int verbosity = apop_opts.verbose;
+    apop_opts.verbose = -1;
+    apop_model *underdetermined = apop_lm_blocks_estimate(few, apop_ols);
+    apop_opts.verbose = verbosity;
+    assert(underdetermined->error == 'd');
+
+    apop_model_free(west); apop_model_free(wplain); apop_model_free(underdetermined);
+    apop_lm_blocks_free(weighted); apop_lm_blocks_free(few);
+    apop_data_free(wset);
+    apop_model_free(plain);
+    apop_data_free(set_copy);
+    apop_data_free(set);
+}
+
+//Blocked IV should match apop_iv, and mixing weighted with unweighted blocks is refused.
+void test_lm_blocks_iv(gsl_rng *r){
+    int rows = 5000;
+    apop_data *set = apop_data_alloc(rows, 4); //y, a noisy x1, x2, and a clean instrument for x1
+    for(int i=0; i< rows; i++){
+        double x1 = gsl_rng_uniform(r)*10;
+        apop_data_set(set, i, 1, x1 + gsl_ran_gaussian(r, 1));
+        apop_data_set(set, i, 2, gsl_rng_uniform(r)*10);
+        apop_data_set(set, i, 3, x1);
+        apop_data_set(set, i, 0, 1 + 2*x1 - 3*apop_data_get(set, i, 2) + gsl_ran_gaussian(r, 2));
+    }
+    gsl_vector *instrumented = apop_vector_fill(gsl_vector_alloc(1), 1);
+    apop_lm_blocks *acc = apop_lm_blocks_alloc(instrumented);
+    for (int i=0; i< rows; i+= 1500)
+        assert(!apop_lm_blocks_add(Apop_rs(set, i, GSL_MIN(1500, rows-i)), acc));
+    apop_model *blocked = apop_lm_blocks_estimate(acc, NULL);
+    assert(!blocked->error);
+
+    //The same regression via apop_iv, with the instrument in its own set.
+    apop_data *xset = apop_data_alloc(rows, 3), *inst = apop_data_alloc(rows, 1);
+    gsl_matrix_memcpy(xset->matrix, Apop_subm(set->matrix, 0, 0, rows, 3));
+    gsl_vector_memcpy(Apop_cv(inst, 0), Apop_cv(set, 3));
+    inst->vector = apop_vector_copy(instrumented);
+    apop_model *iv = apop_model_copy(apop_iv);
+    Apop_model_add_group(iv, apop_lm, .instruments=inst);
+    apop_model *est = apop_estimate(xset, iv);
+    apop_data *cov = apop_data_get_page(est->parameters, "<Covariance>"),
+              *bcov = apop_data_get_page(blocked->parameters, "<Covariance>");
+    for (int i=0; i< 3; i++){
+        Diff(apop_data_get(blocked->parameters, i, -1), apop_data_get(est->parameters, i, -1), 1e-6);
+        Diff(apop_data_get(bcov, i, i), apop_data_get(cov, i, i), 1e-8);
+    }
+    Diff(apop_data_get(blocked->parameters, 1, -1), 2, 0.1);
+
+    //Weights on some blocks but not others are refused, and the block isn't added.
+    apop_lm_blocks *mixed = apop_lm_blocks_alloc(NULL);
+    assert(!apop_lm_blocks_add(Apop_rs(set, 0, 100), mixed));
+    apop_data *weighted = apop_data_copy(Apop_rs(set, 100, 100));
+    weighted->weights = gsl_vector_alloc(100);
+    gsl_vector_set_all(weighted->weights, 2);
+    int verbosity = apop_opts.verbose;
+    apop_opts.verbose = -1;
+    assert(apop_lm_blocks_add(weighted, mixed) == 'w' && mixed->error == 'w' && mixed->n == 100);
+    apop_model *refused = apop_lm_blocks_estimate(mixed, NULL);
+    apop_opts.verbose = verbosity;
+    assert(refused->error);
+
+    apop_model_free(blocked); apop_model_free(est); apop_model_free(iv); apop_model_free(refused);
+    apop_lm_blocks_free(acc); apop_lm_blocks_free(mixed);
+    apop_data_free(set); apop_data_free(xset); apop_data_free(inst); apop_data_free(weighted);
+    gsl_vector_free(instrumented);
+}
+
+void test_absorbed_fe(gsl_rng *r){
+    int rows = 600;
+    apop_data *d = apop_text_alloc(apop_data_alloc(rows, 2), rows, 1);
+    for (int i=0; i< rows; i++){
+        int g = gsl_rng_uniform_int(r, 20);
+        apop_text_set(d, i, 0, "g%02i", g);
+        apop_data_set(d, i, 1, gsl_rng_uniform(r)*10 + g/4.);
+        apop_data_set(d, i, 0, 1 + 2*apop_data_get(d, i, 1) + g%7 + gsl_ran_gaussian(r, 1));
+    }
+    apop_data *sparse_set = apop_data_copy(d);
+    apop_data_to_dummies(d, .type='t', .append='y');
+    apop_model *dense = apop_estimate(d, apop_ols);
+    int k = d->matrix->size2;
+
+    apop_data *fe = apop_data_to_dummies(sparse_set, .type='t', .sparse='y');
+    assert(!fe->matrix && fe->vector->size == rows && fe->names->colct == k-2);
+    apop_model *m = apop_model_copy(apop_ols);
+    Apop_model_add_group(m, apop_lm, .fixed_effects=fe);
+    apop_model *absorbed = apop_estimate(sparse_set, m);
+    assert(!absorbed->error);
+
+    apop_data *dcov = apop_data_get_page(dense->parameters, "<Covariance>");
+    apop_data *acov = apop_data_get_page(absorbed->parameters, "<Covariance>");
+    for (int i=0; i< 2; i++){
+        Diff(apop_data_get(absorbed->parameters, i, -1), apop_data_get(dense->parameters, i, -1), 1e-8);
+        Diff(apop_data_get(acov, i, i), apop_data_get(dcov, i, i), 1e-8);
+    }
+    apop_data *effects = apop_data_get_page(absorbed->parameters, "<Fixed effects>");
+    for (int i=2; i< k; i++){
+        Diff(apop_data_get(effects, i-2, -1), apop_data_get(dense->parameters, i, -1), 1e-6);
+        assert(!strcmp(effects->names->row[i-2], dense->parameters->names->row[i]));
+    }
+    Diff(apop_data_get(absorbed->parameters, .page="<Error variance>"),
+         apop_data_get(dense->parameters, .page="<Error variance>"), 1e-8);
+    Diff(apop_data_get(absorbed->info, .rowname="log likelihood"),
+         apop_data_get(dense->info, .rowname="log likelihood"), 1e-6);
+    Diff(apop_data_get(absorbed->info, .rowname="R squared"),
+         apop_data_get(dense->info, .rowname="R squared"), 1e-8);
+    Diff(apop_data_get(absorbed->info, .rowname="R squared adj"),
+         apop_data_get(dense->info, .rowname="R squared adj"), 1e-8);
+
+    //With no parts wanted, there's no <Predicted> page, and the log likelihood has to
+    //add the effects to X beta itself.
+    apop_model *dense_bare = apop_model_copy(apop_ols);
+    Apop_model_add_group(dense_bare, apop_parts_wanted);
+    Apop_model_add_group(m, apop_parts_wanted);
+    apop_model *dense_est = apop_estimate(d, dense_bare);
+    apop_model *absorbed_bare = apop_estimate(sparse_set, m);
+    assert(!absorbed_bare->error && !apop_data_get_page(absorbed_bare->info, "<Predicted>"));
+    for (int i=0; i< 2; i++)
+        Diff(apop_data_get(absorbed_bare->parameters, i, -1), apop_data_get(dense_est->parameters, i, -1), 1e-8);
+    Diff(apop_log_likelihood(sparse_set, absorbed_bare), apop_log_likelihood(d, dense_est), 1e-6);
+
+    apop_model_free(dense);
+    apop_model_free(absorbed);
+    apop_model_free(dense_bare);
+    apop_model_free(dense_est);
+    apop_model_free(absorbed_bare);
+    apop_model_free(m);
+    apop_data_free(fe);
+    apop_data_free(d);
+    apop_data_free(sparse_set);
+}
+
+void test_spd(gsl_rng *r){
+    size_t n = 60;
+    gsl_matrix *b = gsl_matrix_alloc(n, n), *spd = gsl_matrix_alloc(n, n);
+    for (size_t i=0; i< n; i++)
+        for (size_t j=0; j< n; j++)
+            gsl_matrix_set(b, i, j, gsl_rng_uniform(r)-.5);
+    gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1, b, b, 0, spd);
+    for (size_t i=0; i< n; i++) *gsl_matrix_ptr(spd, i, i) += 1;
+
+    gsl_matrix *lu_inv, *chol_inv;
+    double det = apop_det_and_inv(spd, &lu_inv, 1, 1);
+    double logdet = apop_spd_logdet_and_inv(spd, &chol_inv, 1, 1);
+    assert(fabs(logdet - log(det)) < 1e-6);
+    assert(fabs(apop_matrix_spd_logdet(spd) - logdet) < 1e-10);
+    for (size_t i=0; i< n; i++)
+        for (size_t j=0; j< n; j++)
+            assert(fabs(gsl_matrix_get(lu_inv, i, j) - gsl_matrix_get(chol_inv, i, j)) < 1e-8);
+
+    gsl_vector *y = gsl_vector_alloc(n), *x = gsl_vector_alloc(n), *check = gsl_vector_alloc(n);
+    for (size_t i=0; i< n; i++) gsl_vector_set(y, i, gsl_rng_uniform(r));
+    assert(!apop_matrix_spd_solve(spd, y, x));
+    gsl_blas_dgemv(CblasNoTrans, 1, lu_inv, y, 0, check);
+    for (size_t i=0; i< n; i++) assert(fabs(gsl_vector_get(x, i) - gsl_vector_get(check, i)) < 1e-8);
+
+    //indefinite but invertible: fall back to LU; the log determinant of -I (odd n) is NaN.
+    gsl_matrix *negi = gsl_matrix_alloc(3, 3);
+    gsl_matrix_set_identity(negi);
+    gsl_matrix_scale(negi, -1);
+    gsl_matrix *negi_inv = apop_matrix_spd_inverse(negi);
+    for (size_t i=0; i< 3; i++) assert(gsl_matrix_get(negi_inv, i, i) == -1);
+    assert(isnan(apop_matrix_spd_logdet(negi)));
+    gsl_matrix_set_zero(negi);
+    assert(isinf(apop_matrix_spd_logdet(negi)));
+
+    gsl_matrix_free(b); gsl_matrix_free(spd); gsl_matrix_free(negi); gsl_matrix_free(negi_inv);
+    gsl_matrix_free(lu_inv); gsl_matrix_free(chol_inv);
+    gsl_vector_free(y); gsl_vector_free(x); gsl_vector_free(check);
+}
+
+//Three strong factors plus noise; dense, randomized, and blocked PCA should agree.
+void test_pca(gsl_rng *r){
+    size_t n = 3000, d = 40;
+    gsl_matrix *x = gsl_matrix_alloc(n, d);
+    for (size_t i=0; i< n; i++){
+        double f[3] = {10*gsl_ran_gaussian(r, 1), 5*gsl_ran_gaussian(r, 1), 2*gsl_ran_gaussian(r, 1)};
+        for (size_t j=0; j< d; j++)
+            gsl_matrix_set(x, i, j, 3 + f[j%3]*(1+j/3.)/d + gsl_ran_gaussian(r, .1));
+    }
+    apop_pca_blocks *acc = apop_pca_blocks_alloc();
+    size_t cuts[] = {0, 17, 1200, n};
+    for (int b=0; b< 3; b++)
+        apop_pca_blocks_add(&(apop_data){.matrix=Apop_subm(x, cuts[b], 0, cuts[b+1]-cuts[b], d)}, acc);
+    assert(acc->n == n && !acc->error);
+
+    gsl_matrix *x2 = apop_matrix_copy(x);
+    apop_data *dense = apop_matrix_pca(x, 3);
+    apop_data *randomized = apop_matrix_pca(x2, 3, .method='r');
+    apop_data *blocked = apop_pca_blocks_estimate(acc, 3);
+    apop_data *blocked_r = apop_pca_blocks_estimate(acc, 3, 'r');
+    apop_data *others[] = {randomized, blocked, blocked_r};
+    for (int o=0; o< 3; o++)
+        for (int i=0; i< 3; i++){
+            double dot;
+            gsl_blas_ddot(Apop_cv(dense, i), Apop_cv(others[o], i), &dot);
+            assert(fabs(fabs(dot) - 1) < 1e-6);
+            assert(fabs(apop_data_get(dense, i, -1) - apop_data_get(others[o], i, -1)) < 1e-6);
+        }
+    apop_data_free(dense); apop_data_free(randomized);
+    apop_data_free(blocked); apop_data_free(blocked_r);
+    apop_pca_blocks_free(acc);
+    gsl_matrix_free(x); gsl_matrix_free(x2);
+}
+
+/* Fitted values at every seventh point, from the FORTRAN-derived code before it was
+   made re-entrant and parallel. Two fits run at once must each reproduce them. */
+void test_loess(){
+    int n = 60;
+    apop_data *d = apop_data_alloc(n, n, 2);
+    for (int i=0; i< n; i++){
+        apop_data_set(d, i, 0, i/6.);
+        apop_data_set(d, i, 1, ((i*7)%n)/10.);
+        apop_data_set(d, i, -1, sin(i/6.) + 0.1*(((i*7)%n)/10.) + 0.2*cos(3.1*i));
+    }
+    double expected[] = {0.30458402424658, 1.36256044643594, 0.481508360946333,
+                        -0.0737297333452233, -0.525441788823132, -0.160681181613749,
+                         0.625922255774849, 0.828283718100356, 0.556506410127473};
+    apop_model *fits[2];
+    #pragma omp parallel for
+    for (int k=0; k< 2; k++) fits[k] = apop_estimate(d, apop_loess);
+    for (int k=0; k< 2; k++){
+        apop_data *predicted = apop_data_get_page(fits[k]->info, "<Predicted>");
+        for (int j=0; j< 9; j++)
+            Diff(apop_data_get(predicted, 7*j, 1), expected[j], 1e-9);
+        apop_model_free(fits[k]);
+    }
+    apop_data_free(d);
+}
+
 #define INVERTSIZE 100
 void test_inversion(gsl_rng *r){
     gsl_matrix *invme = gsl_matrix_alloc(INVERTSIZE, INVERTSIZE);
@@ -549,6 +1438,120 @@ apop_data *d9   = apop_dot(dv, d1, .form2='t');
     apop_data_free(d9); apop_data_free(d10); apop_data_free(d11);
 }
  
+static double max_diff(gsl_matrix *a, gsl_matrix *b){
+    double out = 0;
+    for (size_t i=0; i< a->size1; i++)
+        for (size_t j=0; j< a->size2; j++)
+            out = GSL_MAX(out, fabs(gsl_matrix_get(a, i, j) - gsl_matrix_get(b, i, j)));
+    return out;
+}
+
+/* Hinted products read junk-filled matrices, and have to match the plain product of the
+   clean versions: 2 op(l) op(r) + beta, with the output set to all ones beforehand. */
+static void check_hint(apop_data *l, apop_data *l_junk, char f1, char h1,
+                       apop_data *r, apop_data *r_junk, char f2, char h2){
+    apop_data *plain = apop_dot(l, r, .form1=f1, .form2=f2);
+    for (double beta=0; beta< 4; beta+=3){
+        apop_data *out = apop_data_copy(plain);
+        if (out->matrix) gsl_matrix_set_all(out->matrix, 1);
+        else             gsl_vector_set_all(out->vector, 1);
+        apop_data *same = apop_dot(l_junk, r_junk, .form1=f1, .form2=f2, .out=out,
+                                   .alpha=2, .beta=beta, .hint1=h1, .hint2=h2);
+        assert(same == out && !out->error);
+        if (out->matrix){
+            gsl_matrix_scale(out->matrix, 0.5);
+            gsl_matrix_add_constant(out->matrix, -beta/2);
+            assert(max_diff(plain->matrix, out->matrix) < 1e-12);
+        } else {
+            gsl_vector_scale(out->vector, 0.5);
+            gsl_vector_add_constant(out->vector, -beta/2);
+            assert(apop_vector_distance(plain->vector, out->vector) < 1e-12);
+        }
+        apop_data_free(out);
+    }
+    apop_data_free(plain);
+}
+
+//Each BLAS shortcut in apop_dot has to match the general dgemm/dgemv product.
+void test_dot_hints(gsl_rng *r){
+    int n = 5;
+    apop_data *lower = apop_data_calloc(n, n), *upper = apop_data_calloc(n, n),
+              *sym = apop_data_alloc(n, n), *b = apop_data_alloc(n, 3), *x = apop_data_alloc(20, n);
+    for (int i=0; i< n; i++){
+        for (int j=0; j<= i; j++){
+            apop_data_set(lower, i, j, gsl_rng_uniform(r));
+            apop_data_set(upper, j, i, gsl_rng_uniform(r));
+            double s = gsl_rng_uniform(r);
+            apop_data_set(sym, i, j, s);
+            apop_data_set(sym, j, i, s);
+        }
+        for (int j=0; j< 3; j++) apop_data_set(b, i, j, gsl_rng_uniform(r));
+        for (int j=0; j< 20; j++) apop_data_set(x, j, i, gsl_rng_uniform(r));
+    }
+    apop_data *bt = apop_data_transpose(b);
+
+    //Copies with garbage in the triangle the hint says is not read.
+    apop_data *lower_junk = apop_data_copy(lower), *upper_junk = apop_data_copy(upper),
+              *sym_junk = apop_data_copy(sym);
+    for (int i=0; i< n; i++)
+        for (int j=i+1; j< n; j++){
+            apop_data_set(lower_junk, i, j, 99);
+            apop_data_set(upper_junk, j, i, -99);
+            apop_data_set(sym_junk, i, j, 99);
+        }
+
+    //Triangular on either side, transposed or not.
+    check_hint(lower, lower_junk, 0, 'l', b, b, 0, 0);
+    check_hint(lower, lower_junk, 't', 'l', b, b, 0, 0);
+    check_hint(upper, upper_junk, 0, 'u', b, b, 0, 0);
+    check_hint(b, b, 't', 0, lower, lower_junk, 0, 'l');
+    check_hint(b, b, 't', 0, upper, upper_junk, 't', 'u');
+    check_hint(bt, bt, 0, 0, lower, lower_junk, 't', 'l');
+
+    //Symmetric on either side, with the other operand transposed or not.
+    check_hint(sym, sym_junk, 0, 's', b, b, 0, 0);
+    check_hint(sym, sym_junk, 0, 's', bt, bt, 't', 0);
+    check_hint(b, b, 't', 0, sym, sym_junk, 0, 's');
+    check_hint(bt, bt, 0, 0, sym, sym_junk, 0, 's');
+
+    //Both hinted, including one matrix times its own transpose.
+    check_hint(lower, lower_junk, 0, 'l', sym, sym_junk, 0, 's');
+    check_hint(sym, sym_junk, 0, 's', upper, upper_junk, 0, 'u');
+    check_hint(sym, sym_junk, 0, 's', sym, sym_junk, 0, 's');
+    check_hint(lower, lower_junk, 't', 'l', lower, lower_junk, 0, 'l');
+    check_hint(upper, upper_junk, 0, 'u', lower, lower_junk, 0, 'l');
+
+    //Matrix-vector and vector-matrix.
+    apop_data *dv = apop_data_alloc(n);
+    gsl_vector_memcpy(dv->vector, Apop_cv(b, 0));
+    check_hint(lower, lower_junk, 0, 'l', dv, dv, 0, 0);
+    check_hint(upper, upper_junk, 't', 'u', dv, dv, 0, 0);
+    check_hint(sym, sym_junk, 0, 's', dv, dv, 0, 0);
+    check_hint(dv, dv, 0, 0, lower, lower_junk, 0, 'l');
+    check_hint(dv, dv, 0, 0, upper, upper_junk, 't', 'u');
+
+    //X'X from one operand goes via dsyrk; compare to a product of two distinct copies.
+    apop_data *xpx = apop_dot(x, x, .form1='t'), *xcopy = apop_data_copy(x);
+    apop_data *xpx_plain = apop_dot(x, xcopy, .form1='t');
+    assert(max_diff(xpx_plain->matrix, xpx->matrix) < 1e-12);
+    assert(gsl_matrix_get(xpx->matrix, 0, 1) == gsl_matrix_get(xpx->matrix, 1, 0));
+
+    //Wrong-sized output, and output aliasing an input.
+    int verbosity = apop_opts.verbose;
+    apop_opts.verbose = -1;
+    apop_data *wrong = apop_data_alloc(3, 3);
+    assert(apop_dot(lower, b, .out=wrong)->error == 'd');
+    apop_data *alias = apop_data_copy(lower);
+    assert(apop_dot(alias, sym, .out=alias)->error == 'd');
+    apop_opts.verbose = verbosity;
+
+    apop_data_free(lower); apop_data_free(upper); apop_data_free(sym);
+    apop_data_free(lower_junk); apop_data_free(upper_junk); apop_data_free(sym_junk);
+    apop_data_free(b); apop_data_free(bt); apop_data_free(dv); apop_data_free(x);
+    apop_data_free(xpx); apop_data_free(xcopy); apop_data_free(xpx_plain);
+    apop_data_free(wrong); apop_data_free(alias);
+}
+
 static void fill_p(apop_data *d, gsl_rng *r){
     int j, k;
     if (d->vector)
@@ -868,6 +1871,44 @@ void test_vector_moving_average(){
     //with tails missing:
     for(i=0; i < 98; i ++)
         assert(gsl_vector_get(v, i+1) == gsl_vector_get(slightly_smooth, i));
+
+    //windowed stats on 0, 1, 2, ..., 99 in reverse, with a spike.
+    apop_data *d = apop_data_alloc(100, 2);
+    for(i=0; i < 100; i ++){
+        apop_data_set(d, i, 0, i);
+        apop_data_set(d, i, 1, 99-i);
+    }
+    apop_data_set(d, 40, 1, 1000);
+    apop_data *maxes = apop_data_rolling(d, 5, '>');
+    apop_data *mins = apop_data_rolling(d, 5, '<');
+    apop_data *vars = apop_data_rolling(d, 5, 'v');
+    apop_data *sums = apop_data_rolling(d, 5, 's');
+    assert(maxes->matrix->size1 == 96);
+    for(i=0; i < 96; i ++){
+        assert(apop_data_get(maxes, i, 0) == i+4);
+        assert(apop_data_get(mins, i, 0) == i);
+        assert(apop_data_get(sums, i, 0) == 5*i+10);
+        assert(apop_data_get(vars, i, 0) == 2.5);
+        assert(apop_data_get(maxes, i, 1) == ((i >= 36 && i <= 40) ? 1000 : 99-i));
+        assert(apop_data_get(mins, i, 1) == 95-i + (i==36)); //for i=36, row 40 is the spike, so the min is row 39
+    }
+    gsl_vector *ewma = apop_vector_rolling(Apop_cv(d, 0), .stat='e', .lambda=1);
+    for(i=0; i < 100; i ++) assert(gsl_vector_get(ewma, i) == i);
+    gsl_vector_free(ewma);
+
+    //A NaN or infinity touches only the windows that hold it.
+    gsl_vector *gappy = apop_vector_copy(v);
+    gsl_vector_set(gappy, 50, GSL_NAN);
+    gsl_vector_set(gappy, 60, GSL_POSINF);
+    gsl_vector *means = apop_vector_rolling(gappy, 3, 'm');
+    gsl_vector *gvars = apop_vector_rolling(gappy, 3, 'v');
+    for(i=0; i < 98; i ++)
+        if (i >= 48 && i <= 50) assert(gsl_isnan(gsl_vector_get(means, i)));
+        else if (i >= 58 && i <= 60) assert(gsl_isinf(gsl_vector_get(means, i)) && gsl_isnan(gsl_vector_get(gvars, i)));
+        else assert(gsl_vector_get(means, i) == i+1 && gsl_vector_get(gvars, i) == 1);
+    gsl_vector_free(gappy); gsl_vector_free(means); gsl_vector_free(gvars);
+    apop_data_free(maxes); apop_data_free(mins); apop_data_free(vars); apop_data_free(sums);
+    apop_data_free(d);
 }
 
 void test_transpose(){
@@ -958,6 +1999,36 @@ void test_probit_and_logit(gsl_rng *r){
     apop_data_free(data2);
 }
 
+//The analytic scores for multinomial logit and probit should match numeric gradients.
+void test_choice_scores(gsl_rng *r){
+    int len = 3000;
+    apop_data *data = apop_data_alloc(len, 3);
+    for (int i=0; i< len; i++){
+        apop_data_set(data, i, 0, gsl_rng_uniform_int(r, 3));
+        apop_data_set(data, i, 1, gsl_rng_uniform(r)-0.5);
+        apop_data_set(data, i, 2, gsl_rng_uniform(r)*2);
+    }
+    apop_model *models[] = {apop_logit, apop_probit};
+    for (int m=0; m< 2; m++){
+        apop_data *d = apop_data_copy(data); //prep modifies the data.
+        apop_model *est = apop_model_copy(models[m]);
+        apop_prep(d, est);
+        for (int i=0; i< est->parameters->matrix->size1; i++)
+            for (int j=0; j< est->parameters->matrix->size2; j++)
+                apop_data_set(est->parameters, i, j, gsl_rng_uniform(r)-0.5);
+        gsl_vector *analytic = gsl_vector_alloc(est->parameters->matrix->size1 * est->parameters->matrix->size2);
+        apop_score(d, analytic, est);
+        gsl_vector *numeric = apop_numerical_gradient(d, est);
+        for (int i=0; i< analytic->size; i++)
+            Diff(analytic->data[i], numeric->data[i], 1e-3*(1+fabs(numeric->data[i])));
+        gsl_vector_free(analytic);
+        gsl_vector_free(numeric);
+        apop_model_free(est);
+        apop_data_free(d);
+    }
+    apop_data_free(data);
+}
+
 void test_resize(){
     //This is the multiplication table from _Modeling with Data_
     //with a +.1 to distinguish columns from rows.
@@ -1022,6 +2093,12 @@ void test_posdef(gsl_rng *r){
         gsl_matrix_free(neg);
         apop_data_free(d);
     }
+
+    //Cholesky reads only the lower triangle; this one has a negative 2x2 minor.
+    apop_data *nonsym = apop_data_falloc((2, 2), 1, 10,
+                                                 1, 2);
+    assert(!apop_matrix_is_positive_semidefinite(nonsym->matrix));
+    apop_data_free(nonsym);
 }
 
 static double set_to_index(double in, int index){ return index;}
@@ -1162,6 +2239,90 @@ void test_vtables(){
     assert(apop_update_vtable_drop(apop_beta, apop_binomial)==0);
 }
 
+static void diff_models(apop_model *m1, apop_model *m2, double tol){
+    assert(apop_vector_distance(m1->parameters->vector, m2->parameters->vector) < tol);
+    if (m1->parameters->matrix)
+        for (size_t i=0; i< m1->parameters->matrix->size1; i++)
+            assert(apop_vector_distance(Apop_rv(m1->parameters, i), Apop_rv(m2->parameters, i)) < tol);
+}
+
+/* Conjugate updates work from sufficient statistics, so updating on the two halves of d
+   in sequence has to match a single update on all of it. Returns the single update. */
+static apop_model *update_in_halves(apop_data *d, apop_model *prior, apop_model *likelihood, double tol){
+    int n = d->matrix->size1;
+    apop_model *all = apop_update(d, prior, likelihood);
+    apop_model *half = apop_update(Apop_rs(d, 0, n/2), prior, likelihood);
+    apop_model *both = apop_update(Apop_rs(d, n/2, n-n/2), half, likelihood);
+    diff_models(all, both, tol);
+    apop_model_free(half);
+    apop_model_free(both);
+    return all;
+}
+
+void test_conjugate_batches(gsl_rng *r){
+    int n = 400;
+    apop_model *mvn = apop_model_copy(apop_multivariate_normal);
+    mvn->parameters = apop_data_falloc((2, 2, 2), 1, 1, .3,
+                                                  3, .3, 2);
+    mvn->dsize = 2;
+    apop_data *d = apop_model_draws(mvn, n);
+    apop_model *prior = apop_model_copy(apop_multivariate_normal);
+    prior->parameters = apop_data_falloc((2, 2, 2), 0, 10, 0,
+                                                    0, 0, 10);
+    apop_model *all = update_in_halves(d, prior, mvn, 1e-8);
+    assert(fabs(apop_data_get(all->parameters, 0, -1) - 1) < .3);
+    assert(fabs(apop_data_get(all->parameters, 1, -1) - 3) < .3);
+    apop_model_free(all);
+
+    apop_model *multinom = apop_model_set_parameters(apop_multinomial, 10, .2, .3, .1);
+    multinom->dsize = 4;
+    apop_data *counts = apop_model_draws(multinom, n);
+    apop_model *dir = apop_model_set_parameters(apop_dirichlet, 1, 1, 1, 1);
+    all = update_in_halves(counts, dir, apop_multinomial, 1e-8);
+    Diff(apop_data_get(all->parameters, 2)/apop_sum(all->parameters->vector), .3, .05);
+    apop_model_free(all);
+    //With no data, the parametrized likelihood counts as n draws at its expected proportions.
+    all = apop_update(NULL, dir, multinom);
+    double expected[] = {5, 3, 4, 2}; //1 + 10*(.4, .2, .3, .1)
+    for (int i=0; i< 4; i++) Diff(apop_data_get(all->parameters, i), expected[i], 1e-10);
+    apop_model_free(all);
+
+    apop_model *norm = apop_model_set_parameters(apop_normal, 2, .5);
+    apop_data *nd = apop_model_draws(norm, n);
+    apop_model *gam = apop_model_set_parameters(apop_gamma, 1, 1);
+    all = update_in_halves(nd, gam, norm, 1e-8);
+    Diff(apop_data_get(all->parameters, 0)*apop_data_get(all->parameters, 1), 4, .6); //precision = 1/.5^2
+    apop_model_free(all);
+
+    //Bayesian regression, y = 1 + 2x_1 - x_2 + e, with column zero of the matrix holding y.
+    apop_data *reg = apop_data_alloc(n, 3);
+    for (int i=0; i< n; i++){
+        double x1 = gsl_ran_gaussian(r, 1), x2 = gsl_ran_gaussian(r, 1);
+        apop_data_set(reg, i, 1, x1);
+        apop_data_set(reg, i, 2, x2);
+        apop_data_set(reg, i, 0, 1 + 2*x1 - x2 + gsl_ran_gaussian(r, 1));
+    }
+    apop_model *diffuse = apop_model_copy(apop_multivariate_normal);
+    diffuse->parameters = apop_data_falloc((3, 3, 3), 0, 1e6, 0, 0,
+                                                      0, 0, 1e6, 0,
+                                                      0, 0, 0, 1e6);
+    apop_model *known_var = apop_model_copy(apop_ols);
+    known_var->parameters = apop_data_alloc();
+    apop_data_add_page(known_var->parameters, apop_data_falloc((1), 1), "<Error variance>");
+    all = update_in_halves(reg, diffuse, known_var, 1e-6);
+    apop_model *plugin = apop_update(reg, diffuse, apop_ols);
+    apop_data *reg_copy = apop_data_copy(reg);
+    apop_model *ols = apop_estimate(reg_copy, apop_ols);
+    assert(apop_vector_distance(ols->parameters->vector, plugin->parameters->vector) < 1e-3);
+    assert(apop_vector_distance(ols->parameters->vector, all->parameters->vector) < 1e-3);
+
+    apop_model_free(all); apop_model_free(plugin); apop_model_free(ols);
+    apop_model_free(mvn); apop_model_free(prior); apop_model_free(multinom); apop_model_free(dir);
+    apop_model_free(norm); apop_model_free(gam); apop_model_free(diffuse); apop_model_free(known_var);
+    apop_data_free(d); apop_data_free(counts); apop_data_free(nd); apop_data_free(reg);
+    apop_data_free(reg_copy);
+}
+
 void test_weighted_regression(apop_data *d, apop_model *e){
     //pretty rudimentary: set all weights to equal and see if we get the same result.
     apop_data *cp = apop_data_copy(d);
@@ -1229,15 +2390,20 @@ int main(int argc, char **argv){
     apop_model *e  = apop_estimate(d, an_ols_model);
 
     do_test("vtables", test_vtables());
+    do_test("conjugate updates in batches", test_conjugate_batches(r));
     do_test("test listwise delete", test_listwise_delete());
+    do_test("row compaction", test_row_compaction());
     do_test("rownames", test_rownames());
     do_test("apop_dot", test_dot());
+    do_test("apop_dot BLAS shortcuts", test_dot_hints(r));
     do_test("apop_jackknife", test_jackknife(r));
     do_test("test multivariate_normal", test_multivariate_normal());
     do_test("log and exponent", log_and_exp(r));
     do_test("split and stack test", test_split_and_stack(r));
+    do_test("split views and repeated stacking", test_split_views());
     do_test("test probit and logit", test_probit_and_logit(r));
     do_test("test probit and logit again", test_probit_and_logit(r));
+    do_test("test probit and logit scores", test_choice_scores(r));
     do_test("test data compressing", test_pmf_compress(r));
     do_test("weighted regression", test_weighted_regression(d,e));
     do_test("offset OLS", test_ols_offset(r));
@@ -1254,15 +2420,33 @@ int main(int argc, char **argv){
     do_test("test_vector_moving_average", test_vector_moving_average());
     do_test("apop_estimate->dependent test", test_predicted_and_residual(e));
     do_test("OLS test", test_OLS(r));
+    do_test("blocked OLS test", test_lm_blocks(r));
+    do_test("blocked IV test", test_lm_blocks_iv(r));
     do_test("database skew, kurtosis, normalization", test_skew_and_kurt(r));
     do_test("test_percentiles", test_percentiles());
     do_test("weighted moments", test_weigted_moments());
     do_test("multivariate gamma", test_mvn_gamma());
     do_test("Inversion", test_inversion(r));
+    do_test("Cholesky inversion and log determinants", test_spd(r));
+    do_test("truncated and blocked PCA", test_pca(r));
+    do_test("loess, two fits at once", test_loess());
     do_test("apop_matrix_summarize", test_summarize());
     do_test("apop_linear_constraint", test_linear_constraint());
     do_test("transposition", test_transpose());
     do_test("test unique elements", test_unique_elements());
+    do_test("multi-start MLE", test_multistart(r));
+    do_test("MLE parameter layout follows a changed set", test_mle_layout_change(r));
+    do_test("block-parallel dimension cycling", test_dim_cycle_blocks(r));
+    do_test("Fisher exact test, batched", test_fisher_batch());
+    do_test("quantile sketch", test_sketch(r));
+    do_test("Kolmogorov-Smirnov on raw vectors", test_ks_vectors());
+    do_test("closed-form Normal imputation", test_mvn_impute());
+    do_test("direct histograms", test_histogram(r));
+    do_test("arena allocation", test_arena());
+    do_test("copy-on-write text and names", test_shared_copy());
+    do_test("packed text", test_text_pack());
+    do_test("hashed factors", test_factor_hash());
+    do_test("absorbed fixed effects", test_absorbed_fe(r));
     if (slow_tests){
         if (verbose) printf("\tSlower tests:\n");
         do_test("Test score (dlog likelihood) calculation", test_score());
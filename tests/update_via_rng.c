@@ -108,6 +108,52 @@ void gammafish(){
     deciles(gammafied, gammafied2, 5);
 }
 
+/* With thousands of observations, the raw likelihood of the data underflows to zero for
+   every draw from the prior, so the weights have to be calculated in log space. */
+void big_data_draws(){
+    apop_model *gamma = apop_model_set_parameters(apop_gamma, 1.5, 2.2);
+    apop_data *draws = apop_model_draws(apop_model_set_parameters(apop_poisson, 3.1), 5000);
+    apop_model *gammaup = apop_update(draws, gamma, apop_poisson);
+    double conj_mean = apop_data_get(gammaup->parameters, 0) * apop_data_get(gammaup->parameters, 1);
+
+    gamma->log_likelihood = NULL;
+    gamma->p = NULL;
+    apop_model *upd_r = apop_update(draws, gamma, apop_poisson);
+    assert(fabs(apop_sum(upd_r->data->weights) - 1) < 1e-8);
+    double ess = apop_data_get(upd_r->info, .rowname="effective sample size");
+    assert(ess > 1 && ess <= upd_r->data->weights->size);
+    assert(isfinite(apop_data_get(upd_r->info, .rowname="log marginal likelihood")));
+    assert(fabs(apop_vector_mean(Apop_cv(upd_r->data, 0), upd_r->data->weights) - conj_mean) < 0.1);
+}
+
+/* A PMF prior builds its CDF on the first draw, and a fixed-parameter likelihood
+   unpacks into a base model shared by all of its copies, so neither may be used from
+   several threads at once. The info page from the PMF estimation is kept. */
+void pmf_prior_draws(){
+    apop_data *prior_draws = apop_model_draws(apop_model_set_parameters(apop_beta, 10, 5), 2000);
+    apop_model *prior = apop_estimate(prior_draws, apop_pmf);
+    apop_model *drawfrom = apop_model_copy(apop_multinomial);
+    drawfrom->parameters = apop_data_falloc((2), 30, .4);
+    drawfrom->dsize = 2;
+    apop_data *draws = apop_model_draws(drawfrom, 80);
+    apop_model *bi = apop_model_fix_params(apop_model_set_parameters(apop_binomial, 30, NAN));
+    Apop_settings_add_group(prior, apop_mcmc, .periods=4000);
+    apop_model *upd = apop_update(draws, prior, bi);
+    assert(upd->data->matrix->size1 == 4000);
+    assert(fabs(apop_sum(upd->data->weights) - 1) < 1e-8);
+    assert(apop_data_get(upd->info, .rowname="effective sample size") > 1);
+
+    //conjugate answer: Beta(10 + hits, 5 + misses), whose mean is (10 + hits)/(15 + 30n).
+    double mean = (10 + apop_sum(Apop_cv(draws, 1))) / (15 + 30*80.);
+    assert(fabs(apop_vector_mean(Apop_cv(upd->data, 0), upd->data->weights) - mean) < 0.02);
+    apop_model_free(upd);
+    apop_model_free(bi);
+    apop_model_free(drawfrom);
+    apop_model_free(prior);
+    apop_data_free(draws);
+    apop_data_free(prior_draws);
+}
+
 void make_draws(){
     apop_model *multinom = apop_model_copy(apop_multivariate_normal);
     multinom->parameters = apop_data_falloc((2, 2, 2), 
@@ -132,4 +178,6 @@ int main(){
     make_draws();
     betabinom();
     gammafish();
+    big_data_draws();
+    pmf_prior_draws();
 }
@@ -98,7 +98,9 @@ static bool is_stale(apop_dconstrain_settings *cs, apop_model *m){ //do I need t
     if (!cs->last_params && !m->parameters)
         stale=false;
     else {
-        gsl_vector *params = apop_data_pack(m->parameters);
+        apop_arena_begin();
+        gsl_vector *params = apop_arena_vector(apop_data_pack_size(m->parameters));
+        apop_data_pack(m->parameters, params);
         if (!cs->last_params){
             cs->last_params = apop_vector_copy(params);
             stale = true;
@@ -110,7 +112,7 @@ static bool is_stale(apop_dconstrain_settings *cs, apop_model *m){ //do I need t
             gsl_vector_memcpy(cs->last_params, params);
             stale=true;
         }
-        gsl_vector_free(params);
+        apop_arena_end();
     }
     if (!cs->scale) stale = true; //but at this point, last_params is prepped.
     return stale;